@@ -0,0 +1,519 @@
+#ifndef FLAT_ORDERED_HASH_MAP_H
+#define FLAT_ORDERED_HASH_MAP_H
+
+/*************************************************************************/
+/*  flat_ordered_hash_map.h                                              */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "core/containers/hashfuncs.h"
+#include "core/error/error_macros.h"
+#include "core/os/memory.h"
+
+/**
+ * An insertion ordered hash map that keeps its entries in flat, contiguous
+ * storage instead of allocating a list node and a hash node per element.
+ *
+ * Entries are appended to a segmented array: the first segment holds
+ * FIRST_BLOCK_SIZE entries and every following segment doubles the capacity.
+ * The first segment is stored inside the map itself, so maps with up to
+ * FIRST_BLOCK_SIZE entries don't allocate at all. The later segments, and the
+ * table pointing to them, are allocated on the heap. Segments are never moved, so pointers to keys and
+ * values stay valid while new elements are inserted (like with
+ * OrderedHashMap).
+ *
+ * Erasing is different from OrderedHashMap: erased slots are compacted once
+ * they outnumber the live entries, which moves the remaining entries. So any
+ * erase() can invalidate every pointer to a key or value, and every entry
+ * index, not only the ones of the erased element.
+ *
+ * Small maps (up to FIRST_BLOCK_SIZE entries, which all live in the first
+ * segment) are searched linearly, comparing the cached hashes first. Larger
+ * maps additionally maintain an open addressing index of (hash, entry) pairs
+ * with linear probing.
+ *
+ * Iteration uses plain entry indices, see get_next_index().
+ */
+template <class K, class V,
+		class Hasher = HashMapHasherDefault,
+		class Comparator = HashMapComparatorDefault<K>>
+class FlatOrderedHashMap {
+public:
+	static const uint32_t FIRST_BLOCK_SHIFT = 3;
+	static const uint32_t FIRST_BLOCK_SIZE = 1 << FIRST_BLOCK_SHIFT;
+	static const uint32_t MAX_BLOCKS = 32 - FIRST_BLOCK_SHIFT;
+	static const uint32_t MIN_INDEX_CAPACITY = FIRST_BLOCK_SIZE * 4;
+
+	struct Entry {
+		K key;
+		V value;
+		uint32_t hash;
+
+		Entry(const K &p_key, const V &p_value, uint32_t p_hash) :
+				key(p_key),
+				value(p_value),
+				hash(p_hash) {}
+	};
+
+private:
+	struct IndexSlot {
+		uint32_t hash;
+		uint32_t entry;
+	};
+
+	static const uint32_t SLOT_EMPTY = 0xFFFFFFFF;
+	static const uint32_t SLOT_ERASED = 0xFFFFFFFE;
+
+	// The blocks after the first one, null until the first block is full.
+	// Only sized for the blocks in use, to keep small maps small.
+	Entry **_blocks;
+	uint32_t _block_count;
+
+	// Entry slots in use, including erased ones.
+	uint32_t _count;
+	uint32_t _live;
+	// Liveness flag per entry slot, erased entries are already destructed.
+	// Points to _inline_alive until the map grows past the first block.
+	bool *_alive;
+
+	// Storage of the first block, and of its liveness flags.
+	alignas(Entry) uint8_t _inline_block[sizeof(Entry) * FIRST_BLOCK_SIZE];
+	bool _inline_alive[FIRST_BLOCK_SIZE];
+
+	IndexSlot *_index;
+	uint32_t _index_capacity;
+	uint32_t _index_used;
+
+	static _FORCE_INLINE_ uint32_t _high_bit(uint32_t p_value) {
+#if defined(__GNUC__) || defined(__clang__)
+		return 31 - __builtin_clz(p_value);
+#else
+		uint32_t r = 0;
+		while (p_value >>= 1) {
+			r++;
+		}
+		return r;
+#endif
+	}
+
+	static _FORCE_INLINE_ uint32_t _block_size(uint32_t p_block) {
+		return p_block == 0 ? FIRST_BLOCK_SIZE : (1u << (p_block + FIRST_BLOCK_SHIFT - 1));
+	}
+
+	_FORCE_INLINE_ Entry *_first_block() const {
+		return reinterpret_cast<Entry *>(const_cast<uint8_t *>(_inline_block));
+	}
+
+	_FORCE_INLINE_ Entry *_entry(uint32_t p_index) const {
+		if (p_index < FIRST_BLOCK_SIZE) {
+			return _first_block() + p_index;
+		}
+		uint32_t hb = _high_bit(p_index);
+		return _blocks[hb - FIRST_BLOCK_SHIFT] + (p_index - (1u << hb));
+	}
+
+	_FORCE_INLINE_ uint32_t _capacity() const {
+		return _block_count == 0 ? 0 : (FIRST_BLOCK_SIZE << (_block_count - 1));
+	}
+
+	void _grow() {
+		CRASH_COND(_block_count == MAX_BLOCKS);
+
+		if (_block_count == 0) {
+			_block_count = 1;
+			_alive = _inline_alive;
+			return;
+		}
+
+		uint32_t size = _block_size(_block_count);
+		_blocks = (Entry **)memrealloc(_blocks, sizeof(Entry *) * _block_count);
+		_blocks[_block_count - 1] = (Entry *)memalloc(sizeof(Entry) * size);
+		_block_count++;
+
+		if (_alive == _inline_alive) {
+			_alive = (bool *)memalloc(sizeof(bool) * _capacity());
+			memcpy(_alive, _inline_alive, sizeof(bool) * FIRST_BLOCK_SIZE);
+		} else {
+			_alive = (bool *)memrealloc(_alive, sizeof(bool) * _capacity());
+		}
+	}
+
+	_FORCE_INLINE_ uint32_t _hash(const K &p_key) const {
+		return Hasher::hash(p_key);
+	}
+
+	// Returns the entry index of p_key, or -1. r_slot receives the index slot
+	// when the index is in use.
+	int64_t _lookup(const K &p_key, uint32_t p_hash, uint32_t *r_slot = nullptr) const {
+		if (!_index) {
+			for (uint32_t i = 0; i < _count; i++) {
+				const Entry *e = _first_block() + i;
+				if (_alive[i] && e->hash == p_hash && Comparator::compare(e->key, p_key)) {
+					return i;
+				}
+			}
+			return -1;
+		}
+
+		uint32_t mask = _index_capacity - 1;
+		uint32_t pos = p_hash & mask;
+
+		while (true) {
+			const IndexSlot &slot = _index[pos];
+			if (slot.entry == SLOT_EMPTY) {
+				return -1;
+			}
+			if (slot.entry != SLOT_ERASED && slot.hash == p_hash && Comparator::compare(_entry(slot.entry)->key, p_key)) {
+				if (r_slot) {
+					*r_slot = pos;
+				}
+				return slot.entry;
+			}
+			pos = (pos + 1) & mask;
+		}
+	}
+
+	void _index_insert(uint32_t p_hash, uint32_t p_entry) {
+		uint32_t mask = _index_capacity - 1;
+		uint32_t pos = p_hash & mask;
+
+		while (_index[pos].entry < SLOT_ERASED) {
+			pos = (pos + 1) & mask;
+		}
+
+		if (_index[pos].entry == SLOT_EMPTY) {
+			_index_used++;
+		}
+		_index[pos].hash = p_hash;
+		_index[pos].entry = p_entry;
+	}
+
+	void _rebuild_index() {
+		if (_count <= FIRST_BLOCK_SIZE) {
+			// Small enough for linear search.
+			if (_index) {
+				memfree(_index);
+				_index = nullptr;
+				_index_capacity = 0;
+				_index_used = 0;
+			}
+			return;
+		}
+
+		// Keep the load factor below 1/2 after the rebuild.
+		uint32_t capacity = MIN_INDEX_CAPACITY;
+		while (capacity < _live * 4) {
+			capacity <<= 1;
+		}
+
+		if (capacity != _index_capacity) {
+			if (_index) {
+				memfree(_index);
+			}
+			_index = (IndexSlot *)memalloc(sizeof(IndexSlot) * capacity);
+			_index_capacity = capacity;
+		}
+
+		for (uint32_t i = 0; i < _index_capacity; i++) {
+			_index[i].entry = SLOT_EMPTY;
+		}
+		_index_used = 0;
+
+		for (uint32_t i = 0; i < _count; i++) {
+			if (_alive[i]) {
+				_index_insert(_entry(i)->hash, i);
+			}
+		}
+	}
+
+	Entry *_insert(const K &p_key, const V &p_value, uint32_t p_hash) {
+		if (_count == _capacity()) {
+			_grow();
+		}
+
+		uint32_t idx = _count;
+		Entry *e = _entry(idx);
+		memnew_placement(e, Entry(p_key, p_value, p_hash));
+		_alive[idx] = true;
+		_count++;
+		_live++;
+
+		if (_index) {
+			// Max load factor of 3/4, erased slots included.
+			if ((_index_used + 1) * 4 > _index_capacity * 3) {
+				_rebuild_index();
+			} else {
+				_index_insert(p_hash, idx);
+			}
+		} else if (_count > FIRST_BLOCK_SIZE) {
+			_rebuild_index();
+		}
+
+		return e;
+	}
+
+	// Moves the live entries to the front, preserving their order.
+	// Invalidates all pointers to keys and values, and all entry indices.
+	void _compact() {
+		uint32_t to = 0;
+		for (uint32_t from = 0; from < _count; from++) {
+			if (!_alive[from]) {
+				continue;
+			}
+			if (from != to) {
+				Entry *src = _entry(from);
+				memnew_placement(_entry(to), Entry(*src));
+				src->~Entry();
+				_alive[to] = true;
+				_alive[from] = false;
+			}
+			to++;
+		}
+		_count = to;
+
+		_rebuild_index();
+	}
+
+	void _release() {
+		for (uint32_t i = 0; i < _count; i++) {
+			if (_alive[i]) {
+				_entry(i)->~Entry();
+			}
+		}
+		// The first block is _inline_block.
+		for (uint32_t i = 1; i < _block_count; i++) {
+			memfree(_blocks[i - 1]);
+		}
+		if (_blocks) {
+			memfree(_blocks);
+		}
+		if (_alive && _alive != _inline_alive) {
+			memfree(_alive);
+		}
+		if (_index) {
+			memfree(_index);
+		}
+
+		_blocks = nullptr;
+		_block_count = 0;
+		_count = 0;
+		_live = 0;
+		_alive = nullptr;
+		_index = nullptr;
+		_index_capacity = 0;
+		_index_used = 0;
+	}
+
+public:
+	_FORCE_INLINE_ uint32_t size() const {
+		return _live;
+	}
+
+	_FORCE_INLINE_ bool empty() const {
+		return _live == 0;
+	}
+
+	V *getptr(const K &p_key) {
+		int64_t idx = _lookup(p_key, _hash(p_key));
+		return idx < 0 ? nullptr : &_entry(idx)->value;
+	}
+
+	const V *getptr(const K &p_key) const {
+		int64_t idx = _lookup(p_key, _hash(p_key));
+		return idx < 0 ? nullptr : &_entry(idx)->value;
+	}
+
+	_FORCE_INLINE_ bool has(const K &p_key) const {
+		return _lookup(p_key, _hash(p_key)) >= 0;
+	}
+
+	// Entry index of p_key, or -1 if it's not in the map.
+	_FORCE_INLINE_ int64_t find_index(const K &p_key) const {
+		return _lookup(p_key, _hash(p_key));
+	}
+
+	V &operator[](const K &p_key) {
+		uint32_t hash = _hash(p_key);
+		int64_t idx = _lookup(p_key, hash);
+		if (idx >= 0) {
+			return _entry(idx)->value;
+		}
+		return _insert(p_key, V(), hash)->value;
+	}
+
+	const V &operator[](const K &p_key) const {
+		int64_t idx = _lookup(p_key, _hash(p_key));
+		CRASH_COND(idx < 0);
+		return _entry(idx)->value;
+	}
+
+	void set(const K &p_key, const V &p_value) {
+		uint32_t hash = _hash(p_key);
+		int64_t idx = _lookup(p_key, hash);
+		if (idx >= 0) {
+			_entry(idx)->value = p_value;
+		} else {
+			_insert(p_key, p_value, hash);
+		}
+	}
+
+	// Can move the other entries, see the class description.
+	bool erase(const K &p_key) {
+		uint32_t slot = 0;
+		int64_t idx = _lookup(p_key, _hash(p_key), &slot);
+		if (idx < 0) {
+			return false;
+		}
+
+		if (_index) {
+			_index[slot].entry = SLOT_ERASED;
+		}
+
+		_entry(idx)->~Entry();
+		_alive[idx] = false;
+		_live--;
+
+		if (_live == 0) {
+			// Keep the allocated blocks around for reuse.
+			_count = 0;
+			_rebuild_index();
+			return true;
+		}
+
+		// Trailing erased entries can be reused right away.
+		while (!_alive[_count - 1]) {
+			_count--;
+		}
+
+		uint32_t erased = _count - _live;
+		if (erased >= FIRST_BLOCK_SIZE && erased > _live) {
+			_compact();
+		}
+
+		return true;
+	}
+
+	void clear() {
+		_release();
+	}
+
+	// Makes sure p_size entries fit without allocating new blocks.
+	void reserve(uint32_t p_size) {
+		while (_capacity() < p_size) {
+			_grow();
+		}
+	}
+
+	/**
+	 * Entry indices are only valid until the next erase. Returns the index of
+	 * the first live entry after p_index (pass -1 to get the first one), or
+	 * -1 once the end is reached.
+	 */
+	int64_t get_next_index(int64_t p_index = -1) const {
+		for (uint32_t i = p_index + 1; i < _count; i++) {
+			if (_alive[i]) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	// Entry index of the p_position-th live entry (in insertion order), or -1.
+	int64_t get_index_at_position(uint32_t p_position) const {
+		if (p_position >= _live) {
+			return -1;
+		}
+		if (_live == _count) {
+			return p_position;
+		}
+		for (uint32_t i = 0; i < _count; i++) {
+			if (_alive[i]) {
+				if (p_position == 0) {
+					return i;
+				}
+				p_position--;
+			}
+		}
+		return -1;
+	}
+
+	_FORCE_INLINE_ const K &get_key(int64_t p_index) const {
+		return _entry(p_index)->key;
+	}
+
+	_FORCE_INLINE_ V &get_value(int64_t p_index) {
+		return _entry(p_index)->value;
+	}
+
+	_FORCE_INLINE_ const V &get_value(int64_t p_index) const {
+		return _entry(p_index)->value;
+	}
+
+	// Appends all entries of p_other, which must not contain any key of this
+	// map. The cached hashes are reused, so nothing gets rehashed.
+	void append_unique(const FlatOrderedHashMap &p_other) {
+		reserve(_count + p_other._live);
+		for (uint32_t i = 0; i < p_other._count; i++) {
+			if (p_other._alive[i]) {
+				const Entry *e = p_other._entry(i);
+				_insert(e->key, e->value, e->hash);
+			}
+		}
+	}
+
+	void operator=(const FlatOrderedHashMap &p_other) {
+		if (this == &p_other) {
+			return;
+		}
+		_release();
+		append_unique(p_other);
+	}
+
+	FlatOrderedHashMap(const FlatOrderedHashMap &p_other) :
+			FlatOrderedHashMap() {
+		append_unique(p_other);
+	}
+
+	FlatOrderedHashMap() {
+		_blocks = nullptr;
+		_block_count = 0;
+		_count = 0;
+		_live = 0;
+		_alive = nullptr;
+		_index = nullptr;
+		_index_capacity = 0;
+		_index_used = 0;
+	}
+
+	~FlatOrderedHashMap() {
+		_release();
+	}
+};
+
+#endif // FLAT_ORDERED_HASH_MAP_H
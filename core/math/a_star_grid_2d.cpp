@@ -0,0 +1,968 @@
+/*************************************************************************/
+/*  a_star_grid_2d.cpp                                                   */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "a_star_grid_2d.h"
+
+#include "core/containers/sort_array.h"
+#include "core/object/class_db.h"
+
+static const Vector2i _directions[8] = {
+	Vector2i(1, 0),
+	Vector2i(0, 1),
+	Vector2i(-1, 0),
+	Vector2i(0, -1),
+	Vector2i(1, 1),
+	Vector2i(-1, 1),
+	Vector2i(-1, -1),
+	Vector2i(1, -1),
+};
+
+#if defined(__GNUC__) || (_llvm_has_builtin(__builtin_ctzll))
+#define CTZ64(x) __builtin_ctzll(x)
+#elif defined(_MSC_VER) && defined(_WIN64)
+#include "intrin.h"
+static int __bsf_ctz64(uint64_t x) {
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return index;
+}
+#define CTZ64(x) __bsf_ctz64(x)
+#else
+static int __loop_ctz64(uint64_t x) {
+	int index = 0;
+	while (!(x & 1)) {
+		x >>= 1;
+		index++;
+	}
+	return index;
+}
+#define CTZ64(x) __loop_ctz64(x)
+#endif
+
+static _FORCE_INLINE_ int _get_step(int p_delta) {
+	return (p_delta > 0) - (p_delta < 0);
+}
+
+static _FORCE_INLINE_ uint64_t _reverse_bits(uint64_t p_bits) {
+	p_bits = ((p_bits >> 1) & 0x5555555555555555ULL) | ((p_bits & 0x5555555555555555ULL) << 1);
+	p_bits = ((p_bits >> 2) & 0x3333333333333333ULL) | ((p_bits & 0x3333333333333333ULL) << 2);
+	p_bits = ((p_bits >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((p_bits & 0x0F0F0F0F0F0F0F0FULL) << 4);
+	p_bits = ((p_bits >> 8) & 0x00FF00FF00FF00FFULL) | ((p_bits & 0x00FF00FF00FF00FFULL) << 8);
+	p_bits = ((p_bits >> 16) & 0x0000FFFF0000FFFFULL) | ((p_bits & 0x0000FFFF0000FFFFULL) << 16);
+	return (p_bits >> 32) | (p_bits << 32);
+}
+
+bool AStarGrid2D::_can_move(int p_x, int p_y, int p_dx, int p_dy) const {
+	if (!_is_walkable(p_x + p_dx, p_y + p_dy)) {
+		return false;
+	}
+
+	if (p_dx == 0 || p_dy == 0) {
+		return true;
+	}
+
+	switch (diagonal_mode) {
+		case DIAGONAL_MODE_ALWAYS:
+			return true;
+		case DIAGONAL_MODE_NEVER:
+			return false;
+		case DIAGONAL_MODE_AT_LEAST_ONE_WALKABLE:
+			return _is_walkable(p_x + p_dx, p_y) || _is_walkable(p_x, p_y + p_dy);
+		case DIAGONAL_MODE_ONLY_IF_NO_OBSTACLES:
+			return _is_walkable(p_x + p_dx, p_y) && _is_walkable(p_x, p_y + p_dy);
+		default:
+			return false;
+	}
+}
+
+real_t AStarGrid2D::_estimate_cost(int p_from_x, int p_from_y, int p_to_x, int p_to_y) const {
+	real_t dx = (real_t)ABS(p_to_x - p_from_x);
+	real_t dy = (real_t)ABS(p_to_y - p_from_y);
+
+	switch (default_heuristic) {
+		case HEURISTIC_EUCLIDEAN:
+			return Math::sqrt(dx * dx + dy * dy);
+		case HEURISTIC_MANHATTAN:
+			return dx + dy;
+		case HEURISTIC_OCTILE: {
+			const real_t f = (real_t)Math_SQRT2 - 1;
+			return (dx < dy) ? f * dx + dy : f * dy + dx;
+		}
+		case HEURISTIC_CHEBYSHEV:
+			return MAX(dx, dy);
+		default:
+			return 0;
+	}
+}
+
+// Solid bits of the 64 cells of a line starting at p_start, cells outside of the grid count as solid.
+uint64_t AStarGrid2D::_get_line_bits(const LocalVector<uint64_t> &p_mask, int p_line_length, int p_line_count, int p_line, int p_start) const {
+	if (p_line < 0 || p_line >= p_line_count) {
+		return ~uint64_t(0);
+	}
+
+	const int from = MAX(p_start, 0);
+	const int to = MIN(p_start + 64, p_line_length);
+	if (from >= to) {
+		return ~uint64_t(0);
+	}
+
+	const uint32_t bit = (uint32_t)p_line * (uint32_t)p_line_length + (uint32_t)from;
+	const uint32_t word = bit >> 6;
+	const uint32_t shift = bit & 63;
+
+	uint64_t bits = p_mask[word] >> shift;
+	if (shift != 0 && word + 1 < p_mask.size()) {
+		bits |= p_mask[word + 1] << (64 - shift);
+	}
+
+	const int count = to - from;
+	const int offset = from - p_start;
+	const uint64_t valid = ((count == 64) ? ~uint64_t(0) : ((uint64_t(1) << count) - 1)) << offset;
+
+	return ((bits << offset) & valid) | ~valid;
+}
+
+// Bit i is the cell i + p_steps steps away from p_pos in the direction p_dir.
+uint64_t AStarGrid2D::_get_scan_bits(const LocalVector<uint64_t> &p_mask, int p_line_length, int p_line_count, int p_line, int p_pos, int p_dir, int p_steps) const {
+	if (p_dir > 0) {
+		return _get_line_bits(p_mask, p_line_length, p_line_count, p_line, p_pos + p_steps);
+	}
+	return _reverse_bits(_get_line_bits(p_mask, p_line_length, p_line_count, p_line, p_pos - p_steps - 63));
+}
+
+// Straight jump along a line of the mask, checks the forced neighbour rules of 64 cells at once.
+bool AStarGrid2D::_jump_straight(const LocalVector<uint64_t> &p_mask, int p_line_length, int p_line_count, int p_line, int &r_pos, int p_dir, int p_end_line, int p_end_pos) const {
+	const bool corner_cutting = diagonal_mode == DIAGONAL_MODE_ALWAYS || diagonal_mode == DIAGONAL_MODE_AT_LEAST_ONE_WALKABLE;
+
+	int pos = r_pos;
+
+	while (true) {
+		const uint64_t blocked = _get_scan_bits(p_mask, p_line_length, p_line_count, p_line, pos, p_dir, 0);
+
+		uint64_t forced = 0;
+		for (int side = -1; side <= 1; side += 2) {
+			if (corner_cutting) {
+				// The cell ahead on the side opens up while the one next to us is solid.
+				forced |= ~_get_scan_bits(p_mask, p_line_length, p_line_count, p_line + side, pos, p_dir, 1) & _get_scan_bits(p_mask, p_line_length, p_line_count, p_line + side, pos, p_dir, 0);
+			} else {
+				// The cell next to us opens up while the one behind it is solid.
+				forced |= ~_get_scan_bits(p_mask, p_line_length, p_line_count, p_line + side, pos, p_dir, 0) & _get_scan_bits(p_mask, p_line_length, p_line_count, p_line + side, pos, p_dir, -1);
+			}
+		}
+
+		uint64_t stops = blocked | forced;
+		if (p_line == p_end_line) {
+			const int end_steps = (p_end_pos - pos) * p_dir;
+			if (end_steps >= 0 && end_steps < 64) {
+				stops |= uint64_t(1) << end_steps;
+			}
+		}
+
+		if (stops) {
+			const int steps = CTZ64(stops);
+			if (blocked & (uint64_t(1) << steps)) {
+				return false;
+			}
+
+			r_pos = pos + steps * p_dir;
+			return true;
+		}
+
+		pos += 64 * p_dir;
+	}
+}
+
+// Walks from r_x, r_y in the given direction until it reaches a jump point, the end or a dead end.
+// The forced neighbour rules follow the diagonal mode, see _get_jump_directions() for the pruning side.
+bool AStarGrid2D::_jump(int &r_x, int &r_y, int p_dx, int p_dy, int p_end_x, int p_end_y) const {
+	if (p_dy == 0) {
+		return _jump_straight(solid_mask, width, height, r_y, r_x, p_dx, p_end_y, p_end_x);
+	}
+	if (p_dx == 0 && diagonal_mode != DIAGONAL_MODE_NEVER) {
+		return _jump_straight(solid_mask_transposed, height, width, r_x, r_y, p_dy, p_end_x, p_end_y);
+	}
+
+	// Diagonal jumps, and vertical ones without diagonals which also look for horizontal jump points on the way.
+	const bool corner_cutting = diagonal_mode == DIAGONAL_MODE_ALWAYS || diagonal_mode == DIAGONAL_MODE_AT_LEAST_ONE_WALKABLE;
+
+	int x = r_x;
+	int y = r_y;
+
+	while (true) {
+		if (!_is_walkable(x, y)) {
+			return false;
+		}
+
+		if (x == p_end_x && y == p_end_y) {
+			break;
+		}
+
+		if (p_dx != 0) {
+			if (corner_cutting) {
+				if ((_is_walkable(x - p_dx, y + p_dy) && !_is_walkable(x - p_dx, y)) || (_is_walkable(x + p_dx, y - p_dy) && !_is_walkable(x, y - p_dy))) {
+					break;
+				}
+			}
+
+			int jump_x = x + p_dx;
+			int jump_y = y;
+			if (_jump(jump_x, jump_y, p_dx, 0, p_end_x, p_end_y)) {
+				break;
+			}
+
+			jump_x = x;
+			jump_y = y + p_dy;
+			if (_jump(jump_x, jump_y, 0, p_dy, p_end_x, p_end_y)) {
+				break;
+			}
+
+			if (diagonal_mode == DIAGONAL_MODE_ONLY_IF_NO_OBSTACLES && !(_is_walkable(x + p_dx, y) && _is_walkable(x, y + p_dy))) {
+				return false;
+			}
+			if (diagonal_mode == DIAGONAL_MODE_AT_LEAST_ONE_WALKABLE && !(_is_walkable(x + p_dx, y) || _is_walkable(x, y + p_dy))) {
+				return false;
+			}
+		} else {
+			if ((_is_walkable(x - 1, y) && !_is_walkable(x - 1, y - p_dy)) || (_is_walkable(x + 1, y) && !_is_walkable(x + 1, y - p_dy))) {
+				break;
+			}
+
+			int jump_x = x + 1;
+			int jump_y = y;
+			if (_jump(jump_x, jump_y, 1, 0, p_end_x, p_end_y)) {
+				break;
+			}
+
+			jump_x = x - 1;
+			if (_jump(jump_x, jump_y, -1, 0, p_end_x, p_end_y)) {
+				break;
+			}
+		}
+
+		x += p_dx;
+		y += p_dy;
+	}
+
+	r_x = x;
+	r_y = y;
+	return true;
+}
+
+// Directions worth jumping in from a cell reached while moving in p_dx, p_dy.
+int AStarGrid2D::_get_jump_directions(int p_x, int p_y, int p_dx, int p_dy, Vector2i *r_directions) const {
+	int count = 0;
+
+	if (p_dx == 0 && p_dy == 0) {
+		for (int i = 0; i < 8; i++) {
+			if (_can_move(p_x, p_y, _directions[i].x, _directions[i].y)) {
+				r_directions[count++] = _directions[i];
+			}
+		}
+		return count;
+	}
+
+	Vector2i candidates[5];
+	int candidate_count = 0;
+
+	if (diagonal_mode == DIAGONAL_MODE_ALWAYS || diagonal_mode == DIAGONAL_MODE_AT_LEAST_ONE_WALKABLE) {
+		if (p_dx != 0 && p_dy != 0) {
+			candidates[candidate_count++] = Vector2i(0, p_dy);
+			candidates[candidate_count++] = Vector2i(p_dx, 0);
+			candidates[candidate_count++] = Vector2i(p_dx, p_dy);
+			if (!_is_walkable(p_x - p_dx, p_y)) {
+				candidates[candidate_count++] = Vector2i(-p_dx, p_dy);
+			}
+			if (!_is_walkable(p_x, p_y - p_dy)) {
+				candidates[candidate_count++] = Vector2i(p_dx, -p_dy);
+			}
+		} else if (p_dx != 0) {
+			candidates[candidate_count++] = Vector2i(p_dx, 0);
+			if (!_is_walkable(p_x, p_y + 1)) {
+				candidates[candidate_count++] = Vector2i(p_dx, 1);
+			}
+			if (!_is_walkable(p_x, p_y - 1)) {
+				candidates[candidate_count++] = Vector2i(p_dx, -1);
+			}
+		} else {
+			candidates[candidate_count++] = Vector2i(0, p_dy);
+			if (!_is_walkable(p_x + 1, p_y)) {
+				candidates[candidate_count++] = Vector2i(1, p_dy);
+			}
+			if (!_is_walkable(p_x - 1, p_y)) {
+				candidates[candidate_count++] = Vector2i(-1, p_dy);
+			}
+		}
+	} else if (diagonal_mode == DIAGONAL_MODE_ONLY_IF_NO_OBSTACLES) {
+		if (p_dx != 0 && p_dy != 0) {
+			candidates[candidate_count++] = Vector2i(0, p_dy);
+			candidates[candidate_count++] = Vector2i(p_dx, 0);
+			candidates[candidate_count++] = Vector2i(p_dx, p_dy);
+		} else if (p_dx != 0) {
+			candidates[candidate_count++] = Vector2i(p_dx, 0);
+			candidates[candidate_count++] = Vector2i(p_dx, 1);
+			candidates[candidate_count++] = Vector2i(p_dx, -1);
+			candidates[candidate_count++] = Vector2i(0, 1);
+			candidates[candidate_count++] = Vector2i(0, -1);
+		} else {
+			candidates[candidate_count++] = Vector2i(0, p_dy);
+			candidates[candidate_count++] = Vector2i(1, p_dy);
+			candidates[candidate_count++] = Vector2i(-1, p_dy);
+			candidates[candidate_count++] = Vector2i(1, 0);
+			candidates[candidate_count++] = Vector2i(-1, 0);
+		}
+	} else {
+		if (p_dx != 0) {
+			candidates[candidate_count++] = Vector2i(p_dx, 0);
+			candidates[candidate_count++] = Vector2i(0, 1);
+			candidates[candidate_count++] = Vector2i(0, -1);
+		} else {
+			candidates[candidate_count++] = Vector2i(0, p_dy);
+			candidates[candidate_count++] = Vector2i(1, 0);
+			candidates[candidate_count++] = Vector2i(-1, 0);
+		}
+	}
+
+	for (int i = 0; i < candidate_count; i++) {
+		if (_can_move(p_x, p_y, candidates[i].x, candidates[i].y)) {
+			r_directions[count++] = candidates[i];
+		}
+	}
+
+	return count;
+}
+
+void AStarGrid2D::_open_cell(uint32_t p_cell, uint32_t p_prev_cell, real_t p_g_score, real_t p_f_score) {
+	CellState &state = cell_states[p_cell];
+
+	if (state.open_pass == pass && p_g_score >= state.g_score) { // The new path is worse than the previous.
+		return;
+	}
+
+	state.open_pass = pass;
+	state.g_score = p_g_score;
+	state.prev_cell = p_prev_cell;
+
+	// Improved cells are pushed again, the outdated entry is skipped when it gets popped.
+	OpenEntry entry;
+	entry.f_score = p_f_score;
+	entry.g_score = p_g_score;
+	entry.cell = p_cell;
+	open_list.push_back(entry);
+
+	SortArray<OpenEntry, SortOpenEntries> sorter;
+	sorter.push_heap(0, open_list.size() - 1, 0, entry, open_list.ptr());
+}
+
+bool AStarGrid2D::_solve(uint32_t p_from_cell, uint32_t p_to_cell) {
+	pass++;
+	if (unlikely(pass == 0)) {
+		for (uint32_t i = 0; i < cell_states.size(); i++) {
+			cell_states[i].open_pass = 0;
+			cell_states[i].closed_pass = 0;
+		}
+		pass = 1;
+	}
+
+	open_list.clear();
+
+	const bool use_jumping = jumping_enabled && weight_scales.empty();
+	const int end_x = (int)(p_to_cell % width);
+	const int end_y = (int)(p_to_cell / width);
+
+	SortArray<OpenEntry, SortOpenEntries> sorter;
+
+	_open_cell(p_from_cell, p_from_cell, 0, _estimate_cost(p_from_cell % width, p_from_cell / width, end_x, end_y));
+
+	while (!open_list.empty()) {
+		sorter.pop_heap(0, open_list.size(), open_list.ptr());
+		OpenEntry entry = open_list[open_list.size() - 1];
+		open_list.resize(open_list.size() - 1);
+
+		CellState &state = cell_states[entry.cell];
+		if (state.closed_pass == pass || entry.g_score > state.g_score) {
+			continue;
+		}
+
+		if (entry.cell == p_to_cell) {
+			return true;
+		}
+
+		state.closed_pass = pass;
+
+		const int x = (int)(entry.cell % width);
+		const int y = (int)(entry.cell / width);
+
+		if (use_jumping) {
+			const int prev_x = (int)(state.prev_cell % width);
+			const int prev_y = (int)(state.prev_cell / width);
+
+			Vector2i directions[8];
+			int direction_count = _get_jump_directions(x, y, _get_step(x - prev_x), _get_step(y - prev_y), directions);
+
+			for (int i = 0; i < direction_count; i++) {
+				int jump_x = x + directions[i].x;
+				int jump_y = y + directions[i].y;
+				if (!_jump(jump_x, jump_y, directions[i].x, directions[i].y, end_x, end_y)) {
+					continue;
+				}
+
+				uint32_t cell = _get_cell(jump_x, jump_y);
+				if (cell_states[cell].closed_pass == pass) {
+					continue;
+				}
+
+				real_t steps = (real_t)MAX(ABS(jump_x - x), ABS(jump_y - y));
+				real_t g_score = state.g_score + ((directions[i].x != 0 && directions[i].y != 0) ? steps * (real_t)Math_SQRT2 : steps);
+				_open_cell(cell, entry.cell, g_score, g_score + _estimate_cost(jump_x, jump_y, end_x, end_y));
+			}
+		} else {
+			const int direction_count = diagonal_mode == DIAGONAL_MODE_NEVER ? 4 : 8;
+
+			for (int i = 0; i < direction_count; i++) {
+				const Vector2i &direction = _directions[i];
+				if (!_can_move(x, y, direction.x, direction.y)) {
+					continue;
+				}
+
+				uint32_t cell = _get_cell(x + direction.x, y + direction.y);
+				if (cell_states[cell].closed_pass == pass) {
+					continue;
+				}
+
+				real_t cost = (i < 4) ? real_t(1) : (real_t)Math_SQRT2;
+				real_t g_score = state.g_score + cost * _get_weight_scale(cell);
+				_open_cell(cell, entry.cell, g_score, g_score + _estimate_cost(x + direction.x, y + direction.y, end_x, end_y));
+			}
+		}
+	}
+
+	return false;
+}
+
+void AStarGrid2D::_get_cell_path(uint32_t p_from_cell, uint32_t p_to_cell, LocalVector<Vector2i> &r_path) const {
+	uint32_t cell = p_to_cell;
+	r_path.push_back(_get_cell_id(cell));
+
+	while (cell != p_from_cell) {
+		uint32_t prev_cell = cell_states[cell].prev_cell;
+
+		// Jump points are connected by straight or diagonal lines, fill in the cells in between.
+		Vector2i to = _get_cell_id(cell);
+		Vector2i from = _get_cell_id(prev_cell);
+		Vector2i step = Vector2i(_get_step(from.x - to.x), _get_step(from.y - to.y));
+		for (Vector2i id = to + step; id != from; id += step) {
+			r_path.push_back(id);
+		}
+
+		r_path.push_back(from);
+		cell = prev_cell;
+	}
+
+	r_path.invert();
+}
+
+void AStarGrid2D::_build_flow_field(uint32_t p_to_cell, FlowField &r_flow_field) {
+	const uint32_t cell_count = (uint32_t)width * (uint32_t)height;
+	r_flow_field.distances.resize(cell_count);
+	r_flow_field.directions.resize(cell_count);
+	for (uint32_t i = 0; i < cell_count; i++) {
+		r_flow_field.distances[i] = FLT_MAX;
+		r_flow_field.directions[i] = FLOW_FIELD_NO_DIRECTION;
+	}
+
+	if (!_is_walkable((int)(p_to_cell % width), (int)(p_to_cell / width))) {
+		return;
+	}
+
+	// Dijkstra from the goal. A cell is reached from a neighbour by the move
+	// the other way around, which costs as much as a path would pay for it.
+	open_list.clear();
+	SortArray<OpenEntry, SortOpenEntries> sorter;
+
+	r_flow_field.distances[p_to_cell] = 0;
+
+	OpenEntry goal_entry;
+	goal_entry.f_score = 0;
+	goal_entry.g_score = 0;
+	goal_entry.cell = p_to_cell;
+	open_list.push_back(goal_entry);
+
+	const int direction_count = diagonal_mode == DIAGONAL_MODE_NEVER ? 4 : 8;
+
+	while (!open_list.empty()) {
+		sorter.pop_heap(0, open_list.size(), open_list.ptr());
+		OpenEntry entry = open_list[open_list.size() - 1];
+		open_list.resize(open_list.size() - 1);
+
+		if (entry.g_score > r_flow_field.distances[entry.cell]) {
+			continue;
+		}
+
+		const int x = (int)(entry.cell % width);
+		const int y = (int)(entry.cell / width);
+		const real_t weight_scale = _get_weight_scale(entry.cell);
+
+		for (int i = 0; i < direction_count; i++) {
+			const Vector2i &direction = _directions[i];
+			const int from_x = x - direction.x;
+			const int from_y = y - direction.y;
+			if (from_x < 0 || from_y < 0 || from_x >= width || from_y >= height || !_can_move(from_x, from_y, direction.x, direction.y)) {
+				continue;
+			}
+
+			const uint32_t from_cell = _get_cell(from_x, from_y);
+			const real_t cost = (i < 4) ? real_t(1) : (real_t)Math_SQRT2;
+			const real_t distance = entry.g_score + cost * weight_scale;
+			if (distance < r_flow_field.distances[from_cell]) {
+				r_flow_field.distances[from_cell] = distance;
+				r_flow_field.directions[from_cell] = (uint8_t)i;
+
+				// Like paths, the field leads out of a solid cell, but never through one.
+				if (!_is_walkable(from_x, from_y)) {
+					continue;
+				}
+
+				OpenEntry new_entry;
+				new_entry.f_score = distance;
+				new_entry.g_score = distance;
+				new_entry.cell = from_cell;
+				open_list.push_back(new_entry);
+				sorter.push_heap(0, open_list.size() - 1, 0, new_entry, open_list.ptr());
+			}
+		}
+	}
+}
+
+const AStarGrid2D::FlowField *AStarGrid2D::_get_flow_field(const Vector2i &p_to_id) {
+	FlowField *flow_field = flow_fields.getptr(p_to_id);
+	if (flow_field) {
+		flow_field->last_used = ++flow_fields_use_counter;
+		return flow_field;
+	}
+
+	if (flow_fields.size() >= MAX_FLOW_FIELDS) {
+		const HashMap<Vector2i, FlowField>::Element *least_used = flow_fields.front();
+		for (const HashMap<Vector2i, FlowField>::Element *E = least_used->next; E; E = E->next) {
+			if (E->value().last_used < least_used->value().last_used) {
+				least_used = E;
+			}
+		}
+		const Vector2i least_used_id = least_used->key();
+		flow_fields.erase(least_used_id);
+	}
+
+	flow_field = &flow_fields.insert(p_to_id, FlowField())->value();
+	flow_field->last_used = ++flow_fields_use_counter;
+	_build_flow_field(_get_cell(p_to_id.x - region.position.x, p_to_id.y - region.position.y), *flow_field);
+	return flow_field;
+}
+
+void AStarGrid2D::set_region(const Rect2i &p_region) {
+	ERR_FAIL_COND(p_region.size.x < 0 || p_region.size.y < 0);
+	if (p_region != region) {
+		region = p_region;
+		dirty = true;
+	}
+}
+
+Rect2i AStarGrid2D::get_region() const {
+	return region;
+}
+
+void AStarGrid2D::set_offset(const Vector2 &p_offset) {
+	offset = p_offset;
+}
+
+Vector2 AStarGrid2D::get_offset() const {
+	return offset;
+}
+
+void AStarGrid2D::set_cell_size(const Size2 &p_cell_size) {
+	cell_size = p_cell_size;
+}
+
+Size2 AStarGrid2D::get_cell_size() const {
+	return cell_size;
+}
+
+void AStarGrid2D::set_diagonal_mode(DiagonalMode p_diagonal_mode) {
+	ERR_FAIL_INDEX((int)p_diagonal_mode, (int)DIAGONAL_MODE_MAX);
+	diagonal_mode = p_diagonal_mode;
+	flow_fields.clear();
+}
+
+AStarGrid2D::DiagonalMode AStarGrid2D::get_diagonal_mode() const {
+	return diagonal_mode;
+}
+
+void AStarGrid2D::set_default_heuristic(Heuristic p_heuristic) {
+	ERR_FAIL_INDEX((int)p_heuristic, (int)HEURISTIC_MAX);
+	default_heuristic = p_heuristic;
+}
+
+AStarGrid2D::Heuristic AStarGrid2D::get_default_heuristic() const {
+	return default_heuristic;
+}
+
+void AStarGrid2D::set_jumping_enabled(bool p_enabled) {
+	jumping_enabled = p_enabled;
+}
+
+bool AStarGrid2D::is_jumping_enabled() const {
+	return jumping_enabled;
+}
+
+void AStarGrid2D::update() {
+	width = region.size.x;
+	height = region.size.y;
+
+	const uint32_t cell_count = (uint32_t)width * (uint32_t)height;
+
+	solid_mask.clear();
+	solid_mask.resize((cell_count + 63) / 64);
+	solid_mask_transposed.clear();
+	solid_mask_transposed.resize(solid_mask.size());
+	for (uint32_t i = 0; i < solid_mask.size(); i++) {
+		solid_mask[i] = 0;
+		solid_mask_transposed[i] = 0;
+	}
+
+	weight_scales.clear();
+	weighted_cell_count = 0;
+
+	cell_states.clear();
+	cell_states.resize(cell_count);
+	open_list.clear();
+	pass = 0;
+
+	flow_fields.clear();
+
+	dirty = false;
+}
+
+bool AStarGrid2D::is_dirty() const {
+	return dirty;
+}
+
+bool AStarGrid2D::is_in_bounds(const Vector2i &p_id) const {
+	return region.has_point(p_id);
+}
+
+void AStarGrid2D::set_point_solid(const Vector2i &p_id, bool p_solid) {
+	ERR_FAIL_COND_MSG(dirty, "Grid is not initialized. Call the update method.");
+	ERR_FAIL_COND_MSG(!is_in_bounds(p_id), vformat("Can't set if point is solid. Point %s out of bounds %s.", p_id, region));
+
+	const int x = p_id.x - region.position.x;
+	const int y = p_id.y - region.position.y;
+	const uint32_t cell = _get_cell(x, y);
+	const uint32_t transposed_cell = (uint32_t)(x * height + y);
+	flow_fields.clear();
+	if (p_solid) {
+		solid_mask[cell >> 6] |= uint64_t(1) << (cell & 63);
+		solid_mask_transposed[transposed_cell >> 6] |= uint64_t(1) << (transposed_cell & 63);
+	} else {
+		solid_mask[cell >> 6] &= ~(uint64_t(1) << (cell & 63));
+		solid_mask_transposed[transposed_cell >> 6] &= ~(uint64_t(1) << (transposed_cell & 63));
+	}
+}
+
+bool AStarGrid2D::is_point_solid(const Vector2i &p_id) const {
+	ERR_FAIL_COND_V_MSG(dirty, false, "Grid is not initialized. Call the update method.");
+	ERR_FAIL_COND_V_MSG(!is_in_bounds(p_id), false, vformat("Can't get if point is solid. Point %s out of bounds %s.", p_id, region));
+
+	return !_is_walkable(p_id.x - region.position.x, p_id.y - region.position.y);
+}
+
+void AStarGrid2D::set_point_weight_scale(const Vector2i &p_id, real_t p_weight_scale) {
+	ERR_FAIL_COND_MSG(dirty, "Grid is not initialized. Call the update method.");
+	ERR_FAIL_COND_MSG(!is_in_bounds(p_id), vformat("Can't set point's weight scale. Point %s out of bounds %s.", p_id, region));
+	ERR_FAIL_COND_MSG(p_weight_scale < 0.0, vformat("Can't set point's weight scale less than 0.0: %f.", p_weight_scale));
+
+	if (weight_scales.empty()) {
+		if (p_weight_scale == 1) {
+			return;
+		}
+
+		weight_scales.resize((uint32_t)width * (uint32_t)height);
+		for (uint32_t i = 0; i < weight_scales.size(); i++) {
+			weight_scales[i] = 1;
+		}
+	}
+
+	uint32_t cell = _get_cell(p_id.x - region.position.x, p_id.y - region.position.y);
+	real_t &weight_scale = weight_scales[cell];
+	flow_fields.clear();
+
+	if (weight_scale == 1 && p_weight_scale != 1) {
+		weighted_cell_count++;
+	} else if (weight_scale != 1 && p_weight_scale == 1) {
+		weighted_cell_count--;
+	}
+	weight_scale = p_weight_scale;
+
+	if (weighted_cell_count == 0) {
+		// Uniform again, which allows jumping.
+		weight_scales.clear();
+	}
+}
+
+real_t AStarGrid2D::get_point_weight_scale(const Vector2i &p_id) const {
+	ERR_FAIL_COND_V_MSG(dirty, 0, "Grid is not initialized. Call the update method.");
+	ERR_FAIL_COND_V_MSG(!is_in_bounds(p_id), 0, vformat("Can't get point's weight scale. Point %s out of bounds %s.", p_id, region));
+
+	return _get_weight_scale(_get_cell(p_id.x - region.position.x, p_id.y - region.position.y));
+}
+
+void AStarGrid2D::fill_solid_region(const Rect2i &p_region, bool p_solid) {
+	ERR_FAIL_COND_MSG(dirty, "Grid is not initialized. Call the update method.");
+
+	const Rect2i safe_region = p_region.intersection(region);
+	const Point2i end = safe_region.position + safe_region.size;
+
+	for (int y = safe_region.position.y; y < end.y; y++) {
+		for (int x = safe_region.position.x; x < end.x; x++) {
+			set_point_solid(Vector2i(x, y), p_solid);
+		}
+	}
+}
+
+void AStarGrid2D::fill_weight_scale_region(const Rect2i &p_region, real_t p_weight_scale) {
+	ERR_FAIL_COND_MSG(dirty, "Grid is not initialized. Call the update method.");
+	ERR_FAIL_COND_MSG(p_weight_scale < 0.0, vformat("Can't set point's weight scale less than 0.0: %f.", p_weight_scale));
+
+	const Rect2i safe_region = p_region.intersection(region);
+	const Point2i end = safe_region.position + safe_region.size;
+
+	for (int y = safe_region.position.y; y < end.y; y++) {
+		for (int x = safe_region.position.x; x < end.x; x++) {
+			set_point_weight_scale(Vector2i(x, y), p_weight_scale);
+		}
+	}
+}
+
+Vector2 AStarGrid2D::get_point_position(const Vector2i &p_id) const {
+	return offset + Vector2(p_id.x, p_id.y) * cell_size;
+}
+
+PoolVector<Vector2> AStarGrid2D::get_point_path(const Vector2i &p_from_id, const Vector2i &p_to_id) {
+	PoolVector<Vector2i> id_path = get_id_path(p_from_id, p_to_id);
+
+	PoolVector<Vector2> path;
+	path.resize(id_path.size());
+
+	{
+		PoolVector<Vector2i>::Read r = id_path.read();
+		PoolVector<Vector2>::Write w = path.write();
+		for (int i = 0; i < id_path.size(); i++) {
+			w[i] = get_point_position(r[i]);
+		}
+	}
+
+	return path;
+}
+
+PoolVector<Vector2i> AStarGrid2D::get_id_path(const Vector2i &p_from_id, const Vector2i &p_to_id) {
+	ERR_FAIL_COND_V_MSG(dirty, PoolVector<Vector2i>(), "Grid is not initialized. Call the update method.");
+	ERR_FAIL_COND_V_MSG(!is_in_bounds(p_from_id), PoolVector<Vector2i>(), vformat("Can't get id path. Point %s out of bounds %s.", p_from_id, region));
+	ERR_FAIL_COND_V_MSG(!is_in_bounds(p_to_id), PoolVector<Vector2i>(), vformat("Can't get id path. Point %s out of bounds %s.", p_to_id, region));
+
+	if (p_from_id == p_to_id) {
+		PoolVector<Vector2i> ret;
+		ret.push_back(p_from_id);
+		return ret;
+	}
+
+	const uint32_t from_cell = _get_cell(p_from_id.x - region.position.x, p_from_id.y - region.position.y);
+	const uint32_t to_cell = _get_cell(p_to_id.x - region.position.x, p_to_id.y - region.position.y);
+
+	if (!_is_walkable(p_to_id.x - region.position.x, p_to_id.y - region.position.y)) {
+		return PoolVector<Vector2i>();
+	}
+
+	if (!_solve(from_cell, to_cell)) {
+		return PoolVector<Vector2i>();
+	}
+
+	LocalVector<Vector2i> cell_path;
+	_get_cell_path(from_cell, to_cell, cell_path);
+
+	PoolVector<Vector2i> path;
+	path.resize(cell_path.size());
+
+	{
+		PoolVector<Vector2i>::Write w = path.write();
+		for (uint32_t i = 0; i < cell_path.size(); i++) {
+			w[i] = cell_path[i];
+		}
+	}
+
+	return path;
+}
+
+void AStarGrid2D::update_flow_field(const Vector2i &p_to_id) {
+	ERR_FAIL_COND_MSG(dirty, "Grid is not initialized. Call the update method.");
+	ERR_FAIL_COND_MSG(!is_in_bounds(p_to_id), vformat("Can't update flow field. Point %s out of bounds %s.", p_to_id, region));
+
+	_get_flow_field(p_to_id);
+}
+
+Vector2i AStarGrid2D::get_flow_direction(const Vector2i &p_from_id, const Vector2i &p_to_id) {
+	ERR_FAIL_COND_V_MSG(dirty, Vector2i(), "Grid is not initialized. Call the update method.");
+	ERR_FAIL_COND_V_MSG(!is_in_bounds(p_from_id), Vector2i(), vformat("Can't get flow direction. Point %s out of bounds %s.", p_from_id, region));
+	ERR_FAIL_COND_V_MSG(!is_in_bounds(p_to_id), Vector2i(), vformat("Can't get flow direction. Point %s out of bounds %s.", p_to_id, region));
+
+	const FlowField *flow_field = _get_flow_field(p_to_id);
+	const uint8_t direction = flow_field->directions[_get_cell(p_from_id.x - region.position.x, p_from_id.y - region.position.y)];
+	if (direction == FLOW_FIELD_NO_DIRECTION) {
+		return Vector2i();
+	}
+
+	return _directions[direction];
+}
+
+real_t AStarGrid2D::get_flow_distance(const Vector2i &p_from_id, const Vector2i &p_to_id) {
+	ERR_FAIL_COND_V_MSG(dirty, -1, "Grid is not initialized. Call the update method.");
+	ERR_FAIL_COND_V_MSG(!is_in_bounds(p_from_id), -1, vformat("Can't get flow distance. Point %s out of bounds %s.", p_from_id, region));
+	ERR_FAIL_COND_V_MSG(!is_in_bounds(p_to_id), -1, vformat("Can't get flow distance. Point %s out of bounds %s.", p_to_id, region));
+
+	if (p_from_id == p_to_id) {
+		return 0;
+	}
+
+	const FlowField *flow_field = _get_flow_field(p_to_id);
+	const real_t distance = flow_field->distances[_get_cell(p_from_id.x - region.position.x, p_from_id.y - region.position.y)];
+	if (distance == FLT_MAX) {
+		return -1;
+	}
+
+	return distance;
+}
+
+void AStarGrid2D::clear_flow_fields() {
+	flow_fields.clear();
+}
+
+int AStarGrid2D::get_flow_field_count() const {
+	return flow_fields.size();
+}
+
+void AStarGrid2D::clear() {
+	region = Rect2i();
+	width = 0;
+	height = 0;
+
+	solid_mask.clear();
+	solid_mask_transposed.clear();
+	weight_scales.clear();
+	weighted_cell_count = 0;
+	cell_states.clear();
+	open_list.clear();
+	pass = 0;
+
+	flow_fields.clear();
+
+	dirty = false;
+}
+
+void AStarGrid2D::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("set_region", "region"), &AStarGrid2D::set_region);
+	ClassDB::bind_method(D_METHOD("get_region"), &AStarGrid2D::get_region);
+	ClassDB::bind_method(D_METHOD("set_offset", "offset"), &AStarGrid2D::set_offset);
+	ClassDB::bind_method(D_METHOD("get_offset"), &AStarGrid2D::get_offset);
+	ClassDB::bind_method(D_METHOD("set_cell_size", "cell_size"), &AStarGrid2D::set_cell_size);
+	ClassDB::bind_method(D_METHOD("get_cell_size"), &AStarGrid2D::get_cell_size);
+	ClassDB::bind_method(D_METHOD("set_diagonal_mode", "mode"), &AStarGrid2D::set_diagonal_mode);
+	ClassDB::bind_method(D_METHOD("get_diagonal_mode"), &AStarGrid2D::get_diagonal_mode);
+	ClassDB::bind_method(D_METHOD("set_default_heuristic", "heuristic"), &AStarGrid2D::set_default_heuristic);
+	ClassDB::bind_method(D_METHOD("get_default_heuristic"), &AStarGrid2D::get_default_heuristic);
+	ClassDB::bind_method(D_METHOD("set_jumping_enabled", "enabled"), &AStarGrid2D::set_jumping_enabled);
+	ClassDB::bind_method(D_METHOD("is_jumping_enabled"), &AStarGrid2D::is_jumping_enabled);
+
+	ClassDB::bind_method(D_METHOD("update"), &AStarGrid2D::update);
+	ClassDB::bind_method(D_METHOD("is_dirty"), &AStarGrid2D::is_dirty);
+	ClassDB::bind_method(D_METHOD("is_in_bounds", "id"), &AStarGrid2D::is_in_bounds);
+
+	ClassDB::bind_method(D_METHOD("set_point_solid", "id", "solid"), &AStarGrid2D::set_point_solid, DEFVAL(true));
+	ClassDB::bind_method(D_METHOD("is_point_solid", "id"), &AStarGrid2D::is_point_solid);
+	ClassDB::bind_method(D_METHOD("set_point_weight_scale", "id", "weight_scale"), &AStarGrid2D::set_point_weight_scale);
+	ClassDB::bind_method(D_METHOD("get_point_weight_scale", "id"), &AStarGrid2D::get_point_weight_scale);
+	ClassDB::bind_method(D_METHOD("fill_solid_region", "region", "solid"), &AStarGrid2D::fill_solid_region, DEFVAL(true));
+	ClassDB::bind_method(D_METHOD("fill_weight_scale_region", "region", "weight_scale"), &AStarGrid2D::fill_weight_scale_region);
+
+	ClassDB::bind_method(D_METHOD("get_point_position", "id"), &AStarGrid2D::get_point_position);
+	ClassDB::bind_method(D_METHOD("get_point_path", "from_id", "to_id"), &AStarGrid2D::get_point_path);
+	ClassDB::bind_method(D_METHOD("get_id_path", "from_id", "to_id"), &AStarGrid2D::get_id_path);
+
+	ClassDB::bind_method(D_METHOD("update_flow_field", "to_id"), &AStarGrid2D::update_flow_field);
+	ClassDB::bind_method(D_METHOD("get_flow_direction", "from_id", "to_id"), &AStarGrid2D::get_flow_direction);
+	ClassDB::bind_method(D_METHOD("get_flow_distance", "from_id", "to_id"), &AStarGrid2D::get_flow_distance);
+	ClassDB::bind_method(D_METHOD("clear_flow_fields"), &AStarGrid2D::clear_flow_fields);
+	ClassDB::bind_method(D_METHOD("get_flow_field_count"), &AStarGrid2D::get_flow_field_count);
+
+	ClassDB::bind_method(D_METHOD("clear"), &AStarGrid2D::clear);
+
+	ADD_PROPERTY(PropertyInfo(Variant::RECT2I, "region"), "set_region", "get_region");
+	ADD_PROPERTY(PropertyInfo(Variant::VECTOR2, "offset"), "set_offset", "get_offset");
+	ADD_PROPERTY(PropertyInfo(Variant::VECTOR2, "cell_size"), "set_cell_size", "get_cell_size");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "diagonal_mode", PROPERTY_HINT_ENUM, "Always,Never,At Least One Walkable,Only If No Obstacles"), "set_diagonal_mode", "get_diagonal_mode");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "default_heuristic", PROPERTY_HINT_ENUM, "Euclidean,Manhattan,Octile,Chebyshev"), "set_default_heuristic", "get_default_heuristic");
+	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "jumping_enabled"), "set_jumping_enabled", "is_jumping_enabled");
+
+	BIND_ENUM_CONSTANT(DIAGONAL_MODE_ALWAYS);
+	BIND_ENUM_CONSTANT(DIAGONAL_MODE_NEVER);
+	BIND_ENUM_CONSTANT(DIAGONAL_MODE_AT_LEAST_ONE_WALKABLE);
+	BIND_ENUM_CONSTANT(DIAGONAL_MODE_ONLY_IF_NO_OBSTACLES);
+	BIND_ENUM_CONSTANT(DIAGONAL_MODE_MAX);
+
+	BIND_ENUM_CONSTANT(HEURISTIC_EUCLIDEAN);
+	BIND_ENUM_CONSTANT(HEURISTIC_MANHATTAN);
+	BIND_ENUM_CONSTANT(HEURISTIC_OCTILE);
+	BIND_ENUM_CONSTANT(HEURISTIC_CHEBYSHEV);
+	BIND_ENUM_CONSTANT(HEURISTIC_MAX);
+}
+
+AStarGrid2D::AStarGrid2D() {
+	cell_size = Size2(1, 1);
+	diagonal_mode = DIAGONAL_MODE_ALWAYS;
+	default_heuristic = HEURISTIC_EUCLIDEAN;
+	jumping_enabled = false;
+	dirty = false;
+
+	width = 0;
+	height = 0;
+	weighted_cell_count = 0;
+	pass = 0;
+	flow_fields_use_counter = 0;
+}
+
+AStarGrid2D::~AStarGrid2D() {
+}
@@ -0,0 +1,228 @@
+#ifndef A_STAR_GRID_2D_H
+#define A_STAR_GRID_2D_H
+
+/*************************************************************************/
+/*  a_star_grid_2d.h                                                     */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "core/containers/local_vector.h"
+#include "core/containers/hash_map.h"
+#include "core/math/rect2.h"
+#include "core/math/rect2i.h"
+#include "core/math/vector2i.h"
+#include "core/object/reference.h"
+
+/**
+	A* pathfinding on a dense grid, with optional jump point search.
+
+	Cells are addressed by their coordinates inside the region. Solidity is
+	stored as a bitset and weights only once a cell gets a non default one,
+	so large tile maps don't need a point object per cell like AStar2D.
+*/
+
+class AStarGrid2D : public Reference {
+	GDCLASS(AStarGrid2D, Reference);
+
+public:
+	enum DiagonalMode {
+		DIAGONAL_MODE_ALWAYS = 0,
+		DIAGONAL_MODE_NEVER,
+		DIAGONAL_MODE_AT_LEAST_ONE_WALKABLE,
+		DIAGONAL_MODE_ONLY_IF_NO_OBSTACLES,
+		DIAGONAL_MODE_MAX,
+	};
+
+	enum Heuristic {
+		HEURISTIC_EUCLIDEAN = 0,
+		HEURISTIC_MANHATTAN,
+		HEURISTIC_OCTILE,
+		HEURISTIC_CHEBYSHEV,
+		HEURISTIC_MAX,
+	};
+
+private:
+	struct CellState {
+		real_t g_score = 0;
+		uint32_t prev_cell = 0;
+		uint32_t open_pass = 0;
+		uint32_t closed_pass = 0;
+	};
+
+	struct OpenEntry {
+		real_t f_score;
+		real_t g_score;
+		uint32_t cell;
+	};
+
+	struct SortOpenEntries {
+		// Returns true when A is worse than B, the heap functions of SortArray keep the best one on top.
+		_FORCE_INLINE_ bool operator()(const OpenEntry &A, const OpenEntry &B) const {
+			if (A.f_score > B.f_score) {
+				return true;
+			} else if (A.f_score < B.f_score) {
+				return false;
+			} else {
+				return A.g_score < B.g_score; // If the f_costs are the same then prioritize the points that are further away from the start.
+			}
+		}
+	};
+
+	Rect2i region;
+	Vector2 offset;
+	Size2 cell_size;
+	DiagonalMode diagonal_mode;
+	Heuristic default_heuristic;
+	bool jumping_enabled;
+	bool dirty;
+
+	int width;
+	int height;
+
+	// One bit per cell, row by row. The transposed copy goes column by column, so vertical
+	// jumps can scan it 64 cells at a time like horizontal ones.
+	LocalVector<uint64_t> solid_mask;
+	LocalVector<uint64_t> solid_mask_transposed;
+	// Empty while every cell has the default weight scale of 1.
+	LocalVector<real_t> weight_scales;
+	uint32_t weighted_cell_count;
+
+	LocalVector<CellState> cell_states;
+	LocalVector<OpenEntry> open_list;
+	uint32_t pass;
+
+	// Cost to reach one goal cell from every cell, with the move to make from each of them.
+	// Built on first use and dropped when the solid cells or the weights change. At most
+	// MAX_FLOW_FIELDS are kept, the least recently used one makes room for a new goal, so
+	// goals that keep moving don't pile up.
+	struct FlowField {
+		LocalVector<real_t> distances;
+		// Index in the direction table, FLOW_FIELD_NO_DIRECTION at the goal and where it can't be reached.
+		LocalVector<uint8_t> directions;
+		// Value of flow_fields_use_counter when it was last used.
+		uint64_t last_used;
+	};
+
+	enum {
+		FLOW_FIELD_NO_DIRECTION = 0xFF,
+		MAX_FLOW_FIELDS = 16,
+	};
+
+	HashMap<Vector2i, FlowField> flow_fields;
+	uint64_t flow_fields_use_counter;
+
+	_FORCE_INLINE_ uint32_t _get_cell(int p_x, int p_y) const { return (uint32_t)(p_y * width + p_x); }
+	_FORCE_INLINE_ Vector2i _get_cell_id(uint32_t p_cell) const { return Vector2i(region.position.x + (int)(p_cell % width), region.position.y + (int)(p_cell / width)); }
+
+	// Coordinates relative to the region, anything outside of it counts as solid.
+	_FORCE_INLINE_ bool _is_walkable(int p_x, int p_y) const {
+		if (p_x < 0 || p_y < 0 || p_x >= width || p_y >= height) {
+			return false;
+		}
+		uint32_t cell = _get_cell(p_x, p_y);
+		return !(solid_mask[cell >> 6] & (uint64_t(1) << (cell & 63)));
+	}
+
+	_FORCE_INLINE_ real_t _get_weight_scale(uint32_t p_cell) const {
+		return weight_scales.empty() ? real_t(1) : weight_scales[p_cell];
+	}
+
+	bool _can_move(int p_x, int p_y, int p_dx, int p_dy) const;
+	real_t _estimate_cost(int p_from_x, int p_from_y, int p_to_x, int p_to_y) const;
+
+	uint64_t _get_line_bits(const LocalVector<uint64_t> &p_mask, int p_line_length, int p_line_count, int p_line, int p_start) const;
+	uint64_t _get_scan_bits(const LocalVector<uint64_t> &p_mask, int p_line_length, int p_line_count, int p_line, int p_pos, int p_dir, int p_steps) const;
+	bool _jump_straight(const LocalVector<uint64_t> &p_mask, int p_line_length, int p_line_count, int p_line, int &r_pos, int p_dir, int p_end_line, int p_end_pos) const;
+	bool _jump(int &r_x, int &r_y, int p_dx, int p_dy, int p_end_x, int p_end_y) const;
+	int _get_jump_directions(int p_x, int p_y, int p_dx, int p_dy, Vector2i *r_directions) const;
+
+	void _open_cell(uint32_t p_cell, uint32_t p_prev_cell, real_t p_g_score, real_t p_f_score);
+	bool _solve(uint32_t p_from_cell, uint32_t p_to_cell);
+	void _get_cell_path(uint32_t p_from_cell, uint32_t p_to_cell, LocalVector<Vector2i> &r_path) const;
+
+	void _build_flow_field(uint32_t p_to_cell, FlowField &r_flow_field);
+	const FlowField *_get_flow_field(const Vector2i &p_to_id);
+
+protected:
+	static void _bind_methods();
+
+public:
+	void set_region(const Rect2i &p_region);
+	Rect2i get_region() const;
+
+	void set_offset(const Vector2 &p_offset);
+	Vector2 get_offset() const;
+
+	void set_cell_size(const Size2 &p_cell_size);
+	Size2 get_cell_size() const;
+
+	void set_diagonal_mode(DiagonalMode p_diagonal_mode);
+	DiagonalMode get_diagonal_mode() const;
+
+	void set_default_heuristic(Heuristic p_heuristic);
+	Heuristic get_default_heuristic() const;
+
+	void set_jumping_enabled(bool p_enabled);
+	bool is_jumping_enabled() const;
+
+	void update();
+	bool is_dirty() const;
+
+	bool is_in_bounds(const Vector2i &p_id) const;
+
+	void set_point_solid(const Vector2i &p_id, bool p_solid = true);
+	bool is_point_solid(const Vector2i &p_id) const;
+
+	void set_point_weight_scale(const Vector2i &p_id, real_t p_weight_scale);
+	real_t get_point_weight_scale(const Vector2i &p_id) const;
+
+	void fill_solid_region(const Rect2i &p_region, bool p_solid = true);
+	void fill_weight_scale_region(const Rect2i &p_region, real_t p_weight_scale);
+
+	Vector2 get_point_position(const Vector2i &p_id) const;
+
+	PoolVector<Vector2> get_point_path(const Vector2i &p_from_id, const Vector2i &p_to_id);
+	PoolVector<Vector2i> get_id_path(const Vector2i &p_from_id, const Vector2i &p_to_id);
+
+	void update_flow_field(const Vector2i &p_to_id);
+	Vector2i get_flow_direction(const Vector2i &p_from_id, const Vector2i &p_to_id);
+	real_t get_flow_distance(const Vector2i &p_from_id, const Vector2i &p_to_id);
+	void clear_flow_fields();
+	int get_flow_field_count() const;
+
+	void clear();
+
+	AStarGrid2D();
+	~AStarGrid2D();
+};
+
+VARIANT_ENUM_CAST(AStarGrid2D::DiagonalMode);
+VARIANT_ENUM_CAST(AStarGrid2D::Heuristic);
+
+#endif // A_STAR_GRID_2D_H
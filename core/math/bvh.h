@@ -54,6 +54,7 @@
 
 #include "bvh_tree.h"
 #include "core/os/mutex.h"
+#include "core/os/thread_work_pool.h"
 
 #define BVHTREE_CLASS BVH_Tree<T, NUM_TREES, 2, MAX_ITEMS, USER_PAIR_TEST_FUNCTION, USER_CULL_TEST_FUNCTION, USE_PAIRS, BOUNDS, POINT>
 #define BVH_LOCKED_FUNCTION BVHLockedFunction _lock_guard(&_mutex, BVH_THREAD_SAFE &&_thread_safe);
@@ -72,6 +73,14 @@ public:
 		_thread_safe = p_enable;
 	}
 
+	// Finds the pairs of moved items on p_work_pool, when there are enough of them (null to disable).
+	// The pool is owned by the caller and can be shared, it's initialized on first use.
+	// Only set it if the user cull test function can be called from several threads.
+	void params_set_pairing_work_pool(ThreadWorkPool *p_work_pool) {
+		BVH_LOCKED_FUNCTION
+		_pairing_work_pool = p_work_pool;
+	}
+
 	// these 2 are crucial for fine tuning, and can be applied manually
 	// see the variable declarations for more info.
 	void params_set_node_expansion(real_t p_value) {
@@ -428,6 +437,14 @@ private:
 			return;
 		}
 
+#ifndef NO_THREADS
+		// The pool can be busy when it's shared and the update was triggered from one of its jobs.
+		if (_pairing_work_pool && !_pairing_work_pool->is_working() && changed_items.size() > PAIRING_BATCH_SIZE) {
+			_check_for_collisions_threaded(p_full_check);
+			return;
+		}
+#endif
+
 		BOUNDS bb;
 
 		typename BVHTREE_CLASS::CullParams params;
@@ -477,6 +494,88 @@ private:
 		_reset();
 	}
 
+#ifndef NO_THREADS
+	// Culls a batch of changed items against the tree, into the batch's own hit list.
+	// Runs on the pairing work pool, so must not modify the tree or the pairs.
+	void _pairing_cull_batch(uint32_t p_batch, void *p_userdata) {
+		PairingBatch &batch = _pairing_batches[p_batch];
+		batch.hits.clear();
+		batch.hit_counts.clear();
+
+		typename BVHTREE_CLASS::CullParams params;
+
+		params.result_count_overall = 0;
+		params.result_max = INT_MAX;
+		params.result_array = nullptr;
+		params.subindex_array = nullptr;
+
+		uint32_t from = p_batch * PAIRING_BATCH_SIZE;
+		uint32_t to = MIN(from + PAIRING_BATCH_SIZE, changed_items.size());
+
+		for (uint32_t n = from; n < to; n++) {
+			const BVHHandle &h = changed_items[n];
+
+			BVHABB_CLASS abb;
+			abb.from(tree._pairs[h.id()].expanded_aabb);
+
+			tree.item_fill_cullparams(h, params);
+			params.abb = abb;
+
+			batch.hit_counts.push_back(tree.cull_aabb_to(params, batch.hits));
+		}
+	}
+
+	// Same as the serial path, except that the culling is done up front in parallel.
+	// The hits are then processed in changed item order on this thread,
+	// so the pair and unpair callbacks fire in the same order as in the serial path.
+	void _check_for_collisions_threaded(bool p_full_check) {
+		uint32_t num_batches = (changed_items.size() + PAIRING_BATCH_SIZE - 1) / PAIRING_BATCH_SIZE;
+		if (_pairing_batches.size() < num_batches) {
+			_pairing_batches.resize(num_batches);
+		}
+
+		if (_pairing_work_pool->get_thread_count() == 0) {
+			_pairing_work_pool->init();
+		}
+		_pairing_work_pool->do_work(num_batches, this, &BVH_Manager::_pairing_cull_batch, (void *)nullptr);
+
+		for (uint32_t b = 0; b < num_batches; b++) {
+			const PairingBatch &batch = _pairing_batches[b];
+			uint32_t first_item = b * PAIRING_BATCH_SIZE;
+			uint32_t hit_id = 0;
+
+			for (uint32_t i = 0; i < batch.hit_counts.size(); i++) {
+				const BVHHandle &h = changed_items[first_item + i];
+				uint32_t changed_item_ref_id = h.id();
+
+				BVHABB_CLASS abb;
+				abb.from(tree._pairs[changed_item_ref_id].expanded_aabb);
+
+				// find all the existing paired aabbs that are no longer
+				// paired, and send callbacks
+				_find_leavers(h, abb, p_full_check);
+
+				uint32_t hits_end = hit_id + batch.hit_counts[i];
+				for (; hit_id < hits_end; hit_id++) {
+					uint32_t ref_id = batch.hits[hit_id];
+
+					// don't collide against ourself
+					if (ref_id == changed_item_ref_id) {
+						continue;
+					}
+
+					BVHHandle h_collidee;
+					h_collidee.set_id(ref_id);
+
+					// find NEW enterers, and send callbacks for them only
+					_collide(h, h_collidee);
+				}
+			}
+		}
+		_reset();
+	}
+#endif
+
 public:
 	void item_get_AABB(BVHHandle p_handle, BOUNDS &r_aabb) {
 		BVHABB_CLASS abb;
@@ -801,6 +900,20 @@ private:
 	// local toggle for turning on and off thread safety in project settings
 	bool _thread_safe;
 
+	// parallel pair finding for the changed items
+	enum {
+		PAIRING_BATCH_SIZE = 64,
+	};
+
+	struct PairingBatch {
+		LocalVector<uint32_t, uint32_t, true> hits;
+		// number of hits for each changed item of the batch
+		LocalVector<uint32_t, uint32_t, true> hit_counts;
+	};
+
+	LocalVector<PairingBatch> _pairing_batches;
+	ThreadWorkPool *_pairing_work_pool;
+
 public:
 	BVH_Manager() {
 		_tick = 1; // start from 1 so items with 0 indicate never updated
@@ -809,6 +922,7 @@ public:
 		pair_callback_userdata = nullptr;
 		unpair_callback_userdata = nullptr;
 		_thread_safe = BVH_THREAD_SAFE;
+		_pairing_work_pool = nullptr;
 	}
 };
 
@@ -0,0 +1,338 @@
+#ifndef BVH_LEAF_BOUNDS_H
+#define BVH_LEAF_BOUNDS_H
+
+/*************************************************************************/
+/*  bvh_leaf_bounds.h                                                    */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+// Leaf bounds stored as structure of arrays, one array per axis, so that
+// the hot leaf loops can test 4 items at a time with SSE or NEON.
+// The scalar versions of the tests are always available, and are used
+// when SIMD is unavailable, disabled with BVH_SIMD_DISABLED, or when
+// real_t is double.
+
+#if !defined(BVH_SIMD_DISABLED) && !defined(REAL_T_IS_DOUBLE)
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BVH_SIMD_SSE
+#define BVH_SIMD
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BVH_SIMD_NEON
+#define BVH_SIMD
+#endif
+#endif
+
+#ifdef BVH_SIMD
+// thin wrapper over the 4 wide float instructions needed by the leaf tests
+struct BVH_SIMD4 {
+#ifdef BVH_SIMD_SSE
+	typedef __m128 Float;
+	typedef __m128 Mask;
+
+	static _FORCE_INLINE_ Float load(const float *p_ptr) { return _mm_loadu_ps(p_ptr); }
+	static _FORCE_INLINE_ Float set(float p_value) { return _mm_set1_ps(p_value); }
+	static _FORCE_INLINE_ Float add(Float p_a, Float p_b) { return _mm_add_ps(p_a, p_b); }
+	static _FORCE_INLINE_ Float sub(Float p_a, Float p_b) { return _mm_sub_ps(p_a, p_b); }
+	static _FORCE_INLINE_ Float mul(Float p_a, Float p_b) { return _mm_mul_ps(p_a, p_b); }
+	static _FORCE_INLINE_ Mask greater(Float p_a, Float p_b) { return _mm_cmpgt_ps(p_a, p_b); }
+	static _FORCE_INLINE_ Mask less(Float p_a, Float p_b) { return _mm_cmplt_ps(p_a, p_b); }
+	static _FORCE_INLINE_ Mask mask_or(Mask p_a, Mask p_b) { return _mm_or_ps(p_a, p_b); }
+	static _FORCE_INLINE_ Mask mask_none() { return _mm_setzero_ps(); }
+	static _FORCE_INLINE_ uint32_t mask_bits(Mask p_mask) { return _mm_movemask_ps(p_mask); }
+#else
+	typedef float32x4_t Float;
+	typedef uint32x4_t Mask;
+
+	static _FORCE_INLINE_ Float load(const float *p_ptr) { return vld1q_f32(p_ptr); }
+	static _FORCE_INLINE_ Float set(float p_value) { return vdupq_n_f32(p_value); }
+	static _FORCE_INLINE_ Float add(Float p_a, Float p_b) { return vaddq_f32(p_a, p_b); }
+	static _FORCE_INLINE_ Float sub(Float p_a, Float p_b) { return vsubq_f32(p_a, p_b); }
+	static _FORCE_INLINE_ Float mul(Float p_a, Float p_b) { return vmulq_f32(p_a, p_b); }
+	static _FORCE_INLINE_ Mask greater(Float p_a, Float p_b) { return vcgtq_f32(p_a, p_b); }
+	static _FORCE_INLINE_ Mask less(Float p_a, Float p_b) { return vcltq_f32(p_a, p_b); }
+	static _FORCE_INLINE_ Mask mask_or(Mask p_a, Mask p_b) { return vorrq_u32(p_a, p_b); }
+	static _FORCE_INLINE_ Mask mask_none() { return vdupq_n_u32(0); }
+	static _FORCE_INLINE_ uint32_t mask_bits(Mask p_mask) {
+		static const uint32_t lane_bits[4] = { 1, 2, 4, 8 };
+		uint32x4_t bits = vandq_u32(p_mask, vld1q_u32(lane_bits));
+		uint32x2_t halves = vorr_u32(vget_low_u32(bits), vget_high_u32(bits));
+		return vget_lane_u32(halves, 0) | vget_lane_u32(halves, 1);
+	}
+#endif
+};
+#endif
+
+template <class BOUNDS, class POINT, int MAX_ITEMS>
+struct BVH_LeafBounds {
+	typedef BVH_ABB<BOUNDS, POINT> ABB;
+
+	enum {
+		LANES = 4,
+		LANE_MASK = (1 << LANES) - 1,
+		// rounded up so a full group of lanes can always be loaded
+		PADDED_ITEMS = (MAX_ITEMS + LANES - 1) & ~(LANES - 1),
+	};
+
+	// same representation as BVH_ABB, mins and negated maxs
+	real_t mins[POINT::AXIS_COUNT][PADDED_ITEMS];
+	real_t neg_maxs[POINT::AXIS_COUNT][PADDED_ITEMS];
+
+	void set(uint32_t p_id, const ABB &p_abb) {
+		for (int axis = 0; axis < POINT::AXIS_COUNT; ++axis) {
+			mins[axis][p_id] = p_abb.min[axis];
+			neg_maxs[axis][p_id] = p_abb.neg_max[axis];
+		}
+	}
+
+	ABB get(uint32_t p_id) const {
+		ABB abb;
+		for (int axis = 0; axis < POINT::AXIS_COUNT; ++axis) {
+			abb.min[axis] = mins[axis][p_id];
+			abb.neg_max[axis] = neg_maxs[axis][p_id];
+		}
+		return abb;
+	}
+
+	void move(uint32_t p_to, uint32_t p_from) {
+		for (int axis = 0; axis < POINT::AXIS_COUNT; ++axis) {
+			mins[axis][p_to] = mins[axis][p_from];
+			neg_maxs[axis][p_to] = neg_maxs[axis][p_from];
+		}
+	}
+
+	// All the find functions write the ids of the hit items to r_hits
+	// (which must hold p_count ids) in ascending order, and return the number of hits.
+	uint32_t find_intersecting(uint32_t p_count, const ABB &p_abb, uint32_t *r_hits) const {
+#ifdef BVH_SIMD
+		return find_intersecting_simd(p_count, p_abb, r_hits);
+#else
+		return find_intersecting_scalar(p_count, p_abb, r_hits);
+#endif
+	}
+
+	uint32_t find_containing_point(uint32_t p_count, const POINT &p_point, uint32_t *r_hits) const {
+#ifdef BVH_SIMD
+		return find_containing_point_simd(p_count, p_point, r_hits);
+#else
+		return find_containing_point_scalar(p_count, p_point, r_hits);
+#endif
+	}
+
+	uint32_t find_intersecting_segment(uint32_t p_count, const typename ABB::Segment &p_segment, uint32_t *r_hits) const {
+#ifdef BVH_SIMD
+		return find_intersecting_segment_simd(p_count, p_segment, r_hits);
+#else
+		return find_intersecting_segment_scalar(p_count, p_segment, r_hits);
+#endif
+	}
+
+	uint32_t find_intersecting_convex(uint32_t p_count, const typename ABB::ConvexHull &p_hull, const uint32_t *p_plane_ids, uint32_t p_num_planes, uint32_t *r_hits) const {
+#ifdef BVH_SIMD
+		return find_intersecting_convex_simd(p_count, p_hull, p_plane_ids, p_num_planes, r_hits);
+#else
+		return find_intersecting_convex_scalar(p_count, p_hull, p_plane_ids, p_num_planes, r_hits);
+#endif
+	}
+
+	uint32_t find_intersecting_scalar(uint32_t p_count, const ABB &p_abb, uint32_t *r_hits) const {
+		// pre-swizzled, as in the original leaf loop
+		ABB swizzled_tester;
+		swizzled_tester.min = -p_abb.neg_max;
+		swizzled_tester.neg_max = -p_abb.min;
+
+		uint32_t num_hits = 0;
+		for (uint32_t n = 0; n < p_count; n++) {
+			if (swizzled_tester.intersects_swizzled(get(n))) {
+				r_hits[num_hits++] = n;
+			}
+		}
+		return num_hits;
+	}
+
+	uint32_t find_containing_point_scalar(uint32_t p_count, const POINT &p_point, uint32_t *r_hits) const {
+		uint32_t num_hits = 0;
+		for (uint32_t n = 0; n < p_count; n++) {
+			if (get(n).intersects_point(p_point)) {
+				r_hits[num_hits++] = n;
+			}
+		}
+		return num_hits;
+	}
+
+	uint32_t find_intersecting_segment_scalar(uint32_t p_count, const typename ABB::Segment &p_segment, uint32_t *r_hits) const {
+		uint32_t num_hits = 0;
+		for (uint32_t n = 0; n < p_count; n++) {
+			if (get(n).intersects_segment(p_segment)) {
+				r_hits[num_hits++] = n;
+			}
+		}
+		return num_hits;
+	}
+
+	uint32_t find_intersecting_convex_scalar(uint32_t p_count, const typename ABB::ConvexHull &p_hull, const uint32_t *p_plane_ids, uint32_t p_num_planes, uint32_t *r_hits) const {
+		uint32_t num_hits = 0;
+		for (uint32_t n = 0; n < p_count; n++) {
+			if (get(n).intersects_convex_optimized(p_hull, p_plane_ids, p_num_planes)) {
+				r_hits[num_hits++] = n;
+			}
+		}
+		return num_hits;
+	}
+
+#ifdef BVH_SIMD
+	_FORCE_INLINE_ static uint32_t _write_hits(uint32_t p_first, uint32_t p_count, uint32_t p_miss_bits, uint32_t *r_hits, uint32_t p_num_hits) {
+		uint32_t hit_bits = ~p_miss_bits & LANE_MASK;
+
+		// the lanes past the last item contain garbage
+		if (p_first + LANES > p_count) {
+			hit_bits &= (1 << (p_count - p_first)) - 1;
+		}
+
+		for (uint32_t lane = 0; hit_bits; lane++, hit_bits >>= 1) {
+			if (hit_bits & 1) {
+				r_hits[p_num_hits++] = p_first + lane;
+			}
+		}
+		return p_num_hits;
+	}
+
+	uint32_t find_intersecting_simd(uint32_t p_count, const ABB &p_abb, uint32_t *r_hits) const {
+		typedef BVH_SIMD4 S;
+
+		// miss if the item min is above the tester max, or the item max is below the tester min
+		S::Float maxs[POINT::AXIS_COUNT];
+		S::Float neg_mins[POINT::AXIS_COUNT];
+		for (int axis = 0; axis < POINT::AXIS_COUNT; ++axis) {
+			maxs[axis] = S::set(-p_abb.neg_max[axis]);
+			neg_mins[axis] = S::set(-p_abb.min[axis]);
+		}
+
+		uint32_t num_hits = 0;
+		for (uint32_t first = 0; first < p_count; first += LANES) {
+			S::Mask miss = S::mask_none();
+			for (int axis = 0; axis < POINT::AXIS_COUNT; ++axis) {
+				miss = S::mask_or(miss, S::greater(S::load(&mins[axis][first]), maxs[axis]));
+				miss = S::mask_or(miss, S::greater(S::load(&neg_maxs[axis][first]), neg_mins[axis]));
+			}
+			num_hits = _write_hits(first, p_count, S::mask_bits(miss), r_hits, num_hits);
+		}
+		return num_hits;
+	}
+
+	uint32_t find_containing_point_simd(uint32_t p_count, const POINT &p_point, uint32_t *r_hits) const {
+		typedef BVH_SIMD4 S;
+
+		S::Float point[POINT::AXIS_COUNT];
+		S::Float neg_point[POINT::AXIS_COUNT];
+		for (int axis = 0; axis < POINT::AXIS_COUNT; ++axis) {
+			point[axis] = S::set(p_point[axis]);
+			neg_point[axis] = S::set(-p_point[axis]);
+		}
+
+		uint32_t num_hits = 0;
+		for (uint32_t first = 0; first < p_count; first += LANES) {
+			S::Mask miss = S::mask_none();
+			for (int axis = 0; axis < POINT::AXIS_COUNT; ++axis) {
+				miss = S::mask_or(miss, S::less(neg_point[axis], S::load(&neg_maxs[axis][first])));
+				miss = S::mask_or(miss, S::less(point[axis], S::load(&mins[axis][first])));
+			}
+			num_hits = _write_hits(first, p_count, S::mask_bits(miss), r_hits, num_hits);
+		}
+		return num_hits;
+	}
+
+	uint32_t find_intersecting_segment_simd(uint32_t p_count, const typename ABB::Segment &p_segment, uint32_t *r_hits) const {
+		// The bound of the segment rejects most items 4 at a time,
+		// the exact segment test is only run on the survivors.
+		POINT seg_min = p_segment.from;
+		POINT seg_max = p_segment.from;
+		for (int axis = 0; axis < POINT::AXIS_COUNT; ++axis) {
+			seg_min[axis] = MIN(seg_min[axis], p_segment.to[axis]);
+			seg_max[axis] = MAX(seg_max[axis], p_segment.to[axis]);
+		}
+
+		ABB seg_abb;
+		seg_abb.set(seg_min, seg_max);
+
+		uint32_t num_candidates = find_intersecting_simd(p_count, seg_abb, r_hits);
+
+		uint32_t num_hits = 0;
+		for (uint32_t n = 0; n < num_candidates; n++) {
+			uint32_t id = r_hits[n];
+			if (get(id).intersects_segment(p_segment)) {
+				r_hits[num_hits++] = id;
+			}
+		}
+		return num_hits;
+	}
+
+	uint32_t find_intersecting_convex_simd(uint32_t p_count, const typename ABB::ConvexHull &p_hull, const uint32_t *p_plane_ids, uint32_t p_num_planes, uint32_t *r_hits) const {
+		typedef BVH_SIMD4 S;
+
+		const S::Float half = S::set(0.5f);
+		const S::Float zero = S::set(0.0f);
+
+		uint32_t num_hits = 0;
+		for (uint32_t first = 0; first < p_count; first += LANES) {
+			// same operation order as BVH_ABB::intersects_convex_optimized()
+			S::Float half_extents[POINT::AXIS_COUNT];
+			S::Float ofs[POINT::AXIS_COUNT];
+			for (int axis = 0; axis < POINT::AXIS_COUNT; ++axis) {
+				S::Float min = S::load(&mins[axis][first]);
+				S::Float size = S::sub(S::sub(zero, S::load(&neg_maxs[axis][first])), min);
+				half_extents[axis] = S::mul(size, half);
+				ofs[axis] = S::add(min, half_extents[axis]);
+			}
+
+			S::Mask miss = S::mask_none();
+			for (uint32_t i = 0; i < p_num_planes; i++) {
+				const Plane &p = p_hull.planes[p_plane_ids[i]];
+
+				// the corner furthest behind the plane
+				S::Float dist = zero;
+				for (int axis = 0; axis < POINT::AXIS_COUNT; ++axis) {
+					S::Float point = (p.normal[axis] > 0) ? S::sub(ofs[axis], half_extents[axis]) : S::add(ofs[axis], half_extents[axis]);
+					dist = S::add(dist, S::mul(S::set(p.normal[axis]), point));
+				}
+				miss = S::mask_or(miss, S::greater(dist, S::set(p.d)));
+
+				if (S::mask_bits(miss) == LANE_MASK) {
+					break;
+				}
+			}
+			num_hits = _write_hits(first, p_count, S::mask_bits(miss), r_hits, num_hits);
+		}
+		return num_hits;
+	}
+#endif
+};
+
+#endif // BVH_LEAF_BOUNDS_H
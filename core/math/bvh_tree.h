@@ -44,6 +44,7 @@
 #include "core/containers/pooled_list.h"
 #include "core/math/aabb.h"
 #include "core/math/bvh_abb.h"
+#include "core/math/bvh_leaf_bounds.h"
 #include "core/math/geometry.h"
 #include "core/math/vector3.h"
 #include "core/string/print_string.h"
@@ -426,7 +427,7 @@ private:
 		BVH_ASSERT(ref.item_id != BVHCommon::INVALID);
 
 		// set the aabb of the new item
-		leaf.get_aabb(ref.item_id) = p_aabb;
+		leaf.set_aabb(ref.item_id, p_aabb);
 
 		// back reference on the item back to the item reference
 		leaf.get_item_ref_id(ref.item_id) = p_ref_id;
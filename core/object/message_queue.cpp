@@ -33,35 +33,190 @@
 
 #include "core/config/project_settings.h"
 #include "core/object/script_language.h"
+#include "core/os/thread.h"
 
 MessageQueue *MessageQueue::singleton = nullptr;
+uint32_t MessageQueue::last_generation = 0;
+SpinLock MessageQueue::teardown_lock;
+
+// Marks the buffer of an exiting thread, so flush() can free it once its
+// messages have been merged.
+struct MessageQueue::ThreadBufferHandle {
+	ThreadBuffer *buffer = nullptr;
+	uint32_t generation = 0;
+
+	~ThreadBufferHandle() {
+		if (!buffer) {
+			return;
+		}
+
+		// The queue can't be destroyed (freeing this buffer) while the lock is held.
+		MessageQueue::teardown_lock.lock();
+		MessageQueue *mq = MessageQueue::singleton;
+		if (mq && mq->generation == generation) {
+			buffer->lock.lock();
+			buffer->orphaned = true;
+			buffer->lock.unlock();
+		}
+		MessageQueue::teardown_lock.unlock();
+	}
+};
+
+thread_local MessageQueue::ThreadBufferHandle MessageQueue::thread_buffer_handle;
+
+// Locks the buffer the calling thread should write to.
+class MessageQueue::WriteLock {
+	MessageQueue *queue;
+	ThreadBuffer *thread_buffer;
+
+public:
+	Buffer *buffer;
+
+	WriteLock(MessageQueue *p_queue) {
+		queue = p_queue;
+		thread_buffer = queue->_get_thread_buffer();
+		if (thread_buffer) {
+			thread_buffer->lock.lock();
+			buffer = &thread_buffer->buffer;
+		} else {
+			queue->_thread_safe_.lock();
+			buffer = &queue->buffers[queue->write_buffer];
+		}
+	}
+
+	~WriteLock() {
+		if (thread_buffer) {
+			thread_buffer->lock.unlock();
+		} else {
+			queue->_thread_safe_.unlock();
+		}
+	}
+};
 
 MessageQueue *MessageQueue::get_singleton() {
 	return singleton;
 }
 
-Error MessageQueue::push_call(ObjectID p_id, const StringName &p_method, const Variant **p_args, int p_argcount, bool p_show_error) {
-	_THREAD_SAFE_METHOD_
+MessageQueue::ThreadBuffer *MessageQueue::_get_thread_buffer() {
+	if (Thread::is_main_thread()) {
+		return nullptr;
+	}
+
+	ThreadBufferHandle &handle = thread_buffer_handle;
+	if (handle.buffer && handle.generation == generation) {
+		return handle.buffer;
+	}
 
-	int room_needed = sizeof(Message) + sizeof(Variant) * p_argcount;
+	ThreadBuffer *tb = memnew(ThreadBuffer);
 
-	Buffer &buffer = buffers[write_buffer];
+	_THREAD_SAFE_LOCK_
+	tb->next = thread_buffers;
+	thread_buffers = tb;
+	_THREAD_SAFE_UNLOCK_
 
-	if ((buffer.end + room_needed) > buffer.data.size()) {
-		if ((buffer.end + room_needed) > max_allowed_buffer_size) {
-			String type;
-			if (ObjectDB::get_instance(p_id)) {
-				type = ObjectDB::get_instance(p_id)->get_class();
-			}
-			print_line("Failed method: " + p_method);
-			statistics();
-			ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_mb' in project settings.");
+	handle.buffer = tb;
+	handle.generation = generation;
+	return tb;
+}
+
+void MessageQueue::_merge_thread_buffers() {
+	// Called with the queue locked.
+	Buffer &dst = buffers[write_buffer];
+
+	ThreadBuffer **prev = &thread_buffers;
+	ThreadBuffer *tb = thread_buffers;
+
+	while (tb) {
+		tb->lock.lock();
+
+		Buffer &src = tb->buffer;
+		// The merged buffer has the same size limit as the others. What doesn't fit stays in
+		// the thread's buffer and gets merged after the next swap.
+		if (src.end && dst.end + src.end <= max_allowed_buffer_size) {
+			// Messages are plain bytes until flushed, Variants can be moved with memcpy
+			// (the same happens when a buffer gets resized).
+			dst.data.resize(dst.end + src.end);
+			memcpy(&dst.data[dst.end], src.data.ptr(), src.end);
+			dst.end += src.end;
+
+			src.end = 0;
+			src.data.clear();
+		}
+
+		bool orphaned = tb->orphaned && src.end == 0;
+		tb->lock.unlock();
+
+		ThreadBuffer *next = tb->next;
+		if (orphaned) {
+			*prev = next;
+			memdelete(tb);
 		} else {
-			buffer.data.resize(buffer.end + room_needed);
+			prev = &tb->next;
+		}
+		tb = next;
+	}
+}
+
+MessageQueue::Message *MessageQueue::_alloc_message(Buffer &p_buffer, uint32_t p_room_needed) {
+	if ((p_buffer.end + p_room_needed) > p_buffer.data.size()) {
+		if ((p_buffer.end + p_room_needed) > max_allowed_buffer_size) {
+			return nullptr;
 		}
+		p_buffer.data.resize(p_buffer.end + p_room_needed);
 	}
 
-	Message *msg = memnew_placement(&buffer.data[buffer.end], Message);
+	Message *msg = memnew_placement(&p_buffer.data[p_buffer.end], Message);
+	p_buffer.end += sizeof(Message);
+	return msg;
+}
+
+static _FORCE_INLINE_ bool _is_trivial_variant(Variant::Type p_type) {
+	// Types stored directly in the Variant, without any allocation or reference.
+	switch (p_type) {
+		case Variant::NIL:
+		case Variant::BOOL:
+		case Variant::INT:
+		case Variant::REAL:
+		case Variant::RECT2:
+		case Variant::RECT2I:
+		case Variant::VECTOR2:
+		case Variant::VECTOR2I:
+		case Variant::VECTOR3:
+		case Variant::VECTOR3I:
+		case Variant::VECTOR4:
+		case Variant::VECTOR4I:
+		case Variant::PLANE:
+		case Variant::QUATERNION:
+		case Variant::COLOR:
+			return true;
+		default:
+			return false;
+	}
+}
+
+void MessageQueue::_push_args(Buffer &p_buffer, const Variant **p_args, int p_argcount) {
+	for (int i = 0; i < p_argcount; i++) {
+		uint8_t *dst = &p_buffer.data[p_buffer.end];
+		p_buffer.end += sizeof(Variant);
+
+		if (_is_trivial_variant(p_args[i]->get_type())) {
+			memcpy(dst, p_args[i], sizeof(Variant));
+		} else {
+			memnew_placement(dst, Variant(*p_args[i]));
+		}
+	}
+}
+
+Error MessageQueue::push_call(ObjectID p_id, const StringName &p_method, const Variant **p_args, int p_argcount, bool p_show_error) {
+	WriteLock lock(this);
+	Buffer &buffer = *lock.buffer;
+
+	Message *msg = _alloc_message(buffer, sizeof(Message) + sizeof(Variant) * p_argcount);
+	if (!msg) {
+		print_line("Failed method: " + p_method);
+		_statistics(buffer);
+		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_mb' in project settings.");
+	}
 
 	msg->args = p_argcount;
 	msg->instance_id = p_id;
@@ -71,13 +226,7 @@ Error MessageQueue::push_call(ObjectID p_id, const StringName &p_method, const V
 		msg->type |= FLAG_SHOW_ERROR;
 	}
 
-	buffer.end += sizeof(Message);
-
-	for (int i = 0; i < p_argcount; i++) {
-		Variant *v = memnew_placement(&buffer.data[buffer.end], Variant);
-		buffer.end += sizeof(Variant);
-		*v = *p_args[i];
-	}
+	_push_args(buffer, p_args, p_argcount);
 
 	return OK;
 }
@@ -98,74 +247,49 @@ Error MessageQueue::push_call(ObjectID p_id, const StringName &p_method, VARIANT
 }
 
 Error MessageQueue::push_set(ObjectID p_id, const StringName &p_prop, const Variant &p_value) {
-	_THREAD_SAFE_METHOD_
-
-	uint8_t room_needed = sizeof(Message) + sizeof(Variant);
-
-	Buffer &buffer = buffers[write_buffer];
-
-	if ((buffer.end + room_needed) > buffer.data.size()) {
-		if ((buffer.end + room_needed) > max_allowed_buffer_size) {
-			String type;
-			if (ObjectDB::get_instance(p_id)) {
-				type = ObjectDB::get_instance(p_id)->get_class();
-			}
-			print_line("Failed set: " + type + ":" + p_prop + " target ID: " + itos(p_id));
-			statistics();
-			ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_mb' in project settings.");
-		} else {
-			buffer.data.resize(buffer.end + room_needed);
+	WriteLock lock(this);
+	Buffer &buffer = *lock.buffer;
+
+	Message *msg = _alloc_message(buffer, sizeof(Message) + sizeof(Variant));
+	if (!msg) {
+		String type;
+		if (ObjectDB::get_instance(p_id)) {
+			type = ObjectDB::get_instance(p_id)->get_class();
 		}
+		print_line("Failed set: " + type + ":" + p_prop + " target ID: " + itos(p_id));
+		_statistics(buffer);
+		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_mb' in project settings.");
 	}
 
-	Message *msg = memnew_placement(&buffer.data[buffer.end], Message);
-
 	msg->args = 1;
 	msg->instance_id = p_id;
 	msg->target = p_prop;
 	msg->type = TYPE_SET;
 
-	buffer.end += sizeof(Message);
-
-	Variant *v = memnew_placement(&buffer.data[buffer.end], Variant);
-	buffer.end += sizeof(Variant);
-	*v = p_value;
+	const Variant *argptr = &p_value;
+	_push_args(buffer, &argptr, 1);
 
 	return OK;
 }
 
 Error MessageQueue::push_notification(ObjectID p_id, int p_notification) {
-	_THREAD_SAFE_METHOD_
-
 	ERR_FAIL_COND_V(p_notification < 0, ERR_INVALID_PARAMETER);
 
-	uint8_t room_needed = sizeof(Message);
+	WriteLock lock(this);
+	Buffer &buffer = *lock.buffer;
 
-	Buffer &buffer = buffers[write_buffer];
-
-	if ((buffer.end + room_needed) > buffer.data.size()) {
-		if ((buffer.end + room_needed) > max_allowed_buffer_size) {
-			String type;
-			if (ObjectDB::get_instance(p_id)) {
-				type = ObjectDB::get_instance(p_id)->get_class();
-			}
-			print_line("Failed notification: " + itos(p_notification) + " target ID: " + itos(p_id));
-			statistics();
-			ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_mb' in project settings.");
-		} else {
-			buffer.data.resize(buffer.end + room_needed);
-		}
+	Message *msg = _alloc_message(buffer, sizeof(Message));
+	if (!msg) {
+		print_line("Failed notification: " + itos(p_notification) + " target ID: " + itos(p_id));
+		_statistics(buffer);
+		ERR_FAIL_V_MSG(ERR_OUT_OF_MEMORY, "Message queue out of memory. Try increasing 'memory/limits/message_queue/max_size_mb' in project settings.");
 	}
 
-	Message *msg = memnew_placement(&buffer.data[buffer.end], Message);
-
 	msg->type = TYPE_NOTIFICATION;
 	msg->instance_id = p_id;
 	//msg->target;
 	msg->notification = p_notification;
 
-	buffer.end += sizeof(Message);
-
 	return OK;
 }
 
@@ -181,12 +305,18 @@ Error MessageQueue::push_set(Object *p_object, const StringName &p_prop, const V
 }
 
 void MessageQueue::statistics() {
+	_THREAD_SAFE_METHOD_
+
+	_statistics(buffers[write_buffer]);
+}
+
+void MessageQueue::_statistics(const Buffer &p_buffer) {
 	RBMap<StringName, int> set_count;
 	RBMap<int, int> notify_count;
 	RBMap<StringName, int> call_count;
 	int null_count = 0;
 
-	Buffer &buffer = buffers[write_buffer];
+	const Buffer &buffer = p_buffer;
 
 	uint32_t read_pos = 0;
 	while (read_pos < buffer.end) {
@@ -255,6 +385,23 @@ int MessageQueue::get_max_buffer_usage() const {
 	return _buffer_size_monitor.max_size_overall;
 }
 
+int MessageQueue::get_peak_buffer_usage() const {
+	return MAX(_buffer_size_monitor.max_size, _buffer_size_monitor.max_size_last_window);
+}
+
+int MessageQueue::get_current_buffer_usage() const {
+	_THREAD_SAFE_METHOD_
+
+	uint64_t usage = buffers[write_buffer].end;
+	for (ThreadBuffer *tb = thread_buffers; tb; tb = tb->next) {
+		tb->lock.lock();
+		usage += tb->buffer.end;
+		tb->lock.unlock();
+	}
+
+	return usage;
+}
+
 void MessageQueue::_call_function(Object *p_target, const StringName &p_func, const Variant *p_args, int p_argcount, bool p_show_error) {
 	const Variant **argptrs = nullptr;
 	if (p_argcount) {
@@ -278,16 +425,10 @@ void MessageQueue::_update_buffer_monitor() {
 	if (++_buffer_size_monitor.flush_count == 8192) {
 		uint32_t max_size = _buffer_size_monitor.max_size;
 
-		// Uncomment this define to log message queue sizes and
-		// auto-shrinking behaviour.
-		// #define DEBUG_MESSAGE_QUEUE_SIZES
-#ifdef DEBUG_MESSAGE_QUEUE_SIZES
-		print_line("MessageQueue buffer max size " + itos(max_size) + " bytes.");
-#endif
-
-		// reset for next time
+		// reset for next time, the peak stays available to the performance monitor
 		_buffer_size_monitor.flush_count = 0;
 		_buffer_size_monitor.max_size = 0;
+		_buffer_size_monitor.max_size_last_window = max_size;
 
 		for (uint32_t n = 0; n < 2; n++) {
 			uint32_t cap = buffers[n].data.get_capacity();
@@ -300,9 +441,6 @@ void MessageQueue::_update_buffer_monitor() {
 				// Only shrink if we are routinely using a lot less than the capacity.
 				if ((max_size * 4) < cap) {
 					buffers[n].data.reserve(cap / 2, true);
-#ifdef DEBUG_MESSAGE_QUEUE_SIZES
-					print_line("MessageQueue reducing buffer[" + itos(n) + "] capacity from " + itos(cap) + " bytes to " + itos(cap / 2) + " bytes.");
-#endif
 				}
 			}
 		}
@@ -319,6 +457,7 @@ void MessageQueue::flush() {
 	}
 
 	// first flip buffers, in preparation
+	_merge_thread_buffers();
 	SWAP(read_buffer, write_buffer);
 
 	flushing = true;
@@ -397,6 +536,7 @@ void MessageQueue::flush() {
 		_buffer_size_monitor.max_size_overall = MAX(buffer_data_size, _buffer_size_monitor.max_size_overall);
 
 		// flip buffers, this is the only part that requires a lock
+		_merge_thread_buffers();
 		SWAP(read_buffer, write_buffer);
 		_THREAD_SAFE_UNLOCK_
 
@@ -408,6 +548,30 @@ void MessageQueue::flush() {
 	_THREAD_SAFE_UNLOCK_
 }
 
+void MessageQueue::_clear_buffer(Buffer &p_buffer) {
+	uint32_t read_pos = 0;
+
+	while (read_pos < p_buffer.end) {
+		Message *message = (Message *)&p_buffer.data[read_pos];
+		Variant *args = (Variant *)(message + 1);
+		int argc = message->args;
+		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
+			for (int i = 0; i < argc; i++) {
+				args[i].~Variant();
+			}
+		}
+
+		read_pos += sizeof(Message);
+		if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
+			read_pos += sizeof(Variant) * message->args;
+		}
+
+		message->~Message();
+	}
+
+	p_buffer.end = 0;
+}
+
 bool MessageQueue::is_flushing() const {
 	return flushing;
 }
@@ -416,6 +580,7 @@ MessageQueue::MessageQueue() {
 	ERR_FAIL_COND_MSG(singleton != nullptr, "A MessageQueue singleton already exists.");
 	singleton = this;
 	flushing = false;
+	generation = ++last_generation;
 
 	max_allowed_buffer_size = GLOBAL_DEF_RST("memory/limits/message_queue/max_size_mb", 32);
 	ProjectSettings::get_singleton()->set_custom_property_info("memory/limits/message_queue/max_size_mb", PropertyInfo(Variant::INT, "memory/limits/message_queue/max_size_mb", PROPERTY_HINT_RANGE, "4,512,1,or_greater"));
@@ -424,29 +589,19 @@ MessageQueue::MessageQueue() {
 }
 
 MessageQueue::~MessageQueue() {
-	for (int which = 0; which < 2; which++) {
-		Buffer &buffer = buffers[which];
-		uint32_t read_pos = 0;
-
-		while (read_pos < buffer.end) {
-			Message *message = (Message *)&buffer.data[read_pos];
-			Variant *args = (Variant *)(message + 1);
-			int argc = message->args;
-			if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-				for (int i = 0; i < argc; i++) {
-					args[i].~Variant();
-				}
-			}
-
-			read_pos += sizeof(Message);
-			if ((message->type & FLAG_MASK) != TYPE_NOTIFICATION) {
-				read_pos += sizeof(Variant) * message->args;
-			}
-
-			message->~Message();
-		}
+	// Exiting threads stop touching their buffers once they see no singleton.
+	teardown_lock.lock();
+	singleton = nullptr;
+	teardown_lock.unlock();
 
-	} // for which
+	for (int which = 0; which < 2; which++) {
+		_clear_buffer(buffers[which]);
+	}
 
-	singleton = nullptr;
+	while (thread_buffers) {
+		ThreadBuffer *tb = thread_buffers;
+		thread_buffers = tb->next;
+		_clear_buffer(tb->buffer);
+		memdelete(tb);
+	}
 }
@@ -34,6 +34,7 @@
 
 #include "core/containers/local_vector.h"
 #include "core/object/object.h"
+#include "core/os/spin_lock.h"
 #include "core/os/thread_safe.h"
 
 class MessageQueue {
@@ -63,23 +64,52 @@ class MessageQueue {
 		uint64_t end = 0;
 	};
 
+	// Calls pushed from threads other than the main thread go to a buffer
+	// owned by that thread, so producers don't contend on the queue mutex.
+	// They are merged into the main buffers by flush().
+	struct ThreadBuffer {
+		SpinLock lock;
+		Buffer buffer;
+		ThreadBuffer *next = nullptr;
+		bool orphaned = false;
+	};
+
+	class WriteLock;
+	struct ThreadBufferHandle;
+
 	Buffer buffers[2];
 	int read_buffer = 0;
 	int write_buffer = 1;
 	uint64_t max_allowed_buffer_size = 0;
 
+	ThreadBuffer *thread_buffers = nullptr;
+	uint32_t generation = 0;
+
 	struct BufferSizeMonitor {
 		uint32_t max_size = 0;
 		uint32_t flush_count = 0;
 
 		// Only used for performance statistics.
 		uint32_t max_size_overall = 0;
+		uint32_t max_size_last_window = 0;
 	} _buffer_size_monitor;
 
+	ThreadBuffer *_get_thread_buffer();
+	void _merge_thread_buffers();
+	Message *_alloc_message(Buffer &p_buffer, uint32_t p_room_needed);
+	void _push_args(Buffer &p_buffer, const Variant **p_args, int p_argcount);
+	void _clear_buffer(Buffer &p_buffer);
+	void _statistics(const Buffer &p_buffer);
+
 	void _call_function(Object *p_target, const StringName &p_func, const Variant *p_args, int p_argcount, bool p_show_error);
 	void _update_buffer_monitor();
 
 	static MessageQueue *singleton;
+	static uint32_t last_generation;
+	// Held while an exiting thread marks its buffer, and while the queue is destroyed.
+	// Static, so it outlives the queue.
+	static SpinLock teardown_lock;
+	static thread_local ThreadBufferHandle thread_buffer_handle;
 
 	bool flushing;
 
@@ -101,6 +131,7 @@ public:
 	bool is_flushing() const;
 
 	int get_max_buffer_usage() const;
+	int get_peak_buffer_usage() const;
 	int get_current_buffer_usage() const;
 
 	MessageQueue();
@@ -0,0 +1,194 @@
+/*************************************************************************/
+/*  arena_allocator.cpp                                                  */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "arena_allocator.h"
+
+void *ArenaAllocator::alloc(size_t p_bytes, size_t p_align) {
+	uint8_t *p = (uint8_t *)(((uintptr_t)_pos + (p_align - 1)) & ~(uintptr_t)(p_align - 1));
+
+	if (unlikely(!_pos || p + p_bytes > _end)) {
+		_add_chunk(p_bytes + p_align);
+
+		p = (uint8_t *)(((uintptr_t)_pos + (p_align - 1)) & ~(uintptr_t)(p_align - 1));
+	}
+
+	_last = p;
+	_pos = p + p_bytes;
+
+	return p;
+}
+
+void *ArenaAllocator::realloc(void *p_ptr, size_t p_old_bytes, size_t p_new_bytes, size_t p_align) {
+	if (!p_ptr) {
+		return alloc(p_new_bytes, p_align);
+	}
+
+	uint8_t *p = (uint8_t *)p_ptr;
+
+	if (p == _last && p + p_new_bytes <= _end) {
+		_pos = p + p_new_bytes;
+		return p;
+	}
+
+	if (p_new_bytes <= p_old_bytes) {
+		return p;
+	}
+
+	void *n = alloc(p_new_bytes, p_align);
+	memcpy(n, p_ptr, p_old_bytes);
+
+	return n;
+}
+
+void ArenaAllocator::reset() {
+	if (_max_retained_size > 0 && _reserved > _max_retained_size) {
+		// Too big to keep, the next round starts again from the initial buffer / chunk size.
+		_free_chunks();
+		_spilled = false;
+	} else if (_spilled) {
+		// More than one block was needed, merge them into one, so next time it all fits.
+		size_t total = _reserved + _initial_buffer_size;
+
+		_free_chunks();
+		_add_chunk(total);
+
+		_spilled = false;
+	}
+
+	if (_chunk) {
+		_begin = _chunk_data(_chunk);
+		_end = _begin + _chunk->size;
+	} else {
+		_begin = _initial_buffer;
+		_end = _initial_buffer + _initial_buffer_size;
+	}
+
+	_pos = _begin;
+	_last = nullptr;
+	_used_in_previous = 0;
+}
+
+void ArenaAllocator::clear() {
+	_free_chunks();
+
+	_begin = _initial_buffer;
+	_pos = _initial_buffer;
+	_end = _initial_buffer + _initial_buffer_size;
+	_last = nullptr;
+	_used_in_previous = 0;
+	_spilled = false;
+}
+
+size_t ArenaAllocator::get_used_bytes() const {
+	return _used_in_previous + (_pos - _begin);
+}
+
+size_t ArenaAllocator::get_reserved_bytes() const {
+	return _reserved + _initial_buffer_size;
+}
+
+void ArenaAllocator::set_max_retained_size(size_t p_size) {
+	_max_retained_size = p_size;
+}
+
+size_t ArenaAllocator::get_max_retained_size() const {
+	return _max_retained_size;
+}
+
+void ArenaAllocator::_add_chunk(size_t p_min_bytes) {
+	size_t size = MAX(_chunk_size, p_min_bytes);
+
+	Chunk *c = (Chunk *)memalloc(sizeof(Chunk) + size);
+	CRASH_COND_MSG(!c, "Out of memory.");
+
+	c->prev = _chunk;
+	c->size = size;
+
+	if (_begin) {
+		_used_in_previous += _pos - _begin;
+		_spilled = true;
+	}
+
+	_chunk = c;
+	_reserved += size;
+
+	_begin = _chunk_data(c);
+	_pos = _begin;
+	_end = _begin + size;
+	_last = nullptr;
+}
+
+void ArenaAllocator::_free_chunks() {
+	while (_chunk) {
+		Chunk *prev = _chunk->prev;
+		memfree(_chunk);
+		_chunk = prev;
+	}
+
+	_reserved = 0;
+	_begin = nullptr;
+	_pos = nullptr;
+	_end = nullptr;
+}
+
+ArenaAllocator::ArenaAllocator(size_t p_chunk_size) {
+	_begin = nullptr;
+	_pos = nullptr;
+	_end = nullptr;
+	_last = nullptr;
+	_chunk = nullptr;
+	_initial_buffer = nullptr;
+	_initial_buffer_size = 0;
+	_chunk_size = p_chunk_size;
+	_max_retained_size = DEFAULT_MAX_RETAINED_SIZE;
+	_used_in_previous = 0;
+	_reserved = 0;
+	_spilled = false;
+}
+
+ArenaAllocator::ArenaAllocator(void *p_initial_buffer, size_t p_initial_buffer_size, size_t p_chunk_size) {
+	_initial_buffer = (uint8_t *)p_initial_buffer;
+	_initial_buffer_size = p_initial_buffer_size;
+	_begin = _initial_buffer;
+	_pos = _initial_buffer;
+	_end = _initial_buffer + _initial_buffer_size;
+	_last = nullptr;
+	_chunk = nullptr;
+	_chunk_size = p_chunk_size;
+	_max_retained_size = DEFAULT_MAX_RETAINED_SIZE;
+	_used_in_previous = 0;
+	_reserved = 0;
+	_spilled = false;
+}
+
+ArenaAllocator::~ArenaAllocator() {
+	_free_chunks();
+}
@@ -0,0 +1,206 @@
+#ifndef ARENA_ALLOCATOR_H
+#define ARENA_ALLOCATOR_H
+
+/*************************************************************************/
+/*  arena_allocator.h                                                    */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "core/error/error_macros.h"
+#include "core/os/memory.h"
+#include "core/typedefs.h"
+
+#include <string.h>
+
+// Bump allocator for data that dies together.
+// Allocations can't be freed one by one, everything is released at once with reset().
+// reset() keeps memory around (merged into one chunk), so an arena that is reused
+// (for example for every request on a connection) stops allocating after a few rounds.
+// Only up to max_retained_size is kept, after a bigger round reset() gives the memory back,
+// so one large request doesn't pin its memory for the lifetime of the arena.
+// Optionally the first chunk can be an external (for example stack) buffer.
+// Not thread safe.
+
+class ArenaAllocator {
+public:
+	void *alloc(size_t p_bytes, size_t p_align = DEFAULT_ALIGN);
+	// Grows in place if p_ptr is the last allocation, otherwise allocates and copies.
+	void *realloc(void *p_ptr, size_t p_old_bytes, size_t p_new_bytes, size_t p_align = DEFAULT_ALIGN);
+
+	// Invalidates every allocation.
+	void reset();
+	// Same as reset(), but also gives back all memory.
+	void clear();
+
+	size_t get_used_bytes() const;
+	size_t get_reserved_bytes() const;
+
+	// 0 means no limit.
+	void set_max_retained_size(size_t p_size);
+	size_t get_max_retained_size() const;
+
+	ArenaAllocator(size_t p_chunk_size = DEFAULT_CHUNK_SIZE);
+	ArenaAllocator(void *p_initial_buffer, size_t p_initial_buffer_size, size_t p_chunk_size = DEFAULT_CHUNK_SIZE);
+	~ArenaAllocator();
+
+	enum {
+		DEFAULT_ALIGN = 16,
+		DEFAULT_CHUNK_SIZE = 4096,
+		DEFAULT_MAX_RETAINED_SIZE = 256 * 1024,
+	};
+
+protected:
+	struct Chunk {
+		Chunk *prev;
+		size_t size;
+	};
+
+	_FORCE_INLINE_ static uint8_t *_chunk_data(Chunk *p_chunk) {
+		return (uint8_t *)p_chunk + sizeof(Chunk);
+	}
+
+	void _add_chunk(size_t p_min_bytes);
+	void _free_chunks();
+
+	// Memory in the current chunk / initial buffer
+	uint8_t *_begin;
+	uint8_t *_pos;
+	uint8_t *_end;
+
+	// Start of the last allocation, used for in-place growing
+	uint8_t *_last;
+
+	Chunk *_chunk;
+
+	uint8_t *_initial_buffer;
+	size_t _initial_buffer_size;
+
+	size_t _chunk_size;
+	size_t _max_retained_size;
+	// Bytes used in previous (full) chunks
+	size_t _used_in_previous;
+	size_t _reserved;
+	// Set when allocations didn't fit into one block.
+	bool _spilled;
+
+private:
+	ArenaAllocator(const ArenaAllocator &);
+	ArenaAllocator &operator=(const ArenaAllocator &);
+};
+
+// Growable array that lives in an ArenaAllocator. Only for trivial types.
+// After the arena is reset the vector has to be reset too.
+template <class T>
+class ArenaVector {
+public:
+	_FORCE_INLINE_ T *ptr() { return _data; }
+	_FORCE_INLINE_ const T *ptr() const { return _data; }
+	_FORCE_INLINE_ uint32_t size() const { return _size; }
+	_FORCE_INLINE_ bool empty() const { return _size == 0; }
+
+	_FORCE_INLINE_ T &operator[](uint32_t p_index) {
+		CRASH_BAD_UNSIGNED_INDEX(p_index, _size);
+		return _data[p_index];
+	}
+	_FORCE_INLINE_ const T &operator[](uint32_t p_index) const {
+		CRASH_BAD_UNSIGNED_INDEX(p_index, _size);
+		return _data[p_index];
+	}
+
+	_FORCE_INLINE_ void push_back(const T &p_elem) {
+		if (unlikely(_size == _capacity)) {
+			_grow(_size + 1);
+		}
+
+		_data[_size++] = p_elem;
+	}
+
+	void append_array(const T *p_data, uint32_t p_count) {
+		if (_size + p_count > _capacity) {
+			_grow(_size + p_count);
+		}
+
+		memcpy(_data + _size, p_data, p_count * sizeof(T));
+		_size += p_count;
+	}
+
+	void resize(uint32_t p_size) {
+		if (p_size > _capacity) {
+			_grow(p_size);
+		}
+
+		_size = p_size;
+	}
+
+	// Removes the first p_count elements.
+	void remove_front(uint32_t p_count) {
+		ERR_FAIL_COND(p_count > _size);
+
+		memmove(_data, _data + p_count, (_size - p_count) * sizeof(T));
+		_size -= p_count;
+	}
+
+	// Keeps the memory.
+	_FORCE_INLINE_ void clear() { _size = 0; }
+
+	// Forgets the memory, call it when the arena was reset.
+	_FORCE_INLINE_ void reset() {
+		_data = nullptr;
+		_size = 0;
+		_capacity = 0;
+	}
+
+	_FORCE_INLINE_ void set_arena(ArenaAllocator *p_arena) {
+		reset();
+		_arena = p_arena;
+	}
+
+	ArenaVector(ArenaAllocator *p_arena = nullptr) {
+		_arena = p_arena;
+		_data = nullptr;
+		_size = 0;
+		_capacity = 0;
+	}
+
+private:
+	void _grow(uint32_t p_min_capacity) {
+		CRASH_COND_MSG(!_arena, "ArenaVector has no arena set.");
+
+		uint32_t new_capacity = MAX(MAX(_capacity * 2, p_min_capacity), 16u);
+		_data = (T *)_arena->realloc(_data, _capacity * sizeof(T), new_capacity * sizeof(T), alignof(T) > 8 ? alignof(T) : 8);
+		_capacity = new_capacity;
+	}
+
+	ArenaAllocator *_arena;
+	T *_data;
+	uint32_t _size;
+	uint32_t _capacity;
+};
+
+#endif // ARENA_ALLOCATOR_H
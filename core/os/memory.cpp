@@ -34,6 +34,10 @@
 #include "core/error/error_macros.h"
 #include "core/os/safe_refcount.h"
 
+#ifdef THREAD_CACHE_ALLOCATOR_ENABLED
+#include "core/os/thread_cache_allocator.h"
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -67,13 +71,18 @@ SafeNumeric<uint64_t> Memory::max_usage;
 SafeNumeric<uint64_t> Memory::alloc_count;
 
 void *Memory::alloc_static(size_t p_bytes, bool p_pad_align) {
-#ifdef DEBUG_ENABLED
+#if defined(DEBUG_ENABLED) || defined(THREAD_CACHE_ALLOCATOR_ENABLED)
 	bool prepad = true;
 #else
 	bool prepad = p_pad_align;
 #endif
 
+#ifdef THREAD_CACHE_ALLOCATOR_ENABLED
+	// The allocator needs to know the size of the blocks when they are freed, so the prepad is always used.
+	void *mem = ThreadCacheAllocator::alloc(p_bytes + PAD_ALIGN);
+#else
 	void *mem = malloc(p_bytes + (prepad ? PAD_ALIGN : 0));
+#endif
 
 	ERR_FAIL_COND_V(!mem, nullptr);
 
@@ -102,7 +111,7 @@ void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
 
 	uint8_t *mem = (uint8_t *)p_memory;
 
-#ifdef DEBUG_ENABLED
+#if defined(DEBUG_ENABLED) || defined(THREAD_CACHE_ALLOCATOR_ENABLED)
 	bool prepad = true;
 #else
 	bool prepad = p_pad_align;
@@ -112,6 +121,10 @@ void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
 		mem -= PAD_ALIGN;
 		uint64_t *s = (uint64_t *)mem;
 
+#ifdef THREAD_CACHE_ALLOCATOR_ENABLED
+		uint64_t old_bytes = *s;
+#endif
+
 #ifdef DEBUG_ENABLED
 		if (p_bytes > *s) {
 			uint64_t new_mem_usage = mem_usage.add(p_bytes - *s);
@@ -122,12 +135,20 @@ void *Memory::realloc_static(void *p_memory, size_t p_bytes, bool p_pad_align) {
 #endif
 
 		if (p_bytes == 0) {
+#ifdef THREAD_CACHE_ALLOCATOR_ENABLED
+			ThreadCacheAllocator::free(mem, old_bytes + PAD_ALIGN);
+#else
 			free(mem);
+#endif
 			return nullptr;
 		} else {
 			*s = p_bytes;
 
+#ifdef THREAD_CACHE_ALLOCATOR_ENABLED
+			mem = (uint8_t *)ThreadCacheAllocator::realloc(mem, old_bytes + PAD_ALIGN, p_bytes + PAD_ALIGN);
+#else
 			mem = (uint8_t *)realloc(mem, p_bytes + PAD_ALIGN);
+#endif
 			ERR_FAIL_COND_V(!mem, nullptr);
 
 			s = (uint64_t *)mem;
@@ -150,7 +171,7 @@ void Memory::free_static(void *p_ptr, bool p_pad_align) {
 
 	uint8_t *mem = (uint8_t *)p_ptr;
 
-#ifdef DEBUG_ENABLED
+#if defined(DEBUG_ENABLED) || defined(THREAD_CACHE_ALLOCATOR_ENABLED)
 	bool prepad = true;
 #else
 	bool prepad = p_pad_align;
@@ -161,12 +182,19 @@ void Memory::free_static(void *p_ptr, bool p_pad_align) {
 	if (prepad) {
 		mem -= PAD_ALIGN;
 
-#ifdef DEBUG_ENABLED
+#if defined(DEBUG_ENABLED) || defined(THREAD_CACHE_ALLOCATOR_ENABLED)
 		uint64_t *s = (uint64_t *)mem;
+#endif
+
+#ifdef DEBUG_ENABLED
 		mem_usage.sub(*s);
 #endif
 
+#ifdef THREAD_CACHE_ALLOCATOR_ENABLED
+		ThreadCacheAllocator::free(mem, *s + PAD_ALIGN);
+#else
 		free(mem);
+#endif
 	} else {
 		free(mem);
 	}
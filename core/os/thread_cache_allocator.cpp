@@ -0,0 +1,398 @@
+/*************************************************************************/
+/*  thread_cache_allocator.cpp                                           */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "thread_cache_allocator.h"
+
+#include "core/os/spin_lock.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Everything in here has to work before static constructors ran, and after static destructors ran,
+// so only zero initialized PODs are used for the global state.
+
+namespace {
+
+struct FreeBlock {
+	FreeBlock *next;
+};
+
+struct CentralList {
+	SpinLock lock;
+	FreeBlock *first;
+	uint32_t count;
+};
+
+struct ThreadCache {
+	FreeBlock *first[ThreadCacheAllocator::SIZE_CLASS_COUNT];
+	uint32_t count[ThreadCacheAllocator::SIZE_CLASS_COUNT];
+};
+
+enum ThreadCacheState {
+	THREAD_CACHE_STATE_UNINITIALIZED = 0,
+	THREAD_CACHE_STATE_ACTIVE,
+	THREAD_CACHE_STATE_RELEASED,
+};
+
+CentralList central_lists[ThreadCacheAllocator::SIZE_CLASS_COUNT];
+
+SpinLock stats_lock;
+uint64_t reserved_bytes;
+uint64_t large_bytes;
+uint32_t thread_cache_count;
+
+thread_local ThreadCache thread_cache;
+thread_local int thread_cache_state;
+
+// Only exists so the thread's blocks get handed back to the central lists when it exits.
+struct ThreadCacheReleaser {
+	~ThreadCacheReleaser() {
+		ThreadCacheAllocator::flush_thread_cache();
+		thread_cache_state = THREAD_CACHE_STATE_RELEASED;
+
+		stats_lock.lock();
+		thread_cache_count--;
+		stats_lock.unlock();
+	}
+};
+
+thread_local ThreadCacheReleaser thread_cache_releaser;
+
+// How many blocks move between a thread cache and the central list at once.
+_FORCE_INLINE_ uint32_t get_batch_size(int p_class) {
+	uint32_t batch = (uint32_t)(ThreadCacheAllocator::SPAN_SIZE / 4 / ThreadCacheAllocator::get_class_size(p_class));
+	return CLAMP(batch, 2u, 64u);
+}
+
+_FORCE_INLINE_ bool thread_cache_usable() {
+	if (likely(thread_cache_state == THREAD_CACHE_STATE_ACTIVE)) {
+		return true;
+	}
+
+	if (thread_cache_state == THREAD_CACHE_STATE_RELEASED) {
+		// Thread is shutting down, everything goes through the central lists from now on.
+		return false;
+	}
+
+	thread_cache_state = THREAD_CACHE_STATE_ACTIVE;
+	// Odr-use to register the destructor for this thread.
+	(void)&thread_cache_releaser;
+
+	stats_lock.lock();
+	thread_cache_count++;
+	stats_lock.unlock();
+
+	return true;
+}
+
+// Carves a new span into blocks. Returns the number of blocks stored into r_first.
+uint32_t allocate_span(int p_class, FreeBlock *&r_first) {
+	size_t block_size = ThreadCacheAllocator::get_class_size(p_class);
+	size_t span_size = MAX((size_t)ThreadCacheAllocator::SPAN_SIZE, block_size * get_batch_size(p_class));
+	uint32_t block_count = (uint32_t)(span_size / block_size);
+
+	uint8_t *span = (uint8_t *)::malloc(span_size);
+	if (!span) {
+		r_first = nullptr;
+		return 0;
+	}
+
+	stats_lock.lock();
+	reserved_bytes += span_size;
+	stats_lock.unlock();
+
+	FreeBlock *first = nullptr;
+	for (uint32_t i = block_count; i > 0; --i) {
+		FreeBlock *b = (FreeBlock *)(span + (i - 1) * block_size);
+		b->next = first;
+		first = b;
+	}
+
+	r_first = first;
+	return block_count;
+}
+
+// Takes up to p_max blocks from the central list, allocating a new span if it's empty.
+uint32_t central_take(int p_class, uint32_t p_max, FreeBlock *&r_first) {
+	CentralList &cl = central_lists[p_class];
+
+	cl.lock.lock();
+
+	if (cl.first) {
+		FreeBlock *first = cl.first;
+		FreeBlock *last = first;
+		uint32_t taken = 1;
+
+		while (taken < p_max && last->next) {
+			last = last->next;
+			++taken;
+		}
+
+		cl.first = last->next;
+		cl.count -= taken;
+		cl.lock.unlock();
+
+		last->next = nullptr;
+		r_first = first;
+		return taken;
+	}
+
+	cl.lock.unlock();
+
+	FreeBlock *first = nullptr;
+	uint32_t count = allocate_span(p_class, first);
+	if (count == 0) {
+		r_first = nullptr;
+		return 0;
+	}
+
+	if (count <= p_max) {
+		r_first = first;
+		return count;
+	}
+
+	// Keep p_max, the rest goes to the central list.
+	FreeBlock *last = first;
+	for (uint32_t i = 1; i < p_max; ++i) {
+		last = last->next;
+	}
+
+	FreeBlock *rest = last->next;
+	last->next = nullptr;
+
+	FreeBlock *rest_last = rest;
+	while (rest_last->next) {
+		rest_last = rest_last->next;
+	}
+
+	cl.lock.lock();
+	rest_last->next = cl.first;
+	cl.first = rest;
+	cl.count += count - p_max;
+	cl.lock.unlock();
+
+	r_first = first;
+	return p_max;
+}
+
+void central_put(int p_class, FreeBlock *p_first, FreeBlock *p_last, uint32_t p_count) {
+	CentralList &cl = central_lists[p_class];
+
+	cl.lock.lock();
+	p_last->next = cl.first;
+	cl.first = p_first;
+	cl.count += p_count;
+	cl.lock.unlock();
+}
+
+} // namespace
+
+void *ThreadCacheAllocator::alloc(size_t p_bytes) {
+	int size_class = get_size_class(p_bytes);
+
+	if (unlikely(size_class < 0)) {
+		void *mem = ::malloc(p_bytes);
+
+		if (mem) {
+			stats_lock.lock();
+			large_bytes += p_bytes;
+			stats_lock.unlock();
+		}
+
+		return mem;
+	}
+
+	if (unlikely(!thread_cache_usable())) {
+		FreeBlock *b = nullptr;
+		central_take(size_class, 1, b);
+		return b;
+	}
+
+	FreeBlock *b = thread_cache.first[size_class];
+
+	if (likely(b)) {
+		thread_cache.first[size_class] = b->next;
+		thread_cache.count[size_class]--;
+		return b;
+	}
+
+	uint32_t count = central_take(size_class, get_batch_size(size_class), b);
+
+	if (unlikely(count == 0)) {
+		return nullptr;
+	}
+
+	thread_cache.first[size_class] = b->next;
+	thread_cache.count[size_class] = count - 1;
+
+	return b;
+}
+
+void *ThreadCacheAllocator::realloc(void *p_ptr, size_t p_old_bytes, size_t p_new_bytes) {
+	if (!p_ptr) {
+		return alloc(p_new_bytes);
+	}
+
+	int old_class = get_size_class(p_old_bytes);
+	int new_class = get_size_class(p_new_bytes);
+
+	if (old_class >= 0 && old_class == new_class) {
+		// Still fits into the same block.
+		return p_ptr;
+	}
+
+	if (old_class < 0 && new_class < 0) {
+		void *mem = ::realloc(p_ptr, p_new_bytes);
+
+		if (mem) {
+			stats_lock.lock();
+			large_bytes = large_bytes + p_new_bytes - p_old_bytes;
+			stats_lock.unlock();
+		}
+
+		return mem;
+	}
+
+	void *mem = alloc(p_new_bytes);
+
+	if (!mem) {
+		return nullptr;
+	}
+
+	memcpy(mem, p_ptr, MIN(p_old_bytes, p_new_bytes));
+	free(p_ptr, p_old_bytes);
+
+	return mem;
+}
+
+void ThreadCacheAllocator::free(void *p_ptr, size_t p_bytes) {
+	int size_class = get_size_class(p_bytes);
+
+	if (unlikely(size_class < 0)) {
+		stats_lock.lock();
+		large_bytes -= p_bytes;
+		stats_lock.unlock();
+
+		::free(p_ptr);
+		return;
+	}
+
+	FreeBlock *b = (FreeBlock *)p_ptr;
+
+	if (unlikely(!thread_cache_usable())) {
+		central_put(size_class, b, b, 1);
+		return;
+	}
+
+	b->next = thread_cache.first[size_class];
+	thread_cache.first[size_class] = b;
+	uint32_t count = ++thread_cache.count[size_class];
+
+	uint32_t batch = get_batch_size(size_class);
+
+	if (unlikely(count > batch * 2)) {
+		// Too many cached blocks, move a batch to the central list.
+		// This is also what makes blocks freed on a different thread than they were allocated on available again.
+		FreeBlock *first = thread_cache.first[size_class];
+		FreeBlock *last = first;
+
+		for (uint32_t i = 1; i < batch; ++i) {
+			last = last->next;
+		}
+
+		thread_cache.first[size_class] = last->next;
+		thread_cache.count[size_class] -= batch;
+
+		central_put(size_class, first, last, batch);
+	}
+}
+
+void ThreadCacheAllocator::flush_thread_cache() {
+	if (thread_cache_state != THREAD_CACHE_STATE_ACTIVE) {
+		return;
+	}
+
+	for (int i = 0; i < SIZE_CLASS_COUNT; ++i) {
+		FreeBlock *first = thread_cache.first[i];
+
+		if (!first) {
+			continue;
+		}
+
+		FreeBlock *last = first;
+		while (last->next) {
+			last = last->next;
+		}
+
+		central_put(i, first, last, thread_cache.count[i]);
+
+		thread_cache.first[i] = nullptr;
+		thread_cache.count[i] = 0;
+	}
+}
+
+uint64_t ThreadCacheAllocator::get_reserved_bytes() {
+	stats_lock.lock();
+	uint64_t ret = reserved_bytes;
+	stats_lock.unlock();
+
+	return ret;
+}
+
+uint64_t ThreadCacheAllocator::get_central_free_bytes() {
+	uint64_t ret = 0;
+
+	for (int i = 0; i < SIZE_CLASS_COUNT; ++i) {
+		CentralList &cl = central_lists[i];
+
+		cl.lock.lock();
+		ret += (uint64_t)cl.count * get_class_size(i);
+		cl.lock.unlock();
+	}
+
+	return ret;
+}
+
+uint64_t ThreadCacheAllocator::get_large_bytes() {
+	stats_lock.lock();
+	uint64_t ret = large_bytes;
+	stats_lock.unlock();
+
+	return ret;
+}
+
+uint32_t ThreadCacheAllocator::get_thread_cache_count() {
+	stats_lock.lock();
+	uint32_t ret = thread_cache_count;
+	stats_lock.unlock();
+
+	return ret;
+}
@@ -0,0 +1,107 @@
+#ifndef THREAD_CACHE_ALLOCATOR_H
+#define THREAD_CACHE_ALLOCATOR_H
+
+/*************************************************************************/
+/*  thread_cache_allocator.h                                             */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "core/typedefs.h"
+
+#include <stddef.h>
+
+// Optional allocator backend for Memory::alloc_static (enable with the
+// use_thread_cache_allocator=yes SCons option).
+// Small blocks are grouped into size classes. Every thread keeps its own free lists,
+// so the common alloc / free pair never takes a lock. When a thread's list grows too
+// long (for example when blocks allocated on one thread are freed on another),
+// a batch of blocks is moved to a central, per size class free list, where every
+// other thread can pick them up.
+// Frees are sized, the caller (Memory) always knows the size of the block thanks to its prepad.
+// Memory that was handed out for small blocks is never returned to the system.
+
+class ThreadCacheAllocator {
+public:
+	enum {
+		SMALL_CLASS_STEP = 16,
+		SMALL_CLASS_MAX_SIZE = 1024,
+		SMALL_CLASS_COUNT = SMALL_CLASS_MAX_SIZE / SMALL_CLASS_STEP,
+		// 4 classes for every power of two between SMALL_CLASS_MAX_SIZE and MAX_SIZE.
+		MEDIUM_CLASS_SHIFT_MIN = 11,
+		MEDIUM_CLASS_SHIFT_MAX = 15,
+		MEDIUM_CLASSES_PER_SHIFT = 4,
+		MEDIUM_CLASS_COUNT = (MEDIUM_CLASS_SHIFT_MAX - MEDIUM_CLASS_SHIFT_MIN + 1) * MEDIUM_CLASSES_PER_SHIFT,
+		SIZE_CLASS_COUNT = SMALL_CLASS_COUNT + MEDIUM_CLASS_COUNT,
+		// Allocations larger than this go directly to the system allocator.
+		MAX_SIZE = 1 << MEDIUM_CLASS_SHIFT_MAX,
+		SPAN_SIZE = 64 * 1024,
+	};
+
+	static void *alloc(size_t p_bytes);
+	static void *realloc(void *p_ptr, size_t p_old_bytes, size_t p_new_bytes);
+	static void free(void *p_ptr, size_t p_bytes);
+
+	// Moves every block cached by the calling thread to the central lists.
+	static void flush_thread_cache();
+
+	static uint64_t get_reserved_bytes();
+	static uint64_t get_central_free_bytes();
+	static uint64_t get_large_bytes();
+	static uint32_t get_thread_cache_count();
+
+	static _FORCE_INLINE_ int get_size_class(size_t p_bytes) {
+		if (p_bytes <= SMALL_CLASS_MAX_SIZE) {
+			return p_bytes == 0 ? 0 : (int)((p_bytes - 1) / SMALL_CLASS_STEP);
+		}
+
+		if (p_bytes > MAX_SIZE) {
+			return -1;
+		}
+
+		int shift = nearest_shift((unsigned int)(p_bytes - 1));
+		size_t base = (size_t)1 << (shift - 1);
+		size_t step = base / MEDIUM_CLASSES_PER_SHIFT;
+
+		return SMALL_CLASS_COUNT + (shift - MEDIUM_CLASS_SHIFT_MIN) * MEDIUM_CLASSES_PER_SHIFT + (int)((p_bytes - base - 1) / step);
+	}
+
+	static _FORCE_INLINE_ size_t get_class_size(int p_class) {
+		if (p_class < SMALL_CLASS_COUNT) {
+			return (size_t)(p_class + 1) * SMALL_CLASS_STEP;
+		}
+
+		int medium = p_class - SMALL_CLASS_COUNT;
+		int shift = MEDIUM_CLASS_SHIFT_MIN + medium / MEDIUM_CLASSES_PER_SHIFT;
+		size_t base = (size_t)1 << (shift - 1);
+
+		return base + (base / MEDIUM_CLASSES_PER_SHIFT) * (size_t)(medium % MEDIUM_CLASSES_PER_SHIFT + 1);
+	}
+};
+
+#endif // THREAD_CACHE_ALLOCATOR_H
@@ -62,6 +62,7 @@
 #include "core/io/xml_parser.h"
 #include "core/log/logger_backend.h"
 #include "core/math/a_star.h"
+#include "core/math/a_star_grid_2d.h"
 #include "core/math/expression.h"
 #include "core/math/geometry.h"
 #include "core/math/random_number_generator.h"
@@ -223,6 +224,7 @@ void register_core_types() {
 	ClassDB::register_virtual_class<PackedDataContainerRef>();
 	ClassDB::register_class<AStar>();
 	ClassDB::register_class<AStar2D>();
+	ClassDB::register_class<AStarGrid2D>();
 	ClassDB::register_class<EncodedObjectAsID>();
 	ClassDB::register_class<RandomNumberGenerator>();
 
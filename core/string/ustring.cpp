@@ -3166,8 +3166,6 @@ Error String::parse_utf8(const char *p_utf8, int p_len, bool p_skip_cr) {
 		return ERR_INVALID_DATA;
 	}
 
-	String aux;
-
 	int cstr_size = 0;
 	int str_size = 0;
 
@@ -3183,13 +3181,53 @@ Error String::parse_utf8(const char *p_utf8, int p_len, bool p_skip_cr) {
 		}
 	}
 
+	// Fast path for pure ASCII input, which is the most common case (protocol data, paths, identifiers).
+	// If a non-ASCII byte is found, the general decoder continues from there.
+	int ascii_len = 0;
+	{
+		const char *ptrtmp = p_utf8;
+		const char *ptrtmp_limit = &p_utf8[p_len];
+		while (ptrtmp != ptrtmp_limit && *ptrtmp) {
+			uint8_t c = uint8_t(*ptrtmp);
+
+			if (c >= 0x80 || (p_skip_cr && c == '\r')) {
+				break;
+			}
+
+			ptrtmp++;
+		}
+
+		ascii_len = ptrtmp - p_utf8;
+
+		if (ptrtmp == ptrtmp_limit || !*ptrtmp) {
+			if (ascii_len == 0) {
+				clear();
+				return OK; // empty string
+			}
+
+			resize(ascii_len + 1);
+			CharType *dst = ptrw();
+
+			for (int i = 0; i < ascii_len; ++i) {
+				dst[i] = uint8_t(p_utf8[i]);
+			}
+			dst[ascii_len] = 0;
+
+			return OK;
+		}
+	}
+
 	bool decode_error = false;
 	bool decode_failed = false;
 	{
-		const char *ptrtmp = p_utf8;
+		const char *ptrtmp = p_utf8 + ascii_len;
 		const char *ptrtmp_limit = &p_utf8[p_len];
 		int skip = 0;
 		uint8_t c_start = 0;
+
+		cstr_size = ascii_len;
+		str_size = ascii_len;
+
 		while (ptrtmp != ptrtmp_limit && *ptrtmp) {
 #if CHAR_MIN == 0
 			uint8_t c = *ptrtmp;
@@ -3397,6 +3435,18 @@ CharString String::utf8() const {
 	utf8s.resize(fl + 1);
 	uint8_t *cdst = (uint8_t *)utf8s.get_data();
 
+	if (fl == l) {
+		// Every character is encoded on one byte, so it's (almost always) plain ASCII.
+		for (int i = 0; i < l; i++) {
+			uint32_t c = d[i];
+			cdst[i] = c <= 0x7f ? c : 0x20;
+		}
+
+		cdst[l] = 0; //trailing zero
+
+		return utf8s;
+	}
+
 #define APPEND_CHAR(m_c) *(cdst++) = m_c
 
 	for (int i = 0; i < l; i++) {
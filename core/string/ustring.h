@@ -575,6 +575,9 @@ public:
 	String(const StrRange &p_range);
 
 private:
+	// Always a single UTF-32 CowData pointer. That keeps String inside Variant's inline
+	// storage and makes copies a refcount increment. ptrw() hands out this buffer, so there
+	// is no small string buffer and no compact (Latin-1 / UTF-8) representation.
 	CowData<CharType> _cowdata;
 	static const CharType _null;
 
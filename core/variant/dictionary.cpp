@@ -31,13 +31,15 @@
 
 #include "dictionary.h"
 
-#include "core/containers/ordered_hash_map.h"
+#include "core/containers/flat_ordered_hash_map.h"
 #include "core/os/safe_refcount.h"
 #include "core/variant/variant.h"
 
+typedef FlatOrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> DictionaryMap;
+
 struct DictionaryPrivate {
 	SafeRefCount refcount;
-	OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> variant_map;
+	DictionaryMap variant_map;
 };
 
 void Dictionary::get_key_list(List<Variant> *p_keys) const {
@@ -45,33 +47,35 @@ void Dictionary::get_key_list(List<Variant> *p_keys) const {
 		return;
 	}
 
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-		p_keys->push_back(E.key());
+	for (int64_t i = _p->variant_map.get_next_index(); i >= 0; i = _p->variant_map.get_next_index(i)) {
+		p_keys->push_back(_p->variant_map.get_key(i));
 	}
 }
 
 Variant Dictionary::get_key_at_index(int p_index) const {
-	int index = 0;
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-		if (index == p_index) {
-			return E.key();
-		}
-		index++;
+	if (p_index < 0) {
+		return Variant();
 	}
 
-	return Variant();
+	int64_t i = _p->variant_map.get_index_at_position(p_index);
+	if (i < 0) {
+		return Variant();
+	}
+
+	return _p->variant_map.get_key(i);
 }
 
 Variant Dictionary::get_value_at_index(int p_index) const {
-	int index = 0;
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-		if (index == p_index) {
-			return E.value();
-		}
-		index++;
+	if (p_index < 0) {
+		return Variant();
 	}
 
-	return Variant();
+	int64_t i = _p->variant_map.get_index_at_position(p_index);
+	if (i < 0) {
+		return Variant();
+	}
+
+	return _p->variant_map.get_value(i);
 }
 
 Variant &Dictionary::operator[](const Variant &p_key) {
@@ -82,30 +86,19 @@ const Variant &Dictionary::operator[](const Variant &p_key) const {
 	return _p->variant_map[p_key];
 }
 const Variant *Dictionary::getptr(const Variant &p_key) const {
-	OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::ConstElement E = ((const OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(p_key);
-
-	if (!E) {
-		return nullptr;
-	}
-	return &E.get();
+	return ((const DictionaryMap *)&_p->variant_map)->getptr(p_key);
 }
 
 Variant *Dictionary::getptr(const Variant &p_key) {
-	OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.find(p_key);
-
-	if (!E) {
-		return nullptr;
-	}
-	return &E.get();
+	return _p->variant_map.getptr(p_key);
 }
 
 Variant Dictionary::get_valid(const Variant &p_key) const {
-	OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::ConstElement E = ((const OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator> *)&_p->variant_map)->find(p_key);
-
-	if (!E) {
+	const Variant *result = getptr(p_key);
+	if (!result) {
 		return Variant();
 	}
-	return E.get();
+	return *result;
 }
 
 Variant Dictionary::get(const Variant &p_key, const Variant &p_default) const {
@@ -147,9 +140,9 @@ bool Dictionary::has_all(const Array &p_keys) const {
 }
 
 Variant Dictionary::find_key(const Variant &p_value) const {
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-		if (E.value() == p_value) {
-			return E.key();
+	for (int64_t i = _p->variant_map.get_next_index(); i >= 0; i = _p->variant_map.get_next_index(i)) {
+		if (_p->variant_map.get_value(i) == p_value) {
+			return _p->variant_map.get_key(i);
 		}
 	}
 	return Variant();
@@ -170,21 +163,23 @@ bool Dictionary::deep_equal(const Dictionary &p_dictionary, int p_recursion_coun
 	}
 
 	// Heavy O(n) check
-	OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element this_E = _p->variant_map.front();
-	OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element other_E = p_dictionary._p->variant_map.front();
+	const DictionaryMap &this_map = _p->variant_map;
+	const DictionaryMap &other_map = p_dictionary._p->variant_map;
+	int64_t this_i = this_map.get_next_index();
+	int64_t other_i = other_map.get_next_index();
 	p_recursion_count++;
-	while (this_E && other_E) {
+	while (this_i >= 0 && other_i >= 0) {
 		if (
-				!this_E.key().deep_equal(other_E.key(), p_recursion_count) ||
-				!this_E.value().deep_equal(other_E.value(), p_recursion_count)) {
+				!this_map.get_key(this_i).deep_equal(other_map.get_key(other_i), p_recursion_count) ||
+				!this_map.get_value(this_i).deep_equal(other_map.get_value(other_i), p_recursion_count)) {
 			return false;
 		}
 
-		this_E = this_E.next();
-		other_E = other_E.next();
+		this_i = this_map.get_next_index(this_i);
+		other_i = other_map.get_next_index(other_i);
 	}
 
-	return !this_E && !other_E;
+	return this_i < 0 && other_i < 0;
 }
 
 bool Dictionary::operator==(const Dictionary &p_dictionary) const {
@@ -217,9 +212,10 @@ void Dictionary::clear() {
 }
 
 void Dictionary::merge(const Dictionary &p_dictionary, bool p_overwrite) {
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = p_dictionary._p->variant_map.front(); E; E = E.next()) {
-		if (p_overwrite || !has(E.key())) {
-			this->operator[](E.key()) = E.value();
+	const DictionaryMap &other_map = p_dictionary._p->variant_map;
+	for (int64_t i = other_map.get_next_index(); i >= 0; i = other_map.get_next_index(i)) {
+		if (p_overwrite || !has(other_map.get_key(i))) {
+			this->operator[](other_map.get_key(i)) = other_map.get_value(i);
 		}
 	}
 }
@@ -242,9 +238,9 @@ uint32_t Dictionary::recursive_hash(int p_recursion_count) const {
 
 	uint32_t h = hash_murmur3_one_32(Variant::DICTIONARY);
 
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-		h = hash_murmur3_one_32(E.key().recursive_hash(p_recursion_count), h);
-		h = hash_murmur3_one_32(E.value().recursive_hash(p_recursion_count), h);
+	for (int64_t i = _p->variant_map.get_next_index(); i >= 0; i = _p->variant_map.get_next_index(i)) {
+		h = hash_murmur3_one_32(_p->variant_map.get_key(i).recursive_hash(p_recursion_count), h);
+		h = hash_murmur3_one_32(_p->variant_map.get_value(i).recursive_hash(p_recursion_count), h);
 	}
 
 	return hash_fmix32(h);
@@ -259,8 +255,8 @@ Array Dictionary::keys() const {
 	varr.resize(size());
 
 	int i = 0;
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-		varr[i] = E.key();
+	for (int64_t idx = _p->variant_map.get_next_index(); idx >= 0; idx = _p->variant_map.get_next_index(idx)) {
+		varr[i] = _p->variant_map.get_key(idx);
 		i++;
 	}
 
@@ -276,8 +272,8 @@ Array Dictionary::values() const {
 	varr.resize(size());
 
 	int i = 0;
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-		varr[i] = E.get();
+	for (int64_t idx = _p->variant_map.get_next_index(); idx >= 0; idx = _p->variant_map.get_next_index(idx)) {
+		varr[i] = _p->variant_map.get_value(idx);
 		i++;
 	}
 
@@ -285,26 +281,36 @@ Array Dictionary::values() const {
 }
 
 const Variant *Dictionary::next(const Variant *p_key) const {
+	int64_t i;
 	if (p_key == nullptr) {
 		// caller wants to get the first element
-		if (_p->variant_map.front()) {
-			return &_p->variant_map.front().key();
+		i = _p->variant_map.get_next_index();
+	} else {
+		i = _p->variant_map.find_index(*p_key);
+		if (i < 0) {
+			return nullptr;
 		}
-		return nullptr;
+		i = _p->variant_map.get_next_index(i);
 	}
-	OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.find(*p_key);
 
-	if (E && E.next()) {
-		return &E.next().key();
+	if (i < 0) {
+		return nullptr;
 	}
-	return nullptr;
+	return &_p->variant_map.get_key(i);
 }
 
 Dictionary Dictionary::duplicate(bool p_deep) const {
 	Dictionary n;
 
-	for (OrderedHashMap<Variant, Variant, VariantHasher, VariantComparator>::Element E = _p->variant_map.front(); E; E = E.next()) {
-		n[E.key()] = p_deep ? E.value().duplicate(true) : E.value();
+	if (!p_deep) {
+		// Keys are already unique and hashed, copy the entries as they are.
+		n._p->variant_map.append_unique(_p->variant_map);
+		return n;
+	}
+
+	n._p->variant_map.reserve(_p->variant_map.size());
+	for (int64_t i = _p->variant_map.get_next_index(); i >= 0; i = _p->variant_map.get_next_index(i)) {
+		n[_p->variant_map.get_key(i)] = _p->variant_map.get_value(i).duplicate(true);
 	}
 
 	return n;
@@ -70,6 +70,8 @@ public:
 	bool has_all(const Array &p_keys) const;
 	Variant find_key(const Variant &p_value) const;
 
+	// Pointers returned by getptr() and next() stay valid when keys are added,
+	// but any erase can move the remaining entries and invalidate them.
 	bool erase(const Variant &p_key);
 
 	bool deep_equal(const Dictionary &p_dictionary, int p_recursion_count = 0) const;
@@ -205,6 +205,7 @@ void initialize_physics() {
 	GLOBAL_DEF("physics/3d/pandemonium_physics/use_bvh", true);
 	GLOBAL_DEF("physics/3d/pandemonium_physics/bvh_collision_margin", 0.1);
 	ProjectSettings::get_singleton()->set_custom_property_info("physics/3d/pandemonium_physics/bvh_collision_margin", PropertyInfo(Variant::REAL, "physics/3d/pandemonium_physics/bvh_collision_margin", PROPERTY_HINT_RANGE, "0.0,2.0,0.01"));
+	GLOBAL_DEF("physics/3d/pandemonium_physics/use_multiple_threads", false);
 
 	/// 3D Physics Server
 	physics_server = PhysicsServerManager::new_server(ProjectSettings::get_singleton()->get(PhysicsServerManager::setting_property_name));
@@ -2436,6 +2437,7 @@ bool Main::iteration() {
 		// may be the same, and no interpolation takes place.
 		OS::get_singleton()->get_main_loop()->iteration_prepare();
 
+		PhysicsServer::get_singleton()->sync();
 		PhysicsServer::get_singleton()->flush_queries();
 
 		Physics2DServer::get_singleton()->sync();
@@ -2456,6 +2458,7 @@ bool Main::iteration() {
 
 		message_queue->flush();
 
+		PhysicsServer::get_singleton()->end_sync();
 		PhysicsServer::get_singleton()->step(frame_slice * time_scale);
 
 		Physics2DServer::get_singleton()->end_sync();
@@ -33,6 +33,7 @@
 
 #include "core/object/message_queue.h"
 #include "core/os/os.h"
+#include "core/os/thread_cache_allocator.h"
 #include "scene/main/node.h"
 #include "scene/main/scene_tree.h"
 #include "servers/audio_server.h"
@@ -87,6 +88,16 @@ void Performance::_bind_methods() {
 	BIND_ENUM_CONSTANT(NAVIGATION_EDGE_MERGE_COUNT);
 	BIND_ENUM_CONSTANT(NAVIGATION_EDGE_CONNECTION_COUNT);
 	BIND_ENUM_CONSTANT(NAVIGATION_EDGE_FREE_COUNT);
+	BIND_ENUM_CONSTANT(MEMORY_ALLOCATOR_RESERVED);
+	BIND_ENUM_CONSTANT(MEMORY_ALLOCATOR_CENTRAL_FREE);
+	BIND_ENUM_CONSTANT(MEMORY_ALLOCATOR_LARGE);
+	BIND_ENUM_CONSTANT(MEMORY_ALLOCATOR_THREAD_CACHES);
+	BIND_ENUM_CONSTANT(MEMORY_MESSAGE_BUFFER_PEAK);
+	BIND_ENUM_CONSTANT(NAVIGATION_SYNC_TIME);
+	BIND_ENUM_CONSTANT(NAVIGATION_AVOIDANCE_TIME);
+	BIND_ENUM_CONSTANT(NAVIGATION_CALLBACK_TIME);
+	BIND_ENUM_CONSTANT(NAVIGATION_PATH_QUERY_COUNT);
+	BIND_ENUM_CONSTANT(NAVIGATION_PATH_QUERY_TIME);
 
 	BIND_ENUM_CONSTANT(MONITOR_MAX);
 }
@@ -145,6 +156,16 @@ String Performance::get_monitor_name(Monitor p_monitor) const {
 		"navigation/edges_merged",
 		"navigation/edges_connected",
 		"navigation/edges_free",
+		"memory/allocator_reserved",
+		"memory/allocator_central_free",
+		"memory/allocator_large",
+		"memory/allocator_thread_caches",
+		"memory/msg_buf_peak",
+		"navigation/sync_time",
+		"navigation/avoidance_time",
+		"navigation/callback_time",
+		"navigation/path_queries",
+		"navigation/path_query_time",
 
 	};
 
@@ -235,6 +256,26 @@ float Performance::get_monitor(Monitor p_monitor) const {
 			return NavigationServer::get_singleton()->get_process_info(NavigationServer::INFO_EDGE_CONNECTION_COUNT);
 		case NAVIGATION_EDGE_FREE_COUNT:
 			return NavigationServer::get_singleton()->get_process_info(NavigationServer::INFO_EDGE_FREE_COUNT);
+		case MEMORY_ALLOCATOR_RESERVED:
+			return ThreadCacheAllocator::get_reserved_bytes();
+		case MEMORY_ALLOCATOR_CENTRAL_FREE:
+			return ThreadCacheAllocator::get_central_free_bytes();
+		case MEMORY_ALLOCATOR_LARGE:
+			return ThreadCacheAllocator::get_large_bytes();
+		case MEMORY_ALLOCATOR_THREAD_CACHES:
+			return ThreadCacheAllocator::get_thread_cache_count();
+		case MEMORY_MESSAGE_BUFFER_PEAK:
+			return MessageQueue::get_singleton()->get_peak_buffer_usage();
+		case NAVIGATION_SYNC_TIME:
+			return USEC_TO_SEC(NavigationServer::get_singleton()->get_process_info(NavigationServer::INFO_SYNC_TIME));
+		case NAVIGATION_AVOIDANCE_TIME:
+			return USEC_TO_SEC(NavigationServer::get_singleton()->get_process_info(NavigationServer::INFO_AVOIDANCE_TIME));
+		case NAVIGATION_CALLBACK_TIME:
+			return USEC_TO_SEC(NavigationServer::get_singleton()->get_process_info(NavigationServer::INFO_CALLBACK_TIME));
+		case NAVIGATION_PATH_QUERY_COUNT:
+			return NavigationServer::get_singleton()->get_process_info(NavigationServer::INFO_PATH_QUERY_COUNT);
+		case NAVIGATION_PATH_QUERY_TIME:
+			return USEC_TO_SEC(NavigationServer::get_singleton()->get_process_info(NavigationServer::INFO_PATH_QUERY_TIME));
 
 		default: {
 		}
@@ -289,6 +330,16 @@ Performance::MonitorType Performance::get_monitor_type(Monitor p_monitor) const
 		MONITOR_TYPE_QUANTITY,
 		MONITOR_TYPE_QUANTITY,
 		MONITOR_TYPE_QUANTITY,
+		MONITOR_TYPE_MEMORY,
+		MONITOR_TYPE_MEMORY,
+		MONITOR_TYPE_MEMORY,
+		MONITOR_TYPE_QUANTITY,
+		MONITOR_TYPE_MEMORY,
+		MONITOR_TYPE_TIME,
+		MONITOR_TYPE_TIME,
+		MONITOR_TYPE_TIME,
+		MONITOR_TYPE_QUANTITY,
+		MONITOR_TYPE_TIME,
 	};
 
 	return types[p_monitor];
@@ -93,6 +93,16 @@ public:
 		NAVIGATION_EDGE_MERGE_COUNT,
 		NAVIGATION_EDGE_CONNECTION_COUNT,
 		NAVIGATION_EDGE_FREE_COUNT,
+		MEMORY_ALLOCATOR_RESERVED,
+		MEMORY_ALLOCATOR_CENTRAL_FREE,
+		MEMORY_ALLOCATOR_LARGE,
+		MEMORY_ALLOCATOR_THREAD_CACHES,
+		MEMORY_MESSAGE_BUFFER_PEAK,
+		NAVIGATION_SYNC_TIME,
+		NAVIGATION_AVOIDANCE_TIME,
+		NAVIGATION_CALLBACK_TIME,
+		NAVIGATION_PATH_QUERY_COUNT,
+		NAVIGATION_PATH_QUERY_TIME,
 		MONITOR_MAX
 	};
 
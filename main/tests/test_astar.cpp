@@ -32,6 +32,7 @@
 #include "test_astar.h"
 
 #include "core/math/a_star.h"
+#include "core/math/a_star_grid_2d.h"
 #include "core/math/math_funcs.h"
 #include "core/os/os.h"
 
@@ -376,6 +377,210 @@ bool test_solutions() {
 	return true;
 }
 
+static bool _grid_walkable(const Ref<AStarGrid2D> &p_grid, const Vector2i &p_id) {
+	return p_grid->is_in_bounds(p_id) && !p_grid->is_point_solid(p_id);
+}
+
+// Checks that every step of the path is a move the diagonal mode allows, and
+// returns its cost, or -1 when it isn't a valid path from p_from to p_to.
+static real_t _grid_path_cost(const Ref<AStarGrid2D> &p_grid, const PoolVector<Vector2i> &p_path, const Vector2i &p_from, const Vector2i &p_to) {
+	if (p_path.size() == 0 || p_path[0] != p_from || p_path[p_path.size() - 1] != p_to) {
+		return -1;
+	}
+
+	real_t cost = 0;
+	for (int i = 1; i < p_path.size(); i++) {
+		const Vector2i from = p_path[i - 1];
+		const Vector2i step = p_path[i] - from;
+		if (ABS(step.x) > 1 || ABS(step.y) > 1 || step == Vector2i() || !_grid_walkable(p_grid, p_path[i])) {
+			return -1;
+		}
+
+		if (step.x == 0 || step.y == 0) {
+			cost += 1;
+			continue;
+		}
+
+		const bool side_x = _grid_walkable(p_grid, Vector2i(from.x + step.x, from.y));
+		const bool side_y = _grid_walkable(p_grid, Vector2i(from.x, from.y + step.y));
+		switch (p_grid->get_diagonal_mode()) {
+			case AStarGrid2D::DIAGONAL_MODE_NEVER:
+				return -1;
+			case AStarGrid2D::DIAGONAL_MODE_AT_LEAST_ONE_WALKABLE:
+				if (!side_x && !side_y) {
+					return -1;
+				}
+				break;
+			case AStarGrid2D::DIAGONAL_MODE_ONLY_IF_NO_OBSTACLES:
+				if (!side_x || !side_y) {
+					return -1;
+				}
+				break;
+			default:
+				break;
+		}
+		cost += Math_SQRT2;
+	}
+	return cost;
+}
+
+// Finds the path with and without jumping, both must be equally long valid paths, or both empty.
+static bool _grid_compare_jumping(Ref<AStarGrid2D> &p_grid, const Vector2i &p_from, const Vector2i &p_to) {
+	p_grid->set_jumping_enabled(false);
+	PoolVector<Vector2i> plain_path = p_grid->get_id_path(p_from, p_to);
+	p_grid->set_jumping_enabled(true);
+	PoolVector<Vector2i> jump_path = p_grid->get_id_path(p_from, p_to);
+
+	if (plain_path.size() == 0 || jump_path.size() == 0) {
+		if (plain_path.size() != jump_path.size()) {
+			printf("Mode %d, from %s to %s: only one of the searches found a path\n", p_grid->get_diagonal_mode(), String(p_from).utf8().get_data(), String(p_to).utf8().get_data());
+			return false;
+		}
+		return true;
+	}
+
+	const real_t plain_cost = _grid_path_cost(p_grid, plain_path, p_from, p_to);
+	const real_t jump_cost = _grid_path_cost(p_grid, jump_path, p_from, p_to);
+	if (plain_cost < 0 || jump_cost < 0 || !Math::is_equal_approx(plain_cost, jump_cost)) {
+		printf("Mode %d, from %s to %s: A* gives %.6f, jump point search gives %.6f\n", p_grid->get_diagonal_mode(), String(p_from).utf8().get_data(), String(p_to).utf8().get_data(), plain_cost, jump_cost);
+		return false;
+	}
+	return true;
+}
+
+bool test_grid_jumping_random() {
+	// Sizes around the 64 cells of a mask word, lines one cell wide, and a region not at the origin.
+	const Size2i sizes[] = {
+		Size2i(130, 70),
+		Size2i(70, 130),
+		Size2i(64, 64),
+		Size2i(65, 3),
+		Size2i(3, 65),
+		Size2i(1, 150),
+		Size2i(150, 1),
+		Size2i(129, 2),
+		Size2i(63, 65),
+	};
+	const int size_count = sizeof(sizes) / sizeof(sizes[0]);
+
+	Math::seed(0);
+
+	for (int mode = 0; mode < AStarGrid2D::DIAGONAL_MODE_MAX; mode++) {
+		int found = 0;
+
+		for (int size = 0; size < size_count; size++) {
+			for (int test = 0; test < 40; test++) {
+				Ref<AStarGrid2D> grid;
+				grid.instance();
+				grid->set_region(Rect2i(Vector2i(-7, 3), sizes[size]));
+				grid->set_diagonal_mode((AStarGrid2D::DiagonalMode)mode);
+				grid->set_default_heuristic(AStarGrid2D::HEURISTIC_EUCLIDEAN);
+				grid->update();
+
+				const Rect2i region = grid->get_region();
+				const int solid_percent = (test % 4) * 12;
+				for (int y = region.position.y; y < region.position.y + region.size.y; y++) {
+					for (int x = region.position.x; x < region.position.x + region.size.x; x++) {
+						if ((int)(Math::rand() % 100) < solid_percent) {
+							grid->set_point_solid(Vector2i(x, y));
+						}
+					}
+				}
+
+				for (int query = 0; query < 5; query++) {
+					const Vector2i from = region.position + Vector2i(Math::rand() % region.size.x, Math::rand() % region.size.y);
+					const Vector2i to = region.position + Vector2i(Math::rand() % region.size.x, Math::rand() % region.size.y);
+					if (!_grid_compare_jumping(grid, from, to)) {
+						return false;
+					}
+					if (grid->get_id_path(from, to).size() > 0) {
+						found++;
+					}
+				}
+			}
+		}
+
+		printf("Diagonal mode %d: %d paths found\n", mode, found);
+	}
+	return true;
+}
+
+bool test_grid_jumping_lines() {
+	for (int mode = 0; mode < AStarGrid2D::DIAGONAL_MODE_MAX; mode++) {
+		for (int transposed = 0; transposed < 2; transposed++) {
+			// A corridor 3 cells wide and 200 long. Rows or, transposed, columns so the vertical
+			// jumps which use the transposed mask are covered too.
+			const int length = 200;
+			Ref<AStarGrid2D> grid;
+			grid.instance();
+			grid->set_region(Rect2i(0, 0, transposed ? 3 : length, transposed ? length : 3));
+			grid->set_diagonal_mode((AStarGrid2D::DiagonalMode)mode);
+			grid->update();
+
+#define GRID_ID(m_along, m_across) (transposed ? Vector2i(m_across, m_along) : Vector2i(m_along, m_across))
+
+			// Straight along the grid edge, over the word boundaries.
+			PoolVector<Vector2i> path = grid->get_id_path(GRID_ID(0, 0), GRID_ID(length - 1, 0));
+			if (path.size() != length || !_grid_compare_jumping(grid, GRID_ID(0, 0), GRID_ID(length - 1, 0))) {
+				printf("Mode %d: the straight path along the edge has %d cells\n", mode, path.size());
+				return false;
+			}
+
+			// Obstacles right before, on and after the word boundaries, next to the lines the jumps scan.
+			const int obstacles[] = { 62, 63, 64, 65, 127, 128, 129, 191, 192 };
+			for (int i = 0; i < (int)(sizeof(obstacles) / sizeof(obstacles[0])); i++) {
+				grid->set_point_solid(GRID_ID(obstacles[i], (i % 2) ? 0 : 2));
+			}
+			for (int from = 0; from < 3; from++) {
+				for (int to = 0; to < 3; to++) {
+					if (!_grid_compare_jumping(grid, GRID_ID(0, from), GRID_ID(length - 1, to)) ||
+							!_grid_compare_jumping(grid, GRID_ID(length - 1, from), GRID_ID(0, to)) ||
+							!_grid_compare_jumping(grid, GRID_ID(63, from), GRID_ID(129, to))) {
+						return false;
+					}
+				}
+			}
+
+			// A wall across the corridor right at a word boundary, nothing gets through.
+			grid->fill_solid_region(Rect2i(GRID_ID(128, 0), transposed ? Size2i(3, 1) : Size2i(1, 3)));
+			if (grid->get_id_path(GRID_ID(0, 1), GRID_ID(length - 1, 1)).size() != 0 || !_grid_compare_jumping(grid, GRID_ID(0, 1), GRID_ID(length - 1, 1))) {
+				printf("Mode %d: a path went through the wall\n", mode);
+				return false;
+			}
+
+#undef GRID_ID
+		}
+	}
+	return true;
+}
+
+bool test_grid_flow_field_cap() {
+	Ref<AStarGrid2D> grid;
+	grid.instance();
+	grid->set_region(Rect2i(0, 0, 40, 40));
+	grid->update();
+
+	const real_t first_distance = grid->get_flow_distance(Vector2i(0, 0), Vector2i(39, 0));
+
+	// A goal that keeps moving, like one following the player, builds a field for every cell it visits.
+	const int goal_count = 50;
+	for (int i = 0; i < goal_count; i++) {
+		grid->get_flow_direction(Vector2i(0, 0), Vector2i(i % 40, 1 + i / 40));
+		if (grid->get_flow_field_count() > 16) {
+			printf("%d flow fields kept after %d goals, expected 16 at most\n", grid->get_flow_field_count(), i + 2);
+			return false;
+		}
+	}
+
+	if (grid->get_flow_field_count() != 16) {
+		printf("%d flow fields kept after %d goals, expected 16\n", grid->get_flow_field_count(), goal_count + 1);
+		return false;
+	}
+
+	// The field of the first goal was dropped, it's built again when needed.
+	return Math::is_equal_approx(grid->get_flow_distance(Vector2i(0, 0), Vector2i(39, 0)), first_distance) && Math::is_equal_approx(first_distance, 39);
+}
+
 typedef bool (*TestFunc)();
 
 TestFunc test_funcs[] = {
@@ -383,6 +588,9 @@ TestFunc test_funcs[] = {
 	test_abcx,
 	test_add_remove,
 	test_solutions,
+	test_grid_jumping_random,
+	test_grid_jumping_lines,
+	test_grid_flow_field_cap,
 	nullptr
 };
 
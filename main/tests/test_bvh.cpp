@@ -0,0 +1,377 @@
+/*************************************************************************/
+/*  test_bvh.cpp                                                         */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_bvh.h"
+
+#include "core/math/bvh.h"
+#include "core/math/geometry.h"
+#include "core/math/random_pcg.h"
+#include "core/os/os.h"
+
+namespace TestBVH {
+
+// Compares the scalar and SIMD leaf tests, and times the leaf loops and whole tree culls.
+
+enum {
+	LEAF_ITEMS = 128,
+	LEAF_ITERATIONS = 20000,
+	TREE_ITEMS = 10000,
+	TREE_ITERATIONS = 2000,
+	TREE_RESULT_MAX = 1024,
+};
+
+typedef BVH_LeafBounds<AABB, Vector3, LEAF_ITEMS> LeafBounds;
+typedef LeafBounds::ABB ABB;
+
+static RandomPCG rng;
+
+template <class T>
+class UserPairTestFunction {
+public:
+	static bool user_pair_check(const T *p_a, const T *p_b) {
+		return true;
+	}
+};
+
+template <class T>
+class UserCullTestFunction {
+public:
+	static bool user_cull_check(const T *p_a, const T *p_b) {
+		return true;
+	}
+};
+
+static AABB random_aabb(real_t p_world_size, real_t p_max_size) {
+	Vector3 pos(rng.randf(), rng.randf(), rng.randf());
+	Vector3 size(rng.randf(), rng.randf(), rng.randf());
+	return AABB(pos * p_world_size, size * p_max_size);
+}
+
+static ABB random_abb(real_t p_world_size, real_t p_max_size) {
+	ABB abb;
+	abb.from(random_aabb(p_world_size, p_max_size));
+	return abb;
+}
+
+static void fill_leaf(LeafBounds &r_leaf) {
+	for (int n = 0; n < LEAF_ITEMS; n++) {
+		r_leaf.set(n, random_abb(100, 10));
+	}
+}
+
+static bool same_hits(const uint32_t *p_a, uint32_t p_num_a, const uint32_t *p_b, uint32_t p_num_b) {
+	if (p_num_a != p_num_b) {
+		return false;
+	}
+	for (uint32_t n = 0; n < p_num_a; n++) {
+		if (p_a[n] != p_b[n]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void print_timing(const char *p_name, uint64_t p_scalar_usec, uint64_t p_simd_usec) {
+	if (p_simd_usec) {
+		OS::get_singleton()->print("\t%s: scalar %d usec, simd %d usec (%.2fx)\n", p_name, (int)p_scalar_usec, (int)p_simd_usec, (double)p_scalar_usec / p_simd_usec);
+	} else {
+		OS::get_singleton()->print("\t%s: scalar %d usec\n", p_name, (int)p_scalar_usec);
+	}
+}
+
+bool test_leaf_aabb() {
+	LeafBounds *leaf = memnew(LeafBounds);
+	fill_leaf(*leaf);
+
+	ABB testers[64];
+	for (int n = 0; n < 64; n++) {
+		testers[n] = random_abb(100, 20);
+	}
+
+	uint32_t scalar_hits[LEAF_ITEMS];
+	uint32_t total_scalar = 0;
+
+	uint64_t t = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < LEAF_ITERATIONS; i++) {
+		total_scalar += leaf->find_intersecting_scalar(LEAF_ITEMS - (i & 3), testers[i & 63], scalar_hits);
+	}
+	uint64_t scalar_usec = OS::get_singleton()->get_ticks_usec() - t;
+	uint64_t simd_usec = 0;
+
+	bool ok = total_scalar > 0;
+
+#ifdef BVH_SIMD
+	uint32_t simd_hits[LEAF_ITEMS];
+	uint32_t total_simd = 0;
+
+	t = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < LEAF_ITERATIONS; i++) {
+		total_simd += leaf->find_intersecting_simd(LEAF_ITEMS - (i & 3), testers[i & 63], simd_hits);
+	}
+	simd_usec = OS::get_singleton()->get_ticks_usec() - t;
+
+	ok = ok && total_simd == total_scalar;
+
+	for (int n = 0; n < 64; n++) {
+		uint32_t num_scalar = leaf->find_intersecting_scalar(LEAF_ITEMS - (n & 3), testers[n], scalar_hits);
+		uint32_t num_simd = leaf->find_intersecting_simd(LEAF_ITEMS - (n & 3), testers[n], simd_hits);
+		ok = ok && same_hits(scalar_hits, num_scalar, simd_hits, num_simd);
+	}
+#endif
+
+	print_timing("leaf aabb", scalar_usec, simd_usec);
+
+	memdelete(leaf);
+	return ok;
+}
+
+bool test_leaf_point() {
+	LeafBounds *leaf = memnew(LeafBounds);
+	fill_leaf(*leaf);
+
+	Vector3 points[64];
+	for (int n = 0; n < 64; n++) {
+		points[n] = Vector3(rng.randf(), rng.randf(), rng.randf()) * 100;
+	}
+
+	uint32_t scalar_hits[LEAF_ITEMS];
+	uint32_t total_scalar = 0;
+
+	uint64_t t = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < LEAF_ITERATIONS; i++) {
+		total_scalar += leaf->find_containing_point_scalar(LEAF_ITEMS, points[i & 63], scalar_hits);
+	}
+	uint64_t scalar_usec = OS::get_singleton()->get_ticks_usec() - t;
+	uint64_t simd_usec = 0;
+
+	bool ok = true;
+
+#ifdef BVH_SIMD
+	uint32_t simd_hits[LEAF_ITEMS];
+	uint32_t total_simd = 0;
+
+	t = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < LEAF_ITERATIONS; i++) {
+		total_simd += leaf->find_containing_point_simd(LEAF_ITEMS, points[i & 63], simd_hits);
+	}
+	simd_usec = OS::get_singleton()->get_ticks_usec() - t;
+
+	ok = ok && total_simd == total_scalar;
+
+	for (int n = 0; n < 64; n++) {
+		uint32_t num_scalar = leaf->find_containing_point_scalar(LEAF_ITEMS, points[n], scalar_hits);
+		uint32_t num_simd = leaf->find_containing_point_simd(LEAF_ITEMS, points[n], simd_hits);
+		ok = ok && same_hits(scalar_hits, num_scalar, simd_hits, num_simd);
+	}
+#endif
+
+	print_timing("leaf point", scalar_usec, simd_usec);
+
+	memdelete(leaf);
+	return ok;
+}
+
+bool test_leaf_segment() {
+	LeafBounds *leaf = memnew(LeafBounds);
+	fill_leaf(*leaf);
+
+	ABB::Segment segments[64];
+	for (int n = 0; n < 64; n++) {
+		segments[n].from = Vector3(rng.randf(), rng.randf(), rng.randf()) * 100;
+		segments[n].to = segments[n].from + Vector3(rng.randf() - 0.5f, rng.randf() - 0.5f, rng.randf() - 0.5f) * 50;
+	}
+
+	uint32_t scalar_hits[LEAF_ITEMS];
+	uint32_t total_scalar = 0;
+
+	uint64_t t = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < LEAF_ITERATIONS; i++) {
+		total_scalar += leaf->find_intersecting_segment_scalar(LEAF_ITEMS, segments[i & 63], scalar_hits);
+	}
+	uint64_t scalar_usec = OS::get_singleton()->get_ticks_usec() - t;
+	uint64_t simd_usec = 0;
+
+	bool ok = total_scalar > 0;
+
+#ifdef BVH_SIMD
+	uint32_t simd_hits[LEAF_ITEMS];
+	uint32_t total_simd = 0;
+
+	t = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < LEAF_ITERATIONS; i++) {
+		total_simd += leaf->find_intersecting_segment_simd(LEAF_ITEMS, segments[i & 63], simd_hits);
+	}
+	simd_usec = OS::get_singleton()->get_ticks_usec() - t;
+
+	ok = ok && total_simd == total_scalar;
+
+	for (int n = 0; n < 64; n++) {
+		uint32_t num_scalar = leaf->find_intersecting_segment_scalar(LEAF_ITEMS, segments[n], scalar_hits);
+		uint32_t num_simd = leaf->find_intersecting_segment_simd(LEAF_ITEMS, segments[n], simd_hits);
+		ok = ok && same_hits(scalar_hits, num_scalar, simd_hits, num_simd);
+	}
+#endif
+
+	print_timing("leaf segment", scalar_usec, simd_usec);
+
+	memdelete(leaf);
+	return ok;
+}
+
+bool test_leaf_convex() {
+	LeafBounds *leaf = memnew(LeafBounds);
+	fill_leaf(*leaf);
+
+	// a box in the middle of the items, with every plane cutting the leaf
+	PoolVector<Plane> box_planes = Geometry::build_box_planes(Vector3(20, 20, 20));
+	Vector<Plane> planes;
+	for (int n = 0; n < box_planes.size(); n++) {
+		Plane p = box_planes[n];
+		p.d += p.normal.dot(Vector3(50, 50, 50));
+		planes.push_back(p);
+	}
+
+	ABB::ConvexHull hull;
+	hull.planes = planes.ptr();
+	hull.num_planes = planes.size();
+	hull.points = nullptr;
+	hull.num_points = 0;
+
+	uint32_t plane_ids[6] = { 0, 1, 2, 3, 4, 5 };
+
+	uint32_t scalar_hits[LEAF_ITEMS];
+	uint32_t total_scalar = 0;
+
+	uint64_t t = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < LEAF_ITERATIONS; i++) {
+		total_scalar += leaf->find_intersecting_convex_scalar(LEAF_ITEMS - (i & 3), hull, plane_ids, 6, scalar_hits);
+	}
+	uint64_t scalar_usec = OS::get_singleton()->get_ticks_usec() - t;
+	uint64_t simd_usec = 0;
+
+	bool ok = total_scalar > 0;
+
+#ifdef BVH_SIMD
+	uint32_t simd_hits[LEAF_ITEMS];
+	uint32_t total_simd = 0;
+
+	t = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < LEAF_ITERATIONS; i++) {
+		total_simd += leaf->find_intersecting_convex_simd(LEAF_ITEMS - (i & 3), hull, plane_ids, 6, simd_hits);
+	}
+	simd_usec = OS::get_singleton()->get_ticks_usec() - t;
+
+	ok = ok && total_simd == total_scalar;
+
+	uint32_t num_scalar = leaf->find_intersecting_convex_scalar(LEAF_ITEMS, hull, plane_ids, 6, scalar_hits);
+	uint32_t num_simd = leaf->find_intersecting_convex_simd(LEAF_ITEMS, hull, plane_ids, 6, simd_hits);
+	ok = ok && same_hits(scalar_hits, num_scalar, simd_hits, num_simd);
+#endif
+
+	print_timing("leaf convex", scalar_usec, simd_usec);
+
+	memdelete(leaf);
+	return ok;
+}
+
+bool test_tree_cull() {
+	BVH_Manager<int, 1, false, 128, UserPairTestFunction<int>, UserCullTestFunction<int>> bvh;
+	bvh.params_set_thread_safe(false);
+
+	LocalVector<int> items;
+	items.resize(TREE_ITEMS);
+
+	for (int n = 0; n < TREE_ITEMS; n++) {
+		items[n] = n;
+		bvh.create(&items[n], true, 0, 1, random_aabb(1000, 10));
+	}
+
+	int *results[TREE_RESULT_MAX];
+	uint64_t total = 0;
+
+	uint64_t t = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < TREE_ITERATIONS; i++) {
+		total += bvh.cull_aabb(random_aabb(1000, 100), results, TREE_RESULT_MAX, nullptr);
+	}
+	uint64_t aabb_usec = OS::get_singleton()->get_ticks_usec() - t;
+
+	t = OS::get_singleton()->get_ticks_usec();
+	for (int i = 0; i < TREE_ITERATIONS; i++) {
+		Vector3 from = Vector3(rng.randf(), rng.randf(), rng.randf()) * 1000;
+		Vector3 to = Vector3(rng.randf(), rng.randf(), rng.randf()) * 1000;
+		total += bvh.cull_segment(from, to, results, TREE_RESULT_MAX, nullptr);
+	}
+	uint64_t segment_usec = OS::get_singleton()->get_ticks_usec() - t;
+
+	OS::get_singleton()->print("\ttree cull (%d items, %s): aabb %d usec, segment %d usec, %d hits\n", TREE_ITEMS,
+#ifdef BVH_SIMD
+			"simd",
+#else
+			"scalar",
+#endif
+			(int)aabb_usec, (int)segment_usec, (int)total);
+
+	return total > 0;
+}
+
+typedef bool (*TestFunc)();
+
+TestFunc test_funcs[] = {
+	test_leaf_aabb,
+	test_leaf_point,
+	test_leaf_segment,
+	test_leaf_convex,
+	test_tree_cull,
+	nullptr
+};
+
+MainLoop *test() {
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!test_funcs[count]) {
+			break;
+		}
+		bool pass = test_funcs[count]();
+		if (pass) {
+			passed++;
+		}
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+	return nullptr;
+}
+
+} // namespace TestBVH
@@ -37,14 +37,19 @@
 
 #include "test_astar.h"
 #include "test_basis.h"
+#include "test_bvh.h"
 #include "test_crypto.h"
 #include "test_gdscript.h"
 #include "test_gui.h"
 #include "test_math.h"
+#include "test_navigation.h"
+#include "test_navigation_bench.h"
 #include "test_oa_hash_map.h"
 #include "test_ordered_hash_map.h"
 #include "test_physics.h"
 #include "test_physics_2d.h"
+#include "test_physics_bench.h"
+#include "test_physics_snapshot.h"
 #include "test_render.h"
 #include "test_shader_lang.h"
 #include "test_string.h"
@@ -54,12 +59,16 @@
 
 const char **tests_get_names() {
 	static const char *test_names[] = {
-		//"string",
+		"string",
 		"math",
 		"basis",
 		"transform",
 		"physics",
 		"physics_2d",
+		"physics_bench",
+		"physics_snapshot",
+		"navigation_bench",
+		"bvh",
 		"render",
 		"oa_hash_map",
 		"gui",
@@ -70,6 +79,7 @@ const char **tests_get_names() {
 		"gd_bytecode",
 		"ordered_hash_map",
 		"astar",
+		"navigation",
 		"xml_parser",
 		"theme",
 		nullptr
@@ -79,9 +89,9 @@ const char **tests_get_names() {
 }
 
 MainLoop *test_main(String p_test, const List<String> &p_args) {
-	//if (p_test == "string") {
-	//	return TestString::test();
-	//}
+	if (p_test == "string") {
+		return TestString::test();
+	}
 
 	if (p_test == "math") {
 		return TestMath::test();
@@ -103,6 +113,22 @@ MainLoop *test_main(String p_test, const List<String> &p_args) {
 		return TestPhysics2D::test();
 	}
 
+	if (p_test == "physics_bench") {
+		return TestPhysicsBench::test();
+	}
+
+	if (p_test == "physics_snapshot") {
+		return TestPhysicsSnapshot::test();
+	}
+
+	if (p_test == "navigation_bench") {
+		return TestNavigationBench::test(p_args);
+	}
+
+	if (p_test == "bvh") {
+		return TestBVH::test();
+	}
+
 	if (p_test == "render") {
 		return TestRender::test();
 	}
@@ -149,6 +175,10 @@ MainLoop *test_main(String p_test, const List<String> &p_args) {
 		return TestAStar::test();
 	}
 
+	if (p_test == "navigation") {
+		return TestNavigation::test();
+	}
+
 	if (p_test == "xml_parser") {
 		return TestXMLParser::test();
 	}
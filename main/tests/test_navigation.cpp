@@ -0,0 +1,227 @@
+/*************************************************************************/
+/*  test_navigation.cpp                                                  */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_navigation.h"
+
+#include "core/os/os.h"
+#include "scene/resources/navigation/navigation_mesh.h"
+#include "scene/resources/navigation/navigation_mesh_source_geometry_data_3d.h"
+#include "servers/navigation/navigation_mesh_generator.h"
+#include "servers/navigation_server.h"
+
+namespace TestNavigation {
+
+// A ramp going up along X, baked in tiles, with a path across it. The tiles
+// start at different heights, their edges must still connect.
+bool test_tiled_bake_slope() {
+	const int quads = 40;
+	const real_t size = 20.0;
+
+	PoolVector3Array faces;
+	for (int x = 0; x < quads; x++) {
+		for (int z = 0; z < quads; z++) {
+			const real_t x0 = x * size / quads;
+			const real_t x1 = (x + 1) * size / quads;
+			const real_t z0 = z * size / quads;
+			const real_t z1 = (z + 1) * size / quads;
+			const real_t y0 = x0 * 0.3 + 0.11;
+			const real_t y1 = x1 * 0.3 + 0.11;
+
+			faces.push_back(Vector3(x0, y0, z0));
+			faces.push_back(Vector3(x1, y1, z0));
+			faces.push_back(Vector3(x1, y1, z1));
+			faces.push_back(Vector3(x0, y0, z0));
+			faces.push_back(Vector3(x1, y1, z1));
+			faces.push_back(Vector3(x0, y0, z1));
+		}
+	}
+
+	Ref<NavigationMeshSourceGeometryData3D> source_geometry;
+	source_geometry.instance();
+	source_geometry->add_faces(faces, Transform());
+
+	Ref<NavigationMesh> navigation_mesh;
+	navigation_mesh.instance();
+	navigation_mesh->set_tile_size(5.0);
+	NavigationMeshGenerator::get_singleton()->bake_3d_from_source_geometry_data(navigation_mesh, source_geometry);
+
+	if (navigation_mesh->get_polygon_count() == 0) {
+		OS::get_singleton()->print("\tNothing was baked\n");
+		return false;
+	}
+
+	NavigationServer *ns = NavigationServer::get_singleton();
+	RID map = ns->map_create();
+	ns->map_set_cell_size(map, navigation_mesh->get_cell_size());
+	ns->map_set_cell_height(map, navigation_mesh->get_cell_height());
+	ns->map_set_active(map, true);
+
+	RID region = ns->region_create();
+	ns->region_set_map(region, map);
+	ns->region_set_navigation_mesh(region, navigation_mesh);
+	ns->map_force_update(map);
+
+	const Vector3 from(2.0, 2.0 * 0.3 + 0.11, 10.0);
+	const Vector3 to(18.0, 18.0 * 0.3 + 0.11, 10.0);
+	Vector<Vector3> path = ns->map_get_path(map, from, to, true);
+
+	ns->free(region);
+	ns->free(map);
+	ns->process(0.0);
+
+	bool ok = path.size() >= 2;
+	ok = ok && path[0].distance_to(from) < 0.5;
+	ok = ok && path[path.size() - 1].distance_to(to) < 0.5;
+	if (!ok) {
+		OS::get_singleton()->print("\tThe path does not cross the tiles, it ends at %s\n", path.size() ? String(path[path.size() - 1]).utf8().get_data() : "nothing");
+	}
+	return ok;
+}
+
+// An agent following a goal that moves every frame. The flow fields to the old
+// goal positions must not be kept around, while a field sampled only every few
+// frames must stay.
+bool test_flow_field_moving_goal() {
+	PoolVector3Array vertices;
+	vertices.push_back(Vector3(0, 0, 0));
+	vertices.push_back(Vector3(0, 0, 20));
+	vertices.push_back(Vector3(20, 0, 20));
+	vertices.push_back(Vector3(20, 0, 0));
+
+	Vector<int> polygon;
+	polygon.push_back(0);
+	polygon.push_back(1);
+	polygon.push_back(2);
+	polygon.push_back(3);
+
+	Ref<NavigationMesh> navigation_mesh;
+	navigation_mesh.instance();
+	navigation_mesh->set_vertices(vertices);
+	navigation_mesh->add_polygon(polygon);
+
+	NavigationServer *ns = NavigationServer::get_singleton();
+	RID map = ns->map_create();
+	ns->map_set_active(map, true);
+
+	RID region = ns->region_create();
+	ns->region_set_map(region, map);
+	ns->region_set_navigation_mesh(region, navigation_mesh);
+	ns->map_force_update(map);
+
+	const Vector3 agent_position(1.0, 0.0, 1.0);
+	int max_count = 0;
+
+	for (int i = 0; i < 300; i++) {
+		const Vector3 goal(2.0 + i * 0.05, 0.0, 10.0);
+		ns->map_get_flow_direction(map, goal, agent_position);
+		ns->process(1.0 / 60.0);
+
+		max_count = MAX(max_count, ns->map_get_process_info(map, NavigationServer::INFO_FLOW_FIELD_COUNT));
+	}
+
+	// Agents that only sample every few frames must still get the field once it's built,
+	// it must not be dropped and rebuilt in between.
+	const Vector3 sparse_goal(18.0, 0.0, 18.0);
+	ns->map_request_flow_field(map, sparse_goal);
+
+	int sparse_samples = 0;
+	int sparse_hits = 0;
+	bool sparse_lost = false;
+	for (int i = 0; i < 600; i++) {
+		if (i % 20 == 0) {
+			const bool hit = ns->map_get_flow_distance(map, sparse_goal, agent_position) >= 0.0;
+			sparse_lost = sparse_lost || (sparse_hits > 0 && !hit);
+			sparse_samples++;
+			if (hit) {
+				sparse_hits++;
+			}
+		}
+		OS::get_singleton()->delay_usec(1000);
+		ns->process(1.0 / 60.0);
+	}
+
+	// Once nothing samples them anymore, all of them go away.
+	int count = ns->map_get_process_info(map, NavigationServer::INFO_FLOW_FIELD_COUNT);
+	for (int i = 0; i < 2000 && count > 0; i++) {
+		OS::get_singleton()->delay_usec(1000);
+		ns->process(1.0 / 60.0);
+		count = ns->map_get_process_info(map, NavigationServer::INFO_FLOW_FIELD_COUNT);
+	}
+
+	ns->free(region);
+	ns->free(map);
+	ns->process(0.0);
+
+	if (max_count > 64) {
+		OS::get_singleton()->print("\tThe map kept %d flow fields\n", max_count);
+		return false;
+	}
+	if (sparse_hits == 0 || sparse_lost) {
+		OS::get_singleton()->print("\tSampling every 20 frames found the field %d times out of %d%s\n", sparse_hits, sparse_samples, sparse_lost ? ", and lost it after it was built" : "");
+		return false;
+	}
+	if (count > 0) {
+		OS::get_singleton()->print("\t%d flow fields are left after they stopped being used\n", count);
+		return false;
+	}
+	return true;
+}
+
+typedef bool (*TestFunc)();
+
+TestFunc test_funcs[] = {
+	test_tiled_bake_slope,
+	test_flow_field_moving_goal,
+	nullptr
+};
+
+MainLoop *test() {
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!test_funcs[count]) {
+			break;
+		}
+		bool pass = test_funcs[count]();
+		if (pass) {
+			passed++;
+		}
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+	return nullptr;
+}
+
+} // namespace TestNavigation
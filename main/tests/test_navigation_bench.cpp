@@ -0,0 +1,405 @@
+/*************************************************************************/
+/*  test_navigation_bench.cpp                                            */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_navigation_bench.h"
+
+#include "core/config/project_settings.h"
+#include "core/containers/local_vector.h"
+#include "core/io/json.h"
+#include "core/io/resource_loader.h"
+#include "core/math/random_pcg.h"
+#include "core/os/os.h"
+#include "scene/resources/navigation/navigation_mesh.h"
+#include "servers/navigation_server.h"
+
+namespace TestNavigationBench {
+
+// Headless benchmark of the navigation server. Puts a large navigation mesh
+// on a map, runs random path queries on it, then steps an avoidance crowd, and
+// prints the percentiles of the timings as JSON on stdout, so the results can
+// be compared between builds and project settings. Progress goes to stderr.
+//
+// The navigation mesh is generated, a grid of tiles with random blocks cut
+// out, unless one is given with `--navmesh <path>`.
+
+enum {
+	TILES = 4, // per side
+	TILE_CELLS = 64, // per side
+	BLOCKS_PER_TILE = 48,
+	PATH_QUERIES = 5000,
+	CROWD_AGENTS = 4000,
+	CROWD_TICKS = 300,
+};
+
+static const real_t CELL_SIZE = 1.0;
+static const real_t DELTA = 1.0 / 60.0;
+
+static RandomPCG rng;
+
+// Microseconds spent on something, once per query or tick.
+struct Samples {
+	LocalVector<uint64_t> values;
+
+	void add(uint64_t p_usec) {
+		values.push_back(p_usec);
+	}
+
+	Dictionary to_dict() const {
+		Dictionary d;
+		d["count"] = values.size();
+		if (values.empty()) {
+			return d;
+		}
+
+		LocalVector<uint64_t> sorted = values;
+		sorted.sort();
+
+		uint64_t total = 0;
+		for (uint32_t i = 0; i < sorted.size(); i++) {
+			total += sorted[i];
+		}
+
+		d["mean_usec"] = double(total) / sorted.size();
+		d["p50_usec"] = sorted[_percentile_index(sorted.size(), 50)];
+		d["p90_usec"] = sorted[_percentile_index(sorted.size(), 90)];
+		d["p99_usec"] = sorted[_percentile_index(sorted.size(), 99)];
+		d["max_usec"] = sorted[sorted.size() - 1];
+		return d;
+	}
+
+	static uint32_t _percentile_index(uint32_t p_size, uint32_t p_percent) {
+		return MIN(p_size - 1, (uint64_t)p_size * p_percent / 100);
+	}
+};
+
+// The regions put on the map, and points on them to start and end paths at.
+struct Level {
+	LocalVector<Ref<NavigationMesh>> meshes;
+	LocalVector<RID> regions;
+	LocalVector<Vector3> spots;
+	int polygons;
+
+	Level() {
+		polygons = 0;
+	}
+};
+
+static void add_spots(Level &r_level, const Ref<NavigationMesh> &p_mesh) {
+	PoolVector<Vector3> vertices = p_mesh->get_vertices();
+	PoolVector<Vector3>::Read r = vertices.read();
+	const Vector<Vector<int>> &polygons = p_mesh->get_polygons();
+
+	for (int i = 0; i < polygons.size(); i++) {
+		const Vector<int> &polygon = polygons[i];
+		if (polygon.size() < 3) {
+			continue;
+		}
+
+		Vector3 center;
+		for (int j = 0; j < polygon.size(); j++) {
+			center += r[polygon[j]];
+		}
+		r_level.spots.push_back(center / polygon.size());
+	}
+
+	r_level.polygons += polygons.size();
+}
+
+static Ref<NavigationMesh> make_tile(int p_tile_x, int p_tile_z) {
+	// Blocks of a few cells, like pillars and buildings, so the paths have to
+	// go around them.
+	bool blocked[TILE_CELLS][TILE_CELLS] = {};
+	for (int i = 0; i < BLOCKS_PER_TILE; i++) {
+		int size_x = rng.random(1, 6);
+		int size_z = rng.random(1, 6);
+		int x = rng.random(0, TILE_CELLS - size_x);
+		int z = rng.random(0, TILE_CELLS - size_z);
+		for (int bx = x; bx < x + size_x; bx++) {
+			for (int bz = z; bz < z + size_z; bz++) {
+				blocked[bx][bz] = true;
+			}
+		}
+	}
+
+	const Vector3 origin(p_tile_x * TILE_CELLS * CELL_SIZE, 0, p_tile_z * TILE_CELLS * CELL_SIZE);
+
+	PoolVector<Vector3> vertices;
+	vertices.resize((TILE_CELLS + 1) * (TILE_CELLS + 1));
+	{
+		PoolVector<Vector3>::Write w = vertices.write();
+		for (int z = 0; z <= TILE_CELLS; z++) {
+			for (int x = 0; x <= TILE_CELLS; x++) {
+				w[z * (TILE_CELLS + 1) + x] = origin + Vector3(x * CELL_SIZE, 0, z * CELL_SIZE);
+			}
+		}
+	}
+
+	Ref<NavigationMesh> mesh;
+	mesh.instance();
+	mesh->set_vertices(vertices);
+
+	// One quad per free cell, the edges on the tile borders are merged with
+	// the ones of the next tile by the map.
+	for (int z = 0; z < TILE_CELLS; z++) {
+		for (int x = 0; x < TILE_CELLS; x++) {
+			if (blocked[x][z]) {
+				continue;
+			}
+
+			Vector<int> polygon;
+			polygon.push_back(z * (TILE_CELLS + 1) + x);
+			polygon.push_back(z * (TILE_CELLS + 1) + x + 1);
+			polygon.push_back((z + 1) * (TILE_CELLS + 1) + x + 1);
+			polygon.push_back((z + 1) * (TILE_CELLS + 1) + x);
+			mesh->add_polygon(polygon);
+		}
+	}
+
+	return mesh;
+}
+
+static bool make_level(NavigationServer *p_ns, RID p_map, const String &p_navmesh_path, Level &r_level) {
+	if (p_navmesh_path != "") {
+		Ref<NavigationMesh> mesh = ResourceLoader::load(p_navmesh_path);
+		if (mesh.is_null()) {
+			OS::get_singleton()->printerr("Can't load a NavigationMesh from '%s'.\n", p_navmesh_path.utf8().get_data());
+			return false;
+		}
+		r_level.meshes.push_back(mesh);
+	} else {
+		for (int x = 0; x < TILES; x++) {
+			for (int z = 0; z < TILES; z++) {
+				r_level.meshes.push_back(make_tile(x, z));
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < r_level.meshes.size(); i++) {
+		RID region = p_ns->region_create();
+		p_ns->region_set_map(region, p_map);
+		p_ns->region_set_navigation_mesh(region, r_level.meshes[i]);
+		r_level.regions.push_back(region);
+
+		add_spots(r_level, r_level.meshes[i]);
+	}
+
+	if (r_level.spots.empty()) {
+		OS::get_singleton()->printerr("The navigation mesh has no polygons.\n");
+		return false;
+	}
+
+	return true;
+}
+
+static const Vector3 &random_spot(const Level &p_level) {
+	return p_level.spots[rng.random(0, (int)p_level.spots.size() - 1)];
+}
+
+static Dictionary bench_sync(NavigationServer *p_ns, RID p_map, const Level &p_level) {
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	p_ns->map_force_update(p_map);
+	uint64_t elapsed = OS::get_singleton()->get_ticks_usec() - begin;
+
+	Dictionary d;
+	d["regions"] = p_level.regions.size();
+	d["polygons"] = p_level.polygons;
+	d["edges"] = p_ns->map_get_process_info(p_map, NavigationServer::INFO_EDGE_COUNT);
+	d["edges_free"] = p_ns->map_get_process_info(p_map, NavigationServer::INFO_EDGE_FREE_COUNT);
+	d["first_sync_usec"] = elapsed;
+	return d;
+}
+
+static Dictionary bench_path_queries(NavigationServer *p_ns, RID p_map, const Level &p_level) {
+	Samples samples;
+	int found = 0;
+	uint64_t path_points = 0;
+
+	for (int i = 0; i < PATH_QUERIES; i++) {
+		const Vector3 &from = random_spot(p_level);
+		const Vector3 &to = random_spot(p_level);
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		Vector<Vector3> path = p_ns->map_get_path(p_map, from, to, true);
+		samples.add(OS::get_singleton()->get_ticks_usec() - begin);
+
+		if (path.size() > 0 && path[path.size() - 1].distance_to(to) < CELL_SIZE) {
+			found++;
+		}
+		path_points += path.size();
+	}
+
+	// The server counts the queries of the map until the next step.
+	p_ns->process(DELTA);
+
+	Dictionary d = samples.to_dict();
+	d["found"] = found;
+	d["mean_path_points"] = double(path_points) / PATH_QUERIES;
+	d["monitored_count"] = p_ns->map_get_process_info(p_map, NavigationServer::INFO_PATH_QUERY_COUNT);
+	d["monitored_usec"] = p_ns->map_get_process_info(p_map, NavigationServer::INFO_PATH_QUERY_TIME);
+	return d;
+}
+
+static Dictionary bench_crowd(NavigationServer *p_ns, RID p_map, const Level &p_level) {
+	const real_t max_speed = 3.0;
+
+	LocalVector<RID> agents;
+	LocalVector<Vector3> positions;
+	LocalVector<Vector3> goals;
+
+	for (int i = 0; i < CROWD_AGENTS; i++) {
+		RID agent = p_ns->agent_create();
+		p_ns->agent_set_map(agent, p_map);
+		p_ns->agent_set_avoidance_enabled(agent, true);
+		p_ns->agent_set_radius(agent, 0.4);
+		p_ns->agent_set_neighbor_distance(agent, 8.0);
+		p_ns->agent_set_max_neighbors(agent, 10);
+		p_ns->agent_set_time_horizon_agents(agent, 1.0);
+		p_ns->agent_set_time_horizon_obstacles(agent, 0.5);
+		p_ns->agent_set_max_speed(agent, max_speed);
+
+		agents.push_back(agent);
+		positions.push_back(random_spot(p_level));
+		goals.push_back(random_spot(p_level));
+	}
+
+	Samples process;
+	Samples sync;
+	Samples avoidance;
+	Samples callbacks;
+
+	for (int tick = 0; tick < CROWD_TICKS; tick++) {
+		// There is no scene to take the safe velocities, the agents follow
+		// their preferred ones, which still moves them around the grid.
+		for (uint32_t i = 0; i < agents.size(); i++) {
+			Vector3 to_goal = goals[i] - positions[i];
+			if (to_goal.length_squared() < max_speed * DELTA * max_speed * DELTA) {
+				goals[i] = random_spot(p_level);
+				to_goal = goals[i] - positions[i];
+			}
+
+			const Vector3 velocity = to_goal.normalized() * max_speed;
+			positions[i] += velocity * DELTA;
+
+			p_ns->agent_set_position(agents[i], positions[i]);
+			p_ns->agent_set_velocity(agents[i], velocity);
+		}
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		p_ns->process(DELTA);
+		process.add(OS::get_singleton()->get_ticks_usec() - begin);
+
+		sync.add(p_ns->map_get_process_info(p_map, NavigationServer::INFO_SYNC_TIME));
+		avoidance.add(p_ns->map_get_process_info(p_map, NavigationServer::INFO_AVOIDANCE_TIME));
+		callbacks.add(p_ns->map_get_process_info(p_map, NavigationServer::INFO_CALLBACK_TIME));
+	}
+
+	for (uint32_t i = 0; i < agents.size(); i++) {
+		p_ns->free(agents[i]);
+	}
+
+	Dictionary d;
+	d["agents"] = CROWD_AGENTS;
+	d["ticks"] = CROWD_TICKS;
+	d["process"] = process.to_dict();
+	d["sync"] = sync.to_dict();
+	d["avoidance"] = avoidance.to_dict();
+	d["callbacks"] = callbacks.to_dict();
+	return d;
+}
+
+static Dictionary get_settings() {
+	static const char *settings[] = {
+		"navigation/avoidance/thread_model/avoidance_use_multiple_threads",
+		"navigation/avoidance/thread_model/avoidance_use_high_priority_threads",
+		"navigation/pathfinding/use_hierarchical_pathfinding",
+		"navigation/pathfinding/hierarchical_cluster_size",
+		nullptr
+	};
+
+	Dictionary d;
+	for (int i = 0; settings[i]; i++) {
+		d[settings[i]] = GLOBAL_GET(settings[i]);
+	}
+	d["real_t_size"] = (int)sizeof(real_t);
+	d["processor_count"] = OS::get_singleton()->get_processor_count();
+	return d;
+}
+
+MainLoop *test(const List<String> &p_args) {
+	NavigationServer *ns = NavigationServer::get_singleton();
+	if (!ns) {
+		OS::get_singleton()->printerr("The navigation benchmark needs a navigation server.\n");
+		return nullptr;
+	}
+
+	String navmesh_path;
+	for (const List<String>::Element *E = p_args.front(); E; E = E->next()) {
+		if (E->get() == "--navmesh" && E->next()) {
+			navmesh_path = E->next()->get();
+		}
+	}
+
+	rng.seed(1);
+
+	RID map = ns->map_create();
+	ns->map_set_active(map, true);
+
+	Level level;
+	if (!make_level(ns, map, navmesh_path, level)) {
+		ns->free(map);
+		return nullptr;
+	}
+
+	Dictionary result;
+	result["benchmark"] = "navigation";
+	result["version"] = 1;
+	result["delta"] = DELTA;
+	result["settings"] = get_settings();
+	result["navmesh"] = navmesh_path != "" ? navmesh_path : String("generated");
+
+	OS::get_singleton()->printerr("sync...\n");
+	result["map"] = bench_sync(ns, map, level);
+	OS::get_singleton()->printerr("path_queries...\n");
+	result["path_queries"] = bench_path_queries(ns, map, level);
+	OS::get_singleton()->printerr("crowd...\n");
+	result["crowd"] = bench_crowd(ns, map, level);
+
+	for (uint32_t i = 0; i < level.regions.size(); i++) {
+		ns->free(level.regions[i]);
+	}
+	ns->free(map);
+	ns->process(DELTA);
+
+	OS::get_singleton()->print("%s\n", JSON::print(result, "\t", false).utf8().get_data());
+	return nullptr;
+}
+
+} // namespace TestNavigationBench
@@ -0,0 +1,528 @@
+/*************************************************************************/
+/*  test_physics_bench.cpp                                               */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_physics_bench.h"
+
+#include "core/config/project_settings.h"
+#include "core/io/json.h"
+#include "core/math/random_pcg.h"
+#include "core/os/os.h"
+#include "servers/physics/physics_server_sw.h"
+#include "servers/physics_2d/physics_2d_server_sw.h"
+
+namespace TestPhysicsBench {
+
+// Headless benchmark of the built-in physics servers. Builds standard scenes,
+// steps each one a fixed number of ticks and prints the timings of every phase
+// of the step (the SpaceSW::ELAPSED_TIME_* counters) as JSON on stdout, so the
+// results can be compared between builds and project settings. Progress goes
+// to stderr.
+
+enum {
+	TICKS = 300,
+	BOX_STACKS = 8, // per side
+	BOX_STACK_HEIGHT = 12,
+	RAGDOLLS = 4, // per side
+	RAGDOLL_LAYERS = 4,
+	RAY_OBSTACLES = 2000,
+	RAYS_PER_TICK = 1000,
+	BULLETS = 10000,
+	BULLET_OBSTACLES = 64,
+};
+
+static const real_t DELTA = 1.0 / 60.0;
+
+static const char *phase_names[SpaceSW::ELAPSED_TIME_MAX] = {
+	"integrate_forces",
+	"generate_islands",
+	"setup_constraints",
+	"solve_constraints",
+	"integrate_velocities"
+};
+
+static RandomPCG rng;
+
+// Microseconds spent on something, over all the ticks of a scene.
+struct Timing {
+	uint64_t total;
+	uint64_t max;
+
+	void add(uint64_t p_usec) {
+		total += p_usec;
+		max = MAX(max, p_usec);
+	}
+
+	Dictionary to_dict(int p_ticks) const {
+		Dictionary d;
+		d["total_usec"] = total;
+		d["mean_usec"] = p_ticks ? double(total) / p_ticks : 0.0;
+		d["max_usec"] = max;
+		return d;
+	}
+
+	Timing() {
+		total = 0;
+		max = 0;
+	}
+};
+
+struct SceneResult {
+	String name;
+	int dimensions;
+	int bodies;
+	Timing frame; // sync, flush_queries, end_sync and step, as in Main::iteration()
+	Timing step;
+	Timing phases[SpaceSW::ELAPSED_TIME_MAX];
+	Dictionary queries;
+
+	Dictionary to_dict() const {
+		Dictionary d;
+		d["name"] = name;
+		d["dimensions"] = dimensions;
+		d["bodies"] = bodies;
+		d["ticks"] = TICKS;
+		d["frame"] = frame.to_dict(TICKS);
+		d["step"] = step.to_dict(TICKS);
+
+		Dictionary p;
+		for (int i = 0; i < SpaceSW::ELAPSED_TIME_MAX; i++) {
+			p[phase_names[i]] = phases[i].to_dict(TICKS);
+		}
+		d["phases"] = p;
+
+		if (!queries.empty()) {
+			d["queries"] = queries;
+		}
+		return d;
+	}
+};
+
+/* 3D */
+
+class Scene3D {
+public:
+	PhysicsServerSW *ps;
+	RID space;
+	Vector<RID> shapes;
+	Vector<RID> bodies;
+	Vector<RID> joints;
+
+	RID make_shape(PhysicsServer::ShapeType p_type, const Variant &p_data) {
+		RID shape = ps->shape_create(p_type);
+		ps->shape_set_data(shape, p_data);
+		shapes.push_back(shape);
+		return shape;
+	}
+
+	RID make_body(PhysicsServer::BodyMode p_mode, RID p_shape, const Transform &p_xform, const Transform &p_shape_xform = Transform()) {
+		RID body = ps->body_create(p_mode);
+		ps->body_set_space(body, space);
+		ps->body_add_shape(body, p_shape, p_shape_xform);
+		ps->body_set_state(body, PhysicsServer::BODY_STATE_TRANSFORM, p_xform);
+		bodies.push_back(body);
+		return body;
+	}
+
+	int dynamic_body_count() const {
+		int count = 0;
+		for (int i = 0; i < bodies.size(); i++) {
+			if (ps->body_get_mode(bodies[i]) != PhysicsServer::BODY_MODE_STATIC) {
+				count++;
+			}
+		}
+		return count;
+	}
+
+	void step(SceneResult &r_result) {
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		ps->sync();
+		ps->flush_queries();
+		ps->end_sync();
+		uint64_t step_begin = OS::get_singleton()->get_ticks_usec();
+		ps->step(DELTA);
+		uint64_t step_end = OS::get_singleton()->get_ticks_usec();
+		r_result.step.add(step_end - step_begin);
+		r_result.frame.add(step_end - begin);
+
+		for (int i = 0; i < SpaceSW::ELAPSED_TIME_MAX; i++) {
+			r_result.phases[i].add(ps->space_get_elapsed_time(space, SpaceSW::ElapsedTime(i)));
+		}
+	}
+
+	Scene3D(PhysicsServerSW *p_ps) {
+		ps = p_ps;
+		space = ps->space_create();
+		ps->space_set_active(space, true);
+	}
+
+	~Scene3D() {
+		for (int i = 0; i < joints.size(); i++) {
+			ps->free(joints[i]);
+		}
+		for (int i = 0; i < bodies.size(); i++) {
+			ps->free(bodies[i]);
+		}
+		for (int i = 0; i < shapes.size(); i++) {
+			ps->free(shapes[i]);
+		}
+		ps->free(space);
+	}
+};
+
+static void add_ground(Scene3D &p_scene, real_t p_size) {
+	RID ground = p_scene.make_shape(PhysicsServer::SHAPE_BOX, Vector3(p_size, 1, p_size));
+	p_scene.make_body(PhysicsServer::BODY_MODE_STATIC, ground, Transform(Basis(), Vector3(0, -1, 0)));
+}
+
+static void run_steps(Scene3D &p_scene, SceneResult &r_result) {
+	r_result.dimensions = 3;
+	r_result.bodies = p_scene.dynamic_body_count();
+
+	for (int i = 0; i < TICKS; i++) {
+		p_scene.step(r_result);
+	}
+}
+
+static SceneResult bench_box_stacks(PhysicsServerSW *p_ps) {
+	SceneResult result;
+	result.name = "box_stacks";
+
+	Scene3D scene(p_ps);
+	add_ground(scene, 100);
+
+	RID box = scene.make_shape(PhysicsServer::SHAPE_BOX, Vector3(0.5, 0.5, 0.5));
+	for (int x = 0; x < BOX_STACKS; x++) {
+		for (int z = 0; z < BOX_STACKS; z++) {
+			for (int y = 0; y < BOX_STACK_HEIGHT; y++) {
+				Vector3 pos((x - BOX_STACKS / 2) * 3.0, 0.5 + y * 1.0, (z - BOX_STACKS / 2) * 3.0);
+				scene.make_body(PhysicsServer::BODY_MODE_RIGID, box, Transform(Basis(), pos));
+			}
+		}
+	}
+
+	run_steps(scene, result);
+	return result;
+}
+
+static void add_ragdoll(Scene3D &p_scene, RID p_trunk, RID p_limb, const Vector3 &p_origin) {
+	struct Part {
+		Vector3 pos;
+		bool trunk;
+		int parent;
+		Vector3 pivot;
+	};
+
+	static const Part parts[] = {
+		{ Vector3(0, 1.0, 0), true, -1, Vector3() }, // pelvis
+		{ Vector3(0, 1.5, 0), true, 0, Vector3(0, 1.25, 0) }, // torso
+		{ Vector3(0, 2.0, 0), false, 1, Vector3(0, 1.75, 0) }, // head
+		{ Vector3(-0.35, 1.35, 0), false, 1, Vector3(-0.35, 1.55, 0) }, // upper arms
+		{ Vector3(0.35, 1.35, 0), false, 1, Vector3(0.35, 1.55, 0) },
+		{ Vector3(-0.35, 0.95, 0), false, 3, Vector3(-0.35, 1.15, 0) }, // lower arms
+		{ Vector3(0.35, 0.95, 0), false, 4, Vector3(0.35, 1.15, 0) },
+		{ Vector3(-0.15, 0.65, 0), false, 0, Vector3(-0.15, 0.85, 0) }, // thighs
+		{ Vector3(0.15, 0.65, 0), false, 0, Vector3(0.15, 0.85, 0) },
+		{ Vector3(-0.15, 0.25, 0), false, 7, Vector3(-0.15, 0.45, 0) }, // shins
+		{ Vector3(0.15, 0.25, 0), false, 8, Vector3(0.15, 0.45, 0) },
+	};
+
+	// capsules are along Z, stand them up
+	Transform upright(Basis(Vector3(1, 0, 0), Math_PI * 0.5), Vector3());
+
+	RID bodies[sizeof(parts) / sizeof(Part)];
+	for (uint32_t i = 0; i < sizeof(parts) / sizeof(Part); i++) {
+		const Part &part = parts[i];
+		bodies[i] = p_scene.make_body(PhysicsServer::BODY_MODE_RIGID, part.trunk ? p_trunk : p_limb, Transform(Basis(), p_origin + part.pos), upright);
+
+		if (part.parent < 0) {
+			continue;
+		}
+
+		const Part &parent = parts[part.parent];
+		RID joint = p_scene.ps->joint_create_cone_twist(bodies[part.parent], Transform(Basis(), part.pivot - parent.pos), bodies[i], Transform(Basis(), part.pivot - part.pos));
+		p_scene.ps->cone_twist_joint_set_param(joint, PhysicsServer::CONE_TWIST_JOINT_SWING_SPAN, Math_PI * 0.25);
+		p_scene.ps->cone_twist_joint_set_param(joint, PhysicsServer::CONE_TWIST_JOINT_TWIST_SPAN, Math_PI * 0.25);
+		p_scene.ps->joint_disable_collisions_between_bodies(joint, true);
+		p_scene.joints.push_back(joint);
+	}
+}
+
+static SceneResult bench_ragdoll_pile(PhysicsServerSW *p_ps) {
+	SceneResult result;
+	result.name = "ragdoll_pile";
+
+	Scene3D scene(p_ps);
+	add_ground(scene, 100);
+
+	Dictionary trunk_data;
+	trunk_data["radius"] = 0.15;
+	trunk_data["height"] = 0.2;
+	RID trunk = scene.make_shape(PhysicsServer::SHAPE_CAPSULE, trunk_data);
+
+	Dictionary limb_data;
+	limb_data["radius"] = 0.08;
+	limb_data["height"] = 0.24;
+	RID limb = scene.make_shape(PhysicsServer::SHAPE_CAPSULE, limb_data);
+
+	// dropped on top of each other, so they end up in a pile
+	for (int layer = 0; layer < RAGDOLL_LAYERS; layer++) {
+		for (int x = 0; x < RAGDOLLS; x++) {
+			for (int z = 0; z < RAGDOLLS; z++) {
+				Vector3 origin((x - RAGDOLLS / 2) * 0.6, 0.5 + layer * 2.5, (z - RAGDOLLS / 2) * 0.6 + (layer % 2) * 0.3);
+				add_ragdoll(scene, trunk, limb, origin);
+			}
+		}
+	}
+
+	run_steps(scene, result);
+	return result;
+}
+
+static SceneResult bench_ray_storm(PhysicsServerSW *p_ps) {
+	SceneResult result;
+	result.name = "ray_storm";
+	result.dimensions = 3;
+
+	Scene3D scene(p_ps);
+	add_ground(scene, 200);
+
+	RID box = scene.make_shape(PhysicsServer::SHAPE_BOX, Vector3(1, 1, 1));
+	RID sphere = scene.make_shape(PhysicsServer::SHAPE_SPHERE, 0.5);
+
+	for (int i = 0; i < RAY_OBSTACLES; i++) {
+		Vector3 pos(rng.random(-150.0f, 150.0f), 1, rng.random(-150.0f, 150.0f));
+		if (i % 4 == 0) {
+			pos.y = rng.random(2.0f, 20.0f);
+			scene.make_body(PhysicsServer::BODY_MODE_RIGID, sphere, Transform(Basis(), pos));
+		} else {
+			scene.make_body(PhysicsServer::BODY_MODE_STATIC, box, Transform(Basis(), pos));
+		}
+	}
+
+	result.bodies = scene.dynamic_body_count();
+
+	Vector<Vector3> from;
+	Vector<Vector3> to;
+	from.resize(RAYS_PER_TICK);
+	to.resize(RAYS_PER_TICK);
+
+	Vector<PhysicsDirectSpaceState::RayResult> ray_results;
+	Vector<bool> ray_hits;
+	ray_results.resize(RAYS_PER_TICK);
+	ray_hits.resize(RAYS_PER_TICK);
+
+	Timing single;
+	Timing batched;
+	uint64_t single_hits = 0;
+	uint64_t batched_hits = 0;
+
+	for (int tick = 0; tick < TICKS; tick++) {
+		scene.step(result);
+
+		for (int i = 0; i < RAYS_PER_TICK; i++) {
+			from.write[i] = Vector3(rng.random(-150.0f, 150.0f), rng.random(0.5f, 10.0f), rng.random(-150.0f, 150.0f));
+			to.write[i] = from[i] + Vector3(rng.random(-1.0f, 1.0f), rng.random(-0.2f, 0.2f), rng.random(-1.0f, 1.0f)).normalized() * 100;
+		}
+
+		PhysicsDirectSpaceState *dss = p_ps->space_get_direct_state(scene.space);
+		ERR_FAIL_COND_V(!dss, result);
+
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		for (int i = 0; i < RAYS_PER_TICK; i++) {
+			PhysicsDirectSpaceState::RayResult ray_result;
+			if (dss->intersect_ray(from[i], to[i], ray_result)) {
+				single_hits++;
+			}
+		}
+		single.add(OS::get_singleton()->get_ticks_usec() - begin);
+
+		begin = OS::get_singleton()->get_ticks_usec();
+		batched_hits += dss->intersect_rays(from.ptr(), to.ptr(), RAYS_PER_TICK, ray_results.ptrw(), ray_hits.ptrw());
+		batched.add(OS::get_singleton()->get_ticks_usec() - begin);
+	}
+
+	Dictionary single_dict = single.to_dict(TICKS);
+	single_dict["rays_per_tick"] = RAYS_PER_TICK;
+	single_dict["hits"] = single_hits;
+	result.queries["intersect_ray"] = single_dict;
+
+	Dictionary batched_dict = batched.to_dict(TICKS);
+	batched_dict["rays_per_tick"] = RAYS_PER_TICK;
+	batched_dict["hits"] = batched_hits;
+	result.queries["intersect_rays"] = batched_dict;
+
+	return result;
+}
+
+/* 2D */
+
+static SceneResult bench_bullets_2d(Physics2DServerSW *p_ps) {
+	SceneResult result;
+	result.name = "bullets_2d";
+	result.dimensions = 2;
+	result.bodies = BULLETS;
+
+	const real_t arena = 4000;
+
+	RID space = p_ps->space_create();
+	p_ps->space_set_active(space, true);
+
+	Vector<RID> bodies;
+
+	// Large static walls and blocks on layer 1, small bullets on layer 2 that
+	// only hit layer 1, as in a top-down shooter.
+	RID wall = p_ps->rectangle_shape_create();
+	p_ps->shape_set_data(wall, Vector2(arena * 0.5, 20));
+	RID block = p_ps->rectangle_shape_create();
+	p_ps->shape_set_data(block, Vector2(100, 100));
+	RID bullet = p_ps->circle_shape_create();
+	p_ps->shape_set_data(bullet, 2);
+
+	for (int i = 0; i < 4 + BULLET_OBSTACLES; i++) {
+		Transform2D xform;
+		RID shape = block;
+		if (i < 4) {
+			shape = wall;
+			xform.set_rotation(i < 2 ? 0 : Math_PI * 0.5);
+			Vector2 side = i < 2 ? Vector2(0, arena * 0.5) : Vector2(arena * 0.5, 0);
+			xform.set_origin(i % 2 ? side : -side);
+		} else {
+			xform.set_origin(Vector2(rng.random(-arena * 0.4f, arena * 0.4f), rng.random(-arena * 0.4f, arena * 0.4f)));
+		}
+
+		RID body = p_ps->body_create();
+		p_ps->body_set_mode(body, Physics2DServer::BODY_MODE_STATIC);
+		p_ps->body_set_space(body, space);
+		p_ps->body_add_shape(body, shape);
+		p_ps->body_set_collision_layer(body, 1);
+		p_ps->body_set_collision_mask(body, 0);
+		p_ps->body_set_state(body, Physics2DServer::BODY_STATE_TRANSFORM, xform);
+		bodies.push_back(body);
+	}
+
+	for (int i = 0; i < BULLETS; i++) {
+		RID body = p_ps->body_create();
+		p_ps->body_set_mode(body, Physics2DServer::BODY_MODE_RIGID);
+		p_ps->body_set_space(body, space);
+		p_ps->body_add_shape(body, bullet);
+		p_ps->body_set_collision_layer(body, 2);
+		p_ps->body_set_collision_mask(body, 1);
+		p_ps->body_set_param(body, Physics2DServer::BODY_PARAM_GRAVITY_SCALE, 0);
+		p_ps->body_set_state(body, Physics2DServer::BODY_STATE_TRANSFORM, Transform2D(0, Vector2(rng.random(-arena * 0.45f, arena * 0.45f), rng.random(-arena * 0.45f, arena * 0.45f))));
+		p_ps->body_set_state(body, Physics2DServer::BODY_STATE_LINEAR_VELOCITY, Vector2(rng.random(-1.0f, 1.0f), rng.random(-1.0f, 1.0f)).normalized() * 600);
+		bodies.push_back(body);
+	}
+
+	for (int tick = 0; tick < TICKS; tick++) {
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		p_ps->sync();
+		p_ps->flush_queries();
+		p_ps->end_sync();
+		uint64_t step_begin = OS::get_singleton()->get_ticks_usec();
+		p_ps->step(DELTA);
+		uint64_t step_end = OS::get_singleton()->get_ticks_usec();
+		result.step.add(step_end - step_begin);
+		result.frame.add(step_end - begin);
+
+		for (int i = 0; i < Space2DSW::ELAPSED_TIME_MAX; i++) {
+			result.phases[i].add(p_ps->space_get_elapsed_time(space, Space2DSW::ElapsedTime(i)));
+		}
+	}
+
+	for (int i = 0; i < bodies.size(); i++) {
+		p_ps->free(bodies[i]);
+	}
+	p_ps->free(wall);
+	p_ps->free(block);
+	p_ps->free(bullet);
+	p_ps->free(space);
+
+	return result;
+}
+
+static Dictionary get_settings() {
+	static const char *settings[] = {
+		"physics/3d/pandemonium_physics/use_bvh",
+		"physics/3d/pandemonium_physics/use_multiple_threads",
+		"physics/2d/use_bvh",
+		"physics/2d/use_hierarchical_grid",
+		"physics/2d/use_multiple_threads",
+		"physics/2d/cell_size",
+		nullptr
+	};
+
+	Dictionary d;
+	for (int i = 0; settings[i]; i++) {
+		d[settings[i]] = GLOBAL_GET(settings[i]);
+	}
+	d["real_t_size"] = (int)sizeof(real_t);
+	d["processor_count"] = OS::get_singleton()->get_processor_count();
+	return d;
+}
+
+MainLoop *test() {
+	// The singletons are the WrapMT servers unless the thread model is single
+	// unsafe, step the built-in servers behind them directly. Nothing else
+	// uses them while the benchmark runs, but with a physics thread the
+	// direct space states are locked outside of the sync.
+	PhysicsServerSW *ps = PhysicsServerSW::singleton;
+	Physics2DServerSW *ps2d = Physics2DServerSW::singletonsw;
+
+	if (!ps || !ps2d || int(GLOBAL_GET("physics/3d/thread_model")) == 2 || int(GLOBAL_GET("physics/2d/thread_model")) == 2) {
+		OS::get_singleton()->printerr("The physics benchmark needs the built-in physics servers, without a separate physics thread.\n");
+		return nullptr;
+	}
+
+	rng.seed(1);
+
+	Array scenes;
+
+	OS::get_singleton()->printerr("box_stacks...\n");
+	scenes.push_back(bench_box_stacks(ps).to_dict());
+	OS::get_singleton()->printerr("ragdoll_pile...\n");
+	scenes.push_back(bench_ragdoll_pile(ps).to_dict());
+	OS::get_singleton()->printerr("ray_storm...\n");
+	scenes.push_back(bench_ray_storm(ps).to_dict());
+	OS::get_singleton()->printerr("bullets_2d...\n");
+	scenes.push_back(bench_bullets_2d(ps2d).to_dict());
+
+	Dictionary result;
+	result["benchmark"] = "physics";
+	result["version"] = 2;
+	result["delta"] = DELTA;
+	result["settings"] = get_settings();
+	result["scenes"] = scenes;
+
+	OS::get_singleton()->print("%s\n", JSON::print(result, "\t", false).utf8().get_data());
+	return nullptr;
+}
+
+} // namespace TestPhysicsBench
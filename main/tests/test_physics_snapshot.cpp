@@ -0,0 +1,363 @@
+/*************************************************************************/
+/*  test_physics_snapshot.cpp                                            */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "test_physics_snapshot.h"
+
+#include "core/config/project_settings.h"
+#include "core/os/os.h"
+#include "servers/physics/body_pair_sw.h"
+#include "servers/physics/physics_server_sw.h"
+#include "servers/physics_2d/body_pair_2d_sw.h"
+#include "servers/physics_2d/physics_2d_server_sw.h"
+
+namespace TestPhysicsSnapshot {
+
+// Snapshots a settling scene, steps it, restores the snapshot, steps it again
+// and checks that both runs end in the same place. Uses the built-in servers
+// directly, in the same order as Main::iteration().
+
+enum {
+	STACKS = 3,
+	STACK_HEIGHT = 6,
+	SETTLE_TICKS = 20,
+	REPLAY_TICKS = 40,
+};
+
+static const real_t DELTA = 1.0 / 60.0;
+static const real_t TOLERANCE = 0.001;
+
+static bool same_bytes(const PoolVector<uint8_t> &p_a, const PoolVector<uint8_t> &p_b) {
+	if (p_a.size() != p_b.size()) {
+		return false;
+	}
+	PoolVector<uint8_t>::Read ra = p_a.read();
+	PoolVector<uint8_t>::Read rb = p_b.read();
+	return memcmp(ra.ptr(), rb.ptr(), p_a.size()) == 0;
+}
+
+/* 3D */
+
+static void step_3d(PhysicsServerSW *p_ps) {
+	p_ps->sync();
+	p_ps->flush_queries();
+	p_ps->end_sync();
+	p_ps->step(DELTA);
+}
+
+static void get_origins_3d(PhysicsServerSW *p_ps, const Vector<RID> &p_bodies, Vector<Vector3> &r_origins) {
+	r_origins.resize(p_bodies.size());
+	for (int i = 0; i < p_bodies.size(); i++) {
+		Transform xform = p_ps->body_get_state(p_bodies[i], PhysicsServer::BODY_STATE_TRANSFORM);
+		r_origins.write[i] = xform.origin;
+	}
+}
+
+static bool test_swap_state_3d() {
+	OS::get_singleton()->print("\n\nTest 1: Swapping the bodies of a 3D pair state\n");
+
+	BodyPairSW::SnapshotState state;
+	memset((void *)&state, 0, sizeof(BodyPairSW::SnapshotState));
+	state.offset_B = Vector3(1, 2, 3);
+	state.sep_axis = Vector3(0, 1, 0);
+	state.contact_count = 1;
+	state.contacts[0].normal = Vector3(0, 1, 0);
+	state.contacts[0].local_A = Vector3(0.5, -0.5, 0);
+	state.contacts[0].local_B = Vector3(-0.25, 0.5, 0);
+	state.contacts[0].rA = Vector3(0.1, 0, 0);
+	state.contacts[0].rB = Vector3(0, 0.2, 0);
+	state.contacts[0].acc_normal_impulse = 2;
+	state.contacts[0].acc_tangent_impulse = Vector3(0.3, 0, 0);
+
+	BodyPairSW::SnapshotState swapped = state;
+	BodyPairSW::swap_snapshot_state(swapped);
+	if (swapped.offset_B != -state.offset_B || swapped.contacts[0].normal != -state.contacts[0].normal || swapped.contacts[0].local_A != state.contacts[0].local_B || swapped.contacts[0].local_B != state.contacts[0].local_A || swapped.contacts[0].rA != state.contacts[0].rB || swapped.contacts[0].rB != state.contacts[0].rA) {
+		OS::get_singleton()->print("\tA and B were not exchanged\n");
+		return false;
+	}
+	// the impulses applied to each body must not change
+	if (swapped.contacts[0].acc_normal_impulse != state.contacts[0].acc_normal_impulse || swapped.contacts[0].normal * swapped.contacts[0].acc_normal_impulse + swapped.contacts[0].acc_tangent_impulse != -(state.contacts[0].normal * state.contacts[0].acc_normal_impulse + state.contacts[0].acc_tangent_impulse)) {
+		OS::get_singleton()->print("\tThe impulses changed\n");
+		return false;
+	}
+
+	BodyPairSW::swap_snapshot_state(swapped);
+	if (swapped.offset_B != state.offset_B || swapped.sep_axis != state.sep_axis || swapped.contacts[0].normal != state.contacts[0].normal || swapped.contacts[0].local_A != state.contacts[0].local_A || swapped.contacts[0].acc_tangent_impulse != state.contacts[0].acc_tangent_impulse) {
+		OS::get_singleton()->print("\tSwapping twice did not give back the same state\n");
+		return false;
+	}
+	return true;
+}
+
+static bool test_round_trip_3d() {
+	OS::get_singleton()->print("\n\nTest 2: 3D snapshot, restore, step and compare\n");
+
+	PhysicsServerSW *ps = PhysicsServerSW::singleton;
+
+	RID space = ps->space_create();
+	ps->space_set_active(space, true);
+
+	RID ground_shape = ps->shape_create(PhysicsServer::SHAPE_BOX);
+	ps->shape_set_data(ground_shape, Vector3(20, 1, 20));
+	RID box_shape = ps->shape_create(PhysicsServer::SHAPE_BOX);
+	ps->shape_set_data(box_shape, Vector3(0.5, 0.5, 0.5));
+
+	Vector<RID> bodies;
+	RID ground = ps->body_create(PhysicsServer::BODY_MODE_STATIC);
+	ps->body_set_space(ground, space);
+	ps->body_add_shape(ground, ground_shape);
+	ps->body_set_state(ground, PhysicsServer::BODY_STATE_TRANSFORM, Transform(Basis(), Vector3(0, -1, 0)));
+
+	// slightly offset and dropped, so there are contacts being made and lost
+	for (int x = 0; x < STACKS; x++) {
+		for (int y = 0; y < STACK_HEIGHT; y++) {
+			RID body = ps->body_create(PhysicsServer::BODY_MODE_RIGID);
+			ps->body_set_space(body, space);
+			ps->body_add_shape(body, box_shape);
+			Vector3 pos(x * 3.0 + (y % 2) * 0.2, 0.6 + y * 1.1, (y % 3) * 0.1);
+			ps->body_set_state(body, PhysicsServer::BODY_STATE_TRANSFORM, Transform(Basis(Vector3(0, 1, 0), y * 0.2), pos));
+			bodies.push_back(body);
+		}
+	}
+
+	for (int i = 0; i < SETTLE_TICKS; i++) {
+		step_3d(ps);
+	}
+
+	PoolVector<uint8_t> snapshot = ps->space_get_snapshot(space);
+	Vector<Vector3> first;
+	for (int i = 0; i < REPLAY_TICKS; i++) {
+		step_3d(ps);
+	}
+	get_origins_3d(ps, bodies, first);
+
+	bool pass = true;
+
+	if (ps->space_set_snapshot(space, snapshot) != OK) {
+		OS::get_singleton()->print("\tCould not restore the snapshot\n");
+		pass = false;
+	} else if (!same_bytes(ps->space_get_snapshot(space), snapshot)) {
+		OS::get_singleton()->print("\tThe restored space does not give back the same snapshot\n");
+		pass = false;
+	}
+
+	Vector<Vector3> second;
+	for (int i = 0; i < REPLAY_TICKS; i++) {
+		step_3d(ps);
+	}
+	get_origins_3d(ps, bodies, second);
+
+	for (int i = 0; i < bodies.size(); i++) {
+		if (first[i].distance_to(second[i]) > TOLERANCE) {
+			OS::get_singleton()->print("\tBody %d ended at %s, expected %s\n", i, String(second[i]).utf8().get_data(), String(first[i]).utf8().get_data());
+			pass = false;
+		}
+	}
+
+	for (int i = 0; i < bodies.size(); i++) {
+		ps->free(bodies[i]);
+	}
+	ps->free(ground);
+	ps->free(box_shape);
+	ps->free(ground_shape);
+	ps->free(space);
+
+	return pass;
+}
+
+/* 2D */
+
+static void step_2d(Physics2DServerSW *p_ps) {
+	p_ps->sync();
+	p_ps->flush_queries();
+	p_ps->end_sync();
+	p_ps->step(DELTA);
+}
+
+static void get_origins_2d(Physics2DServerSW *p_ps, const Vector<RID> &p_bodies, Vector<Vector2> &r_origins) {
+	r_origins.resize(p_bodies.size());
+	for (int i = 0; i < p_bodies.size(); i++) {
+		Transform2D xform = p_ps->body_get_state(p_bodies[i], Physics2DServer::BODY_STATE_TRANSFORM);
+		r_origins.write[i] = xform.get_origin();
+	}
+}
+
+static bool test_swap_state_2d() {
+	OS::get_singleton()->print("\n\nTest 3: Swapping the bodies of a 2D pair state\n");
+
+	BodyPair2DSW::SnapshotState state;
+	memset((void *)&state, 0, sizeof(BodyPair2DSW::SnapshotState));
+	state.offset_B = Vector2(1, 2);
+	state.sep_axis = Vector2(0, 1);
+	state.contact_count = 1;
+	state.contacts[0].normal = Vector2(0, 1);
+	state.contacts[0].local_A = Vector2(0.5, -0.5);
+	state.contacts[0].local_B = Vector2(-0.25, 0.5);
+	state.contacts[0].rA = Vector2(0.1, 0);
+	state.contacts[0].rB = Vector2(0, 0.2);
+	state.contacts[0].acc_normal_impulse = 2;
+	state.contacts[0].acc_tangent_impulse = 0.3;
+
+	BodyPair2DSW::SnapshotState swapped = state;
+	BodyPair2DSW::swap_snapshot_state(swapped);
+	if (swapped.offset_B != -state.offset_B || swapped.contacts[0].normal != -state.contacts[0].normal || swapped.contacts[0].local_A != state.contacts[0].local_B || swapped.contacts[0].local_B != state.contacts[0].local_A || swapped.contacts[0].rA != state.contacts[0].rB || swapped.contacts[0].rB != state.contacts[0].rA) {
+		OS::get_singleton()->print("\tA and B were not exchanged\n");
+		return false;
+	}
+	Vector2 impulse = state.contacts[0].normal * state.contacts[0].acc_normal_impulse + state.contacts[0].normal.tangent() * state.contacts[0].acc_tangent_impulse;
+	Vector2 swapped_impulse = swapped.contacts[0].normal * swapped.contacts[0].acc_normal_impulse + swapped.contacts[0].normal.tangent() * swapped.contacts[0].acc_tangent_impulse;
+	if (swapped_impulse != -impulse) {
+		OS::get_singleton()->print("\tThe impulses changed\n");
+		return false;
+	}
+
+	BodyPair2DSW::swap_snapshot_state(swapped);
+	if (swapped.offset_B != state.offset_B || swapped.sep_axis != state.sep_axis || swapped.contacts[0].normal != state.contacts[0].normal || swapped.contacts[0].local_A != state.contacts[0].local_A || swapped.contacts[0].acc_tangent_impulse != state.contacts[0].acc_tangent_impulse) {
+		OS::get_singleton()->print("\tSwapping twice did not give back the same state\n");
+		return false;
+	}
+	return true;
+}
+
+static bool test_round_trip_2d() {
+	OS::get_singleton()->print("\n\nTest 4: 2D snapshot, restore, step and compare\n");
+
+	Physics2DServerSW *ps = Physics2DServerSW::singletonsw;
+
+	RID space = ps->space_create();
+	ps->space_set_active(space, true);
+
+	RID ground_shape = ps->rectangle_shape_create();
+	ps->shape_set_data(ground_shape, Vector2(1000, 10));
+	RID box_shape = ps->rectangle_shape_create();
+	ps->shape_set_data(box_shape, Vector2(10, 10));
+
+	RID ground = ps->body_create();
+	ps->body_set_mode(ground, Physics2DServer::BODY_MODE_STATIC);
+	ps->body_set_space(ground, space);
+	ps->body_add_shape(ground, ground_shape);
+	ps->body_set_state(ground, Physics2DServer::BODY_STATE_TRANSFORM, Transform2D(0, Vector2(0, 10)));
+
+	// y points down in 2D
+	Vector<RID> bodies;
+	for (int x = 0; x < STACKS; x++) {
+		for (int y = 0; y < STACK_HEIGHT; y++) {
+			RID body = ps->body_create();
+			ps->body_set_mode(body, Physics2DServer::BODY_MODE_RIGID);
+			ps->body_set_space(body, space);
+			ps->body_add_shape(body, box_shape);
+			Vector2 pos(x * 60.0 + (y % 2) * 4.0, -12.0 - y * 22.0);
+			ps->body_set_state(body, Physics2DServer::BODY_STATE_TRANSFORM, Transform2D(y * 0.1, pos));
+			bodies.push_back(body);
+		}
+	}
+
+	for (int i = 0; i < SETTLE_TICKS; i++) {
+		step_2d(ps);
+	}
+
+	PoolVector<uint8_t> snapshot = ps->space_get_snapshot(space);
+	Vector<Vector2> first;
+	for (int i = 0; i < REPLAY_TICKS; i++) {
+		step_2d(ps);
+	}
+	get_origins_2d(ps, bodies, first);
+
+	bool pass = true;
+
+	if (ps->space_set_snapshot(space, snapshot) != OK) {
+		OS::get_singleton()->print("\tCould not restore the snapshot\n");
+		pass = false;
+	} else if (!same_bytes(ps->space_get_snapshot(space), snapshot)) {
+		OS::get_singleton()->print("\tThe restored space does not give back the same snapshot\n");
+		pass = false;
+	}
+
+	Vector<Vector2> second;
+	for (int i = 0; i < REPLAY_TICKS; i++) {
+		step_2d(ps);
+	}
+	get_origins_2d(ps, bodies, second);
+
+	for (int i = 0; i < bodies.size(); i++) {
+		if (first[i].distance_to(second[i]) > TOLERANCE) {
+			OS::get_singleton()->print("\tBody %d ended at %s, expected %s\n", i, String(second[i]).utf8().get_data(), String(first[i]).utf8().get_data());
+			pass = false;
+		}
+	}
+
+	for (int i = 0; i < bodies.size(); i++) {
+		ps->free(bodies[i]);
+	}
+	ps->free(ground);
+	ps->free(box_shape);
+	ps->free(ground_shape);
+	ps->free(space);
+
+	return pass;
+}
+
+typedef bool (*TestFunc)();
+
+TestFunc test_funcs[] = {
+	test_swap_state_3d,
+	test_round_trip_3d,
+	test_swap_state_2d,
+	test_round_trip_2d,
+	nullptr
+};
+
+MainLoop *test() {
+	if (!PhysicsServerSW::singleton || !Physics2DServerSW::singletonsw || int(GLOBAL_GET("physics/3d/thread_model")) == 2 || int(GLOBAL_GET("physics/2d/thread_model")) == 2) {
+		OS::get_singleton()->printerr("The physics snapshot test needs the built-in physics servers, without a separate physics thread.\n");
+		return nullptr;
+	}
+
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!test_funcs[count]) {
+			break;
+		}
+		bool pass = test_funcs[count]();
+		if (pass) {
+			passed++;
+		}
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+	OS::get_singleton()->print("\n");
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+	return nullptr;
+}
+
+} // namespace TestPhysicsSnapshot
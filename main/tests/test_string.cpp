@@ -0,0 +1,129 @@
+/*************************************************************************/
+/*  test_string.cpp                                                      */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+
+#include "test_string.h"
+
+#include "core/os/os.h"
+#include "core/string/ustring.h"
+
+// The rest of the old string tests are in test_string.cpp.old, they need porting.
+
+namespace TestString {
+
+static bool _is_terminated(const String &p_string) {
+	return p_string.ptr()[p_string.length()] == 0;
+}
+
+bool test_parse_utf8_ascii() {
+	OS::get_singleton()->print("\n\nTest 1: parse_utf8 ASCII into a longer string\n");
+
+	String s = "This string is longer than the one parsed into it";
+	s.parse_utf8("Short");
+
+	OS::get_singleton()->print("\tExpected: Short (5)\n");
+	OS::get_singleton()->print("\tResulted: %s (%d)\n", s.utf8().get_data(), s.length());
+
+	return s.length() == 5 && _is_terminated(s) && s == "Short";
+}
+
+bool test_parse_utf8_ascii_len() {
+	OS::get_singleton()->print("\n\nTest 2: parse_utf8 ASCII with a length\n");
+
+	String s = "This string is longer than the one parsed into it";
+	s.parse_utf8("Shortened", 5);
+
+	OS::get_singleton()->print("\tExpected: Short (5)\n");
+	OS::get_singleton()->print("\tResulted: %s (%d)\n", s.utf8().get_data(), s.length());
+
+	return s.length() == 5 && _is_terminated(s) && s == "Short";
+}
+
+bool test_parse_utf8_mixed() {
+	OS::get_singleton()->print("\n\nTest 3: parse_utf8 ASCII followed by multibyte characters\n");
+
+	String s = "This string is longer than the one parsed into it";
+	s.parse_utf8("Sh\xc3\xb6rt");
+
+	OS::get_singleton()->print("\tExpected: 5 characters\n");
+	OS::get_singleton()->print("\tResulted: %d characters\n", s.length());
+
+	return s.length() == 5 && _is_terminated(s) && s[2] == 0xf6;
+}
+
+bool test_parse_utf8_empty() {
+	OS::get_singleton()->print("\n\nTest 4: parse_utf8 empty string\n");
+
+	String s = "Not empty";
+	s.parse_utf8("");
+
+	return s.empty() && s.length() == 0;
+}
+
+typedef bool (*TestFunc)();
+
+TestFunc test_funcs[] = {
+
+	test_parse_utf8_ascii,
+	test_parse_utf8_ascii_len,
+	test_parse_utf8_mixed,
+	test_parse_utf8_empty,
+	nullptr
+
+};
+
+MainLoop *test() {
+	int count = 0;
+	int passed = 0;
+
+	while (true) {
+		if (!test_funcs[count]) {
+			break;
+		}
+		bool pass = test_funcs[count]();
+		if (pass) {
+			passed++;
+		}
+		OS::get_singleton()->print("\t%s\n", pass ? "PASS" : "FAILED");
+
+		count++;
+	}
+
+	OS::get_singleton()->print("\n\n\n");
+	OS::get_singleton()->print("*************\n");
+	OS::get_singleton()->print("***TOTALS!***\n");
+	OS::get_singleton()->print("*************\n");
+
+	OS::get_singleton()->print("Passed %i of %i tests\n", passed, count);
+
+	return nullptr;
+}
+} // namespace TestString
@@ -70,7 +70,7 @@ bool HTTPParser::has_error() const {
 }
 
 void HTTPParser::reset() {
-	_partial_data = "";
+	_reset_parser_buffers();
 	_is_ready = false;
 	_content_type = REQUEST_CONTENT_URLENCODED;
 	_error = false;
@@ -100,7 +100,9 @@ int HTTPParser::read_from_buffer(const char *p_buffer, const int p_data_length)
 	return parsed_bytes;
 }
 
-HTTPParser::HTTPParser() {
+HTTPParser::HTTPParser() :
+		_arena(16 * 1024),
+		_multipart_form_data_arena(16 * 1024) {
 	// Should always get set from the outside, if it remains 0 it's a bug.
 	max_request_size = 0;
 	request_max_file_upload_size = 0;
@@ -115,6 +117,14 @@ HTTPParser::HTTPParser() {
 	_content_type = REQUEST_CONTENT_URLENCODED;
 	_multipart_form_is_file = false;
 
+	// Big bodies and uploads go through the arena too, don't keep their memory between requests.
+	_arena.set_max_retained_size(64 * 1024);
+	_multipart_form_data_arena.set_max_retained_size(64 * 1024);
+
+	_body_data.set_arena(&_arena);
+	_queued_multipart_form_data.set_arena(&_arena);
+	_multipart_form_data.set_arena(&_multipart_form_data_arena);
+
 	settings = memnew(http_parser_settings);
 
 	settings->on_message_begin = _on_message_begin_cb;
@@ -170,6 +180,15 @@ HTTPParser::~HTTPParser() {
 void HTTPParser::_bind_methods() {
 }
 
+void HTTPParser::_reset_parser_buffers() {
+	_body_data.reset();
+	_queued_multipart_form_data.reset();
+	_multipart_form_data.reset();
+
+	_arena.reset();
+	_multipart_form_data_arena.reset();
+}
+
 int HTTPParser::HTTPParser::process_multipart_data(const char *at, size_t p_length) {
 	ERR_FAIL_COND_V(!_multipart_parser, p_length);
 
@@ -270,11 +289,13 @@ void HTTPParser::_process_multipart_header_value(const String &val) {
 }
 
 void HTTPParser::process_urlenc_data() {
-	if (_partial_data == "") {
+	if (_body_data.empty()) {
 		return;
 	}
 
-	Vector<String> params = _partial_data.split("&", false);
+	String data = String::utf8(_body_data.ptr(), _body_data.size());
+
+	Vector<String> params = data.split("&", false);
 
 	for (int i = 0; i < params.size(); ++i) {
 		String p = params[i];
@@ -490,7 +511,7 @@ int HTTPParser::on_headers_complete() {
 	}
 
 	_in_header = false;
-	_partial_data = "";
+	_body_data.clear();
 
 	return 0;
 }
@@ -499,32 +520,21 @@ int HTTPParser::on_body(const char *at, size_t p_length) {
 	int length = static_cast<int>(p_length);
 
 	if (_content_type == REQUEST_CONTENT_MULTIPART_FORM_DATA) {
-		int wofs = _queued_multipart_form_data.size();
-		_queued_multipart_form_data.resize(_queued_multipart_form_data.size() + length);
-		char *w = _queued_multipart_form_data.ptrw();
-		for (int i = 0; i < length; ++i) {
-			w[wofs++] = at[i];
-		}
+		_queued_multipart_form_data.append_array(at, length);
 
 		int processed = process_multipart_data(_queued_multipart_form_data.ptr(), _queued_multipart_form_data.size());
-		int size = _queued_multipart_form_data.size();
-		wofs = 0;
-		for (int i = processed; i < size; ++i) {
-			w[wofs++] = w[i];
-		}
 
-		_queued_multipart_form_data.resize(_queued_multipart_form_data.size() - processed);
+		_queued_multipart_form_data.remove_front(processed);
 
 		return 0;
 	}
 
-	String s = String::utf8(at, length);
-
 #if MESSAGE_DEBUG
-	ERR_PRINT("on_body " + s);
+	ERR_PRINT("on_body " + String::utf8(at, length));
 #endif
 
-	_partial_data += s;
+	// Decoded once the whole body arrived, so multi byte characters that are split between reads are handled properly.
+	_body_data.append_array(at, length);
 
 	return 0;
 }
@@ -563,6 +573,8 @@ int HTTPParser::on_message_complete() {
 	_multipart_form_filename = "";
 	_multipart_form_content_type = "";
 
+	_reset_parser_buffers();
+
 	return 0;
 }
 int HTTPParser::on_chunk_header() {
@@ -679,13 +691,7 @@ int HTTPParser::on_multipart_part_data_cb(const char *at, size_t length) {
 		}
 
 	} else {
-		int l = static_cast<int>(length);
-		int mfdofs = _multipart_form_data.size();
-		_multipart_form_data.resize(mfdofs + length);
-		char *w = _multipart_form_data.ptrw();
-		for (int i = 0; i < l; ++i) {
-			w[mfdofs++] = at[i];
-		}
+		_multipart_form_data.append_array(at, length);
 	}
 
 	return 0;
@@ -33,8 +33,9 @@
 /*************************************************************************/
 
 #include "core/containers/vector.h"
-#include "core/string/ustring.h"
+#include "core/os/arena_allocator.h"
 #include "core/os/file_access.h"
+#include "core/string/ustring.h"
 
 #include "core/object/reference.h"
 
@@ -80,7 +81,16 @@ public:
 protected:
 	static void _bind_methods();
 
-	String _partial_data;
+	void _reset_parser_buffers();
+
+	// Scratch memory for the request that is currently being parsed, released at once when the request is complete.
+	// An arena only grows its last allocation in place, so buffers that grow in turn get their own:
+	// _arena holds the body (_body_data, or _queued_multipart_form_data for multipart requests),
+	// _multipart_form_data_arena the data of the current form field.
+	ArenaAllocator _arena;
+	ArenaAllocator _multipart_form_data_arena;
+
+	ArenaVector<char> _body_data;
 
 	uint64_t _current_request_size;
 	uint64_t _current_upload_files_size;
@@ -100,13 +110,13 @@ protected:
 	String _multipart_boundary;
 
 	String _queued_multipart_header_field;
-	Vector<char> _queued_multipart_form_data;
+	ArenaVector<char> _queued_multipart_form_data;
 
 	String _multipart_form_name;
 	String _multipart_form_filename;
 	String _multipart_form_content_type;
 	bool _multipart_form_is_file;
-	Vector<char> _multipart_form_data;
+	ArenaVector<char> _multipart_form_data;
 
 	bool _error;
 
@@ -35,6 +35,7 @@
 
 #include "core/config/engine.h"
 #include "core/containers/hash_set.h"
+#include "core/math/a_star_grid_2d.h"
 #include "core/core_string_names.h"
 #include "core/io/marshalls.h"
 #include "scene/main/control.h"
@@ -2124,6 +2125,9 @@ void LayeredTileMapLayer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_used_cells_by_id", "source_id", "atlas_coords", "alternative_tile"), &LayeredTileMapLayer::get_used_cells_by_id, DEFVAL(LayeredTileSet::INVALID_SOURCE), DEFVAL(LayeredTileSetSource::INVALID_ATLAS_COORDS), DEFVAL(LayeredTileSetSource::INVALID_TILE_ALTERNATIVE));
 	ClassDB::bind_method(D_METHOD("get_used_rect"), &LayeredTileMapLayer::get_used_rect);
 
+	// Pathfinding.
+	ClassDB::bind_method(D_METHOD("update_astar_grid_2d", "astar_grid", "physics_layer", "weight_custom_data_layer"), &LayeredTileMapLayer::update_astar_grid_2d, DEFVAL(-1), DEFVAL(String()));
+
 	// Patterns.
 	ClassDB::bind_method(D_METHOD("get_pattern", "coords_array"), &LayeredTileMapLayer::get_pattern);
 	ClassDB::bind_method(D_METHOD("set_pattern", "position", "pattern"), &LayeredTileMapLayer::set_pattern);
@@ -2817,6 +2821,57 @@ Rect2i LayeredTileMapLayer::get_used_rect() const {
 	return used_rect_cache;
 }
 
+void LayeredTileMapLayer::update_astar_grid_2d(Ref<AStarGrid2D> p_astar_grid, int p_physics_layer, const String &p_weight_custom_data_layer) const {
+	ERR_FAIL_COND(p_astar_grid.is_null());
+	ERR_FAIL_COND(!tile_set.is_valid());
+	ERR_FAIL_COND_MSG(tile_set->get_tile_shape() != LayeredTileSet::TILE_SHAPE_SQUARE, "AStarGrid2D can only be built from a layer using square tiles.");
+	if (p_physics_layer >= 0) {
+		ERR_FAIL_INDEX(p_physics_layer, tile_set->get_physics_layers_count());
+	}
+
+	int weight_layer_id = -1;
+	if (!p_weight_custom_data_layer.empty()) {
+		weight_layer_id = tile_set->get_custom_data_layer_by_name(p_weight_custom_data_layer);
+		ERR_FAIL_COND_MSG(weight_layer_id < 0, vformat("No custom data layer named \"%s\" in the TileSet.", p_weight_custom_data_layer));
+	}
+
+	// Cell centers match map_to_local().
+	Size2 tile_size = tile_set->get_tile_size();
+	Rect2i region = get_used_rect();
+
+	p_astar_grid->set_region(region);
+	p_astar_grid->set_cell_size(tile_size);
+	p_astar_grid->set_offset(tile_size / 2);
+	p_astar_grid->update();
+
+	// Empty cells are not walkable, only the used cells get opened below.
+	p_astar_grid->fill_solid_region(region, true);
+
+	for (const HashMap<Vector2i, CellData>::Element *E = tile_map_layer_data.front(); E; E = E->next) {
+		if (E->value().cell.source_id == LayeredTileSet::INVALID_SOURCE) {
+			continue;
+		}
+
+		const LayeredTileData *tile_data = get_cell_tile_data(E->key());
+		if (!tile_data) {
+			continue;
+		}
+
+		if (p_physics_layer >= 0 && tile_data->get_collision_polygons_count(p_physics_layer) > 0) {
+			continue;
+		}
+
+		p_astar_grid->set_point_solid(E->key(), false);
+
+		if (weight_layer_id >= 0) {
+			Variant weight = tile_data->get_custom_data_by_layer_id(weight_layer_id);
+			if (weight.get_type() == Variant::REAL || weight.get_type() == Variant::INT) {
+				p_astar_grid->set_point_weight_scale(E->key(), weight);
+			}
+		}
+	}
+}
+
 Ref<LayeredTileMapPattern> LayeredTileMapLayer::get_pattern(PoolVector2iArray p_coords_array) {
 	ERR_FAIL_COND_V(!tile_set.is_valid(), nullptr);
 
@@ -42,6 +42,7 @@
 #include "modules/fastnoise/noise.h"
 #endif
 
+class AStarGrid2D;
 class LayeredTileSetAtlasSource;
 class LayeredTileMap;
 
@@ -505,6 +506,9 @@ public:
 	PoolVector2iArray get_used_cells_by_id(int p_source_id = LayeredTileSet::INVALID_SOURCE, const Vector2i &p_atlas_coords = LayeredTileSetSource::INVALID_ATLAS_COORDS, int p_alternative_tile = LayeredTileSetSource::INVALID_TILE_ALTERNATIVE) const;
 	Rect2i get_used_rect() const;
 
+	// Pathfinding.
+	void update_astar_grid_2d(Ref<AStarGrid2D> p_astar_grid, int p_physics_layer = -1, const String &p_weight_custom_data_layer = String()) const;
+
 	// Patterns.
 	Ref<LayeredTileMapPattern> get_pattern(PoolVector2iArray p_coords_array);
 	void set_pattern(const Vector2i &p_position, const Ref<LayeredTileMapPattern> p_pattern);
@@ -0,0 +1,124 @@
+/*************************************************************************/
+/*  nav_avoidance_grid.cpp                                               */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "nav_avoidance_grid.h"
+
+void NavAvoidanceGrid::_link(uint32_t p_agent) {
+	Node &node = nodes[p_agent];
+	uint32_t &first = buckets[_get_bucket_index(node.point.cell)];
+
+	node.previous = NONE;
+	node.next = first;
+	if (first != NONE) {
+		nodes[first].previous = p_agent;
+	}
+	first = p_agent;
+}
+
+void NavAvoidanceGrid::_unlink(uint32_t p_agent) {
+	const Node &node = nodes[p_agent];
+
+	if (node.previous != NONE) {
+		nodes[node.previous].next = node.next;
+	} else {
+		buckets[_get_bucket_index(node.point.cell)] = node.next;
+	}
+	if (node.next != NONE) {
+		nodes[node.next].previous = node.previous;
+	}
+}
+
+void NavAvoidanceGrid::set_cell_size(real_t p_cell_size) {
+	ERR_FAIL_COND(p_cell_size <= 0.0);
+
+	cell_size = p_cell_size;
+	nodes.clear();
+}
+
+void NavAvoidanceGrid::update(const LocalVector<Point> &p_points) {
+	if (p_points.empty()) {
+		clear();
+		return;
+	}
+
+	if (p_points.size() != nodes.size()) {
+		// About two buckets per agent keeps them short, even with crowded
+		// cells hashing next to sparse ones.
+		const uint32_t bucket_count = next_power_of_2(p_points.size() * 2);
+		buckets.resize(bucket_count);
+		bucket_mask = bucket_count - 1;
+		for (uint32_t i = 0; i < bucket_count; i++) {
+			buckets[i] = NONE;
+		}
+
+		nodes.resize(p_points.size());
+		for (uint32_t i = 0; i < p_points.size(); i++) {
+			nodes[i].point = p_points[i];
+			_link(i);
+		}
+	} else {
+		for (uint32_t i = 0; i < p_points.size(); i++) {
+			Point &point = nodes[i].point;
+			const Point &new_point = p_points[i];
+
+			if (point.cell.x == new_point.cell.x && point.cell.y == new_point.cell.y) {
+				point.position = new_point.position;
+			} else {
+				_unlink(i);
+				point = new_point;
+				_link(i);
+			}
+		}
+	}
+
+	min_cell = p_points[0].cell;
+	max_cell = p_points[0].cell;
+	for (uint32_t i = 1; i < p_points.size(); i++) {
+		const Vector2i &cell = p_points[i].cell;
+		min_cell.x = MIN(min_cell.x, cell.x);
+		min_cell.y = MIN(min_cell.y, cell.y);
+		max_cell.x = MAX(max_cell.x, cell.x);
+		max_cell.y = MAX(max_cell.y, cell.y);
+	}
+}
+
+void NavAvoidanceGrid::clear() {
+	buckets.clear();
+	bucket_mask = 0;
+	nodes.clear();
+	min_cell = Vector2i();
+	max_cell = Vector2i();
+}
+
+NavAvoidanceGrid::NavAvoidanceGrid() {
+	cell_size = 1.0;
+	bucket_mask = 0;
+}
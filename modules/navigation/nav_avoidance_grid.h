@@ -0,0 +1,173 @@
+#ifndef NAV_AVOIDANCE_GRID_H
+#define NAV_AVOIDANCE_GRID_H
+
+/*************************************************************************/
+/*  nav_avoidance_grid.h                                                 */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "core/containers/hashfuncs.h"
+#include "core/containers/local_vector.h"
+#include "core/math/vector2.h"
+#include "core/math/vector2i.h"
+
+/// Uniform grid over the avoidance agents of a map, on the plane of their
+/// position. Cells are hashed into buckets so the grid has no bounds, and
+/// updating it only moves the agents that changed cell since the last update,
+/// instead of rebuilding a tree over all of them every step.
+class NavAvoidanceGrid {
+public:
+	struct Point {
+		Vector2 position;
+		Vector2i cell;
+	};
+
+private:
+	enum {
+		NONE = UINT32_MAX,
+	};
+
+	// The agents of a bucket are linked through their nodes, so moving one
+	// only touches the nodes next to it and the buckets, all in two arrays.
+	struct Node {
+		Point point;
+		uint32_t previous;
+		uint32_t next;
+	};
+
+	real_t cell_size;
+	uint32_t bucket_mask;
+
+	// First agent of each hashed cell. Cells sharing a bucket are told apart
+	// by the cell of the agents.
+	LocalVector<uint32_t> buckets;
+	// By agent index. Points are kept here rather than read from the agents,
+	// so far away agents are skipped without looking them up.
+	LocalVector<Node> nodes;
+
+	// Cells holding agents are within these.
+	Vector2i min_cell;
+	Vector2i max_cell;
+
+	_FORCE_INLINE_ uint32_t _get_bucket_index(const Vector2i &p_cell) const {
+		return hash_fmix32(hash_murmur3_one_32(p_cell.y, hash_murmur3_one_32(p_cell.x))) & bucket_mask;
+	}
+
+	void _link(uint32_t p_agent);
+	void _unlink(uint32_t p_agent);
+
+	template <class T>
+	_FORCE_INLINE_ void _query_cell(const Vector2i &p_cell, real_t p_x, real_t p_y, float &r_range_squared, T &p_visitor) const {
+		if (p_cell.x < min_cell.x || p_cell.y < min_cell.y || p_cell.x > max_cell.x || p_cell.y > max_cell.y) {
+			return;
+		}
+
+		for (uint32_t agent = buckets[_get_bucket_index(p_cell)]; agent != NONE; agent = nodes[agent].next) {
+			const Point &point = nodes[agent].point;
+			if (point.cell.x != p_cell.x || point.cell.y != p_cell.y) {
+				continue;
+			}
+
+			const real_t x = point.position.x - p_x;
+			const real_t y = point.position.y - p_y;
+			if (x * x + y * y < r_range_squared) {
+				p_visitor(agent, r_range_squared);
+			}
+		}
+	}
+
+public:
+	_FORCE_INLINE_ Point get_point(real_t p_x, real_t p_y) const {
+		Point point;
+		point.position = Vector2(p_x, p_y);
+		point.cell = Vector2i((int)Math::floor(p_x / cell_size), (int)Math::floor(p_y / cell_size));
+		return point;
+	}
+
+	real_t get_cell_size() const {
+		return cell_size;
+	}
+
+	uint32_t get_agent_count() const {
+		return nodes.size();
+	}
+
+	/// Removes the agents, the next update adds them back from scratch.
+	void set_cell_size(real_t p_cell_size);
+
+	/// Puts every agent at its point in p_points, by agent index. Moves only
+	/// the agents that changed cell when there are as many agents as in the
+	/// previous update.
+	void update(const LocalVector<Point> &p_points);
+
+	void clear();
+
+	/// Calls p_visitor(agent_index, r_range_squared) for the agents within the
+	/// range of the point, from the nearest ring of cells outwards, until the
+	/// rings are out of range. The visitor can shrink the range, like the
+	/// neighbour insertion of RVO agents does once it has enough of them.
+	template <class T>
+	void query(real_t p_x, real_t p_y, float &r_range_squared, T &p_visitor) const {
+		if (nodes.empty()) {
+			return;
+		}
+
+		const Vector2i center = get_point(p_x, p_y).cell;
+		// Further rings are past every cell holding an agent.
+		const int max_ring = MAX(MAX(center.x - min_cell.x, max_cell.x - center.x), MAX(center.y - min_cell.y, max_cell.y - center.y));
+
+		// Distance from the point to the closest side of its cell, the cells of
+		// a ring are that plus ring - 1 cells away.
+		const real_t x = p_x - center.x * cell_size;
+		const real_t y = p_y - center.y * cell_size;
+		const real_t side_distance = MIN(MIN(x, cell_size - x), MIN(y, cell_size - y));
+
+		_query_cell(center, p_x, p_y, r_range_squared, p_visitor);
+
+		for (int ring = 1; ring <= max_ring; ring++) {
+			const real_t gap = side_distance + (ring - 1) * cell_size;
+			if (gap * gap >= r_range_squared) {
+				break;
+			}
+
+			for (int i = -ring; i <= ring; i++) {
+				_query_cell(Vector2i(center.x + i, center.y - ring), p_x, p_y, r_range_squared, p_visitor);
+				_query_cell(Vector2i(center.x + i, center.y + ring), p_x, p_y, r_range_squared, p_visitor);
+			}
+			for (int i = -ring + 1; i < ring; i++) {
+				_query_cell(Vector2i(center.x - ring, center.y + i), p_x, p_y, r_range_squared, p_visitor);
+				_query_cell(Vector2i(center.x + ring, center.y + i), p_x, p_y, r_range_squared, p_visitor);
+			}
+		}
+	}
+
+	NavAvoidanceGrid();
+};
+
+#endif // NAV_AVOIDANCE_GRID_H
@@ -46,28 +46,50 @@ protected:
 	ObjectID owner_id;
 	NavigationUtilities::PathSegmentType type;
 
+	/// Set when one of the properties copied by the map synchronization changes.
+	bool properties_dirty;
+
 public:
 	NavigationUtilities::PathSegmentType get_type() const { return type; }
 
 	virtual void set_use_edge_connections(bool p_enabled) {}
 	virtual bool get_use_edge_connections() const { return false; }
 
-	void set_navigation_layers(uint32_t p_navigation_layers) { navigation_layers = p_navigation_layers; }
+	void set_navigation_layers(uint32_t p_navigation_layers) {
+		navigation_layers = p_navigation_layers;
+		properties_dirty = true;
+	}
 	uint32_t get_navigation_layers() const { return navigation_layers; }
 
-	void set_enter_cost(real_t p_enter_cost) { enter_cost = MAX(p_enter_cost, 0.0); }
+	void set_enter_cost(real_t p_enter_cost) {
+		enter_cost = MAX(p_enter_cost, 0.0);
+		properties_dirty = true;
+	}
 	real_t get_enter_cost() const { return enter_cost; }
 
-	void set_travel_cost(real_t p_travel_cost) { travel_cost = MAX(p_travel_cost, 0.0); }
+	void set_travel_cost(real_t p_travel_cost) {
+		travel_cost = MAX(p_travel_cost, 0.0);
+		properties_dirty = true;
+	}
 	real_t get_travel_cost() const { return travel_cost; }
 
-	void set_owner_id(ObjectID p_owner_id) { owner_id = p_owner_id; }
+	void set_owner_id(ObjectID p_owner_id) {
+		owner_id = p_owner_id;
+		properties_dirty = true;
+	}
 	ObjectID get_owner_id() const { return owner_id; }
 
+	bool check_properties_dirty() {
+		const bool was_dirty = properties_dirty;
+		properties_dirty = false;
+		return was_dirty;
+	}
+
 	NavBase() {
 		navigation_layers = 1;
 		enter_cost = 0.0;
 		travel_cost = 1.0;
+		properties_dirty = false;
 	};
 	virtual ~NavBase() {};
 };
@@ -0,0 +1,341 @@
+/*************************************************************************/
+/*  nav_flow_field.cpp                                                   */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "nav_flow_field.h"
+
+#include "core/containers/sort_array.h"
+#include "core/math/geometry.h"
+#include "nav_base.h"
+#include "nav_map.h"
+#include "nav_map_iteration.h"
+
+// Distance to the apex of a polygon under which an agent is considered to
+// have reached it, and follows the apex of the next polygon instead.
+#define FLOW_FIELD_PASS_THROUGH_DISTANCE 0.01
+#define FLOW_FIELD_MAX_PASS_THROUGH 4
+// Windows shorter than this, relative to the pathway they are cut from, are
+// seen through edgewise and treated as closed.
+#define FLOW_FIELD_WINDOW_EPSILON 0.0001
+
+static _FORCE_INLINE_ const gd::Polygon *_get_polygon(const NavMapIteration *p_iteration, uint32_t p_id) {
+	if (p_id < p_iteration->polygons.size()) {
+		return &p_iteration->polygons[p_id];
+	}
+	return &p_iteration->link_polygons[p_id - p_iteration->polygons.size()];
+}
+
+// Positive when p_c is on the left of the line from p_a to p_b, looking down the up axis.
+static _FORCE_INLINE_ real_t _get_side(const Vector3 &p_up, const Vector3 &p_a, const Vector3 &p_b, const Vector3 &p_c) {
+	return p_up.dot((p_b - p_a).cross(p_c - p_a));
+}
+
+// Cuts the segment from r_start to r_end down to the part p_apex sees through
+// the window. The apex is past the window and the segment before it, so the
+// window sides only have to be looked at from one way. An apex on the line of
+// the window is inside the polygon the window belongs to and sees all of it.
+// Returns -1 when part of the segment is left, otherwise the window side, 0 for
+// the start and 1 for the end, the whole segment is past.
+static int _clip_to_window(const Vector3 &p_up, const Vector3 &p_apex, const Vector3 &p_window_start, const Vector3 &p_window_end, Vector3 &r_start, Vector3 &r_end) {
+	const Vector3 window_sides[2] = { p_window_start, p_window_end };
+	const real_t window_length = p_window_start.distance_to(p_window_end);
+
+	real_t from = 0.0;
+	real_t to = 1.0;
+	for (int i = 0; i < 2; i++) {
+		const Vector3 &side = window_sides[i];
+		const Vector3 &other_side = window_sides[1 - i];
+
+		const real_t apex_side = _get_side(p_up, p_apex, side, other_side);
+		if (Math::abs(apex_side) <= FLOW_FIELD_WINDOW_EPSILON * window_length * p_apex.distance_to(side)) {
+			continue;
+		}
+
+		// Positive on the inner side of the line from the apex through the window side.
+		const real_t sign = apex_side > 0 ? 1.0 : -1.0;
+		const real_t start_side = _get_side(p_up, p_apex, side, r_start) * sign;
+		const real_t end_side = _get_side(p_up, p_apex, side, r_end) * sign;
+
+		if (start_side < 0 && end_side < 0) {
+			return i;
+		}
+		if (start_side < 0) {
+			from = MAX(from, start_side / (start_side - end_side));
+		} else if (end_side < 0) {
+			to = MIN(to, start_side / (start_side - end_side));
+		}
+	}
+
+	const Vector3 segment = r_end - r_start;
+	if (to - from <= FLOW_FIELD_WINDOW_EPSILON) {
+		// Only grazes the window, go around the closest side.
+		const Vector3 middle = r_start + segment * ((from + to) * 0.5);
+		return middle.distance_squared_to(p_window_start) <= middle.distance_squared_to(p_window_end) ? 0 : 1;
+	}
+
+	const Vector3 start = r_start;
+	r_start = start + segment * from;
+	r_end = start + segment * to;
+	return -1;
+}
+
+struct FlowFieldIncomingConnection {
+	uint32_t polygon;
+	const gd::Edge::Connection *connection;
+};
+
+void NavFlowField::build() {
+	ERR_FAIL_NULL(iteration);
+
+	const LocalVector<gd::Polygon> &polygons = iteration->polygons;
+	const uint32_t polygon_count = polygons.size() + iteration->link_polygons.size();
+
+	NavPolygonBVH::ClosestPoint closest;
+	if (!iteration->polygons_bvh.get_closest_point(polygons, key.goal, true, key.navigation_layers, closest)) {
+		// Nothing to reach, every sample fails.
+		return;
+	}
+
+	distances.resize(polygon_count);
+	next_polygons.resize(polygon_count);
+	apexes.resize(polygon_count);
+	apex_distances.resize(polygon_count);
+	window_starts.resize(polygon_count);
+	window_ends.resize(polygon_count);
+	for (uint32_t i = 0; i < polygon_count; i++) {
+		distances[i] = FLT_MAX;
+		next_polygons[i] = UINT32_MAX;
+	}
+
+	// The connections lead from a polygon to its neighbours, the search goes
+	// from the goal outwards so it needs them the other way around.
+	LocalVector<uint32_t> incoming_offsets;
+	incoming_offsets.resize(polygon_count + 1);
+	for (uint32_t i = 0; i <= polygon_count; i++) {
+		incoming_offsets[i] = 0;
+	}
+
+	for (uint32_t i = 0; i < polygon_count; i++) {
+		const gd::Polygon *polygon = _get_polygon(iteration, i);
+		if (polygon->id == UINT32_MAX) {
+			// Link polygon slot of a link that didn't connect.
+			continue;
+		}
+
+		for (uint32_t j = 0; j < polygon->edges.size(); j++) {
+			const Vector<gd::Edge::Connection> &connections = polygon->edges[j].connections;
+			for (int k = 0; k < connections.size(); k++) {
+				incoming_offsets[connections[k].polygon->id + 1]++;
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < polygon_count; i++) {
+		incoming_offsets[i + 1] += incoming_offsets[i];
+	}
+
+	LocalVector<FlowFieldIncomingConnection> incoming;
+	incoming.resize(incoming_offsets[polygon_count]);
+
+	LocalVector<uint32_t> incoming_cursors = incoming_offsets;
+	for (uint32_t i = 0; i < polygon_count; i++) {
+		const gd::Polygon *polygon = _get_polygon(iteration, i);
+		if (polygon->id == UINT32_MAX) {
+			continue;
+		}
+
+		for (uint32_t j = 0; j < polygon->edges.size(); j++) {
+			const Vector<gd::Edge::Connection> &connections = polygon->edges[j].connections;
+			for (int k = 0; k < connections.size(); k++) {
+				FlowFieldIncomingConnection &incoming_connection = incoming[incoming_cursors[connections[k].polygon->id]++];
+				incoming_connection.polygon = i;
+				incoming_connection.connection = &connections[k];
+			}
+		}
+	}
+
+	// Dijkstra from the goal. Rather than going from pathway to pathway, which
+	// zigzags, each polygon keeps the apex of the straight path towards the
+	// goal, like the funnel of a path query does. A polygon keeps the apex of
+	// the next one when it sees it through the next window, and otherwise
+	// turns around the side of the window that is in the way. The straight
+	// lines stay within polygons of one owner, so they cost the same all along.
+	LocalVector<OpenEntry> open_list;
+	SortArray<OpenEntry, SortOpenEntries> sorter;
+
+	distances[closest.polygon] = 0;
+	apexes[closest.polygon] = closest.point;
+	apex_distances[closest.polygon] = 0;
+	window_starts[closest.polygon] = closest.point;
+	window_ends[closest.polygon] = closest.point;
+
+	OpenEntry goal_entry;
+	goal_entry.distance = 0;
+	goal_entry.polygon = closest.polygon;
+	open_list.push_back(goal_entry);
+
+	while (!open_list.empty()) {
+		sorter.pop_heap(0, open_list.size(), open_list.ptr());
+		OpenEntry entry = open_list[open_list.size() - 1];
+		open_list.resize(open_list.size() - 1);
+
+		if (entry.distance > distances[entry.polygon]) {
+			// Already reached through a shorter way.
+			continue;
+		}
+
+		const gd::Polygon *polygon = _get_polygon(iteration, entry.polygon);
+		const Vector3 &apex = apexes[entry.polygon];
+		const real_t travel_cost = polygon->owner->get_travel_cost();
+
+		for (uint32_t i = incoming_offsets[entry.polygon]; i < incoming_offsets[entry.polygon + 1]; i++) {
+			const FlowFieldIncomingConnection &incoming_connection = incoming[i];
+			const gd::Polygon *from_polygon = _get_polygon(iteration, incoming_connection.polygon);
+
+			if ((key.navigation_layers & from_polygon->owner->get_navigation_layers()) == 0) {
+				continue;
+			}
+
+			Vector3 window_start = incoming_connection.connection->pathway_start;
+			Vector3 window_end = incoming_connection.connection->pathway_end;
+			Vector3 from_apex = apex;
+			real_t from_apex_distance = apex_distances[entry.polygon];
+
+			int corner = _clip_to_window(iteration->up, apex, window_starts[entry.polygon], window_ends[entry.polygon], window_start, window_end);
+			if (corner == -1) {
+				// A window in line with the apex only runs along a side of the
+				// window it is seen through, the polygons past it would see
+				// through walls.
+				const Vector3 to_start = window_start - apex;
+				const Vector3 to_end = window_end - apex;
+				if (to_start.dot(to_end) > 0 && Math::abs(_get_side(iteration->up, apex, window_start, window_end)) <= FLOW_FIELD_WINDOW_EPSILON * to_start.length() * to_end.length()) {
+					const Vector3 middle = (window_start + window_end) * 0.5;
+					corner = middle.distance_squared_to(window_starts[entry.polygon]) <= middle.distance_squared_to(window_ends[entry.polygon]) ? 0 : 1;
+					window_start = incoming_connection.connection->pathway_start;
+					window_end = incoming_connection.connection->pathway_end;
+				}
+			}
+			if (corner != -1) {
+				// The polygon sees all of its own pathway from the corner.
+				from_apex = corner == 0 ? window_starts[entry.polygon] : window_ends[entry.polygon];
+				from_apex_distance += apex.distance_to(from_apex) * travel_cost;
+			}
+
+			Vector3 window[2] = { window_start, window_end };
+			const Vector3 from_exit = Geometry::get_closest_point_to_segment(from_apex, window);
+
+			real_t distance = from_apex_distance + from_exit.distance_to(from_apex) * travel_cost;
+			const bool same_owner = from_polygon->owner->get_self() == polygon->owner->get_self();
+			if (!same_owner) {
+				distance += polygon->owner->get_enter_cost();
+			}
+
+			if (distance < distances[incoming_connection.polygon]) {
+				distances[incoming_connection.polygon] = distance;
+				next_polygons[incoming_connection.polygon] = entry.polygon;
+
+				if (same_owner) {
+					apexes[incoming_connection.polygon] = from_apex;
+					apex_distances[incoming_connection.polygon] = from_apex_distance;
+					window_starts[incoming_connection.polygon] = window_start;
+					window_ends[incoming_connection.polygon] = window_end;
+				} else {
+					// Costs change past the pathway, start a new straight line from it.
+					apexes[incoming_connection.polygon] = from_exit;
+					apex_distances[incoming_connection.polygon] = distance;
+					window_starts[incoming_connection.polygon] = incoming_connection.connection->pathway_start;
+					window_ends[incoming_connection.polygon] = incoming_connection.connection->pathway_end;
+				}
+
+				OpenEntry new_entry;
+				new_entry.distance = distance;
+				new_entry.polygon = incoming_connection.polygon;
+				open_list.push_back(new_entry);
+				sorter.push_heap(0, open_list.size() - 1, 0, new_entry, open_list.ptr());
+			}
+		}
+	}
+}
+
+bool NavFlowField::sample(const Vector3 &p_position, Vector3 &r_direction, real_t &r_distance) const {
+	if (distances.empty()) {
+		return false;
+	}
+
+	NavPolygonBVH::ClosestPoint closest;
+	if (!iteration->polygons_bvh.get_closest_point(iteration->polygons, p_position, true, key.navigation_layers, closest)) {
+		return false;
+	}
+
+	uint32_t polygon = closest.polygon;
+	if (distances[polygon] == FLT_MAX) {
+		return false;
+	}
+
+	// At the apex, or close enough to the start of a link to take it, head for
+	// the apex of the next polygon.
+	for (int i = 0; i < FLOW_FIELD_MAX_PASS_THROUGH && next_polygons[polygon] != UINT32_MAX; i++) {
+		const real_t reach = next_polygons[polygon] >= iteration->polygons.size() ? link_reach : (real_t)FLOW_FIELD_PASS_THROUGH_DISTANCE;
+		if (closest.point.distance_to(apexes[polygon]) > reach) {
+			break;
+		}
+
+		polygon = next_polygons[polygon];
+	}
+
+	const Vector3 &apex = apexes[polygon];
+	const real_t travel_cost = _get_polygon(iteration, polygon)->owner->get_travel_cost();
+
+	Vector3 target = apex;
+	r_distance = apex_distances[polygon];
+
+	Vector3 position_start = closest.point;
+	Vector3 position_end = closest.point;
+	const int corner = _clip_to_window(iteration->up, apex, window_starts[polygon], window_ends[polygon], position_start, position_end);
+	if (corner != -1) {
+		// Off to the side of the window, go around it first.
+		target = corner == 0 ? window_starts[polygon] : window_ends[polygon];
+		r_distance += apex.distance_to(target) * travel_cost;
+	}
+
+	r_direction = (target - closest.point).normalized();
+	r_distance += closest.point.distance_to(target) * travel_cost;
+	return true;
+}
+
+NavFlowField::NavFlowField(const NavFlowFieldKey &p_key, real_t p_link_reach, NavMapIteration *p_iteration) {
+	key = p_key;
+	link_reach = p_link_reach;
+	iteration = p_iteration;
+}
+
+NavFlowField::~NavFlowField() {
+	NavMap::release_iteration(iteration);
+}
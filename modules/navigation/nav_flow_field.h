@@ -0,0 +1,121 @@
+#ifndef NAV_FLOW_FIELD_H
+#define NAV_FLOW_FIELD_H
+
+/*************************************************************************/
+/*  nav_flow_field.h                                                     */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "core/containers/hashfuncs.h"
+#include "core/containers/local_vector.h"
+#include "core/math/vector3.h"
+
+class NavMapIteration;
+
+/// Goal and layers a flow field is cached by.
+struct NavFlowFieldKey {
+	Vector3 goal;
+	uint32_t navigation_layers;
+
+	static uint32_t hash(const NavFlowFieldKey &p_val) {
+		uint32_t h = hash_murmur3_one_real(p_val.goal.x);
+		h = hash_murmur3_one_real(p_val.goal.y, h);
+		h = hash_murmur3_one_real(p_val.goal.z, h);
+		h = hash_murmur3_one_32(p_val.navigation_layers, h);
+		return hash_fmix32(h);
+	}
+
+	bool operator==(const NavFlowFieldKey &p_key) const {
+		return goal == p_key.goal && navigation_layers == p_key.navigation_layers;
+	}
+
+	NavFlowFieldKey(const Vector3 &p_goal = Vector3(), uint32_t p_navigation_layers = 0) :
+			goal(p_goal),
+			navigation_layers(p_navigation_layers) {
+	}
+};
+
+/// The travel distance from every polygon of a map iteration to one goal,
+/// with the point to head to from each polygon. Agents sharing a destination
+/// steer with it instead of each running its own path query.
+///
+/// Built once on a worker thread and then only read, it keeps a reference on
+/// the iteration it was built from so it stays valid when the map changes.
+class NavFlowField {
+	struct OpenEntry {
+		real_t distance;
+		uint32_t polygon;
+	};
+
+	struct SortOpenEntries {
+		// The heap functions of SortArray keep the greatest one on top.
+		_FORCE_INLINE_ bool operator()(const OpenEntry &A, const OpenEntry &B) const {
+			return A.distance > B.distance;
+		}
+	};
+
+	NavFlowFieldKey key;
+	real_t link_reach;
+	NavMapIteration *iteration;
+
+	/// By polygon id, region polygons first then link polygons.
+	/// Travel cost from the exit of the polygon to the goal, FLT_MAX when it can't be reached.
+	LocalVector<real_t> distances;
+	LocalVector<uint32_t> next_polygons;
+	/// The point the straight path from the polygon goes to: the goal, the
+	/// corner it has to turn around, or the start of a region or link with
+	/// other costs. It is seen from the polygon through its window, a part of
+	/// the pathway to the next polygon.
+	LocalVector<Vector3> apexes;
+	LocalVector<real_t> apex_distances;
+	LocalVector<Vector3> window_starts;
+	LocalVector<Vector3> window_ends;
+
+public:
+	const NavFlowFieldKey &get_key() const {
+		return key;
+	}
+
+	const NavMapIteration *get_iteration() const {
+		return iteration;
+	}
+
+	/// Computes the distances, from the goal outwards.
+	void build();
+
+	/// Direction to follow and remaining distance to the goal from p_position.
+	/// Returns false when p_position is off the navigation mesh or can't reach the goal.
+	bool sample(const Vector3 &p_position, Vector3 &r_direction, real_t &r_distance) const;
+
+	/// Takes ownership of the reference on p_iteration.
+	NavFlowField(const NavFlowFieldKey &p_key, real_t p_link_reach, NavMapIteration *p_iteration);
+	~NavFlowField();
+};
+
+#endif // NAV_FLOW_FIELD_H
@@ -32,6 +32,7 @@
 #include "nav_map.h"
 
 #include "core/config/project_settings.h"
+#include "core/os/os.h"
 #include "core/os/threaded_array_processor.h"
 #include "nav_agent.h"
 #include "nav_link.h"
@@ -56,6 +57,42 @@
 		r_path_owners->push_back(poly->owner->get_owner_id()); \
 	}
 
+// Path queries can run on any thread, each one gets its own scratch memory.
+static thread_local gd::PathQueryContext path_query_context;
+static thread_local NavMapHierarchy::QueryContext hierarchy_query_context;
+
+struct PathQueryContextClear {
+	gd::PathQueryContext *context;
+	NavMapHierarchy::QueryContext *hierarchy_context;
+
+	PathQueryContextClear(gd::PathQueryContext *p_context, NavMapHierarchy::QueryContext *p_hierarchy_context) {
+		context = p_context;
+		hierarchy_context = p_hierarchy_context;
+	}
+
+	~PathQueryContextClear() {
+		context->clear();
+		hierarchy_context->clear();
+	}
+};
+
+struct OuterEdgeRef {
+	uint32_t region;
+	uint32_t outer_edge;
+};
+
+struct NavMapIterationRead {
+	NavMapIteration *iteration;
+
+	NavMapIterationRead(const NavMap *p_map) {
+		iteration = p_map->acquire_iteration();
+	}
+
+	~NavMapIterationRead() {
+		NavMap::release_iteration(iteration);
+	}
+};
+
 void NavMap::set_up(Vector3 p_up) {
 	if (up == p_up) {
 		return;
@@ -89,6 +126,7 @@ void NavMap::set_use_edge_connections(bool p_enabled) {
 	}
 	use_edge_connections = p_enabled;
 	regenerate_links = true;
+	regenerate_edge_connections = true;
 }
 
 void NavMap::set_edge_connection_margin(real_t p_edge_connection_margin) {
@@ -98,6 +136,7 @@ void NavMap::set_edge_connection_margin(real_t p_edge_connection_margin) {
 
 	edge_connection_margin = p_edge_connection_margin;
 	regenerate_links = true;
+	regenerate_edge_connections = true;
 }
 
 void NavMap::set_link_connection_radius(real_t p_link_connection_radius) {
@@ -122,9 +161,39 @@ gd::PointKey NavMap::get_point_key(const Vector3 &p_pos) const {
 	return p;
 }
 
+NavMapIteration *NavMap::acquire_iteration() const {
+	RWLockRead read_lock(iteration_lock);
+
+	if (iteration) {
+		iteration->refcount.ref();
+	}
+	return iteration;
+}
+
+void NavMap::release_iteration(NavMapIteration *p_iteration) {
+	if (p_iteration && p_iteration->refcount.unref()) {
+		memdelete(p_iteration);
+	}
+}
+
 Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigation_layers, Vector<int32_t> *r_path_types, Array *r_path_rids, Vector<uint64_t> *r_path_owners) const {
 	ERR_FAIL_COND_V_MSG(map_update_id == 0, Vector<Vector3>(), "NavigationServer map query failed because it was made before first map synchronization.");
 
+	NavMapIterationRead map_iteration(this);
+	ERR_FAIL_COND_V(!map_iteration.iteration, Vector<Vector3>());
+
+	const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	Vector<Vector3> path = get_iteration_path(map_iteration.iteration, p_origin, p_destination, p_optimize, p_navigation_layers, r_path_types, r_path_rids, r_path_owners);
+	add_path_query(OS::get_singleton()->get_ticks_usec() - begin);
+
+	return path;
+}
+
+Vector<Vector3> NavMap::get_iteration_path(const NavMapIteration *p_iteration, Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigation_layers, Vector<int32_t> *r_path_types, Array *r_path_rids, Vector<uint64_t> *r_path_owners) {
+	const LocalVector<gd::Polygon> &polygons = p_iteration->polygons;
+	const NavPolygonBVH &polygons_bvh = p_iteration->polygons_bvh;
+	const Vector3 &up = p_iteration->up;
+
 	// Clear metadata outputs.
 	if (r_path_types) {
 		r_path_types->clear();
@@ -141,38 +210,18 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 	const gd::Polygon *end_poly = nullptr;
 	Vector3 begin_point;
 	Vector3 end_point;
-	real_t begin_d = FLT_MAX;
 	real_t end_d = FLT_MAX;
 
 	// Find the initial poly and the end poly on this map.
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
-
-		// Only consider the polygon if it in a region with compatible layers.
-		if ((p_navigation_layers & p.owner->get_navigation_layers()) == 0) {
-			continue;
-		}
-
-		// For each face check the distance between the origin/destination
-		for (size_t point_id = 2; point_id < p.points.size(); point_id++) {
-			const Face3 face(p.points[0].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-
-			Vector3 point = face.get_closest_point_to(p_origin);
-			real_t distance_to_point = point.distance_to(p_origin);
-			if (distance_to_point < begin_d) {
-				begin_d = distance_to_point;
-				begin_poly = &p;
-				begin_point = point;
-			}
+	NavPolygonBVH::ClosestPoint closest;
+	if (polygons_bvh.get_closest_point(polygons, p_origin, true, p_navigation_layers, closest)) {
+		begin_poly = &polygons[closest.polygon];
+		begin_point = closest.point;
+	}
 
-			point = face.get_closest_point_to(p_destination);
-			distance_to_point = point.distance_to(p_destination);
-			if (distance_to_point < end_d) {
-				end_d = distance_to_point;
-				end_poly = &p;
-				end_point = point;
-			}
-		}
+	if (polygons_bvh.get_closest_point(polygons, p_destination, true, p_navigation_layers, closest)) {
+		end_poly = &polygons[closest.polygon];
+		end_point = closest.point;
 	}
 
 	// Check for trivial cases
@@ -206,9 +255,24 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 		return path;
 	}
 
+	// The scratch memory of this thread, cleared on every exit from here on.
+	PathQueryContextClear context_clear(&path_query_context, &hierarchy_query_context);
+	path_query_context.prepare(polygons.size() + p_iteration->link_polygons.size());
+
+	// On large maps search the cluster graph first, then only the polygons of
+	// the clusters on the way. Its costs assume every polygon can be crossed,
+	// so it is only used when the layers don't exclude any region or link.
+	bool use_corridor = !p_iteration->hierarchy.empty();
+	for (uint32_t i = 0; i < p_iteration->owners.size() && use_corridor; i++) {
+		use_corridor = (p_navigation_layers & p_iteration->owners[i]->get_navigation_layers()) != 0;
+	}
+	if (use_corridor) {
+		use_corridor = p_iteration->hierarchy.find_corridor(polygons, begin_poly, begin_point, end_poly, end_point, hierarchy_query_context);
+	}
+
 	// List of all reachable navigation polys.
-	LocalVector<gd::NavigationPoly> navigation_polys;
-	navigation_polys.reserve(polygons.size() * 0.75);
+	LocalVector<gd::NavigationPoly> &navigation_polys = path_query_context.navigation_polys;
+	LocalVector<uint32_t> &poly_to_navigation_poly = path_query_context.poly_to_navigation_poly;
 
 	// Add the start polygon to the reachable navigation polygons.
 	gd::NavigationPoly begin_navigation_poly = gd::NavigationPoly(begin_poly);
@@ -217,10 +281,10 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 	begin_navigation_poly.back_navigation_edge_pathway_start = begin_point;
 	begin_navigation_poly.back_navigation_edge_pathway_end = begin_point;
 	navigation_polys.push_back(begin_navigation_poly);
+	poly_to_navigation_poly[begin_poly->id] = 0;
 
-	// List of polygon IDs to visit.
-	List<uint32_t> to_visit;
-	to_visit.push_back(0);
+	// Polygons to visit, the least cost one first. The one being visited is not in it.
+	gd::NavigationPolyHeap &to_visit = path_query_context.traversable_polys;
 
 	// This is an implementation of the A* algorithm.
 	int least_cost_id = 0;
@@ -245,6 +309,10 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 					continue;
 				}
 
+				if (use_corridor && !p_iteration->hierarchy.is_polygon_in_corridor(connection.polygon->id, hierarchy_query_context)) {
+					continue;
+				}
+
 				const gd::NavigationPoly &least_cost_poly = navigation_polys[least_cost_id];
 				real_t poly_enter_cost = 0.0;
 				real_t poly_travel_cost = least_cost_poly.poly->owner->get_travel_cost();
@@ -258,9 +326,9 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 				const Vector3 new_entry = Geometry::get_closest_point_to_segment(least_cost_poly.entry, pathway);
 				const real_t new_distance = (least_cost_poly.entry.distance_to(new_entry) * poly_travel_cost) + poly_enter_cost + least_cost_poly.traveled_distance;
 
-				int64_t already_visited_polygon_index = navigation_polys.find(gd::NavigationPoly(connection.polygon));
+				uint32_t already_visited_polygon_index = poly_to_navigation_poly[connection.polygon->id];
 
-				if (already_visited_polygon_index != -1) {
+				if (already_visited_polygon_index != UINT32_MAX) {
 					// Polygon already visited, check if we can reduce the travel cost.
 					gd::NavigationPoly &avp = navigation_polys[already_visited_polygon_index];
 					if (new_distance < avp.traveled_distance) {
@@ -269,7 +337,13 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 						avp.back_navigation_edge_pathway_start = connection.pathway_start;
 						avp.back_navigation_edge_pathway_end = connection.pathway_end;
 						avp.traveled_distance = new_distance;
+						avp.distance_to_destination = new_entry.distance_to(end_point) * avp.poly->owner->get_travel_cost();
 						avp.entry = new_entry;
+
+						// Move it up in the polygons to visit, unless it was visited already.
+						if (avp.traversable_poly_index != UINT32_MAX) {
+							to_visit.decrease_cost(already_visited_polygon_index);
+						}
 					}
 				} else {
 					// Add the neighbour polygon to the reachable ones.
@@ -280,20 +354,36 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 					new_navigation_poly.back_navigation_edge_pathway_start = connection.pathway_start;
 					new_navigation_poly.back_navigation_edge_pathway_end = connection.pathway_end;
 					new_navigation_poly.traveled_distance = new_distance;
+					new_navigation_poly.distance_to_destination = new_entry.distance_to(end_point) * connection.polygon->owner->get_travel_cost();
 					new_navigation_poly.entry = new_entry;
 					navigation_polys.push_back(new_navigation_poly);
+					poly_to_navigation_poly[connection.polygon->id] = new_navigation_poly.self_id;
 
 					// Add the neighbour polygon to the polygons to visit.
-					to_visit.push_back(navigation_polys.size() - 1);
+					to_visit.push(new_navigation_poly.self_id);
 				}
 			}
 		}
 
-		// Removes the least cost polygon from the list of polygons to visit so we can advance.
-		to_visit.erase(least_cost_id);
+		if (to_visit.empty() && use_corridor) {
+			// The end polygon can't be reached inside the corridor, search the whole map instead.
+			use_corridor = false;
+
+			gd::NavigationPoly np = navigation_polys[0];
+			path_query_context.clear();
+			navigation_polys.push_back(np);
+			poly_to_navigation_poly[np.poly->id] = 0;
+			least_cost_id = 0;
+			prev_least_cost_id = -1;
+
+			reachable_end = nullptr;
+			reachable_d = FLT_MAX;
+
+			continue;
+		}
 
 		// When the list of polygons to visit is empty at this point it means the End Polygon is not reachable
-		if (to_visit.size() == 0) {
+		if (to_visit.empty()) {
 			// Thus use the further reachable polygon
 			ERR_BREAK_MSG(is_reachable == false, "It's not expect to not find the most reachable polygons");
 			is_reachable = false;
@@ -357,10 +447,9 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 
 			// Reset open and navigation_polys
 			gd::NavigationPoly np = navigation_polys[0];
-			navigation_polys.clear();
+			path_query_context.clear();
 			navigation_polys.push_back(np);
-			to_visit.clear();
-			to_visit.push_back(0);
+			poly_to_navigation_poly[np.poly->id] = 0;
 			least_cost_id = 0;
 			prev_least_cost_id = -1;
 
@@ -369,20 +458,8 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 			continue;
 		}
 
-		// Find the polygon with the minimum cost from the list of polygons to visit.
-		least_cost_id = -1;
-		real_t least_cost = FLT_MAX;
-		for (List<uint32_t>::Element *element = to_visit.front(); element != nullptr; element = element->next()) {
-			gd::NavigationPoly *np = &navigation_polys[element->get()];
-			real_t cost = np->traveled_distance;
-			cost += (np->entry.distance_to(end_point) * np->poly->owner->get_travel_cost());
-			if (cost < least_cost) {
-				least_cost_id = np->self_id;
-				least_cost = cost;
-			}
-		}
-
-		ERR_BREAK(least_cost_id == -1);
+		// Take the polygon with the minimum cost from the list of polygons to visit.
+		least_cost_id = to_visit.pop();
 
 		// Stores the further reachable end polygon, in case our goal is not reachable.
 		if (is_reachable) {
@@ -483,7 +560,7 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 					left_poly = p;
 					left_portal = left;
 				} else {
-					clip_path(navigation_polys, path, apex_poly, right_portal, right_poly, r_path_types, r_path_rids, r_path_owners);
+					clip_path(navigation_polys, path, apex_poly, right_portal, right_poly, up, r_path_types, r_path_rids, r_path_owners);
 
 					apex_point = right_portal;
 					p = right_poly;
@@ -504,7 +581,7 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 					right_poly = p;
 					right_portal = right;
 				} else {
-					clip_path(navigation_polys, path, apex_poly, left_portal, left_poly, r_path_types, r_path_rids, r_path_owners);
+					clip_path(navigation_polys, path, apex_poly, left_portal, left_poly, up, r_path_types, r_path_rids, r_path_owners);
 
 					apex_point = left_portal;
 					p = left_poly;
@@ -593,6 +670,10 @@ Vector<Vector3> NavMap::get_path(Vector3 p_origin, Vector3 p_destination, bool p
 Vector3 NavMap::get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const {
 	ERR_FAIL_COND_V_MSG(map_update_id == 0, Vector3(), "NavigationServer map query failed because it was made before first map synchronization.");
 
+	NavMapIterationRead map_iteration(this);
+	ERR_FAIL_COND_V(!map_iteration.iteration, Vector3());
+	const LocalVector<gd::Polygon> &polygons = map_iteration.iteration->polygons;
+
 	bool use_collision = p_use_collision;
 	Vector3 closest_point;
 	real_t closest_point_d = FLT_MAX;
@@ -664,28 +745,188 @@ RID NavMap::get_closest_point_owner(const Vector3 &p_point) const {
 
 gd::ClosestPointQueryResult NavMap::get_closest_point_info(const Vector3 &p_point) const {
 	gd::ClosestPointQueryResult result;
-	real_t closest_point_ds = FLT_MAX;
 
-	for (size_t i(0); i < polygons.size(); i++) {
-		const gd::Polygon &p = polygons[i];
+	NavMapIterationRead map_iteration(this);
+	if (!map_iteration.iteration) {
+		return result;
+	}
+	const LocalVector<gd::Polygon> &polygons = map_iteration.iteration->polygons;
 
-		// For each face check the distance to the point
-		for (size_t point_id = 2; point_id < p.points.size(); point_id += 1) {
-			const Face3 f(p.points[0].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
-			const Vector3 inters = f.get_closest_point_to(p_point);
-			const real_t ds = inters.distance_squared_to(p_point);
-			if (ds < closest_point_ds) {
-				result.point = inters;
-				result.normal = f.get_plane().normal;
-				result.owner = p.owner->get_self();
-				closest_point_ds = ds;
-			}
-		}
+	NavPolygonBVH::ClosestPoint closest;
+	if (map_iteration.iteration->polygons_bvh.get_closest_point(polygons, p_point, false, 0, closest)) {
+		result.point = closest.point;
+		result.normal = closest.normal;
+		result.owner = polygons[closest.polygon].owner->get_self();
 	}
 
 	return result;
 }
 
+bool NavMap::sample_flow_field(const Vector3 &p_goal, uint32_t p_navigation_layers, const Vector3 &p_position, Vector3 &r_direction, real_t &r_distance) {
+	MutexLock lock(flow_fields_mutex);
+
+	const NavFlowFieldKey key(p_goal, p_navigation_layers);
+	FlowFieldCacheEntry *entry = flow_fields.getptr(key);
+	if (!entry) {
+		FlowFieldCacheEntry new_entry;
+		new_entry.field = nullptr;
+		new_entry.building = false;
+		new_entry.last_used = ++flow_fields_use_counter;
+		new_entry.last_used_pass = flow_fields_pass;
+		flow_fields.insert(key, new_entry);
+		return false;
+	}
+
+	entry->last_used = ++flow_fields_use_counter;
+	entry->last_used_pass = flow_fields_pass;
+	if (!entry->field) {
+		return false;
+	}
+
+	return entry->field->sample(p_position, r_direction, r_distance);
+}
+
+void NavMap::request_flow_field(const Vector3 &p_goal, uint32_t p_navigation_layers) {
+	MutexLock lock(flow_fields_mutex);
+
+	const NavFlowFieldKey key(p_goal, p_navigation_layers);
+	FlowFieldCacheEntry *entry = flow_fields.getptr(key);
+	if (entry) {
+		entry->last_used = ++flow_fields_use_counter;
+		entry->last_used_pass = flow_fields_pass;
+		return;
+	}
+
+	FlowFieldCacheEntry new_entry;
+	new_entry.field = nullptr;
+	new_entry.building = false;
+	new_entry.last_used = ++flow_fields_use_counter;
+	new_entry.last_used_pass = flow_fields_pass;
+	flow_fields.insert(key, new_entry);
+}
+
+bool NavMap::is_flow_field_ready(const Vector3 &p_goal, uint32_t p_navigation_layers) {
+	MutexLock lock(flow_fields_mutex);
+
+	FlowFieldCacheEntry *entry = flow_fields.getptr(NavFlowFieldKey(p_goal, p_navigation_layers));
+	if (!entry) {
+		return false;
+	}
+
+	// Waiting for a requested field counts as using it.
+	entry->last_used = ++flow_fields_use_counter;
+	entry->last_used_pass = flow_fields_pass;
+	return entry->field && entry->field->get_iteration()->map_update_id == map_update_id;
+}
+
+void NavMap::clear_flow_fields() {
+	MutexLock lock(flow_fields_mutex);
+
+	// The fields being built are deleted when they are given back.
+	for (const HashMap<NavFlowFieldKey, FlowFieldCacheEntry, NavFlowFieldKey>::Element *E = flow_fields.front(); E; E = E->next) {
+		if (E->value().field) {
+			memdelete(E->value().field);
+		}
+	}
+	flow_fields.clear();
+	pm_flow_field_count = 0;
+}
+
+struct NavFlowFieldLastUsed {
+	NavFlowFieldKey key;
+	uint64_t last_used;
+
+	bool operator<(const NavFlowFieldLastUsed &p_other) const {
+		return last_used < p_other.last_used;
+	}
+};
+
+void NavMap::get_flow_fields_to_build(LocalVector<NavFlowField *> &r_flow_fields) {
+	if (map_update_id == 0) {
+		return;
+	}
+
+	MutexLock lock(flow_fields_mutex);
+
+	flow_fields_pass++;
+
+	// Drop the fields nobody sampled for a while, whatever iteration they were built for.
+	// Agents don't have to sample every frame, so a field that missed a few passes stays.
+	// The ones still building are left alone until they are given back.
+	LocalVector<NavFlowFieldKey> unused_keys;
+	LocalVector<NavFlowFieldLastUsed> kept;
+
+	for (const HashMap<NavFlowFieldKey, FlowFieldCacheEntry, NavFlowFieldKey>::Element *E = flow_fields.front(); E; E = E->next) {
+		const FlowFieldCacheEntry &entry = E->value();
+		if (entry.building) {
+			continue;
+		}
+
+		if (flow_fields_pass - entry.last_used_pass > FLOW_FIELD_UNUSED_PASSES) {
+			unused_keys.push_back(E->key());
+		} else {
+			NavFlowFieldLastUsed lu;
+			lu.key = E->key();
+			lu.last_used = entry.last_used;
+			kept.push_back(lu);
+		}
+	}
+
+	// Over the limit, drop the least recently used ones too.
+	int64_t over = int64_t(flow_fields.size()) - int64_t(unused_keys.size()) - MAX_FLOW_FIELDS;
+	if (over > 0) {
+		kept.sort();
+
+		for (uint32_t i = 0; i < kept.size() && over > 0; i++, over--) {
+			unused_keys.push_back(kept[i].key);
+		}
+	}
+
+	for (uint32_t i = 0; i < unused_keys.size(); i++) {
+		FlowFieldCacheEntry *entry = flow_fields.getptr(unused_keys[i]);
+		if (entry->field) {
+			memdelete(entry->field);
+		}
+		flow_fields.erase(unused_keys[i]);
+	}
+
+	for (HashMap<NavFlowFieldKey, FlowFieldCacheEntry, NavFlowFieldKey>::Element *E = flow_fields.front(); E; E = E->next) {
+		FlowFieldCacheEntry &entry = E->value();
+		if (entry.building) {
+			continue;
+		}
+
+		if (entry.field && entry.field->get_iteration()->map_update_id == map_update_id) {
+			continue;
+		}
+
+		entry.building = true;
+		r_flow_fields.push_back(memnew(NavFlowField(E->key(), link_connection_radius, acquire_iteration())));
+	}
+
+	pm_flow_field_count = flow_fields.size();
+}
+
+void NavMap::finish_flow_field(NavFlowField *p_flow_field) {
+	MutexLock lock(flow_fields_mutex);
+
+	FlowFieldCacheEntry *entry = flow_fields.getptr(p_flow_field->get_key());
+	if (!entry) {
+		// Cleared while it was building.
+		memdelete(p_flow_field);
+		return;
+	}
+
+	if (entry->field) {
+		memdelete(entry->field);
+	}
+	entry->field = p_flow_field;
+	entry->building = false;
+	// A new field gets the full FLOW_FIELD_UNUSED_PASSES to be sampled.
+	entry->last_used = ++flow_fields_use_counter;
+	entry->last_used_pass = flow_fields_pass;
+}
+
 void NavMap::add_region(NavRegion *p_region) {
 	regions.push_back(p_region);
 	regenerate_links = true;
@@ -771,12 +1012,14 @@ void NavMap::set_agent_as_controlled(NavAgent *agent) {
 		if (agent_3d_index < 0) {
 			active_3d_avoidance_agents.push_back(agent);
 			agents_dirty = true;
+			avoidance_agents_changed = true;
 		}
 	} else {
 		int64_t agent_2d_index = active_2d_avoidance_agents.find(agent);
 		if (agent_2d_index < 0) {
 			active_2d_avoidance_agents.push_back(agent);
 			agents_dirty = true;
+			avoidance_agents_changed = true;
 		}
 	}
 }
@@ -786,15 +1029,111 @@ void NavMap::remove_agent_as_controlled(NavAgent *agent) {
 	if (agent_3d_index >= 0) {
 		active_3d_avoidance_agents.remove_unordered(agent_3d_index);
 		agents_dirty = true;
+		avoidance_agents_changed = true;
 	}
 	int64_t agent_2d_index = active_2d_avoidance_agents.find(agent);
 	if (agent_2d_index >= 0) {
 		active_2d_avoidance_agents.remove_unordered(agent_2d_index);
 		agents_dirty = true;
+		avoidance_agents_changed = true;
+	}
+}
+
+void NavMap::_update_region_edges(const LocalVector<gd::Polygon> &p_polygons, gd::RegionEdges &r_region_edges) {
+	r_region_edges.inner_edges.clear();
+	r_region_edges.outer_edges.clear();
+
+	// Group the edges per key, the merged ones are marked with an invalid polygon.
+	HashMap<gd::EdgeKey, gd::RegionEdges::OuterEdge, gd::EdgeKey> edges;
+
+	for (uint32_t poly_id = 0; poly_id < p_polygons.size(); poly_id++) {
+		const gd::Polygon &poly = p_polygons[poly_id];
+
+		for (uint32_t p = 0; p < poly.points.size(); p++) {
+			int next_point = (p + 1) % poly.points.size();
+			gd::EdgeKey ek(poly.points[p].key, poly.points[next_point].key);
+
+			HashMap<gd::EdgeKey, gd::RegionEdges::OuterEdge, gd::EdgeKey>::Element *E = edges.find(ek);
+
+			if (!E) {
+				gd::RegionEdges::OuterEdge outer_edge;
+				outer_edge.key = ek;
+				outer_edge.polygon = poly_id;
+				outer_edge.edge = p;
+				outer_edge.free = true;
+				edges.insert(ek, outer_edge);
+			} else if (E->get().polygon != UINT32_MAX) {
+				gd::RegionEdges::InnerEdge inner_edge;
+				inner_edge.polygon_a = E->get().polygon;
+				inner_edge.edge_a = E->get().edge;
+				inner_edge.polygon_b = poly_id;
+				inner_edge.edge_b = p;
+				r_region_edges.inner_edges.push_back(inner_edge);
+
+				E->get().polygon = UINT32_MAX;
+			} else {
+				// The edge is already connected with another edge, skip.
+				ERR_PRINT_ONCE("Navigation map synchronization error. Attempted to merge a navigation mesh polygon edge with another already-merged edge. This is usually caused by crossing edges, overlapping polygons, or a mismatch of the NavigationMesh / NavigationPolygon baked 'cell_size' and navigation map 'cell_size'.");
+			}
+		}
+	}
+
+	for (HashMap<gd::EdgeKey, gd::RegionEdges::OuterEdge, gd::EdgeKey>::Element *E = edges.front(); E; E = E->next) {
+		if (E->get().polygon != UINT32_MAX) {
+			r_region_edges.outer_edges.push_back(E->get());
+		}
+	}
+
+	r_region_edges.dirty = false;
+}
+
+bool NavMap::_get_edge_connection(const gd::Edge::Connection &p_edge, const gd::Edge::Connection &p_other_edge, Vector3 &r_pathway_start, Vector3 &r_pathway_end) const {
+	Vector3 edge_p1 = p_edge.polygon->points[p_edge.edge].pos;
+	Vector3 edge_p2 = p_edge.polygon->points[(p_edge.edge + 1) % p_edge.polygon->points.size()].pos;
+
+	Vector3 other_edge_p1 = p_other_edge.polygon->points[p_other_edge.edge].pos;
+	Vector3 other_edge_p2 = p_other_edge.polygon->points[(p_other_edge.edge + 1) % p_other_edge.polygon->points.size()].pos;
+
+	// Compute the projection of the opposite edge on the current one
+	Vector3 edge_vector = edge_p2 - edge_p1;
+	real_t projected_p1_ratio = edge_vector.dot(other_edge_p1 - edge_p1) / (edge_vector.length_squared());
+	real_t projected_p2_ratio = edge_vector.dot(other_edge_p2 - edge_p1) / (edge_vector.length_squared());
+	if ((projected_p1_ratio < 0.0 && projected_p2_ratio < 0.0) || (projected_p1_ratio > 1.0 && projected_p2_ratio > 1.0)) {
+		return false;
+	}
+
+	// Check if the two edges are close to each other enough and compute a pathway between the two regions.
+	Vector3 self1 = edge_vector * CLAMP(projected_p1_ratio, 0.0, 1.0) + edge_p1;
+	Vector3 other1;
+	if (projected_p1_ratio >= 0.0 && projected_p1_ratio <= 1.0) {
+		other1 = other_edge_p1;
+	} else {
+		other1 = other_edge_p1.linear_interpolate(other_edge_p2, (1.0 - projected_p1_ratio) / (projected_p2_ratio - projected_p1_ratio));
+	}
+	if (other1.distance_to(self1) > edge_connection_margin) {
+		return false;
+	}
+
+	Vector3 self2 = edge_vector * CLAMP(projected_p2_ratio, 0.0, 1.0) + edge_p1;
+	Vector3 other2;
+	if (projected_p2_ratio >= 0.0 && projected_p2_ratio <= 1.0) {
+		other2 = other_edge_p2;
+	} else {
+		other2 = other_edge_p1.linear_interpolate(other_edge_p2, (0.0 - projected_p1_ratio) / (projected_p2_ratio - projected_p1_ratio));
+	}
+
+	if (other2.distance_to(self2) > edge_connection_margin) {
+		return false;
 	}
+
+	r_pathway_start = (self1 + other1) / 2.0;
+	r_pathway_end = (self2 + other2) / 2.0;
+	return true;
 }
 
 void NavMap::sync() {
+	const uint64_t sync_begin = OS::get_singleton()->get_ticks_usec();
+
 	// Performance Monitor
 	int _new_pm_region_count = regions.size();
 	int _new_pm_agent_count = agents.size();
@@ -825,6 +1164,19 @@ void NavMap::sync() {
 		}
 	}
 
+	// The iteration has its own copy of the costs, layers and owners of the regions and links.
+	for (uint32_t r = 0; r < regions.size(); r++) {
+		if (regions[r]->check_properties_dirty()) {
+			regenerate_links = true;
+		}
+	}
+
+	for (uint32_t l = 0; l < links.size(); l++) {
+		if (links[l]->check_properties_dirty()) {
+			regenerate_links = true;
+		}
+	}
+
 	if (regenerate_links) {
 		_new_pm_polygon_count = 0;
 		_new_pm_edge_count = 0;
@@ -837,7 +1189,11 @@ void NavMap::sync() {
 			regions[r]->get_connections().clear();
 		}
 
-		// Resize the polygon count.
+		// The enabled regions and where their polygons start in the map.
+		LocalVector<NavRegion *> enabled_regions;
+		LocalVector<uint32_t> region_polygons_from;
+		HashMap<const NavRegion *, uint32_t> region_indices;
+
 		int count = 0;
 		for (uint32_t r = 0; r < regions.size(); r++) {
 			NavRegion *region = regions[r];
@@ -846,55 +1202,116 @@ void NavMap::sync() {
 				continue;
 			}
 
+			region_indices.insert(region, enabled_regions.size());
+			enabled_regions.push_back(region);
+			region_polygons_from.push_back(count);
 			count += region->get_polygons().size();
 		}
 
+		// The queries may still be using the current iteration, build a new one.
+		NavMapIteration *new_iteration = memnew(NavMapIteration);
+		new_iteration->up = up;
+
+		LocalVector<gd::Polygon> &polygons = new_iteration->polygons;
+		LocalVector<gd::Polygon> &link_polygons = new_iteration->link_polygons;
+
 		polygons.resize(count);
 
+		// The copy of the owner of each polygon, set once the connections are made.
+		LocalVector<NavBase *> polygon_owners;
+		polygon_owners.resize(count);
+
+		// Where the polygons of each region are, for the hierarchy.
+		LocalVector<NavMapHierarchy::RegionPolygons> hierarchy_regions;
+
 		// Copy all region polygons in the map.
-		count = 0;
-		for (uint32_t r = 0; r < regions.size(); r++) {
-			NavRegion *region = regions[r];
+		for (uint32_t r = 0; r < enabled_regions.size(); r++) {
+			NavRegion *region = enabled_regions[r];
+			const uint32_t polygons_from = region_polygons_from[r];
 
-			if (!region->get_enabled()) {
-				continue;
-			}
+			NavBase *owner = memnew(NavBase(*region));
+			new_iteration->owners.push_back(owner);
 
 			const LocalVector<gd::Polygon> &polygons_source = region->get_polygons();
 			for (uint32_t n = 0; n < polygons_source.size(); n++) {
-				polygons[count + n] = polygons_source[n];
+				polygons[polygons_from + n] = polygons_source[n];
+				polygons[polygons_from + n].id = polygons_from + n;
+				polygon_owners[polygons_from + n] = owner;
 			}
 
-			count += region->get_polygons().size();
+			if (use_hierarchical_pathfinding) {
+				NavMapHierarchy::RegionPolygons region_polygons;
+				region_polygons.clusters = &region->get_clusters();
+				region_polygons.polygons_from = polygons_from;
+				region_polygons.polygons_count = polygons_source.size();
+				hierarchy_regions.push_back(region_polygons);
+			}
 		}
 
 		_new_pm_polygon_count = polygons.size();
 
-		// Group all edges per key.
-		HashMap<gd::EdgeKey, Vector<gd::Edge::Connection>, gd::EdgeKey> connections;
+		new_iteration->polygons_bvh.build(polygons);
+
+		// Regions whose connections to the close edges of other regions have to be searched again.
+		LocalVector<uint8_t> reconnect_regions;
+		reconnect_regions.resize(enabled_regions.size());
+
+		// Connect the edges shared inside each region, only the regions whose polygons changed need to find them again.
+		for (uint32_t r = 0; r < enabled_regions.size(); r++) {
+			NavRegion *region = enabled_regions[r];
+			gd::RegionEdges &region_edges = region->get_region_edges();
+
+			reconnect_regions[r] = regenerate_edge_connections || region_edges.dirty;
+
+			if (region_edges.dirty) {
+				_update_region_edges(region->get_polygons(), region_edges);
+			}
+
+			const uint32_t polygons_from = region_polygons_from[r];
+			for (uint32_t i = 0; i < region_edges.inner_edges.size(); i++) {
+				const gd::RegionEdges::InnerEdge &inner_edge = region_edges.inner_edges[i];
+				gd::Polygon &poly_a = polygons[polygons_from + inner_edge.polygon_a];
+				gd::Polygon &poly_b = polygons[polygons_from + inner_edge.polygon_b];
+
+				gd::Edge::Connection connection_a;
+				connection_a.polygon = &poly_a;
+				connection_a.edge = inner_edge.edge_a;
+				connection_a.pathway_start = poly_a.points[inner_edge.edge_a].pos;
+				connection_a.pathway_end = poly_a.points[(inner_edge.edge_a + 1) % poly_a.points.size()].pos;
+
+				gd::Edge::Connection connection_b;
+				connection_b.polygon = &poly_b;
+				connection_b.edge = inner_edge.edge_b;
+				connection_b.pathway_start = poly_b.points[inner_edge.edge_b].pos;
+				connection_b.pathway_end = poly_b.points[(inner_edge.edge_b + 1) % poly_b.points.size()].pos;
+
+				poly_a.edges[inner_edge.edge_a].connections.push_back(connection_b);
+				poly_b.edges[inner_edge.edge_b].connections.push_back(connection_a);
+			}
+
+			_new_pm_edge_count += region_edges.inner_edges.size();
+			_new_pm_edge_merge_count += region_edges.inner_edges.size();
+		}
 
-		for (uint32_t poly_id = 0; poly_id < polygons.size(); poly_id++) {
-			gd::Polygon &poly(polygons[poly_id]);
+		// Group the edges left per key, to merge the ones shared by two regions.
+		HashMap<gd::EdgeKey, LocalVector<OuterEdgeRef>, gd::EdgeKey> outer_edges;
 
-			for (uint32_t p = 0; p < poly.points.size(); p++) {
-				int next_point = (p + 1) % poly.points.size();
-				gd::EdgeKey ek(poly.points[p].key, poly.points[next_point].key);
+		for (uint32_t r = 0; r < enabled_regions.size(); r++) {
+			const gd::RegionEdges &region_edges = enabled_regions[r]->get_region_edges();
 
-				HashMap<gd::EdgeKey, Vector<gd::Edge::Connection>, gd::EdgeKey>::Element *connection = connections.find(ek);
+			for (uint32_t i = 0; i < region_edges.outer_edges.size(); i++) {
+				HashMap<gd::EdgeKey, LocalVector<OuterEdgeRef>, gd::EdgeKey>::Element *E = outer_edges.find(region_edges.outer_edges[i].key);
 
-				if (!connection) {
-					connections[ek] = Vector<gd::Edge::Connection>();
+				if (!E) {
+					E = outer_edges.insert(region_edges.outer_edges[i].key, LocalVector<OuterEdgeRef>());
 					_new_pm_edge_count += 1;
 				}
 
-				if (connections[ek].size() <= 1) {
-					// Add the polygon/edge tuple to this key.
-					gd::Edge::Connection new_connection;
-					new_connection.polygon = &poly;
-					new_connection.edge = p;
-					new_connection.pathway_start = poly.points[p].pos;
-					new_connection.pathway_end = poly.points[next_point].pos;
-					connections[ek].push_back(new_connection);
+				if (E->get().size() <= 1) {
+					OuterEdgeRef outer_edge_ref;
+					outer_edge_ref.region = r;
+					outer_edge_ref.outer_edge = i;
+					E->get().push_back(outer_edge_ref);
 				} else {
 					// The edge is already connected with another edge, skip.
 					ERR_PRINT_ONCE("Navigation map synchronization error. Attempted to merge a navigation mesh polygon edge with another already-merged edge. This is usually caused by crossing edges, overlapping polygons, or a mismatch of the NavigationMesh / NavigationPolygon baked 'cell_size' and navigation map 'cell_size'.");
@@ -903,21 +1320,38 @@ void NavMap::sync() {
 		}
 
 		Vector<gd::Edge::Connection> free_edges;
-		for (HashMap<gd::EdgeKey, Vector<gd::Edge::Connection>, gd::EdgeKey>::Element *E = connections.front(); E; E = E->next) {
-			if (E->get().size() == 2) {
+		LocalVector<uint32_t> free_edge_regions;
+
+		for (HashMap<gd::EdgeKey, LocalVector<OuterEdgeRef>, gd::EdgeKey>::Element *E = outer_edges.front(); E; E = E->next) {
+			const LocalVector<OuterEdgeRef> &edge_refs = E->get();
+			const bool is_free = edge_refs.size() == 1;
+
+			gd::Edge::Connection connections[2];
+			for (uint32_t i = 0; i < edge_refs.size(); i++) {
+				gd::RegionEdges::OuterEdge &outer_edge = enabled_regions[edge_refs[i].region]->get_region_edges().outer_edges[edge_refs[i].outer_edge];
+				gd::Polygon &poly = polygons[region_polygons_from[edge_refs[i].region] + outer_edge.polygon];
+
+				connections[i].polygon = &poly;
+				connections[i].edge = outer_edge.edge;
+				connections[i].pathway_start = poly.points[outer_edge.edge].pos;
+				connections[i].pathway_end = poly.points[(outer_edge.edge + 1) % poly.points.size()].pos;
+
+				// An edge that got merged or unmerged changes the close edges of its region.
+				if (outer_edge.free != is_free) {
+					outer_edge.free = is_free;
+					reconnect_regions[edge_refs[i].region] = true;
+				}
+			}
+
+			if (!is_free) {
 				// Connect edge that are shared in different polygons.
-				gd::Edge::Connection &c1 = E->get().write[0];
-				gd::Edge::Connection &c2 = E->get().write[1];
-				c1.polygon->edges[c1.edge].connections.push_back(c2);
-				c2.polygon->edges[c2.edge].connections.push_back(c1);
+				connections[0].polygon->edges[connections[0].edge].connections.push_back(connections[1]);
+				connections[1].polygon->edges[connections[1].edge].connections.push_back(connections[0]);
 				// Note: The pathway_start/end are full for those connection and do not need to be modified.
 				_new_pm_edge_merge_count += 1;
-			} else {
-				CRASH_COND_MSG(E->get().size() != 1, vformat("Number of connection != 1. Found: %d", E->get().size()));
-
-				if (use_edge_connections && E->get()[0].polygon->owner->get_use_edge_connections()) {
-					free_edges.push_back(E->get()[0]);
-				}
+			} else if (use_edge_connections && enabled_regions[edge_refs[0].region]->get_use_edge_connections()) {
+				free_edges.push_back(connections[0]);
+				free_edge_regions.push_back(edge_refs[0].region);
 			}
 		}
 
@@ -930,64 +1364,73 @@ void NavMap::sync() {
 		// connection, integration and path finding.
 		_new_pm_edge_free_count = free_edges.size();
 
+		// Keep the connections between regions that didn't change.
+		for (int i = region_edge_connections.size() - 1; i >= 0; i--) {
+			const gd::RegionEdgeConnection &edge_connection = region_edge_connections[i];
+			const HashMap<const NavRegion *, uint32_t>::Element *region = region_indices.find(edge_connection.region);
+			const HashMap<const NavRegion *, uint32_t>::Element *other_region = region_indices.find(edge_connection.other_region);
+
+			if (!region || !other_region || reconnect_regions[region->get()] || reconnect_regions[other_region->get()]) {
+				region_edge_connections.remove_unordered(i);
+			}
+		}
+
+		// Search the ones of the regions that changed, both ways.
 		for (int i = 0; i < free_edges.size(); i++) {
-			const gd::Edge::Connection &free_edge = free_edges[i];
-			Vector3 edge_p1 = free_edge.polygon->points[free_edge.edge].pos;
-			Vector3 edge_p2 = free_edge.polygon->points[(free_edge.edge + 1) % free_edge.polygon->points.size()].pos;
+			if (!reconnect_regions[free_edge_regions[i]]) {
+				continue;
+			}
 
 			for (int j = 0; j < free_edges.size(); j++) {
-				const gd::Edge::Connection &other_edge = free_edges[j];
-				if (i == j || free_edge.polygon->owner == other_edge.polygon->owner) {
+				if (i == j || free_edge_regions[i] == free_edge_regions[j]) {
 					continue;
 				}
 
-				Vector3 other_edge_p1 = other_edge.polygon->points[other_edge.edge].pos;
-				Vector3 other_edge_p2 = other_edge.polygon->points[(other_edge.edge + 1) % other_edge.polygon->points.size()].pos;
+				// When both changed this pair is found from the other side too.
+				for (int direction = 0; direction < 2; direction++) {
+					if (direction == 1 && reconnect_regions[free_edge_regions[j]]) {
+						break;
+					}
 
-				// Compute the projection of the opposite edge on the current one
-				Vector3 edge_vector = edge_p2 - edge_p1;
-				real_t projected_p1_ratio = edge_vector.dot(other_edge_p1 - edge_p1) / (edge_vector.length_squared());
-				real_t projected_p2_ratio = edge_vector.dot(other_edge_p2 - edge_p1) / (edge_vector.length_squared());
-				if ((projected_p1_ratio < 0.0 && projected_p2_ratio < 0.0) || (projected_p1_ratio > 1.0 && projected_p2_ratio > 1.0)) {
-					continue;
-				}
+					const int from = direction == 0 ? i : j;
+					const int to = direction == 0 ? j : i;
+					const gd::Edge::Connection &free_edge = free_edges[from];
+					const gd::Edge::Connection &other_edge = free_edges[to];
 
-				// Check if the two edges are close to each other enough and compute a pathway between the two regions.
-				Vector3 self1 = edge_vector * CLAMP(projected_p1_ratio, 0.0, 1.0) + edge_p1;
-				Vector3 other1;
-				if (projected_p1_ratio >= 0.0 && projected_p1_ratio <= 1.0) {
-					other1 = other_edge_p1;
-				} else {
-					other1 = other_edge_p1.linear_interpolate(other_edge_p2, (1.0 - projected_p1_ratio) / (projected_p2_ratio - projected_p1_ratio));
-				}
-				if (other1.distance_to(self1) > edge_connection_margin) {
-					continue;
-				}
-
-				Vector3 self2 = edge_vector * CLAMP(projected_p2_ratio, 0.0, 1.0) + edge_p1;
-				Vector3 other2;
-				if (projected_p2_ratio >= 0.0 && projected_p2_ratio <= 1.0) {
-					other2 = other_edge_p2;
-				} else {
-					other2 = other_edge_p1.linear_interpolate(other_edge_p2, (0.0 - projected_p1_ratio) / (projected_p2_ratio - projected_p1_ratio));
-				}
+					gd::RegionEdgeConnection edge_connection;
+					if (!_get_edge_connection(free_edge, other_edge, edge_connection.pathway_start, edge_connection.pathway_end)) {
+						continue;
+					}
 
-				if (other2.distance_to(self2) > edge_connection_margin) {
-					continue;
+					edge_connection.region = enabled_regions[free_edge_regions[from]];
+					edge_connection.polygon = free_edge.polygon->id - region_polygons_from[free_edge_regions[from]];
+					edge_connection.edge = free_edge.edge;
+					edge_connection.other_region = enabled_regions[free_edge_regions[to]];
+					edge_connection.other_polygon = other_edge.polygon->id - region_polygons_from[free_edge_regions[to]];
+					edge_connection.other_edge = other_edge.edge;
+					region_edge_connections.push_back(edge_connection);
 				}
-
-				// The edges can now be connected.
-				gd::Edge::Connection new_connection = other_edge;
-				new_connection.pathway_start = (self1 + other1) / 2.0;
-				new_connection.pathway_end = (self2 + other2) / 2.0;
-				free_edge.polygon->edges[free_edge.edge].connections.push_back(new_connection);
-
-				// Add the connection to the region_connection map.
-				((NavRegion *)free_edge.polygon->owner)->get_connections().push_back(new_connection);
-				_new_pm_edge_connection_count += 1;
 			}
 		}
 
+		// The edges can now be connected.
+		for (uint32_t i = 0; i < region_edge_connections.size(); i++) {
+			const gd::RegionEdgeConnection &edge_connection = region_edge_connections[i];
+			gd::Polygon &poly = polygons[region_polygons_from[region_indices[edge_connection.region]] + edge_connection.polygon];
+			gd::Polygon &other_poly = polygons[region_polygons_from[region_indices[edge_connection.other_region]] + edge_connection.other_polygon];
+
+			gd::Edge::Connection new_connection;
+			new_connection.polygon = &other_poly;
+			new_connection.edge = edge_connection.other_edge;
+			new_connection.pathway_start = edge_connection.pathway_start;
+			new_connection.pathway_end = edge_connection.pathway_end;
+			poly.edges[edge_connection.edge].connections.push_back(new_connection);
+
+			// Add the connection to the region_connection map.
+			edge_connection.region->get_connections().push_back(new_connection);
+			_new_pm_edge_connection_count += 1;
+		}
+
 		uint32_t link_poly_idx = 0;
 		link_polygons.resize(links.size());
 
@@ -998,55 +1441,32 @@ void NavMap::sync() {
 			const Vector3 end = link->get_end_position();
 
 			gd::Polygon *closest_start_polygon = nullptr;
-			real_t closest_start_distance = link_connection_radius;
 			Vector3 closest_start_point;
 
 			gd::Polygon *closest_end_polygon = nullptr;
-			real_t closest_end_distance = link_connection_radius;
 			Vector3 closest_end_point;
 
-			// Create link to any polygons within the search radius of the start point.
-			for (uint32_t start_index = 0; start_index < polygons.size(); start_index++) {
-				gd::Polygon &start_poly = polygons[start_index];
-
-				// For each face check the distance to the start
-				for (uint32_t start_point_id = 2; start_point_id < start_poly.points.size(); start_point_id += 1) {
-					const Face3 start_face(start_poly.points[0].pos, start_poly.points[start_point_id - 1].pos, start_poly.points[start_point_id].pos);
-					const Vector3 start_point = start_face.get_closest_point_to(start);
-					const real_t start_distance = start_point.distance_to(start);
-
-					// Pick the polygon that is within our radius and is closer than anything we've seen yet.
-					if (start_distance <= link_connection_radius && start_distance < closest_start_distance) {
-						closest_start_distance = start_distance;
-						closest_start_point = start_point;
-						closest_start_polygon = &start_poly;
-					}
-				}
+			// Pick the closest polygons within the search radius of the start and end points.
+			NavPolygonBVH::ClosestPoint closest;
+			if (new_iteration->polygons_bvh.get_closest_point(polygons, start, false, 0, closest) && closest.distance_squared < link_connection_radius * link_connection_radius) {
+				closest_start_polygon = &polygons[closest.polygon];
+				closest_start_point = closest.point;
 			}
 
-			// Find any polygons within the search radius of the end point.
-			for (uint32_t end_index = 0; end_index < polygons.size(); end_index++) {
-				gd::Polygon &end_poly = polygons[end_index];
-
-				// For each face check the distance to the end
-				for (uint32_t end_point_id = 2; end_point_id < end_poly.points.size(); end_point_id += 1) {
-					const Face3 end_face(end_poly.points[0].pos, end_poly.points[end_point_id - 1].pos, end_poly.points[end_point_id].pos);
-					const Vector3 end_point = end_face.get_closest_point_to(end);
-					const real_t end_distance = end_point.distance_to(end);
-
-					// Pick the polygon that is within our radius and is closer than anything we've seen yet.
-					if (end_distance <= link_connection_radius && end_distance < closest_end_distance) {
-						closest_end_distance = end_distance;
-						closest_end_point = end_point;
-						closest_end_polygon = &end_poly;
-					}
-				}
+			if (new_iteration->polygons_bvh.get_closest_point(polygons, end, false, 0, closest) && closest.distance_squared < link_connection_radius * link_connection_radius) {
+				closest_end_polygon = &polygons[closest.polygon];
+				closest_end_point = closest.point;
 			}
 
 			// If we have both a start and end point, then create a synthetic polygon to route through.
 			if (closest_start_polygon && closest_end_polygon) {
-				gd::Polygon &new_polygon = link_polygons[link_poly_idx++];
-				new_polygon.owner = const_cast<NavLink *>(link);
+				gd::Polygon &new_polygon = link_polygons[link_poly_idx];
+				new_polygon.id = polygons.size() + link_poly_idx;
+				link_poly_idx++;
+
+				NavBase *owner = memnew(NavBase(*link));
+				new_iteration->owners.push_back(owner);
+				new_polygon.owner = owner;
 
 				new_polygon.edges.clear();
 				new_polygon.edges.resize(4);
@@ -1102,9 +1522,30 @@ void NavMap::sync() {
 			}
 		}
 
+		// Only the links that found polygons to connect have one, shrinking doesn't move them.
+		link_polygons.resize(link_poly_idx);
+
+		// The region polygons are done being connected, from here on they only point at the copies.
+		for (uint32_t i = 0; i < polygons.size(); i++) {
+			polygons[i].owner = polygon_owners[i];
+		}
+
+		if (use_hierarchical_pathfinding) {
+			new_iteration->hierarchy.build(polygons, link_polygons, hierarchy_regions, hierarchical_cluster_size);
+		}
+
 		// Update the update ID.
 		// Some code treats 0 as a failure case, so we avoid returning 0.
 		map_update_id = map_update_id % 9999999 + 1;
+		new_iteration->map_update_id = map_update_id;
+
+		NavMapIteration *old_iteration;
+		{
+			RWLockWrite write_lock(iteration_lock);
+			old_iteration = iteration;
+			iteration = new_iteration;
+		}
+		release_iteration(old_iteration);
 	}
 
 	// Do we have modified obstacle positions?
@@ -1130,6 +1571,7 @@ void NavMap::sync() {
 
 	regenerate_polygons = false;
 	regenerate_links = false;
+	regenerate_edge_connections = false;
 	obstacles_dirty = false;
 	agents_dirty = false;
 
@@ -1142,6 +1584,16 @@ void NavMap::sync() {
 	pm_edge_merge_count = _new_pm_edge_merge_count;
 	pm_edge_connection_count = _new_pm_edge_connection_count;
 	pm_edge_free_count = _new_pm_edge_free_count;
+
+	// Queries made since the last sync, the ones still running count towards the next.
+	const uint32_t _new_pm_path_query_count = path_query_count.get();
+	const uint64_t _new_pm_path_query_time = path_query_time.get();
+	path_query_count.sub(_new_pm_path_query_count);
+	path_query_time.sub(_new_pm_path_query_time);
+	pm_path_query_count = _new_pm_path_query_count;
+	pm_path_query_time = _new_pm_path_query_time;
+
+	pm_sync_time = OS::get_singleton()->get_ticks_usec() - sync_begin;
 }
 
 void NavMap::_update_rvo_obstacles_tree_2d() {
@@ -1213,26 +1665,111 @@ void NavMap::_update_rvo_obstacles_tree_2d() {
 	rvo_simulation_2d.kdTree_->buildObstacleTree(raw_obstacles);
 }
 
-void NavMap::_update_rvo_agents_tree_2d() {
-	// Cannot use LocalVector here as RVO library expects std::vector to build KdTree.
-	std::vector<RVO2D::Agent2D *> raw_agents;
-	raw_agents.reserve(active_2d_avoidance_agents.size());
-	for (uint32_t k = 0; k < active_2d_avoidance_agents.size(); ++k) {
-		NavAgent *agent = active_2d_avoidance_agents[k];
-		raw_agents.push_back(agent->get_rvo_agent_2d());
+// Makes RVO agents look for their neighbours in one of the avoidance grids.
+struct NavAvoidanceNeighborInserter2D {
+	RVO2D::Agent2D *agent;
+	NavAgent **agents;
+
+	_FORCE_INLINE_ void operator()(uint32_t p_index, float &r_range_squared) const {
+		agent->insertAgentNeighbor(agents[p_index]->get_rvo_agent_2d(), r_range_squared);
 	}
-	rvo_simulation_2d.kdTree_->buildAgentTree(raw_agents);
+};
+
+struct NavAvoidanceNeighborInserter3D {
+	RVO3D::Agent3D *agent;
+	NavAgent **agents;
+
+	_FORCE_INLINE_ void operator()(uint32_t p_index, float &r_range_squared) const {
+		agent->insertAgentNeighbor(agents[p_index]->get_rvo_agent_3d(), r_range_squared);
+	}
+};
+
+void NavMap::_compute_avoidance_grid_point_2d(uint32_t index, NavAgent **agent) {
+	const RVO2D::Vector2 &position = (*(agent + index))->get_rvo_agent_2d()->position_;
+	avoidance_grid_points[index] = avoidance_grid_2d.get_point(position.x(), position.y());
 }
 
-void NavMap::_update_rvo_agents_tree_3d() {
-	// Cannot use LocalVector here as RVO library expects std::vector to build KdTree.
-	std::vector<RVO3D::Agent3D *> raw_agents;
-	raw_agents.reserve(active_3d_avoidance_agents.size());
-	for (uint32_t k = 0; k < active_3d_avoidance_agents.size(); ++k) {
-		NavAgent *agent = active_3d_avoidance_agents[k];
-		raw_agents.push_back(agent->get_rvo_agent_3d());
+void NavMap::_compute_avoidance_grid_point_3d(uint32_t index, NavAgent **agent) {
+	const RVO3D::Vector3 &position = (*(agent + index))->get_rvo_agent_3d()->position_;
+	avoidance_grid_points[index] = avoidance_grid_3d.get_point(position.x(), position.z());
+}
+
+void NavMap::_update_rvo_agents_grid_2d() {
+	const uint32_t agent_count = active_2d_avoidance_agents.size();
+
+	if (avoidance_agents_changed) {
+		// The agent indices changed, start over. Cells about four agents
+		// across keep the neighbour queries as quick as with a tree.
+		real_t radius_sum = 0.0;
+		for (uint32_t i = 0; i < agent_count; i++) {
+			radius_sum += active_2d_avoidance_agents[i]->get_rvo_agent_2d()->radius_;
+		}
+		const real_t cell_size = agent_count > 0 ? radius_sum * 8.0 / agent_count : 0.0;
+		avoidance_grid_2d.set_cell_size(cell_size > CMP_EPSILON ? cell_size : 1.0);
 	}
-	rvo_simulation_3d.kdTree_->buildAgentTree(raw_agents);
+
+	avoidance_grid_points.resize(agent_count);
+#ifndef NO_THREADS
+	if (use_threads && avoidance_use_multiple_threads && agent_count > 0) {
+		if (step_work_pool.get_thread_count() == 0) {
+			step_work_pool.init();
+		}
+		step_work_pool.do_work(
+				agent_count,
+				this,
+				&NavMap::_compute_avoidance_grid_point_2d,
+				active_2d_avoidance_agents.ptr());
+	} else {
+		for (uint32_t i = 0; i < agent_count; i++) {
+			_compute_avoidance_grid_point_2d(i, active_2d_avoidance_agents.ptr());
+		}
+	}
+#else
+	for (uint32_t i = 0; i < agent_count; i++) {
+		_compute_avoidance_grid_point_2d(i, active_2d_avoidance_agents.ptr());
+	}
+#endif // NO_THREADS
+
+	avoidance_grid_2d.update(avoidance_grid_points);
+}
+
+void NavMap::_update_rvo_agents_grid_3d() {
+	const uint32_t agent_count = active_3d_avoidance_agents.size();
+
+	if (avoidance_agents_changed) {
+		real_t radius_sum = 0.0;
+		for (uint32_t i = 0; i < agent_count; i++) {
+			radius_sum += active_3d_avoidance_agents[i]->get_rvo_agent_3d()->radius_;
+		}
+		const real_t cell_size = agent_count > 0 ? radius_sum * 8.0 / agent_count : 0.0;
+		avoidance_grid_3d.set_cell_size(cell_size > CMP_EPSILON ? cell_size : 1.0);
+	}
+
+	// The grid is flat, agents above each other share cells and get told
+	// apart by the neighbour insertion.
+	avoidance_grid_points.resize(agent_count);
+#ifndef NO_THREADS
+	if (use_threads && avoidance_use_multiple_threads && agent_count > 0) {
+		if (step_work_pool.get_thread_count() == 0) {
+			step_work_pool.init();
+		}
+		step_work_pool.do_work(
+				agent_count,
+				this,
+				&NavMap::_compute_avoidance_grid_point_3d,
+				active_3d_avoidance_agents.ptr());
+	} else {
+		for (uint32_t i = 0; i < agent_count; i++) {
+			_compute_avoidance_grid_point_3d(i, active_3d_avoidance_agents.ptr());
+		}
+	}
+#else
+	for (uint32_t i = 0; i < agent_count; i++) {
+		_compute_avoidance_grid_point_3d(i, active_3d_avoidance_agents.ptr());
+	}
+#endif // NO_THREADS
+
+	avoidance_grid_3d.update(avoidance_grid_points);
 }
 
 void NavMap::_update_rvo_simulation() {
@@ -1240,26 +1777,63 @@ void NavMap::_update_rvo_simulation() {
 		_update_rvo_obstacles_tree_2d();
 	}
 	if (agents_dirty) {
-		_update_rvo_agents_tree_2d();
-		_update_rvo_agents_tree_3d();
+		_update_rvo_agents_grid_2d();
+		_update_rvo_agents_grid_3d();
+		avoidance_agents_changed = false;
+	}
+}
+
+void NavMap::_compute_rvo_agent_neighbors_2d(NavAgent *p_agent) {
+	// Same as RVO2D::Agent2D::computeNeighbors(), with the agents from the grid.
+	RVO2D::Agent2D *rvo_agent = p_agent->get_rvo_agent_2d();
+
+	rvo_agent->obstacleNeighbors_.clear();
+	float range_squared = RVO2D::sqr(rvo_agent->timeHorizonObst_ * rvo_agent->maxSpeed_ + rvo_agent->radius_);
+	rvo_simulation_2d.kdTree_->computeObstacleNeighbors(rvo_agent, range_squared);
+
+	rvo_agent->agentNeighbors_.clear();
+	if (rvo_agent->maxNeighbors_ > 0) {
+		range_squared = RVO2D::sqr(rvo_agent->neighborDist_);
+
+		NavAvoidanceNeighborInserter2D inserter;
+		inserter.agent = rvo_agent;
+		inserter.agents = active_2d_avoidance_agents.ptr();
+		avoidance_grid_2d.query(rvo_agent->position_.x(), rvo_agent->position_.y(), range_squared, inserter);
+	}
+}
+
+void NavMap::_compute_rvo_agent_neighbors_3d(NavAgent *p_agent) {
+	// Same as RVO3D::Agent3D::computeNeighbors(), with the agents from the grid.
+	RVO3D::Agent3D *rvo_agent = p_agent->get_rvo_agent_3d();
+
+	rvo_agent->agentNeighbors_.clear();
+	if (rvo_agent->maxNeighbors_ > 0) {
+		float range_squared = rvo_agent->neighborDist_ * rvo_agent->neighborDist_;
+
+		NavAvoidanceNeighborInserter3D inserter;
+		inserter.agent = rvo_agent;
+		inserter.agents = active_3d_avoidance_agents.ptr();
+		avoidance_grid_3d.query(rvo_agent->position_.x(), rvo_agent->position_.z(), range_squared, inserter);
 	}
 }
 
 void NavMap::compute_single_avoidance_step_2d(uint32_t index, NavAgent **agent) {
-	(*(agent + index))->get_rvo_agent_2d()->computeNeighbors(&rvo_simulation_2d);
+	_compute_rvo_agent_neighbors_2d(*(agent + index));
 	(*(agent + index))->get_rvo_agent_2d()->computeNewVelocity(&rvo_simulation_2d);
 	(*(agent + index))->get_rvo_agent_2d()->update(&rvo_simulation_2d);
 	(*(agent + index))->update();
 }
 
 void NavMap::compute_single_avoidance_step_3d(uint32_t index, NavAgent **agent) {
-	(*(agent + index))->get_rvo_agent_3d()->computeNeighbors(&rvo_simulation_3d);
+	_compute_rvo_agent_neighbors_3d(*(agent + index));
 	(*(agent + index))->get_rvo_agent_3d()->computeNewVelocity(&rvo_simulation_3d);
 	(*(agent + index))->get_rvo_agent_3d()->update(&rvo_simulation_3d);
 	(*(agent + index))->update();
 }
 
 void NavMap::step(real_t p_deltatime) {
+	const uint64_t step_begin = OS::get_singleton()->get_ticks_usec();
+
 	deltatime = p_deltatime;
 	if (active_2d_avoidance_agents.size() > 0) {
 #ifndef NO_THREADS
@@ -1276,7 +1850,7 @@ void NavMap::step(real_t p_deltatime) {
 			for (int i(0); i < static_cast<int>(active_2d_avoidance_agents.size()); i++) {
 				NavAgent *agent = active_2d_avoidance_agents[i];
 
-				agent->get_rvo_agent_2d()->computeNeighbors(&rvo_simulation_2d);
+				_compute_rvo_agent_neighbors_2d(agent);
 				agent->get_rvo_agent_2d()->computeNewVelocity(&rvo_simulation_2d);
 				agent->get_rvo_agent_2d()->update(&rvo_simulation_2d);
 				agent->update();
@@ -1286,7 +1860,7 @@ void NavMap::step(real_t p_deltatime) {
 		for (int i(0); i < static_cast<int>(active_2d_avoidance_agents.size()); i++) {
 			NavAgent *agent = active_2d_avoidance_agents[i];
 
-			agent->get_rvo_agent_2d()->computeNeighbors(&rvo_simulation_2d);
+			_compute_rvo_agent_neighbors_2d(agent);
 			agent->get_rvo_agent_2d()->computeNewVelocity(&rvo_simulation_2d);
 			agent->get_rvo_agent_2d()->update(&rvo_simulation_2d);
 			agent->update();
@@ -1309,7 +1883,7 @@ void NavMap::step(real_t p_deltatime) {
 			for (int i(0); i < static_cast<int>(active_3d_avoidance_agents.size()); i++) {
 				NavAgent *agent = active_3d_avoidance_agents[i];
 
-				agent->get_rvo_agent_3d()->computeNeighbors(&rvo_simulation_3d);
+				_compute_rvo_agent_neighbors_3d(agent);
 				agent->get_rvo_agent_3d()->computeNewVelocity(&rvo_simulation_3d);
 				agent->get_rvo_agent_3d()->update(&rvo_simulation_3d);
 				agent->update();
@@ -1319,16 +1893,20 @@ void NavMap::step(real_t p_deltatime) {
 		for (int i(0); i < static_cast<int>(active_3d_avoidance_agents.size()); i++) {
 			NavAgent *agent = active_3d_avoidance_agents[i];
 
-			agent->get_rvo_agent_3d()->computeNeighbors(&rvo_simulation_3d);
+			_compute_rvo_agent_neighbors_3d(agent);
 			agent->get_rvo_agent_3d()->computeNewVelocity(&rvo_simulation_3d);
 			agent->get_rvo_agent_3d()->update(&rvo_simulation_3d);
 			agent->update();
 		}
 #endif // NO_THREADS
 	}
+
+	pm_avoidance_time = OS::get_singleton()->get_ticks_usec() - step_begin;
 }
 
 void NavMap::dispatch_callbacks() {
+	const uint64_t dispatch_begin = OS::get_singleton()->get_ticks_usec();
+
 	for (int i(0); i < static_cast<int>(active_2d_avoidance_agents.size()); i++) {
 		active_2d_avoidance_agents[i]->dispatch_avoidance_callback();
 	}
@@ -1336,9 +1914,11 @@ void NavMap::dispatch_callbacks() {
 	for (int i(0); i < static_cast<int>(active_3d_avoidance_agents.size()); i++) {
 		active_3d_avoidance_agents[i]->dispatch_avoidance_callback();
 	}
+
+	pm_callback_time = OS::get_singleton()->get_ticks_usec() - dispatch_begin;
 }
 
-void NavMap::clip_path(const LocalVector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly, Vector<int32_t> *r_path_types, Array *r_path_rids, Vector<uint64_t> *r_path_owners) const {
+void NavMap::clip_path(const LocalVector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly, const Vector3 &p_up, Vector<int32_t> *r_path_types, Array *r_path_rids, Vector<uint64_t> *r_path_owners) {
 	Vector3 from = path[path.size() - 1];
 
 	if (from.is_equal_approx(p_to_point)) {
@@ -1346,7 +1926,7 @@ void NavMap::clip_path(const LocalVector<gd::NavigationPoly> &p_navigation_polys
 	}
 
 	Plane cut_plane;
-	cut_plane.normal = (from - p_to_point).cross(up);
+	cut_plane.normal = (from - p_to_point).cross(p_up);
 
 	if (cut_plane.normal == Vector3()) {
 		return;
@@ -1382,17 +1962,23 @@ NavMap::NavMap() {
 	edge_connection_margin = 0.25;
 	regenerate_polygons = true;
 	regenerate_links = true;
+	regenerate_edge_connections = true;
 	agents_dirty = false;
 	agents_dirty = true;
+	avoidance_agents_changed = true;
 	obstacles_dirty = true;
 	use_threads = true;
 	avoidance_use_multiple_threads = true;
 	avoidance_use_high_priority_threads = true;
 	deltatime = 0.0;
 	map_update_id = 0;
+	iteration = nullptr;
 	link_connection_radius = 1.0;
 	use_edge_connections = true;
 
+	flow_fields_use_counter = 0;
+	flow_fields_pass = 0;
+
 	// Performance Monitor
 	pm_region_count = 0;
 	pm_agent_count = 0;
@@ -1402,13 +1988,27 @@ NavMap::NavMap() {
 	pm_edge_merge_count = 0;
 	pm_edge_connection_count = 0;
 	pm_edge_free_count = 0;
+	pm_sync_time = 0;
+	pm_avoidance_time = 0;
+	pm_callback_time = 0;
+	pm_path_query_count = 0;
+	pm_path_query_time = 0;
+	pm_flow_field_count = 0;
+	path_query_count.set(0);
+	path_query_time.set(0);
 
 	avoidance_use_multiple_threads = GLOBAL_GET("navigation/avoidance/thread_model/avoidance_use_multiple_threads");
 	avoidance_use_high_priority_threads = GLOBAL_GET("navigation/avoidance/thread_model/avoidance_use_high_priority_threads");
+
+	use_hierarchical_pathfinding = GLOBAL_GET("navigation/pathfinding/use_hierarchical_pathfinding");
+	hierarchical_cluster_size = GLOBAL_GET("navigation/pathfinding/hierarchical_cluster_size");
 }
 
 NavMap::~NavMap() {
 #ifndef NO_THREADS
 	step_work_pool.finish();
 #endif // !NO_THREADS
+
+	clear_flow_fields();
+	release_iteration(iteration);
 }
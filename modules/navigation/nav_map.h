@@ -34,9 +34,16 @@
 
 #include "nav_rid.h"
 
+#include "core/containers/hash_map.h"
 #include "core/containers/rb_map.h"
 #include "core/math/math_defs.h"
+#include "core/os/mutex.h"
+#include "core/os/rw_lock.h"
+#include "core/os/safe_refcount.h"
 #include "core/os/thread_work_pool.h"
+#include "nav_avoidance_grid.h"
+#include "nav_flow_field.h"
+#include "nav_map_iteration.h"
 #include "nav_utils.h"
 
 #include <KdTree2d.h>
@@ -68,18 +75,52 @@ class NavMap : public NavRid {
 	/// This value is used to limit how far links search to find polygons to connect to.
 	real_t link_connection_radius;
 
+	/// Path queries search a graph of clusters of this size first.
+	bool use_hierarchical_pathfinding;
+	real_t hierarchical_cluster_size;
+
 	bool regenerate_polygons;
 	bool regenerate_links;
+	bool regenerate_edge_connections;
 
 	/// Map regions
 	LocalVector<NavRegion *> regions;
 
 	/// Map links
 	LocalVector<NavLink *> links;
-	LocalVector<gd::Polygon> link_polygons;
 
-	/// Map polygons
-	LocalVector<gd::Polygon> polygons;
+	/// Connections between the close edges of the regions, only searched
+	/// again for the regions that changed and their neighbours.
+	LocalVector<gd::RegionEdgeConnection> region_edge_connections;
+
+	/// Map polygons, link polygons and everything else the queries read.
+	/// Replaced by a new one when the polygons are regenerated.
+	NavMapIteration *iteration;
+	mutable RWLock iteration_lock;
+
+	/// Flow fields by goal. Each one is rebuilt on a worker thread when the
+	/// iteration changes, and the old one is used until the new one is done.
+	/// Fields that weren't sampled for FLOW_FIELD_UNUSED_PASSES build passes are
+	/// dropped, and at most MAX_FLOW_FIELDS are kept, so goals that move don't pile up.
+	struct FlowFieldCacheEntry {
+		/// Null until the first build is done.
+		NavFlowField *field;
+		bool building;
+		/// Value of flow_fields_use_counter when it was last sampled or requested.
+		uint64_t last_used;
+		/// Value of flow_fields_pass when it was last sampled, requested or built.
+		uint64_t last_used_pass;
+	};
+	enum {
+		MAX_FLOW_FIELDS = 64,
+		// About 5 seconds with a NavigationServer update per physics frame.
+		FLOW_FIELD_UNUSED_PASSES = 300,
+	};
+	HashMap<NavFlowFieldKey, FlowFieldCacheEntry, NavFlowFieldKey> flow_fields;
+	uint64_t flow_fields_use_counter;
+	/// Number of build passes done so far.
+	uint64_t flow_fields_pass;
+	Mutex flow_fields_mutex;
 
 	/// RVO avoidance worlds
 	RVO2D::RVOSimulator2D rvo_simulation_2d;
@@ -92,6 +133,14 @@ class NavMap : public NavRid {
 	/// dirty flag when one of the agent's arrays are modified
 	bool agents_dirty = true;
 
+	/// Avoidance agents by grid cell, indexed like the active agents, to find their neighbours
+	NavAvoidanceGrid avoidance_grid_2d;
+	NavAvoidanceGrid avoidance_grid_3d;
+	LocalVector<NavAvoidanceGrid::Point> avoidance_grid_points;
+
+	/// Were avoidance agents added or removed since the grids were last updated?
+	bool avoidance_agents_changed;
+
 	/// All the Agents (even the controlled one)
 	LocalVector<NavAgent *> agents;
 
@@ -121,6 +170,18 @@ class NavMap : public NavRid {
 	int pm_edge_connection_count;
 	int pm_edge_free_count;
 
+	// Performance Monitor, times in microseconds
+	int pm_sync_time;
+	int pm_avoidance_time;
+	int pm_callback_time;
+	int pm_path_query_count;
+	int pm_path_query_time;
+	int pm_flow_field_count;
+
+	/// Path queries run on any thread, they are added up here until the next sync.
+	mutable SafeNumeric<uint32_t> path_query_count;
+	mutable SafeNumeric<uint64_t> path_query_time;
+
 #ifndef NO_THREADS
 	/// Pooled threads for computing steps
 	ThreadWorkPool step_work_pool;
@@ -162,13 +223,32 @@ public:
 
 	gd::PointKey get_point_key(const Vector3 &p_pos) const;
 
+	/// Returns the current iteration with a reference taken on it, or null
+	/// before the first synchronization. Give it back with release_iteration().
+	NavMapIteration *acquire_iteration() const;
+	static void release_iteration(NavMapIteration *p_iteration);
+
 	Vector<Vector3> get_path(Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigation_layers, Vector<int32_t> *r_path_types, Array *r_path_rids, Vector<uint64_t> *r_path_owners) const;
+	/// Path query on an acquired iteration, safe to run on any thread.
+	static Vector<Vector3> get_iteration_path(const NavMapIteration *p_iteration, Vector3 p_origin, Vector3 p_destination, bool p_optimize, uint32_t p_navigation_layers, Vector<int32_t> *r_path_types, Array *r_path_rids, Vector<uint64_t> *r_path_owners);
 	Vector3 get_closest_point_to_segment(const Vector3 &p_from, const Vector3 &p_to, const bool p_use_collision) const;
 	Vector3 get_closest_point(const Vector3 &p_point) const;
 	Vector3 get_closest_point_normal(const Vector3 &p_point) const;
 	gd::ClosestPointQueryResult get_closest_point_info(const Vector3 &p_point) const;
 	RID get_closest_point_owner(const Vector3 &p_point) const;
 
+	/// Samples the flow field to p_goal, queuing it to be built when there is none yet.
+	/// Returns false while it is building, or when p_position can't reach the goal.
+	bool sample_flow_field(const Vector3 &p_goal, uint32_t p_navigation_layers, const Vector3 &p_position, Vector3 &r_direction, real_t &r_distance);
+	void request_flow_field(const Vector3 &p_goal, uint32_t p_navigation_layers);
+	bool is_flow_field_ready(const Vector3 &p_goal, uint32_t p_navigation_layers);
+	void clear_flow_fields();
+
+	/// Creates the flow fields that need to be built for the current iteration,
+	/// to build outside of the map and give back with finish_flow_field().
+	void get_flow_fields_to_build(LocalVector<NavFlowField *> &r_flow_fields);
+	void finish_flow_field(NavFlowField *p_flow_field);
+
 	void add_region(NavRegion *p_region);
 	void remove_region(NavRegion *p_region);
 	const LocalVector<NavRegion *> &get_regions() const {
@@ -215,17 +295,36 @@ public:
 	int get_pm_edge_merge_count() const { return pm_edge_merge_count; }
 	int get_pm_edge_connection_count() const { return pm_edge_connection_count; }
 	int get_pm_edge_free_count() const { return pm_edge_free_count; }
+	int get_pm_sync_time() const { return pm_sync_time; }
+	int get_pm_avoidance_time() const { return pm_avoidance_time; }
+	int get_pm_callback_time() const { return pm_callback_time; }
+	int get_pm_path_query_count() const { return pm_path_query_count; }
+	int get_pm_path_query_time() const { return pm_path_query_time; }
+	int get_pm_flow_field_count() const { return pm_flow_field_count; }
+
+	/// Counts a path query that took `p_usec` microseconds, from any thread.
+	void add_path_query(uint64_t p_usec) const {
+		path_query_count.increment();
+		path_query_time.add(p_usec);
+	}
 
 private:
 	void compute_single_avoidance_step_2d(uint32_t index, NavAgent **agent);
 	void compute_single_avoidance_step_3d(uint32_t index, NavAgent **agent);
 
-	void clip_path(const LocalVector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly, Vector<int32_t> *r_path_types, Array *r_path_rids, Vector<uint64_t> *r_path_owners) const;
+	static void clip_path(const LocalVector<gd::NavigationPoly> &p_navigation_polys, Vector<Vector3> &path, const gd::NavigationPoly *from_poly, const Vector3 &p_to_point, const gd::NavigationPoly *p_to_poly, const Vector3 &p_up, Vector<int32_t> *r_path_types, Array *r_path_rids, Vector<uint64_t> *r_path_owners);
+
+	static void _update_region_edges(const LocalVector<gd::Polygon> &p_polygons, gd::RegionEdges &r_region_edges);
+	bool _get_edge_connection(const gd::Edge::Connection &p_edge, const gd::Edge::Connection &p_other_edge, Vector3 &r_pathway_start, Vector3 &r_pathway_end) const;
 
 	void _update_rvo_simulation();
 	void _update_rvo_obstacles_tree_2d();
-	void _update_rvo_agents_tree_2d();
-	void _update_rvo_agents_tree_3d();
+	void _update_rvo_agents_grid_2d();
+	void _update_rvo_agents_grid_3d();
+	void _compute_avoidance_grid_point_2d(uint32_t index, NavAgent **agent);
+	void _compute_avoidance_grid_point_3d(uint32_t index, NavAgent **agent);
+	void _compute_rvo_agent_neighbors_2d(NavAgent *p_agent);
+	void _compute_rvo_agent_neighbors_3d(NavAgent *p_agent);
 };
 
 #endif // NAV_MAP_H
@@ -0,0 +1,652 @@
+/*************************************************************************/
+/*  nav_map_hierarchy.cpp                                                */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "nav_map_hierarchy.h"
+
+#include "core/containers/sort_array.h"
+#include "nav_base.h"
+
+template <class T>
+static void _grow(LocalVector<T> &r_vector, uint32_t p_size, const T &p_value) {
+	uint32_t old_size = r_vector.size();
+	if (old_size < p_size) {
+		r_vector.resize(p_size);
+		for (uint32_t i = old_size; i < p_size; i++) {
+			r_vector[i] = p_value;
+		}
+	}
+}
+
+void NavMapHierarchy::QueryContext::prepare(uint32_t p_polygon_count, uint32_t p_portal_count, uint32_t p_cluster_count) {
+	_grow(polygon_costs, p_polygon_count, real_t(FLT_MAX));
+
+	_grow(portal_costs, p_portal_count, real_t(FLT_MAX));
+	_grow(portal_end_costs, p_portal_count, real_t(FLT_MAX));
+	_grow(portal_parents, p_portal_count, uint32_t(UINT32_MAX));
+	_grow(portal_closed, p_portal_count, uint8_t(0));
+
+	_grow(cluster_in_corridor, p_cluster_count, uint8_t(0));
+}
+
+void NavMapHierarchy::QueryContext::clear_polygon_costs() {
+	for (uint32_t i = 0; i < reached_polygons.size(); i++) {
+		polygon_costs[reached_polygons[i]] = FLT_MAX;
+	}
+	reached_polygons.clear();
+	heap.clear();
+}
+
+void NavMapHierarchy::QueryContext::clear_search() {
+	for (uint32_t i = 0; i < reached_portals.size(); i++) {
+		uint32_t portal = reached_portals[i];
+		portal_costs[portal] = FLT_MAX;
+		portal_end_costs[portal] = FLT_MAX;
+		portal_parents[portal] = UINT32_MAX;
+		portal_closed[portal] = 0;
+	}
+	reached_portals.clear();
+	heap.clear();
+}
+
+void NavMapHierarchy::QueryContext::clear() {
+	clear_polygon_costs();
+	clear_search();
+
+	for (uint32_t i = 0; i < corridor_clusters.size(); i++) {
+		cluster_in_corridor[corridor_clusters[i]] = 0;
+	}
+	corridor_clusters.clear();
+}
+
+void NavMapHierarchy::_heap_push(LocalVector<HeapEntry> &r_heap, real_t p_cost, uint32_t p_index) {
+	HeapEntry entry;
+	entry.cost = p_cost;
+	entry.index = p_index;
+	r_heap.push_back(entry);
+
+	SortArray<HeapEntry, HeapEntryComparator> sorter;
+	sorter.push_heap(0, r_heap.size() - 1, 0, entry, r_heap.ptr());
+}
+
+NavMapHierarchy::HeapEntry NavMapHierarchy::_heap_pop(LocalVector<HeapEntry> &r_heap) {
+	SortArray<HeapEntry, HeapEntryComparator> sorter;
+	sorter.pop_heap(0, r_heap.size(), r_heap.ptr());
+
+	HeapEntry entry = r_heap[r_heap.size() - 1];
+	r_heap.resize(r_heap.size() - 1);
+	return entry;
+}
+
+void NavMapHierarchy::_search_cluster(const LocalVector<gd::Polygon> &p_polygons, const LocalVector<uint32_t> &p_polygon_clusters, uint32_t p_from_polygon, const Vector3 &p_from_point, real_t p_travel_cost, QueryContext &r_context) {
+	const uint32_t cluster = p_polygon_clusters[p_from_polygon];
+
+	real_t from_cost = p_from_point.distance_to(p_polygons[p_from_polygon].center) * p_travel_cost;
+	r_context.polygon_costs[p_from_polygon] = from_cost;
+	r_context.reached_polygons.push_back(p_from_polygon);
+	_heap_push(r_context.heap, from_cost, p_from_polygon);
+
+	// Dijkstra between the polygon centers, entries left behind by a later cost decrease are skipped.
+	while (!r_context.heap.empty()) {
+		HeapEntry entry = _heap_pop(r_context.heap);
+		if (entry.cost > r_context.polygon_costs[entry.index]) {
+			continue;
+		}
+
+		const gd::Polygon &polygon = p_polygons[entry.index];
+		for (uint32_t i = 0; i < polygon.edges.size(); i++) {
+			const gd::Edge &edge = polygon.edges[i];
+
+			for (int connection_index = 0; connection_index < edge.connections.size(); connection_index++) {
+				const gd::Polygon *other = edge.connections[connection_index].polygon;
+				if (p_polygon_clusters[other->id] != cluster) {
+					continue;
+				}
+
+				real_t cost = entry.cost + polygon.center.distance_to(other->center) * p_travel_cost;
+				real_t &other_cost = r_context.polygon_costs[other->id];
+				if (cost < other_cost) {
+					if (other_cost == FLT_MAX) {
+						r_context.reached_polygons.push_back(other->id);
+					}
+					other_cost = cost;
+					_heap_push(r_context.heap, cost, other->id);
+				}
+			}
+		}
+	}
+}
+
+void NavMapHierarchy::_update_region_clusters(const LocalVector<gd::Polygon> &p_polygons, const RegionPolygons &p_region, real_t p_cluster_size) {
+	NavRegionClusters &region_clusters = *p_region.clusters;
+	region_clusters.clear();
+
+	const uint32_t polygons_from = p_region.polygons_from;
+	const uint32_t polygons_count = p_region.polygons_count;
+
+	region_clusters.polygon_clusters.resize(polygons_count);
+	for (uint32_t i = 0; i < polygons_count; i++) {
+		region_clusters.polygon_clusters[i] = UINT32_MAX;
+	}
+
+	// Flood fill the polygons connected to each other in the same cell. Only
+	// the connections inside the region are followed, they don't depend on the
+	// other regions or the links.
+	LocalVector<uint32_t> stack;
+	uint32_t cluster_count = 0;
+
+	for (uint32_t i = 0; i < polygons_count; i++) {
+		if (region_clusters.polygon_clusters[i] != UINT32_MAX) {
+			continue;
+		}
+
+		const Vector3 cell = (p_polygons[polygons_from + i].center / p_cluster_size).floor();
+
+		region_clusters.polygon_clusters[i] = cluster_count;
+		stack.push_back(i);
+
+		while (!stack.empty()) {
+			const gd::Polygon &polygon = p_polygons[polygons_from + stack[stack.size() - 1]];
+			stack.resize(stack.size() - 1);
+
+			for (uint32_t j = 0; j < polygon.edges.size(); j++) {
+				const gd::Edge &edge = polygon.edges[j];
+
+				for (int connection_index = 0; connection_index < edge.connections.size(); connection_index++) {
+					const gd::Polygon *other = edge.connections[connection_index].polygon;
+					if (other->id < polygons_from || other->id >= polygons_from + polygons_count) {
+						continue;
+					}
+
+					uint32_t other_index = other->id - polygons_from;
+					if (region_clusters.polygon_clusters[other_index] != UINT32_MAX) {
+						continue;
+					}
+
+					if ((other->center / p_cluster_size).floor() != cell) {
+						continue;
+					}
+
+					region_clusters.polygon_clusters[other_index] = cluster_count;
+					stack.push_back(other_index);
+				}
+			}
+		}
+
+		cluster_count++;
+	}
+
+	// Group the polygons by cluster.
+	region_clusters.clusters.resize(cluster_count);
+	for (uint32_t i = 0; i < cluster_count; i++) {
+		region_clusters.clusters[i].polygons_count = 0;
+	}
+	for (uint32_t i = 0; i < polygons_count; i++) {
+		region_clusters.clusters[region_clusters.polygon_clusters[i]].polygons_count++;
+	}
+
+	uint32_t polygons_offset = 0;
+	for (uint32_t i = 0; i < cluster_count; i++) {
+		region_clusters.clusters[i].polygons_from = polygons_offset;
+		polygons_offset += region_clusters.clusters[i].polygons_count;
+		region_clusters.clusters[i].polygons_count = 0;
+	}
+
+	region_clusters.polygons.resize(polygons_count);
+	for (uint32_t i = 0; i < polygons_count; i++) {
+		NavRegionClusters::Cluster &cluster = region_clusters.clusters[region_clusters.polygon_clusters[i]];
+		region_clusters.polygons[cluster.polygons_from + cluster.polygons_count] = i;
+		cluster.polygons_count++;
+	}
+
+	// Find the portal candidates.
+	region_clusters.polygon_candidates.resize(polygons_count);
+	uint32_t distances_count = 0;
+
+	for (uint32_t i = 0; i < cluster_count; i++) {
+		NavRegionClusters::Cluster &cluster = region_clusters.clusters[i];
+		cluster.candidates_from = region_clusters.candidates.size();
+		cluster.candidates_count = 0;
+
+		for (uint32_t j = 0; j < cluster.polygons_count; j++) {
+			uint32_t polygon_index = region_clusters.polygons[cluster.polygons_from + j];
+			const gd::Polygon &polygon = p_polygons[polygons_from + polygon_index];
+
+			bool is_candidate = false;
+			for (uint32_t k = 0; k < polygon.edges.size() && !is_candidate; k++) {
+				const gd::Edge &edge = polygon.edges[k];
+
+				bool is_inner_edge = false;
+				for (int connection_index = 0; connection_index < edge.connections.size(); connection_index++) {
+					const gd::Polygon *other = edge.connections[connection_index].polygon;
+					if (other->id >= polygons_from && other->id < polygons_from + polygons_count && region_clusters.polygon_clusters[other->id - polygons_from] == i) {
+						is_inner_edge = true;
+						break;
+					}
+				}
+
+				is_candidate = !is_inner_edge;
+			}
+
+			if (is_candidate) {
+				region_clusters.polygon_candidates[polygon_index] = cluster.candidates_count;
+				region_clusters.candidates.push_back(polygon_index);
+				cluster.candidates_count++;
+			} else {
+				region_clusters.polygon_candidates[polygon_index] = UINT32_MAX;
+			}
+		}
+
+		cluster.distances_from = distances_count;
+		distances_count += cluster.candidates_count * cluster.candidates_count;
+	}
+
+	region_clusters.distances.resize(distances_count);
+}
+
+void NavMapHierarchy::_update_region_distances(const LocalVector<gd::Polygon> &p_polygons, const LocalVector<uint32_t> &p_polygon_clusters, const RegionPolygons &p_region, QueryContext &r_context) {
+	NavRegionClusters &region_clusters = *p_region.clusters;
+
+	for (uint32_t i = 0; i < region_clusters.clusters.size(); i++) {
+		const NavRegionClusters::Cluster &cluster = region_clusters.clusters[i];
+		const uint32_t *candidates = &region_clusters.candidates[cluster.candidates_from];
+		real_t *distances = &region_clusters.distances[cluster.distances_from];
+
+		// Without the travel cost, it is applied when building the graph so cost changes don't need new distances.
+		for (uint32_t j = 0; j < cluster.candidates_count; j++) {
+			uint32_t from_polygon = p_region.polygons_from + candidates[j];
+			_search_cluster(p_polygons, p_polygon_clusters, from_polygon, p_polygons[from_polygon].center, 1.0, r_context);
+
+			for (uint32_t k = 0; k < cluster.candidates_count; k++) {
+				distances[j * cluster.candidates_count + k] = r_context.polygon_costs[p_region.polygons_from + candidates[k]];
+			}
+
+			r_context.clear_polygon_costs();
+		}
+	}
+
+	region_clusters.dirty = false;
+}
+
+void NavMapHierarchy::_add_outer_edges(const gd::Polygon &p_polygon, uint32_t p_cluster, const LocalVector<uint32_t> &p_polygon_portals) {
+	for (uint32_t i = 0; i < p_polygon.edges.size(); i++) {
+		const gd::Edge &edge = p_polygon.edges[i];
+
+		for (int connection_index = 0; connection_index < edge.connections.size(); connection_index++) {
+			const gd::Polygon *other = edge.connections[connection_index].polygon;
+			if (polygon_clusters[other->id] == p_cluster) {
+				continue;
+			}
+
+			PortalEdge portal_edge;
+			portal_edge.portal = p_polygon_portals[other->id];
+			portal_edge.cost = p_polygon.center.distance_to(other->center) * p_polygon.owner->get_travel_cost();
+			if (other->owner != p_polygon.owner) {
+				portal_edge.cost += other->owner->get_enter_cost();
+			}
+			portal_edges.push_back(portal_edge);
+		}
+	}
+}
+
+void NavMapHierarchy::build(const LocalVector<gd::Polygon> &p_polygons, const LocalVector<gd::Polygon> &p_link_polygons, const LocalVector<RegionPolygons> &p_regions, real_t p_cluster_size) {
+	clear();
+
+	ERR_FAIL_COND(p_cluster_size <= 0.0);
+
+	const uint32_t polygon_count = p_polygons.size();
+	const uint32_t total_polygon_count = polygon_count + p_link_polygons.size();
+
+	QueryContext context;
+	context.prepare(polygon_count, 0, 0);
+
+	// Only the regions whose polygons changed need new clusters.
+	for (uint32_t r = 0; r < p_regions.size(); r++) {
+		if (p_regions[r].clusters->dirty) {
+			_update_region_clusters(p_polygons, p_regions[r], p_cluster_size);
+		}
+	}
+
+	// Number the clusters of all the regions, then give each link its own.
+	LocalVector<uint32_t> region_clusters_from;
+	region_clusters_from.resize(p_regions.size());
+
+	polygon_clusters.resize(total_polygon_count);
+	uint32_t cluster_count = 0;
+
+	for (uint32_t r = 0; r < p_regions.size(); r++) {
+		const RegionPolygons &region = p_regions[r];
+		region_clusters_from[r] = cluster_count;
+
+		for (uint32_t i = 0; i < region.polygons_count; i++) {
+			polygon_clusters[region.polygons_from + i] = cluster_count + region.clusters->polygon_clusters[i];
+		}
+		cluster_count += region.clusters->clusters.size();
+	}
+
+	for (uint32_t l = 0; l < p_link_polygons.size(); l++) {
+		polygon_clusters[polygon_count + l] = cluster_count;
+		cluster_count++;
+	}
+
+	for (uint32_t r = 0; r < p_regions.size(); r++) {
+		if (p_regions[r].clusters->dirty) {
+			_update_region_distances(p_polygons, polygon_clusters, p_regions[r], context);
+		}
+	}
+
+	// The portals are the polygons connected from or to another cluster.
+	LocalVector<uint32_t> polygon_portals;
+	polygon_portals.resize(total_polygon_count);
+	for (uint32_t i = 0; i < total_polygon_count; i++) {
+		polygon_portals[i] = UINT32_MAX;
+	}
+
+	min_travel_cost = FLT_MAX;
+
+	for (uint32_t id = 0; id < total_polygon_count; id++) {
+		const gd::Polygon &polygon = id < polygon_count ? p_polygons[id] : p_link_polygons[id - polygon_count];
+		min_travel_cost = MIN(min_travel_cost, polygon.owner->get_travel_cost());
+
+		for (uint32_t i = 0; i < polygon.edges.size(); i++) {
+			const gd::Edge &edge = polygon.edges[i];
+
+			for (int connection_index = 0; connection_index < edge.connections.size(); connection_index++) {
+				const gd::Polygon *other = edge.connections[connection_index].polygon;
+				if (polygon_clusters[other->id] != polygon_clusters[id]) {
+					// Marked for now, numbered below.
+					polygon_portals[id] = 0;
+					polygon_portals[other->id] = 0;
+				}
+			}
+		}
+	}
+
+	if (min_travel_cost == FLT_MAX || min_travel_cost < 0.0) {
+		min_travel_cost = 0.0;
+	}
+
+	// Number the portals cluster by cluster, so the ones of a cluster are together.
+	clusters.resize(cluster_count);
+
+	for (uint32_t r = 0; r < p_regions.size(); r++) {
+		const RegionPolygons &region = p_regions[r];
+		const NavRegionClusters &region_clusters = *region.clusters;
+
+		for (uint32_t i = 0; i < region_clusters.clusters.size(); i++) {
+			const NavRegionClusters::Cluster &region_cluster = region_clusters.clusters[i];
+			Cluster &cluster = clusters[region_clusters_from[r] + i];
+			cluster.portals_from = portals.size();
+
+			for (uint32_t j = 0; j < region_cluster.polygons_count; j++) {
+				uint32_t id = region.polygons_from + region_clusters.polygons[region_cluster.polygons_from + j];
+				if (polygon_portals[id] == UINT32_MAX) {
+					continue;
+				}
+
+				polygon_portals[id] = portals.size();
+
+				Portal portal;
+				portal.polygon = id;
+				portal.position = p_polygons[id].center;
+				portal.cluster = region_clusters_from[r] + i;
+				portal.edges_from = 0;
+				portal.edges_count = 0;
+				portals.push_back(portal);
+			}
+
+			cluster.portals_count = portals.size() - cluster.portals_from;
+		}
+	}
+
+	for (uint32_t l = 0; l < p_link_polygons.size(); l++) {
+		uint32_t id = polygon_count + l;
+		Cluster &cluster = clusters[polygon_clusters[id]];
+		cluster.portals_from = portals.size();
+		cluster.portals_count = 0;
+
+		if (polygon_portals[id] == UINT32_MAX) {
+			continue;
+		}
+
+		polygon_portals[id] = portals.size();
+
+		Portal portal;
+		portal.polygon = id;
+		portal.position = p_link_polygons[l].center;
+		portal.cluster = polygon_clusters[id];
+		portal.edges_from = 0;
+		portal.edges_count = 0;
+		portals.push_back(portal);
+
+		cluster.portals_count = 1;
+	}
+
+	// Connect the portals, first to the other portals of their cluster, then to the ones of the other clusters.
+	LocalVector<real_t> portal_distances;
+
+	for (uint32_t r = 0; r < p_regions.size(); r++) {
+		const RegionPolygons &region = p_regions[r];
+		const NavRegionClusters &region_clusters = *region.clusters;
+
+		for (uint32_t i = 0; i < region_clusters.clusters.size(); i++) {
+			const NavRegionClusters::Cluster &region_cluster = region_clusters.clusters[i];
+			const Cluster &cluster = clusters[region_clusters_from[r] + i];
+			const uint32_t portals_count = cluster.portals_count;
+
+			portal_distances.resize(portals_count * portals_count);
+
+			// The distances between candidates are known. A link can connect to
+			// any polygon, when it isn't a candidate its distances are searched.
+			for (uint32_t j = 0; j < portals_count; j++) {
+				uint32_t from_candidate = region_clusters.polygon_candidates[portals[cluster.portals_from + j].polygon - region.polygons_from];
+
+				for (uint32_t k = 0; k < portals_count; k++) {
+					uint32_t to_candidate = region_clusters.polygon_candidates[portals[cluster.portals_from + k].polygon - region.polygons_from];
+
+					if (from_candidate != UINT32_MAX && to_candidate != UINT32_MAX) {
+						portal_distances[j * portals_count + k] = region_clusters.distances[region_cluster.distances_from + from_candidate * region_cluster.candidates_count + to_candidate];
+					} else {
+						portal_distances[j * portals_count + k] = FLT_MAX;
+					}
+				}
+			}
+
+			for (uint32_t j = 0; j < portals_count; j++) {
+				uint32_t from_polygon = portals[cluster.portals_from + j].polygon;
+				if (region_clusters.polygon_candidates[from_polygon - region.polygons_from] != UINT32_MAX) {
+					continue;
+				}
+
+				// The polygons of a cluster are connected both ways, so the distances are the same in both directions.
+				_search_cluster(p_polygons, polygon_clusters, from_polygon, p_polygons[from_polygon].center, 1.0, context);
+				for (uint32_t k = 0; k < portals_count; k++) {
+					real_t distance = context.polygon_costs[portals[cluster.portals_from + k].polygon];
+					portal_distances[j * portals_count + k] = distance;
+					portal_distances[k * portals_count + j] = distance;
+				}
+				context.clear_polygon_costs();
+			}
+
+			real_t travel_cost = region_cluster.polygons_count > 0 ? p_polygons[region.polygons_from + region_clusters.polygons[region_cluster.polygons_from]].owner->get_travel_cost() : 1.0;
+
+			for (uint32_t j = 0; j < portals_count; j++) {
+				Portal &portal = portals[cluster.portals_from + j];
+				portal.edges_from = portal_edges.size();
+
+				for (uint32_t k = 0; k < portals_count; k++) {
+					real_t distance = portal_distances[j * portals_count + k];
+					if (j == k || distance == FLT_MAX) {
+						continue;
+					}
+
+					PortalEdge portal_edge;
+					portal_edge.portal = cluster.portals_from + k;
+					portal_edge.cost = distance * travel_cost;
+					portal_edges.push_back(portal_edge);
+				}
+
+				_add_outer_edges(p_polygons[portal.polygon], portal.cluster, polygon_portals);
+				portal.edges_count = portal_edges.size() - portal.edges_from;
+			}
+		}
+	}
+
+	for (uint32_t l = 0; l < p_link_polygons.size(); l++) {
+		uint32_t id = polygon_count + l;
+		if (polygon_portals[id] == UINT32_MAX) {
+			continue;
+		}
+
+		Portal &portal = portals[polygon_portals[id]];
+		portal.edges_from = portal_edges.size();
+		_add_outer_edges(p_link_polygons[l], portal.cluster, polygon_portals);
+		portal.edges_count = portal_edges.size() - portal.edges_from;
+	}
+}
+
+void NavMapHierarchy::clear() {
+	polygon_clusters.clear();
+	clusters.clear();
+	portals.clear();
+	portal_edges.clear();
+	min_travel_cost = 1.0;
+}
+
+bool NavMapHierarchy::find_corridor(const LocalVector<gd::Polygon> &p_polygons, const gd::Polygon *p_begin_poly, const Vector3 &p_begin_point, const gd::Polygon *p_end_poly, const Vector3 &p_end_point, QueryContext &r_context) const {
+	if (clusters.empty()) {
+		return false;
+	}
+
+	const uint32_t begin_cluster = polygon_clusters[p_begin_poly->id];
+	const uint32_t end_cluster = polygon_clusters[p_end_poly->id];
+	if (begin_cluster == end_cluster) {
+		return false;
+	}
+
+	// One more entry for the end of the search.
+	const uint32_t end_portal = portals.size();
+	r_context.prepare(p_polygons.size(), portals.size() + 1, clusters.size());
+
+	// The polygons of a cluster are connected both ways, so the costs from the
+	// end point to the portals of its cluster are the costs to reach it from them.
+	_search_cluster(p_polygons, polygon_clusters, p_end_poly->id, p_end_point, p_end_poly->owner->get_travel_cost(), r_context);
+
+	const Cluster &end = clusters[end_cluster];
+	for (uint32_t i = end.portals_from; i < end.portals_from + end.portals_count; i++) {
+		real_t cost = r_context.polygon_costs[portals[i].polygon];
+		if (cost < FLT_MAX) {
+			r_context.portal_end_costs[i] = cost;
+			r_context.reached_portals.push_back(i);
+		}
+	}
+	r_context.clear_polygon_costs();
+
+	_search_cluster(p_polygons, polygon_clusters, p_begin_poly->id, p_begin_point, p_begin_poly->owner->get_travel_cost(), r_context);
+
+	const Cluster &begin = clusters[begin_cluster];
+	for (uint32_t i = begin.portals_from; i < begin.portals_from + begin.portals_count; i++) {
+		real_t cost = r_context.polygon_costs[portals[i].polygon];
+		if (cost < FLT_MAX) {
+			r_context.portal_costs[i] = cost;
+			r_context.reached_portals.push_back(i);
+		}
+	}
+	r_context.clear_polygon_costs();
+
+	for (uint32_t i = begin.portals_from; i < begin.portals_from + begin.portals_count; i++) {
+		if (r_context.portal_costs[i] < FLT_MAX) {
+			_heap_push(r_context.heap, r_context.portal_costs[i] + portals[i].position.distance_to(p_end_point) * min_travel_cost, i);
+		}
+	}
+
+	// A* on the portals, entries left behind by a later cost decrease are skipped.
+	bool found = false;
+	while (!r_context.heap.empty()) {
+		uint32_t portal_index = _heap_pop(r_context.heap).index;
+		if (r_context.portal_closed[portal_index]) {
+			continue;
+		}
+		r_context.portal_closed[portal_index] = 1;
+
+		if (portal_index == end_portal) {
+			found = true;
+			break;
+		}
+
+		const Portal &portal = portals[portal_index];
+		const real_t portal_cost = r_context.portal_costs[portal_index];
+
+		// Candidates for the end of the search, from the portals of the end cluster.
+		real_t cost = portal_cost + r_context.portal_end_costs[portal_index];
+		if (r_context.portal_end_costs[portal_index] < FLT_MAX && cost < r_context.portal_costs[end_portal]) {
+			if (r_context.portal_costs[end_portal] == FLT_MAX) {
+				r_context.reached_portals.push_back(end_portal);
+			}
+			r_context.portal_costs[end_portal] = cost;
+			r_context.portal_parents[end_portal] = portal_index;
+			_heap_push(r_context.heap, cost, end_portal);
+		}
+
+		for (uint32_t i = portal.edges_from; i < portal.edges_from + portal.edges_count; i++) {
+			const PortalEdge &portal_edge = portal_edges[i];
+			if (r_context.portal_closed[portal_edge.portal]) {
+				continue;
+			}
+
+			cost = portal_cost + portal_edge.cost;
+			if (cost < r_context.portal_costs[portal_edge.portal]) {
+				if (r_context.portal_costs[portal_edge.portal] == FLT_MAX && r_context.portal_end_costs[portal_edge.portal] == FLT_MAX) {
+					r_context.reached_portals.push_back(portal_edge.portal);
+				}
+				r_context.portal_costs[portal_edge.portal] = cost;
+				r_context.portal_parents[portal_edge.portal] = portal_index;
+				_heap_push(r_context.heap, cost + portals[portal_edge.portal].position.distance_to(p_end_point) * min_travel_cost, portal_edge.portal);
+			}
+		}
+	}
+
+	if (found) {
+		// The clusters of the portals on the way, the first one is in the begin cluster and the last one in the end cluster.
+		uint32_t portal_index = r_context.portal_parents[end_portal];
+		while (portal_index != UINT32_MAX) {
+			uint32_t cluster = portals[portal_index].cluster;
+			if (!r_context.cluster_in_corridor[cluster]) {
+				r_context.cluster_in_corridor[cluster] = 1;
+				r_context.corridor_clusters.push_back(cluster);
+			}
+			portal_index = r_context.portal_parents[portal_index];
+		}
+	}
+
+	r_context.clear_search();
+
+	return found;
+}
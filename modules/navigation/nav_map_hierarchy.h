@@ -0,0 +1,203 @@
+#ifndef NAV_MAP_HIERARCHY_H
+#define NAV_MAP_HIERARCHY_H
+
+/*************************************************************************/
+/*  nav_map_hierarchy.h                                                  */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "core/containers/local_vector.h"
+#include "nav_utils.h"
+
+/// Clusters of the polygons of one region. Only depends on the polygons of the
+/// region, so the region keeps them between synchronizations and they are only
+/// rebuilt when its polygons change.
+struct NavRegionClusters {
+	struct Cluster {
+		// Range in polygons.
+		uint32_t polygons_from;
+		uint32_t polygons_count;
+		// Range in candidates.
+		uint32_t candidates_from;
+		uint32_t candidates_count;
+		// Start of the candidates_count * candidates_count distances between the candidates.
+		uint32_t distances_from;
+	};
+
+	bool dirty = true;
+
+	/// Region polygon index -> cluster index.
+	LocalVector<uint32_t> polygon_clusters;
+	/// Region polygon index -> index in the candidates of its cluster, or UINT32_MAX.
+	LocalVector<uint32_t> polygon_candidates;
+
+	LocalVector<Cluster> clusters;
+	/// Region polygon indices, grouped by cluster.
+	LocalVector<uint32_t> polygons;
+	/// The polygons that can become portals, the ones with an edge not shared
+	/// with another polygon of their cluster. Grouped by cluster.
+	LocalVector<uint32_t> candidates;
+	/// Shortest distances between the polygon centers of the candidates.
+	LocalVector<real_t> distances;
+
+	void clear() {
+		polygon_clusters.clear();
+		polygon_candidates.clear();
+		clusters.clear();
+		polygons.clear();
+		candidates.clear();
+		distances.clear();
+	}
+};
+
+/// Cluster graph of a map for hierarchical path queries.
+///
+/// The polygons of each region are grouped by cells of cluster_size into
+/// connected clusters, each link is a cluster of its own. The polygons with a
+/// connection to another cluster are the portals, the graph nodes, connected
+/// by the precomputed costs to the other portals of their cluster and to the
+/// portals they are connected to. A path query searches this graph first and
+/// then only the polygons of the clusters along the path found.
+class NavMapHierarchy {
+public:
+	struct RegionPolygons {
+		NavRegionClusters *clusters;
+		// Range of the region polygons in the map polygons.
+		uint32_t polygons_from;
+		uint32_t polygons_count;
+	};
+
+	struct HeapEntry {
+		real_t cost;
+		uint32_t index;
+	};
+
+	struct HeapEntryComparator {
+		// Reversed, the heap functions of SortArray keep the greatest one on top.
+		_FORCE_INLINE_ bool operator()(const HeapEntry &p_a, const HeapEntry &p_b) const {
+			return p_a.cost > p_b.cost;
+		}
+	};
+
+	/// Scratch memory of the searches, kept between queries so they don't
+	/// allocate once it has grown to the size of the map. One per thread.
+	struct QueryContext {
+		/// Polygon id -> cost from the start of the cluster search.
+		LocalVector<real_t> polygon_costs;
+		LocalVector<uint32_t> reached_polygons;
+
+		/// Portal -> cost from the start, cost to the end and previous portal.
+		/// The last entry is the end of the search.
+		LocalVector<real_t> portal_costs;
+		LocalVector<real_t> portal_end_costs;
+		LocalVector<uint32_t> portal_parents;
+		LocalVector<uint8_t> portal_closed;
+		LocalVector<uint32_t> reached_portals;
+
+		LocalVector<HeapEntry> heap;
+
+		/// Cluster -> whether the refined search can enter it.
+		LocalVector<uint8_t> cluster_in_corridor;
+		LocalVector<uint32_t> corridor_clusters;
+
+		void prepare(uint32_t p_polygon_count, uint32_t p_portal_count, uint32_t p_cluster_count);
+
+		void clear_polygon_costs();
+		void clear_search();
+		// Only resets the entries that were used, like gd::PathQueryContext.
+		void clear();
+	};
+
+private:
+	struct Cluster {
+		// Range in portals.
+		uint32_t portals_from;
+		uint32_t portals_count;
+	};
+
+	struct Portal {
+		uint32_t polygon;
+		Vector3 position;
+		uint32_t cluster;
+		// Range in portal_edges.
+		uint32_t edges_from;
+		uint32_t edges_count;
+	};
+
+	struct PortalEdge {
+		uint32_t portal;
+		real_t cost;
+	};
+
+	/// Polygon id -> cluster, for both the polygons and the link polygons.
+	LocalVector<uint32_t> polygon_clusters;
+	LocalVector<Cluster> clusters;
+	LocalVector<Portal> portals;
+	LocalVector<PortalEdge> portal_edges;
+
+	/// Keeps the estimate of the remaining cost of the graph search below the real cost.
+	real_t min_travel_cost;
+
+	static void _heap_push(LocalVector<HeapEntry> &r_heap, real_t p_cost, uint32_t p_index);
+	static HeapEntry _heap_pop(LocalVector<HeapEntry> &r_heap);
+
+	// Shortest costs from p_from_point in p_from_polygon to the polygons of its
+	// cluster, left in r_context.polygon_costs.
+	static void _search_cluster(const LocalVector<gd::Polygon> &p_polygons, const LocalVector<uint32_t> &p_polygon_clusters, uint32_t p_from_polygon, const Vector3 &p_from_point, real_t p_travel_cost, QueryContext &r_context);
+
+	void _add_outer_edges(const gd::Polygon &p_polygon, uint32_t p_cluster, const LocalVector<uint32_t> &p_polygon_portals);
+
+	static void _update_region_clusters(const LocalVector<gd::Polygon> &p_polygons, const RegionPolygons &p_region, real_t p_cluster_size);
+	static void _update_region_distances(const LocalVector<gd::Polygon> &p_polygons, const LocalVector<uint32_t> &p_polygon_clusters, const RegionPolygons &p_region, QueryContext &r_context);
+
+public:
+	/// Updates the clusters of the regions that changed and builds the graph.
+	/// The polygons must be connected already.
+	void build(const LocalVector<gd::Polygon> &p_polygons, const LocalVector<gd::Polygon> &p_link_polygons, const LocalVector<RegionPolygons> &p_regions, real_t p_cluster_size);
+	void clear();
+
+	bool empty() const {
+		return clusters.empty();
+	}
+
+	_FORCE_INLINE_ bool is_polygon_in_corridor(uint32_t p_polygon_id, const QueryContext &p_context) const {
+		return p_context.cluster_in_corridor[polygon_clusters[p_polygon_id]];
+	}
+
+	/// Searches the cluster graph and marks the clusters along the path found
+	/// in r_context. Returns false when both polygons are in the same cluster
+	/// or no path was found, a plain search has to be done then.
+	bool find_corridor(const LocalVector<gd::Polygon> &p_polygons, const gd::Polygon *p_begin_poly, const Vector3 &p_begin_point, const gd::Polygon *p_end_poly, const Vector3 &p_end_point, QueryContext &r_context) const;
+
+	NavMapHierarchy() {
+		min_travel_cost = 1.0;
+	}
+};
+
+#endif // NAV_MAP_HIERARCHY_H
@@ -0,0 +1,79 @@
+#ifndef NAV_MAP_ITERATION_H
+#define NAV_MAP_ITERATION_H
+
+/*************************************************************************/
+/*  nav_map_iteration.h                                                  */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "core/containers/local_vector.h"
+#include "core/os/safe_refcount.h"
+#include "nav_base.h"
+#include "nav_map_hierarchy.h"
+#include "nav_polygon_bvh.h"
+#include "nav_utils.h"
+
+/// The navigation data of a map as built by one synchronization. The path and
+/// closest point queries only read an iteration, and a synchronization that
+/// changes the polygons builds a new one instead of modifying it, so queries
+/// can keep using an iteration on other threads while the map changes.
+class NavMapIteration {
+public:
+	SafeRefCount refcount;
+
+	/// The map update id this iteration was built with.
+	uint32_t map_update_id;
+	Vector3 up;
+
+	LocalVector<gd::Polygon> polygons;
+	LocalVector<gd::Polygon> link_polygons;
+
+	/// Spatial index of the polygons, for the closest point queries.
+	NavPolygonBVH polygons_bvh;
+
+	/// Cluster graph for hierarchical path queries, empty when they are disabled.
+	NavMapHierarchy hierarchy;
+
+	/// Copies of the regions and links the polygons belong to, taken when
+	/// synchronizing, so the polygons don't point at objects that can be freed.
+	LocalVector<NavBase *> owners;
+
+	NavMapIteration() {
+		refcount.init();
+		map_update_id = 0;
+	}
+
+	~NavMapIteration() {
+		for (uint32_t i = 0; i < owners.size(); i++) {
+			memdelete(owners[i]);
+		}
+	}
+};
+
+#endif // NAV_MAP_ITERATION_H
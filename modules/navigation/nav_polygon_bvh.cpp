@@ -0,0 +1,168 @@
+/*************************************************************************/
+/*  nav_polygon_bvh.cpp                                                  */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "nav_polygon_bvh.h"
+
+#include "core/containers/sort_array.h"
+#include "core/math/face3.h"
+#include "nav_base.h"
+
+void NavPolygonBVH::_build(LocalVector<BuildItem> &p_build_items, uint32_t p_from, uint32_t p_to, int p_depth, uint32_t p_node) {
+	AABB aabb = p_build_items[p_from].aabb;
+	AABB centers(p_build_items[p_from].center, Vector3());
+	for (uint32_t i = p_from + 1; i < p_to; i++) {
+		aabb.merge_with(p_build_items[i].aabb);
+		centers.expand_to(p_build_items[i].center);
+	}
+	nodes[p_node].aabb = aabb;
+
+	if (p_to - p_from <= LEAF_SIZE || p_depth >= MAX_DEPTH - 1) {
+		nodes[p_node].first = items.size();
+		nodes[p_node].count = p_to - p_from;
+		for (uint32_t i = p_from; i < p_to; i++) {
+			items.push_back(p_build_items[i].polygon);
+		}
+		return;
+	}
+
+	// Median split along the longest axis of the polygon centers.
+	uint32_t middle = (p_from + p_to) / 2;
+	SortArray<BuildItem, BuildItemComparator> sorter;
+	sorter.compare.axis = Vector3::Axis(centers.get_longest_axis_index());
+	sorter.nth_element(p_from, p_to, middle, p_build_items.ptr());
+
+	// Both children are allocated together so the second one is always first + 1.
+	uint32_t first = nodes.size();
+	nodes.push_back(Node());
+	nodes.push_back(Node());
+	nodes[p_node].first = first;
+	nodes[p_node].count = 0;
+
+	_build(p_build_items, p_from, middle, p_depth + 1, first);
+	_build(p_build_items, middle, p_to, p_depth + 1, first + 1);
+}
+
+void NavPolygonBVH::build(const LocalVector<gd::Polygon> &p_polygons) {
+	clear();
+
+	LocalVector<BuildItem> build_items;
+	build_items.reserve(p_polygons.size());
+
+	for (uint32_t i = 0; i < p_polygons.size(); i++) {
+		const gd::Polygon &polygon = p_polygons[i];
+		if (polygon.points.size() < 3) {
+			// No faces, nothing can be closest to it.
+			continue;
+		}
+
+		BuildItem item;
+		item.polygon = i;
+		item.aabb = AABB(polygon.points[0].pos, Vector3());
+		for (uint32_t j = 1; j < polygon.points.size(); j++) {
+			item.aabb.expand_to(polygon.points[j].pos);
+		}
+		item.center = item.aabb.position + item.aabb.size * 0.5;
+		build_items.push_back(item);
+	}
+
+	if (build_items.empty()) {
+		return;
+	}
+
+	nodes.reserve(build_items.size() / LEAF_SIZE * 2 + 1);
+	items.reserve(build_items.size());
+
+	nodes.push_back(Node());
+	_build(build_items, 0, build_items.size(), 0, 0);
+}
+
+void NavPolygonBVH::clear() {
+	nodes.clear();
+	items.clear();
+}
+
+bool NavPolygonBVH::get_closest_point(const LocalVector<gd::Polygon> &p_polygons, const Vector3 &p_point, bool p_use_layers, uint32_t p_navigation_layers, ClosestPoint &r_closest) const {
+	r_closest = ClosestPoint();
+
+	if (nodes.empty()) {
+		return false;
+	}
+
+	uint32_t stack[MAX_DEPTH + 1];
+	int stack_size = 0;
+	stack[stack_size++] = 0;
+
+	while (stack_size) {
+		const Node &node = nodes[stack[--stack_size]];
+
+		// Equal distances are not pruned, a polygon with a lower index may still win the tie.
+		if (_get_distance_squared(node.aabb, p_point) > r_closest.distance_squared) {
+			continue;
+		}
+
+		if (node.count == 0) {
+			// Visit the closest child first, so the other one is more likely pruned.
+			uint32_t near_child = node.first;
+			uint32_t far_child = node.first + 1;
+			if (_get_distance_squared(nodes[far_child].aabb, p_point) < _get_distance_squared(nodes[near_child].aabb, p_point)) {
+				SWAP(near_child, far_child);
+			}
+			stack[stack_size++] = far_child;
+			stack[stack_size++] = near_child;
+			continue;
+		}
+
+		for (uint32_t i = node.first; i < node.first + node.count; i++) {
+			uint32_t polygon_id = items[i];
+			const gd::Polygon &p = p_polygons[polygon_id];
+
+			// Only consider the polygon if it in a region with compatible layers.
+			if (p_use_layers && (p_navigation_layers & p.owner->get_navigation_layers()) == 0) {
+				continue;
+			}
+
+			// For each face check the distance to the point
+			for (uint32_t point_id = 2; point_id < p.points.size(); point_id++) {
+				const Face3 f(p.points[0].pos, p.points[point_id - 1].pos, p.points[point_id].pos);
+				const Vector3 inters = f.get_closest_point_to(p_point);
+				const real_t ds = inters.distance_squared_to(p_point);
+				if (ds < r_closest.distance_squared || (ds == r_closest.distance_squared && polygon_id < r_closest.polygon)) {
+					r_closest.point = inters;
+					r_closest.normal = f.get_plane().normal;
+					r_closest.polygon = polygon_id;
+					r_closest.distance_squared = ds;
+				}
+			}
+		}
+	}
+
+	return r_closest.polygon != UINT32_MAX;
+}
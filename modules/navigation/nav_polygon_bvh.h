@@ -0,0 +1,113 @@
+#ifndef NAV_POLYGON_BVH_H
+#define NAV_POLYGON_BVH_H
+
+/*************************************************************************/
+/*  nav_polygon_bvh.h                                                    */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "core/containers/local_vector.h"
+#include "core/math/aabb.h"
+#include "nav_utils.h"
+
+/// Static bounding volume hierarchy over the polygons of a map, rebuilt when
+/// the map polygons change. Used to find the closest point on the navigation
+/// mesh without testing every polygon.
+class NavPolygonBVH {
+public:
+	struct ClosestPoint {
+		Vector3 point;
+		Vector3 normal;
+		uint32_t polygon;
+		real_t distance_squared;
+
+		ClosestPoint() {
+			polygon = UINT32_MAX;
+			distance_squared = FLT_MAX;
+		}
+	};
+
+private:
+	enum {
+		LEAF_SIZE = 4,
+		MAX_DEPTH = 64,
+	};
+
+	struct Node {
+		AABB aabb;
+		// Internal nodes: index of the first child, the second one follows it.
+		// Leaves: first item in items.
+		uint32_t first;
+		// Item count for leaves, 0 for internal nodes.
+		uint32_t count;
+	};
+
+	struct BuildItem {
+		uint32_t polygon;
+		Vector3 center;
+		AABB aabb;
+	};
+
+	struct BuildItemComparator {
+		Vector3::Axis axis;
+
+		_FORCE_INLINE_ bool operator()(const BuildItem &p_a, const BuildItem &p_b) const {
+			return p_a.center[axis] < p_b.center[axis];
+		}
+	};
+
+	LocalVector<Node> nodes;
+	// Polygon indices, in leaf order.
+	LocalVector<uint32_t> items;
+
+	void _build(LocalVector<BuildItem> &p_build_items, uint32_t p_from, uint32_t p_to, int p_depth, uint32_t p_node);
+
+	static _FORCE_INLINE_ real_t _get_distance_squared(const AABB &p_aabb, const Vector3 &p_point) {
+		Vector3 closest = p_point;
+		closest.x = CLAMP(closest.x, p_aabb.position.x, p_aabb.position.x + p_aabb.size.x);
+		closest.y = CLAMP(closest.y, p_aabb.position.y, p_aabb.position.y + p_aabb.size.y);
+		closest.z = CLAMP(closest.z, p_aabb.position.z, p_aabb.position.z + p_aabb.size.z);
+		return closest.distance_squared_to(p_point);
+	}
+
+public:
+	void build(const LocalVector<gd::Polygon> &p_polygons);
+	void clear();
+
+	bool empty() const {
+		return nodes.empty();
+	}
+
+	// Finds the closest point to p_point on the polygons, skipping the ones in
+	// regions without any of p_navigation_layers when p_use_layers is set.
+	// On ties the polygon with the lowest index wins, as with a linear scan.
+	bool get_closest_point(const LocalVector<gd::Polygon> &p_polygons, const Vector3 &p_point, bool p_use_layers, uint32_t p_navigation_layers, ClosestPoint &r_closest) const;
+};
+
+#endif // NAV_POLYGON_BVH_H
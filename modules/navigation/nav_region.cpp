@@ -110,6 +110,8 @@ void NavRegion::update_polygons() {
 	}
 	polygons.clear();
 	polygons_dirty = false;
+	region_edges.dirty = true;
+	clusters.dirty = true;
 
 	if (map == nullptr) {
 		return;
@@ -34,6 +34,7 @@
 
 #include "nav_base.h"
 
+#include "nav_map_hierarchy.h"
 #include "nav_utils.h"
 #include "scene/3d/navigation.h"
 #include "scene/resources/navigation/navigation_mesh.h"
@@ -52,6 +53,12 @@ class NavRegion : public NavBase {
 	/// Cache
 	LocalVector<gd::Polygon> polygons;
 
+	/// Edges of the polygons, sorted out by the map when the polygons change.
+	gd::RegionEdges region_edges;
+
+	/// Clusters of the polygons for hierarchical path queries, rebuilt by the map when the polygons change.
+	NavRegionClusters clusters;
+
 public:
 	void scratch_polygons() {
 		polygons_dirty = true;
@@ -91,6 +98,14 @@ public:
 		return polygons;
 	}
 
+	gd::RegionEdges &get_region_edges() {
+		return region_edges;
+	}
+
+	NavRegionClusters &get_clusters() {
+		return clusters;
+	}
+
 	bool sync();
 
 	NavRegion();
@@ -33,10 +33,12 @@
 /*************************************************************************/
 
 #include "core/containers/hashfuncs.h"
+#include "core/containers/local_vector.h"
 #include "core/containers/rid.h"
 #include "core/math/vector3.h"
 
 class NavBase;
+class NavRegion;
 
 namespace gd {
 struct Polygon;
@@ -110,6 +112,9 @@ struct Edge {
 };
 
 struct Polygon {
+	/// Index of this polygon in the map, region polygons first then link polygons.
+	uint32_t id;
+
 	/// Navigation region or link that contains this polygon.
 	NavBase *owner;
 
@@ -126,10 +131,52 @@ struct Polygon {
 	Vector3 center;
 
 	Polygon() {
+		id = UINT32_MAX;
 		owner = nullptr;
 	}
 };
 
+/// The edges of the polygons of a region, sorted out when its polygons change
+/// so the map doesn't go through every polygon edge on each synchronization.
+struct RegionEdges {
+	struct InnerEdge {
+		uint32_t polygon_a;
+		uint32_t edge_a;
+		uint32_t polygon_b;
+		uint32_t edge_b;
+	};
+
+	struct OuterEdge {
+		EdgeKey key;
+		uint32_t polygon;
+		uint32_t edge;
+		/// Not merged with an edge of another region on the last synchronization.
+		bool free;
+	};
+
+	bool dirty = true;
+
+	/// Edges shared by two polygons of the region.
+	LocalVector<InnerEdge> inner_edges;
+	/// The other edges, they can be merged with or connected to the edges of other regions.
+	LocalVector<OuterEdge> outer_edges;
+};
+
+/// A connection between close edges of two regions, kept by the map until
+/// one of them changes. The polygons are indices in their region.
+struct RegionEdgeConnection {
+	NavRegion *region;
+	uint32_t polygon;
+	uint32_t edge;
+
+	NavRegion *other_region;
+	uint32_t other_polygon;
+	uint32_t other_edge;
+
+	Vector3 pathway_start;
+	Vector3 pathway_end;
+};
+
 struct NavigationPoly {
 	uint32_t self_id;
 	/// This poly.
@@ -145,8 +192,20 @@ struct NavigationPoly {
 	Vector3 entry;
 	/// The distance to the destination.
 	real_t traveled_distance;
+	/// The estimated remaining cost to the end point, used to order the open set.
+	real_t distance_to_destination;
+
+	/// Position in the open set, or UINT32_MAX when not in it.
+	uint32_t traversable_poly_index;
 
-	NavigationPoly() { poly = nullptr; }
+	real_t get_total_travel_cost() const {
+		return traveled_distance + distance_to_destination;
+	}
+
+	NavigationPoly() {
+		poly = nullptr;
+		traversable_poly_index = UINT32_MAX;
+	}
 
 	NavigationPoly(const Polygon *p_poly) {
 		self_id = 0;
@@ -155,6 +214,8 @@ struct NavigationPoly {
 		back_navigation_poly_id = -1;
 		back_navigation_edge = -1;
 		traveled_distance = 0.0;
+		distance_to_destination = 0.0;
+		traversable_poly_index = UINT32_MAX;
 	}
 
 	bool operator==(const NavigationPoly &other) const {
@@ -166,6 +227,136 @@ struct NavigationPoly {
 	}
 };
 
+/// Open set of the path search. A binary min-heap of indices into the
+/// navigation polys, ordered by their total travel cost. Each poly keeps its
+/// position in the heap so its cost can be lowered in place.
+class NavigationPolyHeap {
+	LocalVector<NavigationPoly> *navigation_polys;
+	LocalVector<uint32_t> heap;
+
+	_FORCE_INLINE_ real_t _cost(uint32_t p_heap_index) const {
+		return (*navigation_polys)[heap[p_heap_index]].get_total_travel_cost();
+	}
+
+	_FORCE_INLINE_ void _set(uint32_t p_heap_index, uint32_t p_poly_id) {
+		heap[p_heap_index] = p_poly_id;
+		(*navigation_polys)[p_poly_id].traversable_poly_index = p_heap_index;
+	}
+
+	void _shift_up(uint32_t p_heap_index) {
+		uint32_t poly_id = heap[p_heap_index];
+		real_t cost = (*navigation_polys)[poly_id].get_total_travel_cost();
+		while (p_heap_index > 0) {
+			uint32_t parent = (p_heap_index - 1) / 2;
+			if (!(cost < _cost(parent))) {
+				break;
+			}
+			_set(p_heap_index, heap[parent]);
+			p_heap_index = parent;
+		}
+		_set(p_heap_index, poly_id);
+	}
+
+	void _shift_down(uint32_t p_heap_index) {
+		uint32_t poly_id = heap[p_heap_index];
+		real_t cost = (*navigation_polys)[poly_id].get_total_travel_cost();
+		uint32_t size = heap.size();
+		while (true) {
+			uint32_t child = p_heap_index * 2 + 1;
+			if (child >= size) {
+				break;
+			}
+			if (child + 1 < size && _cost(child + 1) < _cost(child)) {
+				child++;
+			}
+			if (!(_cost(child) < cost)) {
+				break;
+			}
+			_set(p_heap_index, heap[child]);
+			p_heap_index = child;
+		}
+		_set(p_heap_index, poly_id);
+	}
+
+public:
+	_FORCE_INLINE_ uint32_t size() const { return heap.size(); }
+	_FORCE_INLINE_ bool empty() const { return heap.empty(); }
+
+	void push(uint32_t p_poly_id) {
+		heap.push_back(p_poly_id);
+		_shift_up(heap.size() - 1);
+	}
+
+	uint32_t pop() {
+		ERR_FAIL_COND_V(heap.empty(), UINT32_MAX);
+		uint32_t poly_id = heap[0];
+		(*navigation_polys)[poly_id].traversable_poly_index = UINT32_MAX;
+
+		uint32_t last = heap[heap.size() - 1];
+		heap.resize(heap.size() - 1);
+		if (!heap.empty()) {
+			heap[0] = last;
+			_shift_down(0);
+		}
+		return poly_id;
+	}
+
+	// Call after lowering the travel cost of a poly that is in the heap.
+	void decrease_cost(uint32_t p_poly_id) {
+		uint32_t heap_index = (*navigation_polys)[p_poly_id].traversable_poly_index;
+		ERR_FAIL_UNSIGNED_INDEX(heap_index, heap.size());
+		_shift_up(heap_index);
+	}
+
+	void clear() {
+		for (uint32_t i = 0; i < heap.size(); i++) {
+			(*navigation_polys)[heap[i]].traversable_poly_index = UINT32_MAX;
+		}
+		heap.clear();
+	}
+
+	NavigationPolyHeap(LocalVector<NavigationPoly> *p_navigation_polys) {
+		navigation_polys = p_navigation_polys;
+	}
+};
+
+/// Scratch memory of a path query, kept between queries so they don't
+/// allocate once it has grown to the size of the map.
+struct PathQueryContext {
+	/// All the reachable navigation polys.
+	LocalVector<NavigationPoly> navigation_polys;
+
+	/// Polygon id -> index in navigation_polys, or UINT32_MAX when not reached yet.
+	LocalVector<uint32_t> poly_to_navigation_poly;
+
+	/// Navigation polys still to visit.
+	NavigationPolyHeap traversable_polys;
+
+	void prepare(uint32_t p_polygon_count) {
+		uint32_t old_size = poly_to_navigation_poly.size();
+		if (old_size < p_polygon_count) {
+			poly_to_navigation_poly.resize(p_polygon_count);
+			for (uint32_t i = old_size; i < p_polygon_count; i++) {
+				poly_to_navigation_poly[i] = UINT32_MAX;
+			}
+		}
+	}
+
+	// Only resets the entries that were used, so the cost depends on the size
+	// of the search and not of the map.
+	void clear() {
+		traversable_polys.clear();
+		for (uint32_t i = 0; i < navigation_polys.size(); i++) {
+			poly_to_navigation_poly[navigation_polys[i].poly->id] = UINT32_MAX;
+		}
+		navigation_polys.clear();
+	}
+
+	PathQueryContext() :
+			traversable_polys(&navigation_polys) {
+	}
+};
+
 struct ClosestPointQueryResult {
 	Vector3 point;
 	Vector3 normal;
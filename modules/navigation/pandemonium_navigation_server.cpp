@@ -32,6 +32,7 @@
 #include "pandemonium_navigation_server.h"
 
 #include "core/os/mutex.h"
+#include "core/os/os.h"
 
 #ifndef _3D_DISABLED
 //#include "navigation_mesh_generator.h"
@@ -125,9 +126,19 @@ PandemoniumNavigationServer::PandemoniumNavigationServer() {
 	pm_edge_merge_count = 0;
 	pm_edge_connection_count = 0;
 	pm_edge_free_count = 0;
+	pm_sync_time = 0;
+	pm_avoidance_time = 0;
+	pm_callback_time = 0;
+	pm_path_query_count = 0;
+	pm_path_query_time = 0;
+	pm_flow_field_count = 0;
+
+	last_path_query_batch_id = 0;
 }
 
 PandemoniumNavigationServer::~PandemoniumNavigationServer() {
+	_clear_path_query_batches();
+	_clear_flow_field_tasks();
 	flush_queries();
 }
 
@@ -303,6 +314,53 @@ RID PandemoniumNavigationServer::map_get_closest_point_owner(RID p_map, const Ve
 	return map->get_closest_point_owner(p_point);
 }
 
+Vector3 PandemoniumNavigationServer::map_get_flow_direction(RID p_map, const Vector3 &p_goal, const Vector3 &p_position, uint32_t p_navigation_layers) const {
+	NavMap *map = map_owner.getornull(p_map);
+	ERR_FAIL_COND_V(map == nullptr, Vector3());
+
+	Vector3 direction;
+	real_t distance;
+	if (!map->sample_flow_field(p_goal, p_navigation_layers, p_position, direction, distance)) {
+		return Vector3();
+	}
+
+	return direction;
+}
+
+real_t PandemoniumNavigationServer::map_get_flow_distance(RID p_map, const Vector3 &p_goal, const Vector3 &p_position, uint32_t p_navigation_layers) const {
+	NavMap *map = map_owner.getornull(p_map);
+	ERR_FAIL_COND_V(map == nullptr, -1);
+
+	Vector3 direction;
+	real_t distance;
+	if (!map->sample_flow_field(p_goal, p_navigation_layers, p_position, direction, distance)) {
+		return -1;
+	}
+
+	return distance;
+}
+
+void PandemoniumNavigationServer::map_request_flow_field(RID p_map, const Vector3 &p_goal, uint32_t p_navigation_layers) {
+	NavMap *map = map_owner.getornull(p_map);
+	ERR_FAIL_COND(map == nullptr);
+
+	map->request_flow_field(p_goal, p_navigation_layers);
+}
+
+bool PandemoniumNavigationServer::map_is_flow_field_ready(RID p_map, const Vector3 &p_goal, uint32_t p_navigation_layers) const {
+	NavMap *map = map_owner.getornull(p_map);
+	ERR_FAIL_COND_V(map == nullptr, false);
+
+	return map->is_flow_field_ready(p_goal, p_navigation_layers);
+}
+
+void PandemoniumNavigationServer::map_clear_flow_fields(RID p_map) {
+	NavMap *map = map_owner.getornull(p_map);
+	ERR_FAIL_COND(map == nullptr);
+
+	map->clear_flow_fields();
+}
+
 Array PandemoniumNavigationServer::map_get_links(RID p_map) const {
 	Array link_rids;
 	const NavMap *map = map_owner.getornull(p_map);
@@ -1158,6 +1216,8 @@ void PandemoniumNavigationServer::map_force_update(RID p_map) {
 void PandemoniumNavigationServer::process(real_t p_delta_time) {
 	flush_queries();
 
+	_process_path_query_batches();
+
 	if (!active) {
 		return;
 	}
@@ -1170,6 +1230,12 @@ void PandemoniumNavigationServer::process(real_t p_delta_time) {
 	int _new_pm_edge_merge_count = 0;
 	int _new_pm_edge_connection_count = 0;
 	int _new_pm_edge_free_count = 0;
+	int _new_pm_sync_time = 0;
+	int _new_pm_avoidance_time = 0;
+	int _new_pm_callback_time = 0;
+	int _new_pm_path_query_count = 0;
+	int _new_pm_path_query_time = 0;
+	int _new_pm_flow_field_count = 0;
 
 	// In c++ we can't be sure that this is performed in the main thread
 	// even with mutable functions.
@@ -1187,6 +1253,12 @@ void PandemoniumNavigationServer::process(real_t p_delta_time) {
 		_new_pm_edge_merge_count += active_maps[i]->get_pm_edge_merge_count();
 		_new_pm_edge_connection_count += active_maps[i]->get_pm_edge_connection_count();
 		_new_pm_edge_free_count += active_maps[i]->get_pm_edge_free_count();
+		_new_pm_sync_time += active_maps[i]->get_pm_sync_time();
+		_new_pm_avoidance_time += active_maps[i]->get_pm_avoidance_time();
+		_new_pm_callback_time += active_maps[i]->get_pm_callback_time();
+		_new_pm_path_query_count += active_maps[i]->get_pm_path_query_count();
+		_new_pm_path_query_time += active_maps[i]->get_pm_path_query_time();
+		_new_pm_flow_field_count += active_maps[i]->get_pm_flow_field_count();
 
 		// Emit a signal if a map changed.
 		const uint32_t new_map_update_id = active_maps[i]->get_map_update_id();
@@ -1196,6 +1268,8 @@ void PandemoniumNavigationServer::process(real_t p_delta_time) {
 		}
 	}
 
+	_process_flow_fields();
+
 	pm_region_count = _new_pm_region_count;
 	pm_agent_count = _new_pm_agent_count;
 	pm_link_count = _new_pm_link_count;
@@ -1204,13 +1278,31 @@ void PandemoniumNavigationServer::process(real_t p_delta_time) {
 	pm_edge_merge_count = _new_pm_edge_merge_count;
 	pm_edge_connection_count = _new_pm_edge_connection_count;
 	pm_edge_free_count = _new_pm_edge_free_count;
+	pm_sync_time = _new_pm_sync_time;
+	pm_avoidance_time = _new_pm_avoidance_time;
+	pm_callback_time = _new_pm_callback_time;
+	pm_path_query_count = _new_pm_path_query_count;
+	pm_path_query_time = _new_pm_path_query_time;
+	pm_flow_field_count = _new_pm_flow_field_count;
 }
 
 PathQueryResult PandemoniumNavigationServer::_query_path(const PathQueryParameters &p_parameters) const {
-	PathQueryResult r_query_result;
-
 	const NavMap *map = map_owner.getornull(p_parameters.map);
-	ERR_FAIL_COND_V(map == nullptr, r_query_result);
+	ERR_FAIL_COND_V(map == nullptr, PathQueryResult());
+
+	NavMapIteration *iteration = map->acquire_iteration();
+	ERR_FAIL_COND_V_MSG(iteration == nullptr, PathQueryResult(), "NavigationServer map query failed because it was made before first map synchronization.");
+
+	const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	PathQueryResult query_result = _query_iteration_path(iteration, p_parameters);
+	map->add_path_query(OS::get_singleton()->get_ticks_usec() - begin);
+	NavMap::release_iteration(iteration);
+
+	return query_result;
+}
+
+PathQueryResult PandemoniumNavigationServer::_query_iteration_path(const NavMapIteration *p_iteration, const PathQueryParameters &p_parameters) {
+	PathQueryResult r_query_result;
 
 	// run the pathfinding
 
@@ -1218,7 +1310,8 @@ PathQueryResult PandemoniumNavigationServer::_query_path(const PathQueryParamete
 		Vector<Vector3> path;
 		// while postprocessing is still part of map.get_path() need to check and route it here for the correct "optimize" post-processing
 		if (p_parameters.path_postprocessing == PathPostProcessing::PATH_POSTPROCESSING_CORRIDORFUNNEL) {
-			path = map->get_path(
+			path = NavMap::get_iteration_path(
+					p_iteration,
 					p_parameters.start_position,
 					p_parameters.target_position,
 					true,
@@ -1227,7 +1320,8 @@ PathQueryResult PandemoniumNavigationServer::_query_path(const PathQueryParamete
 					((p_parameters.metadata_flags & PathMetadataFlags::PATH_INCLUDE_RIDS) != 0) ? &r_query_result.path_rids : nullptr,
 					((p_parameters.metadata_flags & PathMetadataFlags::PATH_INCLUDE_OWNERS) != 0) ? &r_query_result.path_owner_ids : nullptr);
 		} else if (p_parameters.path_postprocessing == PathPostProcessing::PATH_POSTPROCESSING_EDGECENTERED) {
-			path = map->get_path(
+			path = NavMap::get_iteration_path(
+					p_iteration,
 					p_parameters.start_position,
 					p_parameters.target_position,
 					false,
@@ -1256,6 +1350,261 @@ PathQueryResult PandemoniumNavigationServer::_query_path(const PathQueryParamete
 	return r_query_result;
 }
 
+uint32_t PandemoniumNavigationServer::_query_path_batch(const Vector<PathQueryParameters> &p_parameters, const Vector<Ref<NavigationPathQueryResult3D>> &p_results, ObjectID p_object_id, const StringName &p_method, const Variant &p_udata) {
+	ERR_FAIL_COND_V(p_parameters.size() != p_results.size(), 0);
+
+	PathQueryBatch *batch = memnew(PathQueryBatch);
+	batch->parameters.resize(p_parameters.size());
+	batch->iterations.resize(p_parameters.size());
+	batch->results.resize(p_parameters.size());
+	batch->query_times.resize(p_parameters.size());
+	batch->result_objects = p_results;
+	batch->callback_id = p_object_id;
+	batch->callback_method = p_method;
+	batch->callback_udata = p_udata;
+
+	// Take the iterations now, the maps may change before the queries run.
+	for (int i = 0; i < p_parameters.size(); i++) {
+		batch->parameters[i] = p_parameters[i];
+		batch->iterations[i] = nullptr;
+		batch->query_times[i] = 0;
+
+		const NavMap *map = map_owner.getornull(p_parameters[i].map);
+		ERR_CONTINUE(map == nullptr);
+
+		batch->iterations[i] = map->acquire_iteration();
+	}
+
+	MutexLock lock(path_query_batches_mutex);
+
+	// Some code treats 0 as a failure case, so we avoid returning 0.
+	last_path_query_batch_id = last_path_query_batch_id % UINT32_MAX + 1;
+	batch->id = last_path_query_batch_id;
+	queued_path_query_batches.push_back(batch);
+
+	return batch->id;
+}
+
+bool PandemoniumNavigationServer::is_path_batch_done(uint32_t p_batch_id) const {
+	MutexLock lock(path_query_batches_mutex);
+
+	for (uint32_t i = 0; i < queued_path_query_batches.size(); i++) {
+		if (queued_path_query_batches[i]->id == p_batch_id) {
+			return false;
+		}
+	}
+
+	for (uint32_t i = 0; i < running_path_query_batches.size(); i++) {
+		if (running_path_query_batches[i]->id == p_batch_id) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void PandemoniumNavigationServer::_run_path_query_task(uint32_t p_index, void *p_userdata) {
+	const PathQueryTask &task = path_query_tasks[p_index];
+	PathQueryBatch *batch = task.batch;
+
+	const NavMapIteration *iteration = batch->iterations[task.index];
+	if (iteration) {
+		const uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		batch->results[task.index] = _query_iteration_path(iteration, batch->parameters[task.index]);
+		batch->query_times[task.index] = OS::get_singleton()->get_ticks_usec() - begin;
+	}
+
+	path_query_tasks_done.increment();
+}
+
+void PandemoniumNavigationServer::_process_path_query_batches() {
+#ifndef NO_THREADS
+	if (path_query_work_pool.is_working()) {
+		if (path_query_tasks_done.get() < path_query_tasks.size()) {
+			// Still running, never wait for them here.
+			return;
+		}
+
+		path_query_work_pool.end_work();
+	}
+#endif // NO_THREADS
+
+	if (!running_path_query_batches.empty()) {
+		LocalVector<PathQueryBatch *> finished_batches = running_path_query_batches;
+
+		{
+			MutexLock lock(path_query_batches_mutex);
+			running_path_query_batches.clear();
+		}
+
+		for (uint32_t i = 0; i < finished_batches.size(); i++) {
+			_finish_path_query_batch(finished_batches[i]);
+		}
+
+		path_query_tasks.clear();
+	}
+
+	{
+		MutexLock lock(path_query_batches_mutex);
+		running_path_query_batches = queued_path_query_batches;
+		queued_path_query_batches.clear();
+	}
+
+	for (uint32_t i = 0; i < running_path_query_batches.size(); i++) {
+		PathQueryBatch *batch = running_path_query_batches[i];
+		for (uint32_t j = 0; j < batch->parameters.size(); j++) {
+			PathQueryTask task;
+			task.batch = batch;
+			task.index = j;
+			path_query_tasks.push_back(task);
+		}
+	}
+
+	if (path_query_tasks.empty()) {
+		return;
+	}
+
+	path_query_tasks_done.set(0);
+
+#ifndef NO_THREADS
+	if (path_query_work_pool.get_thread_count() == 0) {
+		path_query_work_pool.init();
+	}
+	path_query_work_pool.begin_work(path_query_tasks.size(), this, &PandemoniumNavigationServer::_run_path_query_task, (void *)nullptr);
+#else
+	// Without threads the queries run right away, their results are written on the next process.
+	for (uint32_t i = 0; i < path_query_tasks.size(); i++) {
+		_run_path_query_task(i, nullptr);
+	}
+#endif // NO_THREADS
+}
+
+void PandemoniumNavigationServer::_finish_path_query_batch(PathQueryBatch *p_batch) {
+	for (uint32_t i = 0; i < p_batch->results.size(); i++) {
+		p_batch->result_objects.write[i]->set_from_query_result(p_batch->results[i]);
+
+		if (p_batch->iterations[i]) {
+			// The map may have been freed since the batch was queued.
+			const NavMap *map = map_owner.getornull(p_batch->parameters[i].map);
+			if (map) {
+				map->add_path_query(p_batch->query_times[i]);
+			}
+		}
+		NavMap::release_iteration(p_batch->iterations[i]);
+	}
+
+	if (p_batch->callback_id != 0) {
+		Object *obj = ObjectDB::get_instance(p_batch->callback_id);
+		if (obj) {
+			Variant batch_id = p_batch->id;
+			Variant::CallError call_error;
+			const Variant *vp[2] = { &batch_id, &p_batch->callback_udata };
+			int argc = (p_batch->callback_udata.get_type() == Variant::NIL) ? 1 : 2;
+			obj->call(p_batch->callback_method, vp, argc, call_error);
+		}
+	}
+
+	memdelete(p_batch);
+}
+
+void PandemoniumNavigationServer::_clear_path_query_batches() {
+#ifndef NO_THREADS
+	if (path_query_work_pool.is_working()) {
+		path_query_work_pool.end_work();
+	}
+#endif // NO_THREADS
+
+	MutexLock lock(path_query_batches_mutex);
+
+	for (uint32_t i = 0; i < running_path_query_batches.size(); i++) {
+		queued_path_query_batches.push_back(running_path_query_batches[i]);
+	}
+	running_path_query_batches.clear();
+	path_query_tasks.clear();
+
+	for (uint32_t i = 0; i < queued_path_query_batches.size(); i++) {
+		PathQueryBatch *batch = queued_path_query_batches[i];
+		for (uint32_t j = 0; j < batch->iterations.size(); j++) {
+			NavMap::release_iteration(batch->iterations[j]);
+		}
+		memdelete(batch);
+	}
+	queued_path_query_batches.clear();
+}
+
+void PandemoniumNavigationServer::_build_flow_field_task(uint32_t p_index, void *p_userdata) {
+	flow_field_tasks[p_index].field->build();
+
+	flow_field_tasks_done.increment();
+}
+
+void PandemoniumNavigationServer::_process_flow_fields() {
+#ifndef NO_THREADS
+	if (flow_field_work_pool.is_working()) {
+		if (flow_field_tasks_done.get() < flow_field_tasks.size()) {
+			// Still building, the maps keep using the previous fields.
+			return;
+		}
+
+		flow_field_work_pool.end_work();
+	}
+#endif // NO_THREADS
+
+	for (uint32_t i = 0; i < flow_field_tasks.size(); i++) {
+		NavMap *map = map_owner.getornull(flow_field_tasks[i].map);
+		if (map) {
+			map->finish_flow_field(flow_field_tasks[i].field);
+		} else {
+			memdelete(flow_field_tasks[i].field);
+		}
+	}
+	flow_field_tasks.clear();
+
+	LocalVector<NavFlowField *> fields;
+	for (uint32_t i = 0; i < active_maps.size(); i++) {
+		fields.clear();
+		active_maps[i]->get_flow_fields_to_build(fields);
+
+		for (uint32_t j = 0; j < fields.size(); j++) {
+			FlowFieldTask task;
+			task.map = active_maps[i]->get_self();
+			task.field = fields[j];
+			flow_field_tasks.push_back(task);
+		}
+	}
+
+	if (flow_field_tasks.empty()) {
+		return;
+	}
+
+	flow_field_tasks_done.set(0);
+
+#ifndef NO_THREADS
+	if (flow_field_work_pool.get_thread_count() == 0) {
+		flow_field_work_pool.init();
+	}
+	flow_field_work_pool.begin_work(flow_field_tasks.size(), this, &PandemoniumNavigationServer::_build_flow_field_task, (void *)nullptr);
+#else
+	// Without threads the fields are built right away, the maps get them on the next process.
+	for (uint32_t i = 0; i < flow_field_tasks.size(); i++) {
+		_build_flow_field_task(i, nullptr);
+	}
+#endif // NO_THREADS
+}
+
+void PandemoniumNavigationServer::_clear_flow_field_tasks() {
+#ifndef NO_THREADS
+	if (flow_field_work_pool.is_working()) {
+		flow_field_work_pool.end_work();
+	}
+#endif // NO_THREADS
+
+	for (uint32_t i = 0; i < flow_field_tasks.size(); i++) {
+		memdelete(flow_field_tasks[i].field);
+	}
+	flow_field_tasks.clear();
+}
+
 int PandemoniumNavigationServer::get_process_info(ProcessInfo p_info) const {
 	switch (p_info) {
 		case INFO_ACTIVE_MAPS: {
@@ -1285,6 +1634,79 @@ int PandemoniumNavigationServer::get_process_info(ProcessInfo p_info) const {
 		case INFO_EDGE_FREE_COUNT: {
 			return pm_edge_free_count;
 		} break;
+		case INFO_SYNC_TIME: {
+			return pm_sync_time;
+		} break;
+		case INFO_AVOIDANCE_TIME: {
+			return pm_avoidance_time;
+		} break;
+		case INFO_CALLBACK_TIME: {
+			return pm_callback_time;
+		} break;
+		case INFO_PATH_QUERY_COUNT: {
+			return pm_path_query_count;
+		} break;
+		case INFO_PATH_QUERY_TIME: {
+			return pm_path_query_time;
+		} break;
+		case INFO_FLOW_FIELD_COUNT: {
+			return pm_flow_field_count;
+		} break;
+	}
+
+	return 0;
+}
+
+int PandemoniumNavigationServer::map_get_process_info(RID p_map, ProcessInfo p_info) const {
+	NavMap *map = map_owner.getornull(p_map);
+	ERR_FAIL_COND_V(map == nullptr, 0);
+
+	switch (p_info) {
+		case INFO_ACTIVE_MAPS: {
+			return active_maps.find(map) >= 0 ? 1 : 0;
+		} break;
+		case INFO_REGION_COUNT: {
+			return map->get_pm_region_count();
+		} break;
+		case INFO_AGENT_COUNT: {
+			return map->get_pm_agent_count();
+		} break;
+		case INFO_LINK_COUNT: {
+			return map->get_pm_link_count();
+		} break;
+		case INFO_POLYGON_COUNT: {
+			return map->get_pm_polygon_count();
+		} break;
+		case INFO_EDGE_COUNT: {
+			return map->get_pm_edge_count();
+		} break;
+		case INFO_EDGE_MERGE_COUNT: {
+			return map->get_pm_edge_merge_count();
+		} break;
+		case INFO_EDGE_CONNECTION_COUNT: {
+			return map->get_pm_edge_connection_count();
+		} break;
+		case INFO_EDGE_FREE_COUNT: {
+			return map->get_pm_edge_free_count();
+		} break;
+		case INFO_SYNC_TIME: {
+			return map->get_pm_sync_time();
+		} break;
+		case INFO_AVOIDANCE_TIME: {
+			return map->get_pm_avoidance_time();
+		} break;
+		case INFO_CALLBACK_TIME: {
+			return map->get_pm_callback_time();
+		} break;
+		case INFO_PATH_QUERY_COUNT: {
+			return map->get_pm_path_query_count();
+		} break;
+		case INFO_PATH_QUERY_TIME: {
+			return map->get_pm_path_query_time();
+		} break;
+		case INFO_FLOW_FIELD_COUNT: {
+			return map->get_pm_flow_field_count();
+		} break;
 	}
 
 	return 0;
@@ -35,6 +35,9 @@
 #include "servers/navigation_server.h"
 
 #include "core/containers/rid.h"
+#include "core/os/safe_refcount.h"
+#include "core/os/thread_work_pool.h"
+#include "servers/navigation/navigation_path_query_result_3d.h"
 
 #include "nav_agent.h"
 #include "nav_link.h"
@@ -83,6 +86,57 @@ class PandemoniumNavigationServer : public NavigationServer {
 	LocalVector<NavMap *> active_maps;
 	LocalVector<uint32_t> active_maps_update_id;
 
+	/// Path queries queued with `query_path_batch`.
+	struct PathQueryBatch {
+		uint32_t id;
+		LocalVector<NavigationUtilities::PathQueryParameters> parameters;
+		/// The iteration of the map of each query, taken when it was queued.
+		LocalVector<NavMapIteration *> iterations;
+		LocalVector<NavigationUtilities::PathQueryResult> results;
+		/// Microseconds each query took, added to the monitors of its map when the batch is done.
+		LocalVector<uint64_t> query_times;
+		Vector<Ref<NavigationPathQueryResult3D>> result_objects;
+
+		ObjectID callback_id;
+		StringName callback_method;
+		Variant callback_udata;
+	};
+
+	struct PathQueryTask {
+		PathQueryBatch *batch;
+		uint32_t index;
+	};
+
+	/// Guards the batch lists, the batches themselves are only touched by
+	/// the thread queuing them, the workers and then `process`.
+	Mutex path_query_batches_mutex;
+	uint32_t last_path_query_batch_id;
+	/// Batches waiting for the running ones to finish.
+	LocalVector<PathQueryBatch *> queued_path_query_batches;
+	LocalVector<PathQueryBatch *> running_path_query_batches;
+
+	/// The queries of all the running batches.
+	LocalVector<PathQueryTask> path_query_tasks;
+	SafeNumeric<uint32_t> path_query_tasks_done;
+
+#ifndef NO_THREADS
+	ThreadWorkPool path_query_work_pool;
+#endif // NO_THREADS
+
+	struct FlowFieldTask {
+		/// The map is looked up again when the field is done, it may be freed meanwhile.
+		RID map;
+		NavFlowField *field;
+	};
+
+	/// Flow fields being built, see `NavMap::get_flow_fields_to_build`.
+	LocalVector<FlowFieldTask> flow_field_tasks;
+	SafeNumeric<uint32_t> flow_field_tasks_done;
+
+#ifndef NO_THREADS
+	ThreadWorkPool flow_field_work_pool;
+#endif // NO_THREADS
+
 	// Performance Monitor
 	int pm_region_count;
 	int pm_agent_count;
@@ -92,6 +146,12 @@ class PandemoniumNavigationServer : public NavigationServer {
 	int pm_edge_merge_count;
 	int pm_edge_connection_count;
 	int pm_edge_free_count;
+	int pm_sync_time;
+	int pm_avoidance_time;
+	int pm_callback_time;
+	int pm_path_query_count;
+	int pm_path_query_time;
+	int pm_flow_field_count;
 
 public:
 	PandemoniumNavigationServer();
@@ -130,6 +190,12 @@ public:
 	virtual Vector3 map_get_closest_point_normal(RID p_map, const Vector3 &p_point) const;
 	virtual RID map_get_closest_point_owner(RID p_map, const Vector3 &p_point) const;
 
+	virtual Vector3 map_get_flow_direction(RID p_map, const Vector3 &p_goal, const Vector3 &p_position, uint32_t p_navigation_layers = 1) const;
+	virtual real_t map_get_flow_distance(RID p_map, const Vector3 &p_goal, const Vector3 &p_position, uint32_t p_navigation_layers = 1) const;
+	virtual void map_request_flow_field(RID p_map, const Vector3 &p_goal, uint32_t p_navigation_layers = 1);
+	virtual bool map_is_flow_field_ready(RID p_map, const Vector3 &p_goal, uint32_t p_navigation_layers = 1) const;
+	virtual void map_clear_flow_fields(RID p_map);
+
 	virtual Array map_get_links(RID p_map) const;
 	virtual Array map_get_regions(RID p_map) const;
 	virtual Array map_get_agents(RID p_map) const;
@@ -235,10 +301,25 @@ public:
 	virtual void process(real_t p_delta_time);
 
 	virtual int get_process_info(ProcessInfo p_info) const;
+	virtual int map_get_process_info(RID p_map, ProcessInfo p_info) const;
 
 	virtual NavigationUtilities::PathQueryResult _query_path(const NavigationUtilities::PathQueryParameters &p_parameters) const;
 
+	virtual uint32_t _query_path_batch(const Vector<NavigationUtilities::PathQueryParameters> &p_parameters, const Vector<Ref<NavigationPathQueryResult3D>> &p_results, ObjectID p_object_id, const StringName &p_method, const Variant &p_udata);
+	virtual bool is_path_batch_done(uint32_t p_batch_id) const;
+
 private:
+	static NavigationUtilities::PathQueryResult _query_iteration_path(const NavMapIteration *p_iteration, const NavigationUtilities::PathQueryParameters &p_parameters);
+
+	void _run_path_query_task(uint32_t p_index, void *p_userdata);
+	void _process_path_query_batches();
+	void _finish_path_query_batch(PathQueryBatch *p_batch);
+	void _clear_path_query_batches();
+
+	void _build_flow_field_task(uint32_t p_index, void *p_userdata);
+	void _process_flow_fields();
+	void _clear_flow_field_tasks();
+
 	void internal_free_agent(RID p_object);
 	void internal_free_obstacle(RID p_object);
 };
@@ -62,6 +62,11 @@ public:
 	virtual Vector3 map_get_closest_point(RID p_map, const Vector3 &p_point) const { return Vector3(); }
 	virtual Vector3 map_get_closest_point_normal(RID p_map, const Vector3 &p_point) const { return Vector3(); }
 	virtual RID map_get_closest_point_owner(RID p_map, const Vector3 &p_point) const { return RID(); }
+	virtual Vector3 map_get_flow_direction(RID p_map, const Vector3 &p_goal, const Vector3 &p_position, uint32_t p_navigation_layers = 1) const { return Vector3(); }
+	virtual real_t map_get_flow_distance(RID p_map, const Vector3 &p_goal, const Vector3 &p_position, uint32_t p_navigation_layers = 1) const { return -1; }
+	virtual void map_request_flow_field(RID p_map, const Vector3 &p_goal, uint32_t p_navigation_layers = 1) {}
+	virtual bool map_is_flow_field_ready(RID p_map, const Vector3 &p_goal, uint32_t p_navigation_layers = 1) const { return false; }
+	virtual void map_clear_flow_fields(RID p_map) {}
 
 	virtual Array map_get_links(RID p_map) const { return Array(); }
 	virtual Array map_get_regions(RID p_map) const { return Array(); }
@@ -160,8 +165,11 @@ public:
 	virtual void process(real_t delta_time) {};
 
 	virtual int get_process_info(ProcessInfo p_info) const { return 0; };
+	virtual int map_get_process_info(RID p_map, ProcessInfo p_info) const { return 0; };
 
 	virtual NavigationUtilities::PathQueryResult _query_path(const NavigationUtilities::PathQueryParameters &p_parameters) const;
+	virtual uint32_t _query_path_batch(const Vector<NavigationUtilities::PathQueryParameters> &p_parameters, const Vector<Ref<NavigationPathQueryResult3D>> &p_results, ObjectID p_object_id, const StringName &p_method, const Variant &p_udata) { return 0; };
+	virtual bool is_path_batch_done(uint32_t p_batch_id) const { return true; };
 
 	DummyNavigationServer();
 	virtual ~DummyNavigationServer();
@@ -46,6 +46,10 @@
 #endif // _3D_DISABLED
 
 #ifndef _3D_DISABLED
+#include "core/containers/hash_map.h"
+#include "core/math/vector2i.h"
+#include "core/os/thread_work_pool.h"
+
 #include <Recast.h>
 #endif // _3D_DISABLED
 
@@ -551,19 +555,61 @@ void PandemoniumNavigationMeshGenerator::_process_3d_bake_cleanup_tasks() {
 	}
 }
 
-void PandemoniumNavigationMeshGenerator::_static_bake_3d_from_source_geometry_data(Ref<NavigationMesh> p_navigation_mesh, Ref<NavigationMeshSourceGeometryData3D> p_source_geometry_data) {
-	if (p_navigation_mesh.is_null() || p_source_geometry_data.is_null()) {
-		return;
+struct PandemoniumNavigationMeshGeneratorTileBakeContext {
+	struct Tile {
+		Vector2i coords;
+		uint32_t source_hash = 0;
+		LocalVector<int> triangles;
+		float bmin[3];
+		float bmax[3];
+		bool baked = false;
+		PoolVector<Vector3> vertices;
+		Vector<Vector<int>> polygons;
+	};
+
+	Ref<NavigationMesh> navigation_mesh;
+	const float *verts = nullptr;
+	int nverts = 0;
+	int border_size = 0;
+	LocalVector<Tile> tiles;
+
+	void bake_tile(uint32_t p_index, void *p_userdata) {
+		Tile &tile = tiles[p_index];
+		tile.baked = PandemoniumNavigationMeshGenerator::_static_bake_3d_recast(navigation_mesh, verts, nverts, tile.triangles.ptr(), tile.triangles.size() / 3, tile.bmin, tile.bmax, border_size, tile.vertices, tile.polygons);
 	}
+};
 
-#ifndef _3D_DISABLED
-	PoolRealArray vertices = p_source_geometry_data->get_vertices();
-	PoolIntArray indices = p_source_geometry_data->get_indices();
+static uint32_t _hash_3d_tile_bake_settings(Ref<NavigationMesh> p_navigation_mesh, int p_tile_cells) {
+	uint32_t h = hash_murmur3_one_32(p_tile_cells);
+	h = hash_murmur3_one_float(p_navigation_mesh->get_cell_size(), h);
+	h = hash_murmur3_one_float(p_navigation_mesh->get_cell_height(), h);
+	h = hash_murmur3_one_float(p_navigation_mesh->get_agent_height(), h);
+	h = hash_murmur3_one_float(p_navigation_mesh->get_agent_radius(), h);
+	h = hash_murmur3_one_float(p_navigation_mesh->get_agent_max_climb(), h);
+	h = hash_murmur3_one_float(p_navigation_mesh->get_agent_max_slope(), h);
+	h = hash_murmur3_one_float(p_navigation_mesh->get_region_min_size(), h);
+	h = hash_murmur3_one_float(p_navigation_mesh->get_region_merge_size(), h);
+	h = hash_murmur3_one_float(p_navigation_mesh->get_edge_max_length(), h);
+	h = hash_murmur3_one_float(p_navigation_mesh->get_edge_max_error(), h);
+	h = hash_murmur3_one_float(p_navigation_mesh->get_vertices_per_polygon(), h);
+	h = hash_murmur3_one_float(p_navigation_mesh->get_detail_sample_distance(), h);
+	h = hash_murmur3_one_float(p_navigation_mesh->get_detail_sample_max_error(), h);
+	h = hash_murmur3_one_32(p_navigation_mesh->get_sample_partition_type(), h);
+	h = hash_murmur3_one_32(p_navigation_mesh->get_filter_low_hanging_obstacles(), h);
+	h = hash_murmur3_one_32(p_navigation_mesh->get_filter_ledge_spans(), h);
+	h = hash_murmur3_one_32(p_navigation_mesh->get_filter_walkable_low_height_spans(), h);
 
-	if (vertices.size() < 3 || indices.size() < 3) {
-		return;
+	AABB baking_aabb = p_navigation_mesh->get_filter_baking_aabb();
+	baking_aabb.position += p_navigation_mesh->get_filter_baking_aabb_offset();
+	for (int i = 0; i < 3; i++) {
+		h = hash_murmur3_one_real(baking_aabb.position[i], h);
+		h = hash_murmur3_one_real(baking_aabb.size[i], h);
 	}
 
+	return hash_fmix32(h);
+}
+
+bool PandemoniumNavigationMeshGenerator::_static_bake_3d_recast(Ref<NavigationMesh> p_navigation_mesh, const float *p_verts, int p_nverts, const int *p_tris, int p_ntris, const float *p_bmin, const float *p_bmax, int p_border_size, PoolVector<Vector3> &r_vertices, Vector<Vector<int>> &r_polygons) {
 	rcHeightfield *hf = nullptr;
 	rcCompactHeightfield *chf = nullptr;
 	rcContourSet *cset = nullptr;
@@ -576,15 +622,10 @@ void PandemoniumNavigationMeshGenerator::_static_bake_3d_from_source_geometry_da
 
 	bake_state = "Setting up Configuration..."; // step #1
 
-	PoolRealArray::Read vertices_read = vertices.read();
-	PoolIntArray::Read indices_read = indices.read();
-	const float *verts = vertices_read.ptr();
-	const int nverts = vertices.size() / 3;
-	const int *tris = indices_read.ptr();
-	const int ntris = indices.size() / 3;
-
-	float bmin[3], bmax[3];
-	rcCalcBounds(verts, nverts, bmin, bmax);
+	const float *verts = p_verts;
+	const int nverts = p_nverts;
+	const int *tris = p_tris;
+	const int ntris = p_ntris;
 
 	rcConfig cfg;
 	memset(&cfg, 0, sizeof(cfg));
@@ -602,24 +643,14 @@ void PandemoniumNavigationMeshGenerator::_static_bake_3d_from_source_geometry_da
 	cfg.maxVertsPerPoly = (int)p_navigation_mesh->get_vertices_per_polygon();
 	cfg.detailSampleDist = MAX(p_navigation_mesh->get_cell_size() * p_navigation_mesh->get_detail_sample_distance(), 0.1f);
 	cfg.detailSampleMaxError = p_navigation_mesh->get_cell_height() * p_navigation_mesh->get_detail_sample_max_error();
+	cfg.borderSize = p_border_size;
 
-	cfg.bmin[0] = bmin[0];
-	cfg.bmin[1] = bmin[1];
-	cfg.bmin[2] = bmin[2];
-	cfg.bmax[0] = bmax[0];
-	cfg.bmax[1] = bmax[1];
-	cfg.bmax[2] = bmax[2];
-
-	AABB baking_aabb = p_navigation_mesh->get_filter_baking_aabb();
-	if (!baking_aabb.has_no_volume()) {
-		Vector3 baking_aabb_offset = p_navigation_mesh->get_filter_baking_aabb_offset();
-		cfg.bmin[0] = baking_aabb.position[0] + baking_aabb_offset.x;
-		cfg.bmin[1] = baking_aabb.position[1] + baking_aabb_offset.y;
-		cfg.bmin[2] = baking_aabb.position[2] + baking_aabb_offset.z;
-		cfg.bmax[0] = cfg.bmin[0] + baking_aabb.size[0];
-		cfg.bmax[1] = cfg.bmin[1] + baking_aabb.size[1];
-		cfg.bmax[2] = cfg.bmin[2] + baking_aabb.size[2];
-	}
+	cfg.bmin[0] = p_bmin[0];
+	cfg.bmin[1] = p_bmin[1];
+	cfg.bmin[2] = p_bmin[2];
+	cfg.bmax[0] = p_bmax[0];
+	cfg.bmax[1] = p_bmax[1];
+	cfg.bmax[2] = p_bmax[2];
 
 	bake_state = "Calculating grid size..."; // step #2
 
@@ -629,8 +660,8 @@ void PandemoniumNavigationMeshGenerator::_static_bake_3d_from_source_geometry_da
 
 	hf = rcAllocHeightfield();
 
-	ERR_FAIL_COND(!hf);
-	ERR_FAIL_COND(!rcCreateHeightfield(&ctx, *hf, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs, cfg.ch));
+	ERR_FAIL_COND_V(!hf, false);
+	ERR_FAIL_COND_V(!rcCreateHeightfield(&ctx, *hf, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs, cfg.ch), false);
 
 	bake_state = "Marking walkable triangles..."; // step #4
 
@@ -638,12 +669,12 @@ void PandemoniumNavigationMeshGenerator::_static_bake_3d_from_source_geometry_da
 		Vector<unsigned char> tri_areas;
 		tri_areas.resize(ntris);
 
-		ERR_FAIL_COND(tri_areas.size() == 0);
+		ERR_FAIL_COND_V(tri_areas.size() == 0, false);
 
 		memset(tri_areas.ptrw(), 0, ntris * sizeof(unsigned char));
 		rcMarkWalkableTriangles(&ctx, cfg.walkableSlopeAngle, verts, nverts, tris, ntris, tri_areas.ptrw());
 
-		ERR_FAIL_COND(!rcRasterizeTriangles(&ctx, verts, nverts, tris, tri_areas.ptr(), ntris, *hf, cfg.walkableClimb));
+		ERR_FAIL_COND_V(!rcRasterizeTriangles(&ctx, verts, nverts, tris, tri_areas.ptr(), ntris, *hf, cfg.walkableClimb), false);
 	}
 
 	if (p_navigation_mesh->get_filter_low_hanging_obstacles()) {
@@ -660,43 +691,43 @@ void PandemoniumNavigationMeshGenerator::_static_bake_3d_from_source_geometry_da
 
 	chf = rcAllocCompactHeightfield();
 
-	ERR_FAIL_COND(!chf);
-	ERR_FAIL_COND(!rcBuildCompactHeightfield(&ctx, cfg.walkableHeight, cfg.walkableClimb, *hf, *chf));
+	ERR_FAIL_COND_V(!chf, false);
+	ERR_FAIL_COND_V(!rcBuildCompactHeightfield(&ctx, cfg.walkableHeight, cfg.walkableClimb, *hf, *chf), false);
 
 	rcFreeHeightField(hf);
 	hf = nullptr;
 
 	bake_state = "Eroding walkable area..."; // step #6
 
-	ERR_FAIL_COND(!rcErodeWalkableArea(&ctx, cfg.walkableRadius, *chf));
+	ERR_FAIL_COND_V(!rcErodeWalkableArea(&ctx, cfg.walkableRadius, *chf), false);
 
 	bake_state = "Partitioning..."; // step #7
 
 	if (p_navigation_mesh->get_sample_partition_type() == NavigationMesh::SAMPLE_PARTITION_WATERSHED) {
-		ERR_FAIL_COND(!rcBuildDistanceField(&ctx, *chf));
-		ERR_FAIL_COND(!rcBuildRegions(&ctx, *chf, 0, cfg.minRegionArea, cfg.mergeRegionArea));
+		ERR_FAIL_COND_V(!rcBuildDistanceField(&ctx, *chf), false);
+		ERR_FAIL_COND_V(!rcBuildRegions(&ctx, *chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea), false);
 	} else if (p_navigation_mesh->get_sample_partition_type() == NavigationMesh::SAMPLE_PARTITION_MONOTONE) {
-		ERR_FAIL_COND(!rcBuildRegionsMonotone(&ctx, *chf, 0, cfg.minRegionArea, cfg.mergeRegionArea));
+		ERR_FAIL_COND_V(!rcBuildRegionsMonotone(&ctx, *chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea), false);
 	} else {
-		ERR_FAIL_COND(!rcBuildLayerRegions(&ctx, *chf, 0, cfg.minRegionArea));
+		ERR_FAIL_COND_V(!rcBuildLayerRegions(&ctx, *chf, cfg.borderSize, cfg.minRegionArea), false);
 	}
 
 	bake_state = "Creating contours..."; // step #8
 
 	cset = rcAllocContourSet();
 
-	ERR_FAIL_COND(!cset);
-	ERR_FAIL_COND(!rcBuildContours(&ctx, *chf, cfg.maxSimplificationError, cfg.maxEdgeLen, *cset));
+	ERR_FAIL_COND_V(!cset, false);
+	ERR_FAIL_COND_V(!rcBuildContours(&ctx, *chf, cfg.maxSimplificationError, cfg.maxEdgeLen, *cset), false);
 
 	bake_state = "Creating polymesh..."; // step #9
 
 	poly_mesh = rcAllocPolyMesh();
-	ERR_FAIL_COND(!poly_mesh);
-	ERR_FAIL_COND(!rcBuildPolyMesh(&ctx, *cset, cfg.maxVertsPerPoly, *poly_mesh));
+	ERR_FAIL_COND_V(!poly_mesh, false);
+	ERR_FAIL_COND_V(!rcBuildPolyMesh(&ctx, *cset, cfg.maxVertsPerPoly, *poly_mesh), false);
 
 	detail_mesh = rcAllocPolyMeshDetail();
-	ERR_FAIL_COND(!detail_mesh);
-	ERR_FAIL_COND(!rcBuildPolyMeshDetail(&ctx, *poly_mesh, *chf, cfg.detailSampleDist, cfg.detailSampleMaxError, *detail_mesh));
+	ERR_FAIL_COND_V(!detail_mesh, false);
+	ERR_FAIL_COND_V(!rcBuildPolyMeshDetail(&ctx, *poly_mesh, *chf, cfg.detailSampleDist, cfg.detailSampleMaxError, *detail_mesh), false);
 
 	rcFreeCompactHeightfield(chf);
 	chf = nullptr;
@@ -705,12 +736,9 @@ void PandemoniumNavigationMeshGenerator::_static_bake_3d_from_source_geometry_da
 
 	bake_state = "Converting to native navigation mesh..."; // step #10
 
-	PoolVector<Vector3> new_navigation_mesh_vertices;
-	Vector<Vector<int>> new_navigation_mesh_polygons;
-
 	for (int i = 0; i < detail_mesh->nverts; i++) {
 		const float *v = &detail_mesh->verts[i * 3];
-		new_navigation_mesh_vertices.push_back(Vector3(v[0], v[1], v[2]));
+		r_vertices.push_back(Vector3(v[0], v[1], v[2]));
 	}
 
 	for (int i = 0; i < detail_mesh->nmeshes; i++) {
@@ -726,13 +754,10 @@ void PandemoniumNavigationMeshGenerator::_static_bake_3d_from_source_geometry_da
 			new_navigation_mesh_polygon.write[0] = ((int)(detail_mesh_bverts + detail_mesh_tris[j * 4 + 0]));
 			new_navigation_mesh_polygon.write[1] = ((int)(detail_mesh_bverts + detail_mesh_tris[j * 4 + 2]));
 			new_navigation_mesh_polygon.write[2] = ((int)(detail_mesh_bverts + detail_mesh_tris[j * 4 + 1]));
-			new_navigation_mesh_polygons.push_back(new_navigation_mesh_polygon);
+			r_polygons.push_back(new_navigation_mesh_polygon);
 		}
 	}
 
-	p_navigation_mesh->set_vertices(new_navigation_mesh_vertices);
-	p_navigation_mesh->set_polygons(new_navigation_mesh_polygons);
-
 	bake_state = "Cleanup..."; // step #11
 
 	rcFreePolyMesh(poly_mesh);
@@ -756,10 +781,253 @@ void PandemoniumNavigationMeshGenerator::_static_bake_3d_from_source_geometry_da
 	detail_mesh = nullptr;
 
 	bake_state = "Baking finished."; // step #12
+
+	return true;
+}
+
+void PandemoniumNavigationMeshGenerator::_static_bake_3d_from_source_geometry_data(Ref<NavigationMesh> p_navigation_mesh, Ref<NavigationMeshSourceGeometryData3D> p_source_geometry_data) {
+	if (p_navigation_mesh.is_null() || p_source_geometry_data.is_null()) {
+		return;
+	}
+
+#ifndef _3D_DISABLED
+	PoolRealArray vertices = p_source_geometry_data->get_vertices();
+	PoolIntArray indices = p_source_geometry_data->get_indices();
+
+	if (vertices.size() < 3 || indices.size() < 3) {
+		return;
+	}
+
+	if (p_navigation_mesh->get_tile_size() > 0.0f) {
+		_static_bake_3d_tiles_from_source_geometry_data(p_navigation_mesh, p_source_geometry_data);
+		p_navigation_mesh->commit_changes();
+		return;
+	}
+
+	PoolRealArray::Read vertices_read = vertices.read();
+	PoolIntArray::Read indices_read = indices.read();
+	const float *verts = vertices_read.ptr();
+	const int nverts = vertices.size() / 3;
+	const int *tris = indices_read.ptr();
+	const int ntris = indices.size() / 3;
+
+	float bmin[3], bmax[3];
+	rcCalcBounds(verts, nverts, bmin, bmax);
+
+	AABB baking_aabb = p_navigation_mesh->get_filter_baking_aabb();
+	if (!baking_aabb.has_no_volume()) {
+		Vector3 baking_aabb_offset = p_navigation_mesh->get_filter_baking_aabb_offset();
+		bmin[0] = baking_aabb.position[0] + baking_aabb_offset.x;
+		bmin[1] = baking_aabb.position[1] + baking_aabb_offset.y;
+		bmin[2] = baking_aabb.position[2] + baking_aabb_offset.z;
+		bmax[0] = bmin[0] + baking_aabb.size[0];
+		bmax[1] = bmin[1] + baking_aabb.size[1];
+		bmax[2] = bmin[2] + baking_aabb.size[2];
+	}
+
+	PoolVector<Vector3> new_navigation_mesh_vertices;
+	Vector<Vector<int>> new_navigation_mesh_polygons;
+
+	if (!_static_bake_3d_recast(p_navigation_mesh, verts, nverts, tris, ntris, bmin, bmax, 0, new_navigation_mesh_vertices, new_navigation_mesh_polygons)) {
+		return;
+	}
+
+	p_navigation_mesh->clear_tiles();
+	p_navigation_mesh->set_vertices(new_navigation_mesh_vertices);
+	p_navigation_mesh->set_polygons(new_navigation_mesh_polygons);
 #endif // _3D_DISABLED
 	p_navigation_mesh->commit_changes();
 }
 
+void PandemoniumNavigationMeshGenerator::_static_bake_3d_tiles_from_source_geometry_data(Ref<NavigationMesh> p_navigation_mesh, Ref<NavigationMeshSourceGeometryData3D> p_source_geometry_data) {
+	PoolRealArray vertices = p_source_geometry_data->get_vertices();
+	PoolIntArray indices = p_source_geometry_data->get_indices();
+
+	PoolRealArray::Read vertices_read = vertices.read();
+	PoolIntArray::Read indices_read = indices.read();
+	const float *verts = vertices_read.ptr();
+	const int nverts = vertices.size() / 3;
+	const int *tris = indices_read.ptr();
+	const int ntris = indices.size() / 3;
+
+	// Tiles are aligned to a world grid of whole cells, so a tile keeps its coordinates and its
+	// heightfield cells when geometry elsewhere changes.
+	const float cell_size = p_navigation_mesh->get_cell_size();
+	const float cell_height = p_navigation_mesh->get_cell_height();
+	const int tile_cells = MAX(1, (int)Math::round(p_navigation_mesh->get_tile_size() / cell_size));
+	const float tile_world_size = tile_cells * cell_size;
+
+	// Every tile also rasterizes a border of its neighbours' geometry, so erosion and region building
+	// give the same result on both sides of a tile edge and the baked polygons meet there.
+	const int border_size = (int)Math::ceil(p_navigation_mesh->get_agent_radius() / cell_size) + 3;
+	const float border_world_size = border_size * cell_size;
+
+	AABB baking_aabb = p_navigation_mesh->get_filter_baking_aabb();
+	const bool use_baking_aabb = !baking_aabb.has_no_volume();
+	baking_aabb.position += p_navigation_mesh->get_filter_baking_aabb_offset();
+
+	HashMap<Vector2i, LocalVector<int>> tile_triangles;
+
+	for (int i = 0; i < ntris; i++) {
+		const float *a = &verts[tris[i * 3 + 0] * 3];
+		const float *b = &verts[tris[i * 3 + 1] * 3];
+		const float *c = &verts[tris[i * 3 + 2] * 3];
+
+		const float min_x = MIN(a[0], MIN(b[0], c[0])) - border_world_size;
+		const float max_x = MAX(a[0], MAX(b[0], c[0])) + border_world_size;
+		const float min_z = MIN(a[2], MIN(b[2], c[2])) - border_world_size;
+		const float max_z = MAX(a[2], MAX(b[2], c[2])) + border_world_size;
+
+		const int from_x = (int)Math::floor(min_x / tile_world_size);
+		const int to_x = (int)Math::floor(max_x / tile_world_size);
+		const int from_z = (int)Math::floor(min_z / tile_world_size);
+		const int to_z = (int)Math::floor(max_z / tile_world_size);
+
+		for (int z = from_z; z <= to_z; z++) {
+			for (int x = from_x; x <= to_x; x++) {
+				if (use_baking_aabb) {
+					if (x * tile_world_size > baking_aabb.position.x + baking_aabb.size.x || (x + 1) * tile_world_size < baking_aabb.position.x ||
+							z * tile_world_size > baking_aabb.position.z + baking_aabb.size.z || (z + 1) * tile_world_size < baking_aabb.position.z) {
+						continue;
+					}
+				}
+
+				tile_triangles[Vector2i(x, z)].push_back(i);
+			}
+		}
+	}
+
+	const uint32_t settings_hash = _hash_3d_tile_bake_settings(p_navigation_mesh, tile_cells);
+	const HashMap<Vector2i, NavigationMesh::BakedTile> &previous_baked_tiles = p_navigation_mesh->get_baked_tiles();
+	HashMap<Vector2i, NavigationMesh::BakedTile> baked_tiles;
+
+	PandemoniumNavigationMeshGeneratorTileBakeContext context;
+	context.navigation_mesh = p_navigation_mesh;
+	context.verts = verts;
+	context.nverts = nverts;
+	context.border_size = border_size;
+
+	for (const HashMap<Vector2i, LocalVector<int>>::Element *E = tile_triangles.front(); E; E = E->next) {
+		const Vector2i &coords = E->key();
+		const LocalVector<int> &triangles = E->value();
+
+		uint32_t source_hash = settings_hash;
+		float min_y = verts[tris[triangles[0] * 3] * 3 + 1];
+		float max_y = min_y;
+
+		for (uint32_t i = 0; i < triangles.size(); i++) {
+			for (int j = 0; j < 3; j++) {
+				const float *v = &verts[tris[triangles[i] * 3 + j] * 3];
+				source_hash = hash_murmur3_one_float(v[0], source_hash);
+				source_hash = hash_murmur3_one_float(v[1], source_hash);
+				source_hash = hash_murmur3_one_float(v[2], source_hash);
+				min_y = MIN(min_y, v[1]);
+				max_y = MAX(max_y, v[1]);
+			}
+		}
+		source_hash = hash_fmix32(source_hash);
+
+		const NavigationMesh::BakedTile *previous_baked_tile = previous_baked_tiles.getptr(coords);
+		if (previous_baked_tile && previous_baked_tile->source_hash == source_hash) {
+			baked_tiles.insert(coords, *previous_baked_tile);
+			continue;
+		}
+
+		PandemoniumNavigationMeshGeneratorTileBakeContext::Tile tile;
+		tile.coords = coords;
+		tile.source_hash = source_hash;
+		tile.triangles.resize(triangles.size() * 3);
+		for (uint32_t i = 0; i < triangles.size(); i++) {
+			tile.triangles[i * 3 + 0] = tris[triangles[i] * 3 + 0];
+			tile.triangles[i * 3 + 1] = tris[triangles[i] * 3 + 1];
+			tile.triangles[i * 3 + 2] = tris[triangles[i] * 3 + 2];
+		}
+
+		// Recast quantizes heights from the bottom of the tile. Starting every tile on the same
+		// grid of cell heights keeps the vertices on a shared edge at the same height, so the
+		// navigation map gives them the same point keys.
+		tile.bmin[0] = coords.x * tile_world_size - border_world_size;
+		tile.bmin[1] = use_baking_aabb ? baking_aabb.position.y : Math::floor(min_y / cell_height) * cell_height;
+		tile.bmin[2] = coords.y * tile_world_size - border_world_size;
+		tile.bmax[0] = (coords.x + 1) * tile_world_size + border_world_size;
+		tile.bmax[1] = use_baking_aabb ? baking_aabb.position.y + baking_aabb.size.y : max_y;
+		tile.bmax[2] = (coords.y + 1) * tile_world_size + border_world_size;
+
+		if (use_baking_aabb) {
+			// Same limits as an untiled bake. The border stays around the clipped range, on whole
+			// cells, so the polygons end at the filter and still meet the next tile inside it.
+			tile.bmin[0] = MAX(tile.bmin[0], (Math::floor(baking_aabb.position.x / cell_size) - border_size) * cell_size);
+			tile.bmin[2] = MAX(tile.bmin[2], (Math::floor(baking_aabb.position.z / cell_size) - border_size) * cell_size);
+			tile.bmax[0] = MIN(tile.bmax[0], (Math::ceil((baking_aabb.position.x + baking_aabb.size.x) / cell_size) + border_size) * cell_size);
+			tile.bmax[2] = MIN(tile.bmax[2], (Math::ceil((baking_aabb.position.z + baking_aabb.size.z) / cell_size) + border_size) * cell_size);
+		}
+
+		context.tiles.push_back(tile);
+	}
+
+#ifndef NO_THREADS
+	if (context.tiles.size() > 1) {
+		ThreadWorkPool work_pool;
+		work_pool.init();
+		work_pool.do_work(context.tiles.size(), &context, &PandemoniumNavigationMeshGeneratorTileBakeContext::bake_tile, (void *)nullptr);
+		work_pool.finish();
+	} else if (context.tiles.size() == 1) {
+		context.bake_tile(0, nullptr);
+	}
+#else
+	for (uint32_t i = 0; i < context.tiles.size(); i++) {
+		context.bake_tile(i, nullptr);
+	}
+#endif // NO_THREADS
+
+	for (uint32_t i = 0; i < context.tiles.size(); i++) {
+		PandemoniumNavigationMeshGeneratorTileBakeContext::Tile &tile = context.tiles[i];
+
+		if (!tile.baked) {
+			// Left out of the cache, so the next bake tries this tile again.
+			continue;
+		}
+
+		Ref<NavigationMesh> tile_navigation_mesh;
+		tile_navigation_mesh.instance();
+		tile_navigation_mesh->set_cell_size(p_navigation_mesh->get_cell_size());
+		tile_navigation_mesh->set_cell_height(p_navigation_mesh->get_cell_height());
+		tile_navigation_mesh->set_vertices(tile.vertices);
+		tile_navigation_mesh->set_polygons(tile.polygons);
+		tile_navigation_mesh->commit_changes();
+
+		NavigationMesh::BakedTile baked_tile;
+		baked_tile.source_hash = tile.source_hash;
+		baked_tile.navigation_mesh = tile_navigation_mesh;
+		baked_tiles.insert(tile.coords, baked_tile);
+	}
+
+	// Stitch the tiles into the navigation mesh itself. Tile edges meet on the same cells,
+	// so the navigation map connects them the same way as any other shared edge.
+	PoolVector<Vector3> new_navigation_mesh_vertices;
+	Vector<Vector<int>> new_navigation_mesh_polygons;
+
+	for (const HashMap<Vector2i, NavigationMesh::BakedTile>::Element *E = baked_tiles.front(); E; E = E->next) {
+		const Ref<NavigationMesh> &tile_navigation_mesh = E->value().navigation_mesh;
+		const int vertex_offset = new_navigation_mesh_vertices.size();
+		const Vector<Vector<int>> &tile_polygons = tile_navigation_mesh->get_polygons();
+
+		new_navigation_mesh_vertices.append_array(tile_navigation_mesh->get_vertices());
+
+		for (int i = 0; i < tile_polygons.size(); i++) {
+			Vector<int> new_navigation_mesh_polygon = tile_polygons[i];
+			for (int j = 0; j < new_navigation_mesh_polygon.size(); j++) {
+				new_navigation_mesh_polygon.write[j] += vertex_offset;
+			}
+			new_navigation_mesh_polygons.push_back(new_navigation_mesh_polygon);
+		}
+	}
+
+	p_navigation_mesh->set_baked_tiles(baked_tiles);
+	p_navigation_mesh->set_vertices(new_navigation_mesh_vertices);
+	p_navigation_mesh->set_polygons(new_navigation_mesh_polygons);
+}
+
 void PandemoniumNavigationMeshGenerator::parse_and_bake_3d(Ref<NavigationMesh> p_navigation_mesh, Node *p_root_node, Ref<FuncRef> p_callback) {
 	ERR_FAIL_COND_MSG(_baking_navigation_meshes.find(p_navigation_mesh) >= 0, "NavigationMesh was already added to baking queue. Wait for current bake task to finish.");
 	ERR_FAIL_COND_MSG(p_root_node == nullptr, "avigationMesh requires a valid root node.");
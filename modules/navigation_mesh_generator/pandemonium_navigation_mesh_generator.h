@@ -144,6 +144,8 @@ public:
 	static void _static_parse_3d_geometry_node(Ref<NavigationMesh> p_navigation_mesh, Node *p_node, Ref<NavigationMeshSourceGeometryData3D> p_source_geometry_data, bool p_recurse_children, LocalVector<Ref<NavigationGeometryParser3D>> &p_geometry_3d_parsers);
 	static void _static_parse_3d_source_geometry_data(Ref<NavigationMesh> p_navigation_mesh, Node *p_root_node, Ref<NavigationMeshSourceGeometryData3D> p_source_geometry_data, LocalVector<Ref<NavigationGeometryParser3D>> &p_geometry_3d_parsers);
 	static void _static_bake_3d_from_source_geometry_data(Ref<NavigationMesh> p_navigation_mesh, Ref<NavigationMeshSourceGeometryData3D> p_source_geometry_data);
+	static void _static_bake_3d_tiles_from_source_geometry_data(Ref<NavigationMesh> p_navigation_mesh, Ref<NavigationMeshSourceGeometryData3D> p_source_geometry_data);
+	static bool _static_bake_3d_recast(Ref<NavigationMesh> p_navigation_mesh, const float *p_verts, int p_nverts, const int *p_tris, int p_ntris, const float *p_bmin, const float *p_bmax, int p_border_size, PoolVector<Vector3> &r_vertices, Vector<Vector<int>> &r_polygons);
 
 	virtual bool is_navigation_mesh_baking(Ref<NavigationMesh> p_navigation_mesh) const;
 #endif // _3D_DISABLED
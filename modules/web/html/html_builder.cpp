@@ -34,7 +34,8 @@
 #include "../http/web_server_request.h"
 
 HTMLTag *HTMLTag::str(const String &str) {
-	result += " " + str;
+	result += " ";
+	result += str;
 
 	return this;
 }
@@ -860,7 +861,11 @@ HTMLTag *HTMLTag::inputmode_url() {
 }
 
 HTMLTag *HTMLTag::attrib(const String &attr, const String &val) {
-	result += " " + attr + "=\"" + val + "\"";
+	result += " ";
+	result += attr;
+	result += "=\"";
+	result += val;
+	result += "\"";
 
 	return this;
 }
@@ -868,7 +873,8 @@ HTMLTag *HTMLTag::attrib(const String &attr, const String &val) {
 HTMLTag *HTMLTag::start(const String &p_tag, const bool p_simple) {
 	simple = p_simple;
 
-	result = "<" + p_tag;
+	result = "<";
+	result += p_tag;
 
 	return this;
 }
@@ -905,7 +911,9 @@ HTMLTag::HTMLTag() {
 HTMLBuilder *HTMLBuilder::comment(const String &val) {
 	write_tag();
 
-	result += "<!--" + val + "-->";
+	result += "<!--";
+	result += val;
+	result += "-->";
 
 	return this;
 }
@@ -919,7 +927,9 @@ HTMLTag *HTMLBuilder::doctype() {
 HTMLBuilder *HTMLBuilder::doctype(const String &val) {
 	write_tag();
 
-	result += "<!DOCTYPE " + val + ">";
+	result += "<!DOCTYPE ";
+	result += val;
+	result += ">";
 
 	return this;
 }
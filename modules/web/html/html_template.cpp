@@ -32,6 +32,7 @@
 #include "html_template.h"
 
 #include "core/containers/local_vector.h"
+#include "core/os/arena_allocator.h"
 
 #include "../http/web_server_request.h"
 #include "html_template_data.h"
@@ -596,6 +597,44 @@ method_name_search_done:
 	return call_template_method(call_method, final_values, first_var_decides_print);
 }
 
+// Same as r_result += p_text.substr_index(p_start_index, p_end_index), without the temporary String.
+static void _render_scratch_append_substr_index(ArenaVector<CharType> &r_result, const String &p_text, const int p_start_index, const int p_end_index) {
+	int s = p_text.length();
+
+	if (p_start_index < 0 || p_start_index >= s || p_end_index < 0 || p_start_index > p_end_index) {
+		return;
+	}
+
+	int count;
+	if (p_end_index > s) {
+		count = (s - 1) - p_start_index;
+	} else {
+		count = p_end_index - p_start_index;
+	}
+
+	if (count <= 0) {
+		return;
+	}
+
+	r_result.append_array(p_text.ptr() + p_start_index, count);
+}
+
+// String(const CharType *, int) stops at the first NUL, this keeps the full length like appending to a String did.
+static String _render_scratch_to_string(const ArenaVector<CharType> &p_result) {
+	String str;
+
+	if (p_result.empty()) {
+		return str;
+	}
+
+	str.resize(p_result.size() + 1);
+	CharType *dst = str.ptrw();
+	memcpy(dst, p_result.ptr(), p_result.size() * sizeof(CharType));
+	dst[p_result.size()] = 0;
+
+	return str;
+}
+
 String HTMLTemplate::render_template(const String &p_text, const Dictionary &p_data) {
 	// {\{ Escaped {{
 	// {\\{ -> {\{ etc
@@ -610,14 +649,18 @@ String HTMLTemplate::render_template(const String &p_text, const Dictionary &p_d
 	// {{ qprb(var) }} // Same as prb, but only prints when it's first argument evaluates to true
 	// {{ qvf("%d %d", var1, var2) }} // Same as vf, but only prints when it's first argument evaluates to true
 
-	String result;
-
 	int text_length = p_text.length();
 
 	if (text_length == 0) {
-		return result;
+		return String();
 	}
 
+	// The output is collected into scratch memory, and it's only turned into a String at the end.
+	// Small templates fit into the stack buffer, bigger ones usually need one allocation.
+	uint8_t scratch_buffer[RENDER_SCRATCH_STACK_SIZE];
+	ArenaAllocator scratch(scratch_buffer, RENDER_SCRATCH_STACK_SIZE, text_length * sizeof(CharType) + ArenaAllocator::DEFAULT_CHUNK_SIZE);
+	ArenaVector<CharType> result(&scratch);
+
 	int i = 0;
 	int last_section_start = 0;
 	bool in_string = false;
@@ -661,7 +704,7 @@ String HTMLTemplate::render_template(const String &p_text, const Dictionary &p_d
 							// We should have {\\\ .
 
 							// We cut
-							result += p_text.substr_index(last_section_start, i - 1);
+							_render_scratch_append_substr_index(result, p_text, last_section_start, i - 1);
 
 							// Don't append the now missing {, it will be appended on the next normal text cut
 
@@ -686,7 +729,7 @@ String HTMLTemplate::render_template(const String &p_text, const Dictionary &p_d
 						// i points to:       v
 						//               ... {{
 						// cut up to here:  ^   (Don't include {{ )
-						result += p_text.substr_index(last_section_start, i - 1);
+						_render_scratch_append_substr_index(result, p_text, last_section_start, i - 1);
 
 						// i points to:          v
 						//                  ... {{
@@ -794,7 +837,8 @@ String HTMLTemplate::render_template(const String &p_text, const Dictionary &p_d
 
 						String expression = p_text.substr_index(last_section_start, i - 2);
 
-						result += process_template_expression(expression, p_data);
+						String expression_result = process_template_expression(expression, p_data);
+						result.append_array(expression_result.ptr(), expression_result.length());
 
 						// i points to:          v
 						//                  ... {{
@@ -806,10 +850,10 @@ String HTMLTemplate::render_template(const String &p_text, const Dictionary &p_d
 					default: {
 						// Some other token encountered, error in template
 
-						result += p_text.substr_index(last_section_start, i);
+						_render_scratch_append_substr_index(result, p_text, last_section_start, i);
 
 						// Don't return half-rendered templates.
-						ERR_FAIL_V_MSG(String(), "Error in template! One missing closing bracket encountered. Generated html so far:\n\n" + result);
+						ERR_FAIL_V_MSG(String(), "Error in template! One missing closing bracket encountered. Generated html so far:\n\n" + _render_scratch_to_string(result));
 					} break;
 				}
 			} break;
@@ -823,11 +867,11 @@ String HTMLTemplate::render_template(const String &p_text, const Dictionary &p_d
 		if (in_string) {
 			String c;
 			c += current_string_type;
-			ERR_FAIL_V_MSG(String(), "Error in template! Unterminated string of type " + c + " encountered. Generated html so far:\n\n" + result);
+			ERR_FAIL_V_MSG(String(), "Error in template! Unterminated string of type " + c + " encountered. Generated html so far:\n\n" + _render_scratch_to_string(result));
 		}
 
 		if (current_state == RENDER_TEMPLATE_STATE_EXPRESSION || current_state == RENDER_TEMPLATE_STATE_EXPRESSION_END_NEXT) {
-			ERR_FAIL_V_MSG(String(), "Error in template! Unterminated expression encountered. Generated html so far:\n\n" + result);
+			ERR_FAIL_V_MSG(String(), "Error in template! Unterminated expression encountered. Generated html so far:\n\n" + _render_scratch_to_string(result));
 		}
 
 		// if current_state is RENDER_TEMPLATE_STATE_EXPRESSION_POTENTIAL_START, that is actually fine. Template just ends in {
@@ -837,10 +881,10 @@ String HTMLTemplate::render_template(const String &p_text, const Dictionary &p_d
 	// If the template closes with }}, last_section_start should be == to text_length
 	// If template closes like }}X last_section_start should be == to text_length - 1, in that case we still need to get the last character
 	if (last_section_start <= text_length - 1) {
-		result += p_text.substr_index(last_section_start, text_length);
+		_render_scratch_append_substr_index(result, p_text, last_section_start, text_length);
 	}
 
-	return result;
+	return _render_scratch_to_string(result);
 }
 
 String HTMLTemplate::get_and_render_template(const StringName &p_name, const Dictionary &p_data) {
@@ -111,6 +111,10 @@ public:
 	~HTMLTemplate();
 
 protected:
+	enum {
+		RENDER_SCRATCH_STACK_SIZE = 2048,
+	};
+
 	enum RenderTemplateState {
 		RENDER_TEMPLATE_STATE_NORMAL_TEXT = 0,
 		RENDER_TEMPLATE_STATE_EXPRESSION_POTENTIAL_START,
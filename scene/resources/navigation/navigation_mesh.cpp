@@ -296,6 +296,36 @@ Vector3 NavigationMesh::get_filter_baking_aabb_offset() const {
 	return filter_baking_aabb_offset;
 }
 
+void NavigationMesh::set_tile_size(float p_value) {
+	ERR_FAIL_COND(p_value < 0);
+	tile_size = p_value;
+	emit_changed();
+}
+
+float NavigationMesh::get_tile_size() const {
+	return tile_size;
+}
+
+const HashMap<Vector2i, NavigationMesh::BakedTile> &NavigationMesh::get_baked_tiles() const {
+	return baked_tiles;
+}
+
+void NavigationMesh::set_baked_tiles(const HashMap<Vector2i, BakedTile> &p_baked_tiles) {
+	baked_tiles = p_baked_tiles;
+}
+
+Dictionary NavigationMesh::get_tile_meshes() const {
+	Dictionary tile_meshes;
+	for (const HashMap<Vector2i, BakedTile>::Element *E = baked_tiles.front(); E; E = E->next) {
+		tile_meshes[E->key()] = E->value().navigation_mesh;
+	}
+	return tile_meshes;
+}
+
+void NavigationMesh::clear_tiles() {
+	baked_tiles.clear();
+}
+
 void NavigationMesh::set_vertices(const PoolVector<Vector3> &p_vertices) {
 	vertices = p_vertices;
 	navigation_mesh_dirty = true;
@@ -550,6 +580,12 @@ void NavigationMesh::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_filter_baking_aabb_offset", "baking_aabb_offset"), &NavigationMesh::set_filter_baking_aabb_offset);
 	ClassDB::bind_method(D_METHOD("get_filter_baking_aabb_offset"), &NavigationMesh::get_filter_baking_aabb_offset);
 
+	ClassDB::bind_method(D_METHOD("set_tile_size", "tile_size"), &NavigationMesh::set_tile_size);
+	ClassDB::bind_method(D_METHOD("get_tile_size"), &NavigationMesh::get_tile_size);
+
+	ClassDB::bind_method(D_METHOD("get_tile_meshes"), &NavigationMesh::get_tile_meshes);
+	ClassDB::bind_method(D_METHOD("clear_tiles"), &NavigationMesh::clear_tiles);
+
 	ClassDB::bind_method(D_METHOD("set_vertices", "vertices"), &NavigationMesh::set_vertices);
 	ClassDB::bind_method(D_METHOD("get_vertices"), &NavigationMesh::get_vertices);
 
@@ -610,6 +646,9 @@ void NavigationMesh::_bind_methods() {
 	ADD_PROPERTY(PropertyInfo(Variant::AABB, "filter_baking_aabb"), "set_filter_baking_aabb", "get_filter_baking_aabb");
 	ADD_PROPERTY(PropertyInfo(Variant::VECTOR3, "filter_baking_aabb_offset"), "set_filter_baking_aabb_offset", "get_filter_baking_aabb_offset");
 
+	ADD_GROUP("Tiles", "tile_");
+	ADD_PROPERTY(PropertyInfo(Variant::REAL, "tile_size", PROPERTY_HINT_RANGE, "0.0,1000.0,0.01,or_greater"), "set_tile_size", "get_tile_size");
+
 	BIND_ENUM_CONSTANT(SAMPLE_PARTITION_WATERSHED);
 	BIND_ENUM_CONSTANT(SAMPLE_PARTITION_MONOTONE);
 	BIND_ENUM_CONSTANT(SAMPLE_PARTITION_LAYERS);
@@ -684,6 +723,7 @@ NavigationMesh::NavigationMesh() {
 	filter_low_hanging_obstacles = false;
 	filter_ledge_spans = false;
 	filter_walkable_low_height_spans = false;
+	tile_size = 0.0f;
 
 	navigation_mesh_dirty = true;
 
@@ -32,6 +32,8 @@
 /* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
 /*************************************************************************/
 
+#include "core/containers/hash_map.h"
+#include "core/math/vector2i.h"
 #include "scene/resources/mesh/mesh.h"
 
 class Mesh;
@@ -64,6 +66,12 @@ public:
 		SOURCE_GEOMETRY_MAX
 	};
 
+	// Result of one tile of a tiled bake, keyed by its tile coordinates on the XZ plane.
+	struct BakedTile {
+		uint32_t source_hash = 0;
+		Ref<NavigationMesh> navigation_mesh;
+	};
+
 public:
 	// Recast settings
 	void set_sample_partition_type(SamplePartitionType p_value);
@@ -138,6 +146,15 @@ public:
 	void set_filter_baking_aabb_offset(const Vector3 &p_aabb_offset);
 	Vector3 get_filter_baking_aabb_offset() const;
 
+	void set_tile_size(float p_value);
+	float get_tile_size() const;
+
+	const HashMap<Vector2i, BakedTile> &get_baked_tiles() const;
+	void set_baked_tiles(const HashMap<Vector2i, BakedTile> &p_baked_tiles);
+
+	Dictionary get_tile_meshes() const;
+	void clear_tiles();
+
 	void create_from_mesh(const Ref<Mesh> &p_mesh);
 
 	void set_vertices(const PoolVector<Vector3> &p_vertices);
@@ -202,6 +219,8 @@ protected:
 	AABB filter_baking_aabb;
 	Vector3 filter_baking_aabb_offset;
 
+	float tile_size;
+
 private:
 	RID navigation_mesh_rid;
 
@@ -211,6 +230,8 @@ private:
 
 	Ref<ArrayMesh> debug_mesh;
 
+	HashMap<Vector2i, BakedTile> baked_tiles;
+
 	bool navigation_mesh_dirty;
 };
 
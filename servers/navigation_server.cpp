@@ -76,6 +76,12 @@ void NavigationServer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("map_get_closest_point_normal", "map", "to_point"), &NavigationServer::map_get_closest_point_normal);
 	ClassDB::bind_method(D_METHOD("map_get_closest_point_owner", "map", "to_point"), &NavigationServer::map_get_closest_point_owner);
 
+	ClassDB::bind_method(D_METHOD("map_get_flow_direction", "map", "goal", "position", "navigation_layers"), &NavigationServer::map_get_flow_direction, DEFVAL(1));
+	ClassDB::bind_method(D_METHOD("map_get_flow_distance", "map", "goal", "position", "navigation_layers"), &NavigationServer::map_get_flow_distance, DEFVAL(1));
+	ClassDB::bind_method(D_METHOD("map_request_flow_field", "map", "goal", "navigation_layers"), &NavigationServer::map_request_flow_field, DEFVAL(1));
+	ClassDB::bind_method(D_METHOD("map_is_flow_field_ready", "map", "goal", "navigation_layers"), &NavigationServer::map_is_flow_field_ready, DEFVAL(1));
+	ClassDB::bind_method(D_METHOD("map_clear_flow_fields", "map"), &NavigationServer::map_clear_flow_fields);
+
 	ClassDB::bind_method(D_METHOD("map_get_links", "map"), &NavigationServer::map_get_links);
 	ClassDB::bind_method(D_METHOD("map_get_regions", "map"), &NavigationServer::map_get_regions);
 	ClassDB::bind_method(D_METHOD("map_get_agents", "map"), &NavigationServer::map_get_agents);
@@ -83,6 +89,8 @@ void NavigationServer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("map_force_update", "map"), &NavigationServer::map_force_update);
 
 	ClassDB::bind_method(D_METHOD("query_path", "parameters", "result"), &NavigationServer::query_path);
+	ClassDB::bind_method(D_METHOD("query_path_batch", "parameters", "results", "object_id", "method", "userdata"), &NavigationServer::query_path_batch, DEFVAL(ObjectID(0)), DEFVAL(StringName()), DEFVAL(Variant()));
+	ClassDB::bind_method(D_METHOD("is_path_batch_done", "batch_id"), &NavigationServer::is_path_batch_done);
 
 	ClassDB::bind_method(D_METHOD("region_create"), &NavigationServer::region_create);
 	ClassDB::bind_method(D_METHOD("region_set_enabled", "region", "enabled"), &NavigationServer::region_set_enabled);
@@ -177,6 +185,7 @@ void NavigationServer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_active", "active"), &NavigationServer::set_active);
 
 	ClassDB::bind_method(D_METHOD("get_process_info", "process_info"), &NavigationServer::get_process_info);
+	ClassDB::bind_method(D_METHOD("map_get_process_info", "map", "process_info"), &NavigationServer::map_get_process_info);
 
 	ClassDB::bind_method(D_METHOD("set_debug_enabled", "enabled"), &NavigationServer::set_debug_enabled);
 	ClassDB::bind_method(D_METHOD("get_debug_enabled"), &NavigationServer::get_debug_enabled);
@@ -194,10 +203,20 @@ void NavigationServer::_bind_methods() {
 	BIND_ENUM_CONSTANT(INFO_EDGE_MERGE_COUNT);
 	BIND_ENUM_CONSTANT(INFO_EDGE_CONNECTION_COUNT);
 	BIND_ENUM_CONSTANT(INFO_EDGE_FREE_COUNT);
+	BIND_ENUM_CONSTANT(INFO_SYNC_TIME);
+	BIND_ENUM_CONSTANT(INFO_AVOIDANCE_TIME);
+	BIND_ENUM_CONSTANT(INFO_CALLBACK_TIME);
+	BIND_ENUM_CONSTANT(INFO_PATH_QUERY_COUNT);
+	BIND_ENUM_CONSTANT(INFO_PATH_QUERY_TIME);
+	BIND_ENUM_CONSTANT(INFO_FLOW_FIELD_COUNT);
 
 	GLOBAL_DEF("navigation/avoidance/thread_model/avoidance_use_multiple_threads", true);
 	GLOBAL_DEF("navigation/avoidance/thread_model/avoidance_use_high_priority_threads", true);
 
+	GLOBAL_DEF("navigation/pathfinding/use_hierarchical_pathfinding", false);
+	GLOBAL_DEF("navigation/pathfinding/hierarchical_cluster_size", 32.0);
+	ProjectSettings::get_singleton()->set_custom_property_info("navigation/pathfinding/hierarchical_cluster_size", PropertyInfo(Variant::REAL, "navigation/pathfinding/hierarchical_cluster_size", PROPERTY_HINT_RANGE, "1,1024,0.1,or_greater"));
+
 #ifdef DEBUG_ENABLED
 	ClassDB::bind_method(D_METHOD("_emit_navigation_debug_changed_signal"), &NavigationServer::_emit_navigation_debug_changed_signal);
 	ClassDB::bind_method(D_METHOD("_emit_avoidance_debug_changed_signal"), &NavigationServer::_emit_avoidance_debug_changed_signal);
@@ -915,6 +934,27 @@ void NavigationServer::query_path(const Ref<NavigationPathQueryParameters3D> &p_
 	p_query_result->set_from_query_result(_query_result);
 }
 
+uint32_t NavigationServer::query_path_batch(const Array &p_query_parameters, const Array &p_query_results, ObjectID p_object_id, const StringName &p_method, const Variant &p_udata) {
+	ERR_FAIL_COND_V(p_query_parameters.size() != p_query_results.size(), 0);
+
+	Vector<NavigationUtilities::PathQueryParameters> parameters;
+	Vector<Ref<NavigationPathQueryResult3D>> results;
+	parameters.resize(p_query_parameters.size());
+	results.resize(p_query_results.size());
+
+	for (int i = 0; i < p_query_parameters.size(); i++) {
+		Ref<NavigationPathQueryParameters3D> query_parameters = p_query_parameters[i];
+		Ref<NavigationPathQueryResult3D> query_result = p_query_results[i];
+		ERR_FAIL_COND_V(!query_parameters.is_valid(), 0);
+		ERR_FAIL_COND_V(!query_result.is_valid(), 0);
+
+		parameters.write[i] = query_parameters->get_parameters();
+		results.write[i] = query_result;
+	}
+
+	return _query_path_batch(parameters, results, p_object_id, p_method, p_udata);
+}
+
 Vector<NavigationServerManager::ClassInfo> NavigationServerManager::navigation_servers;
 int NavigationServerManager::default_server_id = -1;
 int NavigationServerManager::default_server_priority = -1;
@@ -113,6 +113,16 @@ public:
 	virtual Vector3 map_get_closest_point_normal(RID p_map, const Vector3 &p_point) const = 0;
 	virtual RID map_get_closest_point_owner(RID p_map, const Vector3 &p_point) const = 0;
 
+	/// Flow fields: every query to the same goal with the same layers samples one
+	/// field of distances to the goal, built on a worker thread and rebuilt when
+	/// the map changes. The direction is zero while the field is not built yet.
+	virtual Vector3 map_get_flow_direction(RID p_map, const Vector3 &p_goal, const Vector3 &p_position, uint32_t p_navigation_layers = 1) const = 0;
+	/// Returns the travel cost to the goal, or -1 when it is unknown or can't be reached.
+	virtual real_t map_get_flow_distance(RID p_map, const Vector3 &p_goal, const Vector3 &p_position, uint32_t p_navigation_layers = 1) const = 0;
+	virtual void map_request_flow_field(RID p_map, const Vector3 &p_goal, uint32_t p_navigation_layers = 1) = 0;
+	virtual bool map_is_flow_field_ready(RID p_map, const Vector3 &p_goal, uint32_t p_navigation_layers = 1) const = 0;
+	virtual void map_clear_flow_fields(RID p_map) = 0;
+
 	virtual Array map_get_links(RID p_map) const = 0;
 	virtual Array map_get_regions(RID p_map) const = 0;
 	virtual Array map_get_agents(RID p_map) const = 0;
@@ -306,6 +316,17 @@ public:
 
 	virtual NavigationUtilities::PathQueryResult _query_path(const NavigationUtilities::PathQueryParameters &p_parameters) const = 0;
 
+	/// Queues path queries to run on worker threads, each against the state of
+	/// its map at the time of the call. The results are written and the
+	/// callback is called from `process`, on the main thread.
+	/// Returns the id of the batch, 0 on failure.
+	uint32_t query_path_batch(const Array &p_query_parameters, const Array &p_query_results, ObjectID p_object_id = ObjectID(0), const StringName &p_method = StringName(), const Variant &p_udata = Variant());
+
+	virtual uint32_t _query_path_batch(const Vector<NavigationUtilities::PathQueryParameters> &p_parameters, const Vector<Ref<NavigationPathQueryResult3D>> &p_results, ObjectID p_object_id, const StringName &p_method, const Variant &p_udata) = 0;
+
+	/// Returns true once the results of the batch are written.
+	virtual bool is_path_batch_done(uint32_t p_batch_id) const = 0;
+
 	virtual void init();
 	virtual void finish();
 
@@ -319,10 +340,19 @@ public:
 		INFO_EDGE_MERGE_COUNT,
 		INFO_EDGE_CONNECTION_COUNT,
 		INFO_EDGE_FREE_COUNT,
+		INFO_SYNC_TIME,
+		INFO_AVOIDANCE_TIME,
+		INFO_CALLBACK_TIME,
+		INFO_PATH_QUERY_COUNT,
+		INFO_PATH_QUERY_TIME,
+		INFO_FLOW_FIELD_COUNT,
 	};
 
 	virtual int get_process_info(ProcessInfo p_info) const = 0;
 
+	/// Same as `get_process_info`, for one map only.
+	virtual int map_get_process_info(RID p_map, ProcessInfo p_info) const = 0;
+
 	NavigationServer();
 	virtual ~NavigationServer();
 
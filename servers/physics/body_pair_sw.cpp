@@ -198,27 +198,46 @@ real_t combine_friction(BodySW *A, BodySW *B) {
 	return ABS(MIN(A->get_friction(), B->get_friction()));
 }
 
-bool BodyPairSW::setup(real_t p_step) {
+void BodyPairSW::generate_contacts(real_t p_step) {
 	//cannot collide
 	if (!A->test_collision_mask(B) || A->has_exception(B->get_self()) || B->has_exception(A->get_self())) {
 		collided = false;
-		return false;
+		check_collision = false;
+		return;
 	}
 
-	bool report_contacts_only = false;
+	report_contacts_only = false;
 	if ((A->get_mode() <= PhysicsServer::BODY_MODE_KINEMATIC) && (B->get_mode() <= PhysicsServer::BODY_MODE_KINEMATIC)) {
 		if ((A->get_max_contacts_reported() > 0) || (B->get_max_contacts_reported() > 0)) {
 			report_contacts_only = true;
 		} else {
 			collided = false;
-			return false;
+			check_collision = false;
+			return;
 		}
 	}
 
+	check_collision = true;
+
 	offset_B = B->get_transform().get_origin() - A->get_transform().get_origin();
 
 	validate_contacts();
 
+	Transform xform_Au = Transform(A->get_transform().basis, Vector3());
+	Transform xform_A = xform_Au * A->get_shape_transform(shape_A);
+
+	Transform xform_Bu = B->get_transform();
+	xform_Bu.origin -= A->get_transform().get_origin();
+	Transform xform_B = xform_Bu * B->get_shape_transform(shape_B);
+
+	collided = CollisionSolverSW::solve_static(A->get_shape(shape_A), xform_A, B->get_shape(shape_B), xform_B, _contact_added_callback, this, &sep_axis);
+}
+
+bool BodyPairSW::setup(real_t p_step) {
+	if (!check_collision) {
+		return false;
+	}
+
 	Vector3 offset_A = A->get_transform().get_origin();
 	Transform xform_Au = Transform(A->get_transform().basis, Vector3());
 	Transform xform_A = xform_Au * A->get_shape_transform(shape_A);
@@ -230,11 +249,9 @@ bool BodyPairSW::setup(real_t p_step) {
 	ShapeSW *shape_A_ptr = A->get_shape(shape_A);
 	ShapeSW *shape_B_ptr = B->get_shape(shape_B);
 
-	bool collided = CollisionSolverSW::solve_static(shape_A_ptr, xform_A, shape_B_ptr, xform_B, _contact_added_callback, this, &sep_axis);
-	this->collided = collided;
-
 	if (!collided) {
 		//test ccd (currently just a raycast)
+		//done here rather than in generate_contacts(), as it changes the velocity of the body
 
 		if (A->is_continuous_collision_detection_enabled() && A->get_mode() > PhysicsServer::BODY_MODE_KINEMATIC && B->get_mode() <= PhysicsServer::BODY_MODE_KINEMATIC) {
 			_test_ccd(p_step, A, shape_A, xform_A, B, shape_B, xform_B);
@@ -263,6 +280,9 @@ bool BodyPairSW::setup(real_t p_step) {
 
 	real_t inv_dt = 1.0 / p_step;
 
+	// Static and kinematic bodies can be part of several islands being set up in parallel.
+	bool lock_contact_report = (A->can_report_contacts() && A->get_mode() <= PhysicsServer::BODY_MODE_KINEMATIC) || (B->can_report_contacts() && B->get_mode() <= PhysicsServer::BODY_MODE_KINEMATIC);
+
 	for (int i = 0; i < contact_count; i++) {
 		Contact &c = contacts[i];
 		c.active = false;
@@ -289,6 +309,10 @@ bool BodyPairSW::setup(real_t p_step) {
 
 		// contact query reporting...
 
+		if (lock_contact_report) {
+			space->get_shared_state_lock().lock();
+		}
+
 		if (A->can_report_contacts()) {
 			Vector3 crA = A->get_angular_velocity().cross(c.rA) + A->get_linear_velocity();
 			A->add_contact(global_A, -c.normal, depth, shape_A, global_B, shape_B, B->get_instance_id(), B->get_self(), crA);
@@ -299,6 +323,10 @@ bool BodyPairSW::setup(real_t p_step) {
 			B->add_contact(global_B, c.normal, depth, shape_B, global_A, shape_A, A->get_instance_id(), A->get_self(), crB);
 		}
 
+		if (lock_contact_report) {
+			space->get_shared_state_lock().unlock();
+		}
+
 		if (report_contacts_only) {
 			collided = false;
 			continue;
@@ -450,8 +478,51 @@ void BodyPairSW::solve(real_t p_step) {
 	}
 }
 
+void BodyPairSW::get_snapshot_state(SnapshotState &r_state) const {
+	r_state.offset_B = offset_B;
+	r_state.sep_axis = sep_axis;
+	for (int i = 0; i < contact_count; i++) {
+		r_state.contacts[i] = contacts[i];
+	}
+	r_state.contact_count = contact_count;
+	r_state.collided = collided;
+}
+
+void BodyPairSW::set_snapshot_state(const SnapshotState &p_state) {
+	ERR_FAIL_INDEX(p_state.contact_count, MAX_CONTACTS + 1);
+
+	offset_B = p_state.offset_B;
+	sep_axis = p_state.sep_axis;
+	for (int i = 0; i < p_state.contact_count; i++) {
+		contacts[i] = p_state.contacts[i];
+	}
+	contact_count = p_state.contact_count;
+	collided = p_state.collided;
+}
+
+// Turns a state saved with the bodies in one order into the state of the same
+// pair with A and B exchanged. The impulse applied to each body must stay the
+// same, so with the normal flipped only the parts that don't follow it change.
+void BodyPairSW::swap_snapshot_state(SnapshotState &r_state) {
+	r_state.offset_B = -r_state.offset_B;
+	r_state.sep_axis = -r_state.sep_axis;
+	for (int i = 0; i < r_state.contact_count; i++) {
+		Contact &c = r_state.contacts[i];
+		SWAP(c.local_A, c.local_B);
+		SWAP(c.rA, c.rB);
+		c.normal = -c.normal;
+		c.acc_tangent_impulse = -c.acc_tangent_impulse;
+	}
+}
+
+void BodyPairSW::clear_contacts() {
+	contact_count = 0;
+	collided = false;
+}
+
 BodyPairSW::BodyPairSW(BodySW *p_A, int p_shape_A, BodySW *p_B, int p_shape_B) :
-		ConstraintSW(_arr, 2) {
+		ConstraintSW(_arr, 2),
+		space_list(this) {
 	A = p_A;
 	B = p_B;
 	shape_A = p_shape_A;
@@ -461,6 +532,9 @@ BodyPairSW::BodyPairSW(BodySW *p_A, int p_shape_A, BodySW *p_B, int p_shape_B) :
 	B->add_constraint(this, 1);
 	contact_count = 0;
 	collided = false;
+	check_collision = false;
+	report_contacts_only = false;
+	space->body_pair_add_to_list(&space_list);
 }
 
 BodyPairSW::~BodyPairSW() {
@@ -76,6 +76,8 @@ class BodyPairSW : public ConstraintSW {
 	Contact contacts[MAX_CONTACTS];
 	int contact_count;
 	bool collided;
+	bool check_collision;
+	bool report_contacts_only;
 
 	static void _contact_added_callback(const Vector3 &p_point_A, const Vector3 &p_point_B, void *p_userdata);
 
@@ -85,8 +87,29 @@ class BodyPairSW : public ConstraintSW {
 	bool _test_ccd(real_t p_step, BodySW *p_A, int p_shape_A, const Transform &p_xform_A, BodySW *p_B, int p_shape_B, const Transform &p_xform_B);
 
 	SpaceSW *space;
+	SelfList<BodyPairSW> space_list;
 
 public:
+	// Contact cache saved and restored by space snapshots, see SpaceSW::get_snapshot().
+	struct SnapshotState {
+		Vector3 offset_B;
+		Vector3 sep_axis;
+		Contact contacts[MAX_CONTACTS];
+		int contact_count;
+		bool collided;
+	};
+
+	_FORCE_INLINE_ BodySW *get_body_a() const { return A; }
+	_FORCE_INLINE_ BodySW *get_body_b() const { return B; }
+	_FORCE_INLINE_ int get_shape_a() const { return shape_A; }
+	_FORCE_INLINE_ int get_shape_b() const { return shape_B; }
+
+	void get_snapshot_state(SnapshotState &r_state) const;
+	void set_snapshot_state(const SnapshotState &p_state);
+	static void swap_snapshot_state(SnapshotState &r_state);
+	void clear_contacts();
+
+	void generate_contacts(real_t p_step);
 	bool setup(real_t p_step);
 	void solve(real_t p_step);
 
@@ -0,0 +1,243 @@
+/*************************************************************************/
+/*  body_state_storage_sw.cpp                                            */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "body_state_storage_sw.h"
+
+// The loops below only index the arrays of one block with the lane of the body,
+// and replace the branches of BodySW's scalar code with selects, so the compiler
+// is free to process several bodies per instruction. Square roots and sines are
+// calls that may set errno, which stops that, so they get loops of their own.
+
+static _FORCE_INLINE_ void _invert_lengths(real_t *r_lengths_squared, uint32_t p_count) {
+	for (uint32_t j = 0; j < p_count; j++) {
+		r_lengths_squared[j] = 1 / Math::sqrt(r_lengths_squared[j]);
+	}
+}
+
+void BodyStateStorageSW::resize(uint32_t p_count) {
+	count = p_count;
+	blocks.resize((p_count + BATCH_SIZE - 1) / BATCH_SIZE);
+}
+
+void BodyStateStorageSW::clear_body(uint32_t p_id) {
+	for (int i = 0; i < COMPONENT_MAX; i++) {
+		set_scalar(i, p_id, 0);
+	}
+
+	set_basis(BASIS, p_id, Basis());
+	set_basis(PRINCIPAL_INERTIA_AXES_LOCAL, p_id, Basis());
+	set_scalar(LINEAR_DAMP, p_id, 1);
+	set_scalar(ANGULAR_DAMP, p_id, 1);
+}
+
+void BodyStateStorageSW::integrate_forces(uint32_t p_batch, real_t p_step) {
+	uint32_t n = MIN(count - p_batch * BATCH_SIZE, (uint32_t)BATCH_SIZE);
+	real_t(*c)[BATCH_SIZE] = blocks[p_batch].components;
+
+	for (uint32_t j = 0; j < n; j++) {
+		real_t linear_scale = c[INV_MASS][j] * p_step;
+
+		c[LINEAR_VELOCITY][j] = c[LINEAR_VELOCITY][j] * c[LINEAR_DAMP][j] + c[FORCE][j] * linear_scale;
+		c[LINEAR_VELOCITY + 1][j] = c[LINEAR_VELOCITY + 1][j] * c[LINEAR_DAMP][j] + c[FORCE + 1][j] * linear_scale;
+		c[LINEAR_VELOCITY + 2][j] = c[LINEAR_VELOCITY + 2][j] * c[LINEAR_DAMP][j] + c[FORCE + 2][j] * linear_scale;
+
+		real_t tx = c[TORQUE][j];
+		real_t ty = c[TORQUE + 1][j];
+		real_t tz = c[TORQUE + 2][j];
+
+		for (int k = 0; k < 3; k++) {
+			const real_t *t = c[INV_INERTIA_TENSOR + k * 3];
+			c[ANGULAR_VELOCITY + k][j] = c[ANGULAR_VELOCITY + k][j] * c[ANGULAR_DAMP][j] + (t[j] * tx + t[BATCH_SIZE + j] * ty + t[BATCH_SIZE * 2 + j] * tz) * p_step;
+		}
+	}
+}
+
+void BodyStateStorageSW::integrate_velocities(uint32_t p_batch, real_t p_step) {
+	uint32_t n = MIN(count - p_batch * BATCH_SIZE, (uint32_t)BATCH_SIZE);
+	real_t(*c)[BATCH_SIZE] = blocks[p_batch].components;
+
+	// inverse of the angular speed, 0 for the bodies that don't rotate
+	real_t inv_speed[BATCH_SIZE];
+	real_t sine[BATCH_SIZE];
+	real_t cosine[BATCH_SIZE];
+	// rotated basis (row major) and origin
+	real_t rb[9][BATCH_SIZE];
+	real_t ro[3][BATCH_SIZE];
+	real_t inv_len[BATCH_SIZE];
+
+	for (uint32_t j = 0; j < n; j++) {
+		real_t speed_squared = 0;
+		for (int k = 0; k < 3; k++) {
+			real_t tav = c[ANGULAR_VELOCITY + k][j] + c[BIASED_ANGULAR_VELOCITY + k][j];
+			speed_squared += tav * tav;
+		}
+		inv_speed[j] = speed_squared;
+	}
+
+	for (uint32_t j = 0; j < n; j++) {
+		real_t speed = Math::sqrt(inv_speed[j]);
+		bool rotates = speed >= (real_t)CMP_EPSILON;
+		real_t phi = rotates ? speed * p_step : 0;
+		sine[j] = Math::sin(phi);
+		cosine[j] = Math::cos(phi);
+		inv_speed[j] = rotates ? 1 / speed : 0;
+	}
+
+	for (uint32_t j = 0; j < n; j++) {
+		// rotation around the center of mass, see Basis::set_axis_angle()
+		real_t ax = (c[ANGULAR_VELOCITY][j] + c[BIASED_ANGULAR_VELOCITY][j]) * inv_speed[j];
+		real_t ay = (c[ANGULAR_VELOCITY + 1][j] + c[BIASED_ANGULAR_VELOCITY + 1][j]) * inv_speed[j];
+		real_t az = (c[ANGULAR_VELOCITY + 2][j] + c[BIASED_ANGULAR_VELOCITY + 2][j]) * inv_speed[j];
+		real_t t = 1 - cosine[j];
+
+		real_t r[9];
+		r[0] = ax * ax + cosine[j] * (1 - ax * ax);
+		r[4] = ay * ay + cosine[j] * (1 - ay * ay);
+		r[8] = az * az + cosine[j] * (1 - az * az);
+		r[1] = ax * ay * t - az * sine[j];
+		r[3] = ax * ay * t + az * sine[j];
+		r[2] = ax * az * t + ay * sine[j];
+		r[6] = ax * az * t - ay * sine[j];
+		r[5] = ay * az * t - ax * sine[j];
+		r[7] = ay * az * t + ax * sine[j];
+
+		// rb = rot * basis
+		for (int row = 0; row < 3; row++) {
+			for (int col = 0; col < 3; col++) {
+				rb[row * 3 + col][j] = r[row * 3] * c[BASIS + col][j] + r[row * 3 + 1] * c[BASIS + 3 + col][j] + r[row * 3 + 2] * c[BASIS + 6 + col][j];
+			}
+		}
+
+		// origin += (basis - rot * basis) * center_of_mass_local
+		for (int row = 0; row < 3; row++) {
+			ro[row][j] = c[ORIGIN + row][j];
+			for (int col = 0; col < 3; col++) {
+				ro[row][j] += (c[BASIS + row * 3 + col][j] - rb[row * 3 + col][j]) * c[CENTER_OF_MASS_LOCAL + col][j];
+			}
+		}
+
+		inv_len[j] = rb[0][j] * rb[0][j] + rb[3][j] * rb[3][j] + rb[6][j] * rb[6][j];
+	}
+
+	// Gram-Schmidt on the columns, see Basis::orthonormalize()
+	_invert_lengths(inv_len, n);
+
+	for (uint32_t j = 0; j < n; j++) {
+		for (int k = 0; k < 9; k += 3) {
+			rb[k][j] *= inv_len[j];
+		}
+		real_t d = rb[0][j] * rb[1][j] + rb[3][j] * rb[4][j] + rb[6][j] * rb[7][j];
+		for (int k = 0; k < 9; k += 3) {
+			rb[k + 1][j] -= rb[k][j] * d;
+		}
+		inv_len[j] = rb[1][j] * rb[1][j] + rb[4][j] * rb[4][j] + rb[7][j] * rb[7][j];
+	}
+
+	_invert_lengths(inv_len, n);
+
+	for (uint32_t j = 0; j < n; j++) {
+		for (int k = 0; k < 9; k += 3) {
+			rb[k + 1][j] *= inv_len[j];
+		}
+		real_t dx = rb[0][j] * rb[2][j] + rb[3][j] * rb[5][j] + rb[6][j] * rb[8][j];
+		real_t dy = rb[1][j] * rb[2][j] + rb[4][j] * rb[5][j] + rb[7][j] * rb[8][j];
+		for (int k = 0; k < 9; k += 3) {
+			rb[k + 2][j] -= rb[k][j] * dx + rb[k + 1][j] * dy;
+		}
+		inv_len[j] = rb[2][j] * rb[2][j] + rb[5][j] * rb[5][j] + rb[8][j] * rb[8][j];
+	}
+
+	_invert_lengths(inv_len, n);
+
+	for (int k = 2; k < 9; k += 3) {
+		for (uint32_t j = 0; j < n; j++) {
+			rb[k][j] *= inv_len[j];
+		}
+	}
+
+	// bodies that don't rotate keep their basis untouched, as in BodySW
+	for (int k = 0; k < 9; k++) {
+		for (uint32_t j = 0; j < n; j++) {
+			real_t kept = c[BASIS + k][j];
+			rb[k][j] = inv_speed[j] > 0 ? rb[k][j] : kept;
+		}
+	}
+	for (int k = 0; k < 3; k++) {
+		for (uint32_t j = 0; j < n; j++) {
+			real_t kept = c[ORIGIN + k][j];
+			ro[k][j] = inv_speed[j] > 0 ? ro[k][j] : kept;
+		}
+	}
+
+	for (uint32_t j = 0; j < n; j++) {
+		real_t b[9];
+		for (int k = 0; k < 9; k++) {
+			b[k] = rb[k][j];
+			c[BASIS + k][j] = b[k];
+		}
+
+		real_t o[3];
+		for (int k = 0; k < 3; k++) {
+			o[k] = ro[k][j] + (c[LINEAR_VELOCITY + k][j] + c[BIASED_LINEAR_VELOCITY + k][j]) * p_step;
+			c[ORIGIN + k][j] = o[k];
+		}
+
+		// orthonormal inverse, see Transform::inverse()
+		for (int k = 0; k < 3; k++) {
+			c[INV_ORIGIN + k][j] = -(b[k] * o[0] + b[3 + k] * o[1] + b[6 + k] * o[2]);
+		}
+
+		// center_of_mass = basis * center_of_mass_local
+		for (int k = 0; k < 3; k++) {
+			c[CENTER_OF_MASS + k][j] = b[k * 3] * c[CENTER_OF_MASS_LOCAL][j] + b[k * 3 + 1] * c[CENTER_OF_MASS_LOCAL + 1][j] + b[k * 3 + 2] * c[CENTER_OF_MASS_LOCAL + 2][j];
+		}
+
+		// principal_inertia_axes = basis * principal_inertia_axes_local
+		real_t p[9];
+		for (int row = 0; row < 3; row++) {
+			for (int col = 0; col < 3; col++) {
+				p[row * 3 + col] = b[row * 3] * c[PRINCIPAL_INERTIA_AXES_LOCAL + col][j] + b[row * 3 + 1] * c[PRINCIPAL_INERTIA_AXES_LOCAL + 3 + col][j] + b[row * 3 + 2] * c[PRINCIPAL_INERTIA_AXES_LOCAL + 6 + col][j];
+				c[PRINCIPAL_INERTIA_AXES + row * 3 + col][j] = p[row * 3 + col];
+			}
+		}
+
+		// inv_inertia_tensor = principal * diag(inv_inertia) * principal^T
+		for (int row = 0; row < 3; row++) {
+			for (int col = 0; col < 3; col++) {
+				c[INV_INERTIA_TENSOR + row * 3 + col][j] = p[row * 3] * c[INV_INERTIA][j] * p[col * 3] + p[row * 3 + 1] * c[INV_INERTIA + 1][j] * p[col * 3 + 1] + p[row * 3 + 2] * c[INV_INERTIA + 2][j] * p[col * 3 + 2];
+			}
+		}
+	}
+}
+
+BodyStateStorageSW::BodyStateStorageSW() {
+	count = 0;
+}
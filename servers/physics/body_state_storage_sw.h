@@ -0,0 +1,145 @@
+#ifndef BODY_STATE_STORAGE_SW_H
+#define BODY_STATE_STORAGE_SW_H
+
+/*************************************************************************/
+/*  body_state_storage_sw.h                                              */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "core/containers/local_vector.h"
+#include "core/math/transform.h"
+
+// Hot integration state of the active bodies of a step, mirrored from BodySW
+// into one array per scalar component. A body's dense id is its index in the
+// step's active list, and the arrays are cut in blocks of BATCH_SIZE ids, one
+// for each batch of the step. The kernels walk a block linearly and without
+// branches, so the compiler can process several bodies at once, and the
+// batches running on other threads never share a block.
+//
+// BodySW stays the owner of its state and the front end. Each pass copies the
+// state of the body into its slot, the kernel runs over the block, and BodySW
+// reads the results back, see BodySW::integrate_forces().
+class BodyStateStorageSW {
+public:
+	enum {
+		BATCH_SIZE = 64,
+	};
+
+	// First component of each value, vectors take 3 and bases 9 (row major).
+	enum Component {
+		ORIGIN = 0,
+		BASIS = ORIGIN + 3,
+		INV_ORIGIN = BASIS + 9,
+		LINEAR_VELOCITY = INV_ORIGIN + 3,
+		ANGULAR_VELOCITY = LINEAR_VELOCITY + 3,
+		BIASED_LINEAR_VELOCITY = ANGULAR_VELOCITY + 3,
+		BIASED_ANGULAR_VELOCITY = BIASED_LINEAR_VELOCITY + 3,
+		FORCE = BIASED_ANGULAR_VELOCITY + 3, // gravity included
+		TORQUE = FORCE + 3,
+		INV_MASS = TORQUE + 3,
+		INV_INERTIA = INV_MASS + 1,
+		INV_INERTIA_TENSOR = INV_INERTIA + 3,
+		PRINCIPAL_INERTIA_AXES_LOCAL = INV_INERTIA_TENSOR + 9,
+		PRINCIPAL_INERTIA_AXES = PRINCIPAL_INERTIA_AXES_LOCAL + 9,
+		CENTER_OF_MASS_LOCAL = PRINCIPAL_INERTIA_AXES + 9,
+		CENTER_OF_MASS = CENTER_OF_MASS_LOCAL + 3,
+		LINEAR_DAMP = CENTER_OF_MASS + 3, // already scaled by the step, 1 keeps the velocity
+		ANGULAR_DAMP = LINEAR_DAMP + 1,
+		COMPONENT_MAX = ANGULAR_DAMP + 1
+	};
+
+private:
+	// Fixed size, so the compiler sees that the components don't overlap.
+	struct Block {
+		real_t components[COMPONENT_MAX][BATCH_SIZE];
+	};
+
+	LocalVector<Block> blocks;
+	uint32_t count;
+
+	_FORCE_INLINE_ real_t *_slot(int p_component, uint32_t p_id) {
+		return &blocks[p_id / BATCH_SIZE].components[p_component][p_id % BATCH_SIZE];
+	}
+	_FORCE_INLINE_ const real_t *_slot(int p_component, uint32_t p_id) const {
+		return &blocks[p_id / BATCH_SIZE].components[p_component][p_id % BATCH_SIZE];
+	}
+
+public:
+	_FORCE_INLINE_ uint32_t size() const { return count; }
+	// The slots are not kept, they are filled again after every resize.
+	void resize(uint32_t p_count);
+
+	_FORCE_INLINE_ void set_scalar(int p_component, uint32_t p_id, real_t p_value) {
+		*_slot(p_component, p_id) = p_value;
+	}
+	_FORCE_INLINE_ real_t get_scalar(int p_component, uint32_t p_id) const {
+		return *_slot(p_component, p_id);
+	}
+
+	_FORCE_INLINE_ void set_vector3(int p_component, uint32_t p_id, const Vector3 &p_value) {
+		real_t *d = _slot(p_component, p_id);
+		d[0] = p_value.x;
+		d[BATCH_SIZE] = p_value.y;
+		d[BATCH_SIZE * 2] = p_value.z;
+	}
+	_FORCE_INLINE_ Vector3 get_vector3(int p_component, uint32_t p_id) const {
+		const real_t *d = _slot(p_component, p_id);
+		return Vector3(d[0], d[BATCH_SIZE], d[BATCH_SIZE * 2]);
+	}
+
+	_FORCE_INLINE_ void set_basis(int p_component, uint32_t p_id, const Basis &p_value) {
+		real_t *d = _slot(p_component, p_id);
+		for (int i = 0; i < 3; i++) {
+			for (int j = 0; j < 3; j++) {
+				d[(i * 3 + j) * BATCH_SIZE] = p_value.rows[i][j];
+			}
+		}
+	}
+	_FORCE_INLINE_ Basis get_basis(int p_component, uint32_t p_id) const {
+		const real_t *d = _slot(p_component, p_id);
+		return Basis(
+				d[0], d[BATCH_SIZE], d[BATCH_SIZE * 2],
+				d[BATCH_SIZE * 3], d[BATCH_SIZE * 4], d[BATCH_SIZE * 5],
+				d[BATCH_SIZE * 6], d[BATCH_SIZE * 7], d[BATCH_SIZE * 8]);
+	}
+
+	// Fills a slot so both kernels leave it unchanged, for the bodies that are
+	// not integrated here (static and kinematic ones).
+	void clear_body(uint32_t p_id);
+
+	// Damping, gravity and applied forces into the velocities, for the ids of a batch.
+	void integrate_forces(uint32_t p_batch, real_t p_step);
+	// Velocities into the transforms, along with the inverse transforms, the center
+	// of mass and the inertia tensor that depend on them, for the ids of a batch.
+	void integrate_velocities(uint32_t p_batch, real_t p_step);
+
+	BodyStateStorageSW();
+};
+
+#endif // BODY_STATE_STORAGE_SW_H
@@ -153,6 +153,29 @@ void BodySW::update_inertias() {
 	_update_transform_dependant();
 }
 
+void BodySW::get_snapshot_state(SnapshotState &r_state) const {
+	r_state.transform = get_transform();
+	r_state.linear_velocity = linear_velocity;
+	r_state.angular_velocity = angular_velocity;
+	r_state.still_time = still_time;
+	r_state.active = active;
+}
+
+void BodySW::set_snapshot_state(const SnapshotState &p_state) {
+	_set_transform(p_state.transform);
+	_set_inv_transform(p_state.transform.affine_inverse());
+	new_transform = p_state.transform;
+	_update_transform_dependant();
+
+	linear_velocity = p_state.linear_velocity;
+	angular_velocity = p_state.angular_velocity;
+	biased_linear_velocity = Vector3();
+	biased_angular_velocity = Vector3();
+	still_time = p_state.still_time;
+
+	set_active(p_state.active);
+}
+
 void BodySW::set_active(bool p_active) {
 	if (active == p_active) {
 		return;
@@ -446,8 +469,9 @@ bool BodySW::is_axis_locked(PhysicsServer::BodyAxis p_axis) const {
 	return locked_axis & p_axis;
 }
 
-void BodySW::integrate_forces(real_t p_step) {
+void BodySW::integrate_forces(real_t p_step, BodyStateStorageSW *p_states, uint32_t p_id) {
 	if (mode == PhysicsServer::BODY_MODE_STATIC) {
+		p_states->clear_body(p_id);
 		return;
 	}
 
@@ -530,7 +554,15 @@ void BodySW::integrate_forces(real_t p_step) {
 		rot.get_axis_angle(axis, angle);
 		axis.normalize();
 		angular_velocity = axis * (angle / p_step);
+
+		p_states->clear_body(p_id);
 	} else {
+		// the velocities are updated by BodyStateStorageSW::integrate_forces()
+		p_states->set_vector3(BodyStateStorageSW::LINEAR_VELOCITY, p_id, linear_velocity);
+		p_states->set_vector3(BodyStateStorageSW::ANGULAR_VELOCITY, p_id, angular_velocity);
+		p_states->set_basis(BodyStateStorageSW::INV_INERTIA_TENSOR, p_id, _inv_inertia_tensor);
+		p_states->set_scalar(BodyStateStorageSW::INV_MASS, p_id, _inv_mass);
+
 		if (!omit_force_integration && !first_integration) {
 			//overridden by direct state query
 
@@ -550,16 +582,15 @@ void BodySW::integrate_forces(real_t p_step) {
 				angular_damp = 0;
 			}
 
-			linear_velocity *= damp;
-			angular_velocity *= angular_damp;
-
-			linear_velocity += _inv_mass * force * p_step;
-			angular_velocity += _inv_inertia_tensor.xform(torque) * p_step;
-		}
-
-		if (continuous_cd) {
-			motion = linear_velocity * p_step;
-			do_motion = true;
+			p_states->set_vector3(BodyStateStorageSW::FORCE, p_id, force);
+			p_states->set_vector3(BodyStateStorageSW::TORQUE, p_id, torque);
+			p_states->set_scalar(BodyStateStorageSW::LINEAR_DAMP, p_id, damp);
+			p_states->set_scalar(BodyStateStorageSW::ANGULAR_DAMP, p_id, angular_damp);
+		} else {
+			p_states->set_vector3(BodyStateStorageSW::FORCE, p_id, Vector3());
+			p_states->set_vector3(BodyStateStorageSW::TORQUE, p_id, Vector3());
+			p_states->set_scalar(BodyStateStorageSW::LINEAR_DAMP, p_id, 1);
+			p_states->set_scalar(BodyStateStorageSW::ANGULAR_DAMP, p_id, 1);
 		}
 	}
 
@@ -573,20 +604,39 @@ void BodySW::integrate_forces(real_t p_step) {
 	biased_linear_velocity = Vector3();
 
 	if (do_motion) { //shapes temporarily extend for raycast
-		_update_shapes_with_motion(motion);
+		pending_shape_motion = motion;
+		pending_shape_motion_update = true;
 	}
 
 	def_area = nullptr; // clear the area, so it is set in the next frame
 	contact_count = 0;
 }
 
-void BodySW::integrate_velocities(real_t p_step) {
-	if (mode == PhysicsServer::BODY_MODE_STATIC) {
+void BodySW::apply_integrated_forces(real_t p_step, const BodyStateStorageSW *p_states, uint32_t p_id) {
+	if (mode == PhysicsServer::BODY_MODE_STATIC || mode == PhysicsServer::BODY_MODE_KINEMATIC) {
 		return;
 	}
 
-	if (fi_callback) {
-		get_space()->body_add_to_state_query_list(&direct_state_query_list);
+	linear_velocity = p_states->get_vector3(BodyStateStorageSW::LINEAR_VELOCITY, p_id);
+	angular_velocity = p_states->get_vector3(BodyStateStorageSW::ANGULAR_VELOCITY, p_id);
+
+	if (continuous_cd) { //shapes temporarily extend for raycast
+		pending_shape_motion = linear_velocity * p_step;
+		pending_shape_motion_update = true;
+	}
+}
+
+void BodySW::finish_integrate_forces() {
+	if (pending_shape_motion_update) {
+		_update_shapes_with_motion(pending_shape_motion);
+		pending_shape_motion_update = false;
+	}
+}
+
+void BodySW::integrate_velocities(real_t p_step, BodyStateStorageSW *p_states, uint32_t p_id) {
+	if (mode == PhysicsServer::BODY_MODE_STATIC) {
+		p_states->clear_body(p_id);
+		return;
 	}
 
 	//apply axis lock linear
@@ -608,45 +658,62 @@ void BodySW::integrate_velocities(real_t p_step) {
 	if (mode == PhysicsServer::BODY_MODE_KINEMATIC) {
 		_set_transform(new_transform, false);
 		_set_inv_transform(new_transform.affine_inverse());
-		if (contacts.size() == 0 && linear_velocity == Vector3() && angular_velocity == Vector3()) {
-			set_active(false); //stopped moving, deactivate
-		}
-
+		p_states->clear_body(p_id);
 		return;
 	}
 
-	Vector3 total_angular_velocity = angular_velocity + biased_angular_velocity;
-
-	real_t ang_vel = total_angular_velocity.length();
-	Transform transform = get_transform();
+	// the transform is updated by BodyStateStorageSW::integrate_velocities()
+	const Transform &transform = get_transform();
+	p_states->set_vector3(BodyStateStorageSW::ORIGIN, p_id, transform.origin);
+	p_states->set_basis(BodyStateStorageSW::BASIS, p_id, transform.basis);
+	p_states->set_vector3(BodyStateStorageSW::LINEAR_VELOCITY, p_id, linear_velocity);
+	p_states->set_vector3(BodyStateStorageSW::ANGULAR_VELOCITY, p_id, angular_velocity);
+	p_states->set_vector3(BodyStateStorageSW::BIASED_LINEAR_VELOCITY, p_id, biased_linear_velocity);
+	p_states->set_vector3(BodyStateStorageSW::BIASED_ANGULAR_VELOCITY, p_id, biased_angular_velocity);
+	p_states->set_vector3(BodyStateStorageSW::INV_INERTIA, p_id, _inv_inertia);
+	p_states->set_basis(BodyStateStorageSW::PRINCIPAL_INERTIA_AXES_LOCAL, p_id, principal_inertia_axes_local);
+	p_states->set_vector3(BodyStateStorageSW::CENTER_OF_MASS_LOCAL, p_id, center_of_mass_local);
+}
 
-	if (!Math::is_zero_approx(ang_vel)) {
-		Vector3 ang_vel_axis = total_angular_velocity / ang_vel;
-		Basis rot(ang_vel_axis, ang_vel * p_step);
-		Basis identity3(1, 0, 0, 0, 1, 0, 0, 0, 1);
-		transform.origin += ((identity3 - rot) * transform.basis).xform(center_of_mass_local);
-		transform.basis = rot * transform.basis;
-		transform.orthonormalize();
+void BodySW::apply_integrated_velocities(const BodyStateStorageSW *p_states, uint32_t p_id) {
+	if (mode == PhysicsServer::BODY_MODE_STATIC || mode == PhysicsServer::BODY_MODE_KINEMATIC) {
+		return;
 	}
 
-	Vector3 total_linear_velocity = linear_velocity + biased_linear_velocity;
-	/*for(int i=0;i<3;i++) {
-		if (axis_lock&(1<<i)) {
-			transform.origin[i]=0.0;
-		}
-	}*/
+	Transform transform;
+	transform.basis = p_states->get_basis(BodyStateStorageSW::BASIS, p_id);
+	transform.origin = p_states->get_vector3(BodyStateStorageSW::ORIGIN, p_id);
+	_set_transform(transform, false);
 
-	transform.origin += total_linear_velocity * p_step;
+	Transform inv_transform;
+	inv_transform.basis = transform.basis.transposed();
+	inv_transform.origin = p_states->get_vector3(BodyStateStorageSW::INV_ORIGIN, p_id);
+	_set_inv_transform(inv_transform);
 
-	_set_transform(transform);
-	_set_inv_transform(get_transform().inverse());
+	// see _update_transform_dependant()
+	center_of_mass = p_states->get_vector3(BodyStateStorageSW::CENTER_OF_MASS, p_id);
+	principal_inertia_axes = p_states->get_basis(BodyStateStorageSW::PRINCIPAL_INERTIA_AXES, p_id);
+	_inv_inertia_tensor = p_states->get_basis(BodyStateStorageSW::INV_INERTIA_TENSOR, p_id);
+}
 
-	_update_transform_dependant();
+void BodySW::finish_integrate_velocities() {
+	if (mode == PhysicsServer::BODY_MODE_STATIC) {
+		return;
+	}
 
-	/*
 	if (fi_callback) {
 		get_space()->body_add_to_state_query_list(&direct_state_query_list);
-	*/
+	}
+
+	if (mode == PhysicsServer::BODY_MODE_KINEMATIC) {
+		if (contacts.size() == 0 && linear_velocity == Vector3() && angular_velocity == Vector3()) {
+			set_active(false); //stopped moving, deactivate
+		}
+
+		return;
+	}
+
+	_update_shapes();
 }
 
 /*
@@ -781,6 +848,7 @@ BodySW::BodySW() :
 	island_list_next = nullptr;
 	first_time_kinematic = false;
 	first_integration = false;
+	pending_shape_motion_update = false;
 	_set_static(false);
 
 	contact_count = 0;
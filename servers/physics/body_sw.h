@@ -33,6 +33,7 @@
 /*************************************************************************/
 
 #include "area_sw.h"
+#include "body_state_storage_sw.h"
 #include "collision_object_sw.h"
 #include "core/containers/vset.h"
 
@@ -96,6 +97,10 @@ class BodySW : public CollisionObjectSW {
 	bool continuous_cd;
 	bool can_sleep;
 	bool first_time_kinematic;
+
+	// Broadphase work left over by integrate_forces(), see finish_integrate_forces().
+	Vector3 pending_shape_motion;
+	bool pending_shape_motion_update;
 	void _update_inertia();
 	virtual void _shapes_changed();
 	Transform new_transform;
@@ -225,20 +230,35 @@ public:
 	_FORCE_INLINE_ const Vector3 &get_biased_linear_velocity() const { return biased_linear_velocity; }
 	_FORCE_INLINE_ const Vector3 &get_biased_angular_velocity() const { return biased_angular_velocity; }
 
+	// Static and kinematic bodies have no inverse mass, impulses can't change
+	// them. Returning early also keeps islands solved in parallel from writing to
+	// the non-dynamic bodies they share.
 	_FORCE_INLINE_ void apply_central_impulse(const Vector3 &p_j) {
+		if (mode <= PhysicsServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		linear_velocity += p_j * _inv_mass;
 	}
 
 	_FORCE_INLINE_ void apply_impulse(const Vector3 &p_pos, const Vector3 &p_j) {
+		if (mode <= PhysicsServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		linear_velocity += p_j * _inv_mass;
 		angular_velocity += _inv_inertia_tensor.xform((p_pos - center_of_mass).cross(p_j));
 	}
 
 	_FORCE_INLINE_ void apply_torque_impulse(const Vector3 &p_j) {
+		if (mode <= PhysicsServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		angular_velocity += _inv_inertia_tensor.xform(p_j);
 	}
 
 	_FORCE_INLINE_ void apply_bias_impulse(const Vector3 &p_pos, const Vector3 &p_j, real_t p_max_delta_av = -1.0) {
+		if (mode <= PhysicsServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		biased_linear_velocity += p_j * _inv_mass;
 		if (p_max_delta_av != 0.0) {
 			Vector3 delta_av = _inv_inertia_tensor.xform((p_pos - center_of_mass).cross(p_j));
@@ -269,6 +289,18 @@ public:
 	void set_active(bool p_active);
 	_FORCE_INLINE_ bool is_active() const { return active; }
 
+	// State saved and restored by space snapshots, see SpaceSW::get_snapshot().
+	struct SnapshotState {
+		Transform transform;
+		Vector3 linear_velocity;
+		Vector3 angular_velocity;
+		real_t still_time;
+		bool active;
+	};
+
+	void get_snapshot_state(SnapshotState &r_state) const;
+	void set_snapshot_state(const SnapshotState &p_state);
+
 	_FORCE_INLINE_ void wakeup() {
 		if ((!get_space()) || mode == PhysicsServer::BODY_MODE_STATIC || mode == PhysicsServer::BODY_MODE_KINEMATIC) {
 			return;
@@ -308,8 +340,18 @@ public:
 	void set_axis_lock(PhysicsServer::BodyAxis p_axis, bool lock);
 	bool is_axis_locked(PhysicsServer::BodyAxis p_axis) const;
 
-	void integrate_forces(real_t p_step);
-	void integrate_velocities(real_t p_step);
+	// The integration passes only touch the body itself, so the active bodies
+	// can be integrated in parallel. Each pass stores the state of the body in
+	// slot p_id of p_states, the math runs there for all the bodies at once,
+	// and apply_integrated_*() reads the result back. Updating the broadphase and
+	// the space lists is left to the matching finish_*() call, made from the
+	// stepping thread.
+	void integrate_forces(real_t p_step, BodyStateStorageSW *p_states, uint32_t p_id);
+	void apply_integrated_forces(real_t p_step, const BodyStateStorageSW *p_states, uint32_t p_id);
+	void finish_integrate_forces();
+	void integrate_velocities(real_t p_step, BodyStateStorageSW *p_states, uint32_t p_id);
+	void apply_integrated_velocities(const BodyStateStorageSW *p_states, uint32_t p_id);
+	void finish_integrate_velocities();
 
 	_FORCE_INLINE_ Vector3 get_velocity_in_local_point(const Vector3 &rel_pos) const {
 		return linear_velocity + angular_velocity.cross(rel_pos - center_of_mass);
@@ -126,6 +126,10 @@ void BroadPhaseBVH::update() {
 	bvh.update();
 }
 
+void BroadPhaseBVH::set_work_pool(ThreadWorkPool *p_work_pool) {
+	bvh.params_set_pairing_work_pool(p_work_pool);
+}
+
 BroadPhaseSW *BroadPhaseBVH::_create() {
 	return memnew(BroadPhaseBVH);
 }
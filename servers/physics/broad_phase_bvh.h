@@ -95,6 +95,8 @@ public:
 
 	virtual void update();
 
+	virtual void set_work_pool(ThreadWorkPool *p_work_pool);
+
 	static BroadPhaseSW *_create();
 	BroadPhaseBVH();
 };
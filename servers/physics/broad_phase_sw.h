@@ -36,6 +36,7 @@
 #include "core/math/math_funcs.h"
 
 class CollisionObjectSW;
+class ThreadWorkPool;
 
 class BroadPhaseSW {
 public:
@@ -68,6 +69,9 @@ public:
 
 	virtual void update() = 0;
 
+	// Pool the broadphase can spread its work on, null when the server doesn't use threads.
+	virtual void set_work_pool(ThreadWorkPool *p_work_pool) {}
+
 	virtual ~BroadPhaseSW();
 };
 
@@ -76,6 +76,9 @@ public:
 	_FORCE_INLINE_ void disable_collisions_between_bodies(const bool p_disabled) { disabled_collisions_between_bodies = p_disabled; }
 	_FORCE_INLINE_ bool is_disabled_collisions_between_bodies() const { return disabled_collisions_between_bodies; }
 
+	// Narrow phase, run for every constraint of the step before the islands are set up.
+	// Constraints are processed in parallel here, so it may only write to the constraint itself.
+	virtual void generate_contacts(real_t p_step) {}
 	virtual bool setup(real_t p_step) = 0;
 	virtual void solve(real_t p_step) = 0;
 
@@ -130,6 +130,7 @@ RID PhysicsServerSW::space_create() {
 	SpaceSW *space = memnew(SpaceSW);
 	RID id = space_owner.make_rid(space);
 	space->set_self(id);
+	space->set_work_pool(_get_work_pool());
 	RID area_id = RID_PRIME(area_create());
 	AreaSW *area = area_owner.get(area_id);
 	ERR_FAIL_COND_V(!area, RID());
@@ -177,7 +178,7 @@ real_t PhysicsServerSW::space_get_param(RID p_space, SpaceParameter p_param) con
 PhysicsDirectSpaceState *PhysicsServerSW::space_get_direct_state(RID p_space) {
 	SpaceSW *space = space_owner.get(p_space);
 	ERR_FAIL_COND_V(!space, nullptr);
-	ERR_FAIL_COND_V_MSG(space->is_locked(), nullptr, "Space state is inaccessible right now, wait for iteration or physics process notification.");
+	ERR_FAIL_COND_V_MSG((using_threads && !doing_sync) || space->is_locked(), nullptr, "Space state is inaccessible right now, wait for iteration or physics process notification.");
 
 	return space->get_direct_state();
 }
@@ -200,6 +201,25 @@ int PhysicsServerSW::space_get_contact_count(RID p_space) const {
 	return space->get_debug_contact_count();
 }
 
+PoolVector<uint8_t> PhysicsServerSW::space_get_snapshot(RID p_space) const {
+	const SpaceSW *space = space_owner.get(p_space);
+	ERR_FAIL_COND_V(!space, PoolVector<uint8_t>());
+	return space->get_snapshot();
+}
+
+Error PhysicsServerSW::space_set_snapshot(RID p_space, const PoolVector<uint8_t> &p_snapshot) {
+	SpaceSW *space = space_owner.get(p_space);
+	ERR_FAIL_COND_V(!space, ERR_INVALID_PARAMETER);
+	return space->set_snapshot(p_snapshot);
+}
+
+uint64_t PhysicsServerSW::space_get_elapsed_time(RID p_space, SpaceSW::ElapsedTime p_time) const {
+	const SpaceSW *space = space_owner.get(p_space);
+	ERR_FAIL_COND_V(!space, 0);
+	ERR_FAIL_INDEX_V(p_time, SpaceSW::ELAPSED_TIME_MAX, 0);
+	return space->get_elapsed_time(p_time);
+}
+
 RID PhysicsServerSW::area_create() {
 	AreaSW *area = memnew(AreaSW);
 	RID rid = area_owner.make_rid(area);
@@ -893,7 +913,7 @@ PhysicsDirectBodyState *PhysicsServerSW::body_get_direct_state(RID p_body) {
 		return nullptr;
 	}
 
-	ERR_FAIL_COND_V_MSG(body->get_space()->is_locked(), nullptr, "Body state is inaccessible right now, wait for iteration or physics process notification.");
+	ERR_FAIL_COND_V_MSG((using_threads && !doing_sync) || body->get_space()->is_locked(), nullptr, "Body state is inaccessible right now, wait for iteration or physics process notification.");
 	return body->get_direct_state();
 }
 
@@ -1290,8 +1310,10 @@ void PhysicsServerSW::set_collision_iterations(int p_iterations) {
 };
 
 void PhysicsServerSW::init() {
+	doing_sync = false;
 	iterations = 8; // 8?
 	stepper = memnew(StepSW);
+	stepper->set_work_pool(_get_work_pool());
 };
 
 void PhysicsServerSW::step(real_t p_step) {
@@ -1315,6 +1337,10 @@ void PhysicsServerSW::step(real_t p_step) {
 #endif
 }
 
+void PhysicsServerSW::sync() {
+	doing_sync = true;
+};
+
 void PhysicsServerSW::flush_queries() {
 #ifndef _3D_DISABLED
 
@@ -1367,8 +1393,13 @@ void PhysicsServerSW::flush_queries() {
 #endif
 };
 
+void PhysicsServerSW::end_sync() {
+	doing_sync = false;
+}
+
 void PhysicsServerSW::finish() {
 	memdelete(stepper);
+	work_pool.finish();
 };
 
 int PhysicsServerSW::get_process_info(ProcessInfo p_info) {
@@ -1444,6 +1475,12 @@ PhysicsServerSW::PhysicsServerSW() {
 	collision_pairs = 0;
 
 	active = true;
+#ifdef NO_THREADS
+	using_threads = false;
+#else
+	using_threads = int(GLOBAL_GET("physics/3d/thread_model")) == 2;
+#endif
+	use_multiple_threads = GLOBAL_GET("physics/3d/pandemonium_physics/use_multiple_threads");
 	flushing_queries = false;
 };
 
@@ -44,14 +44,23 @@ class PhysicsServerSW : public PhysicsServer {
 	friend class PhysicsDirectSpaceStateSW;
 	bool active;
 	int iterations;
+	bool doing_sync;
 
 	int island_count;
 	int active_objects;
 	int collision_pairs;
 
+	bool using_threads;
+
 	bool flushing_queries;
 
 	StepSW *stepper;
+
+	// Shared by the stepper and every space, so the server never runs more than one set of threads.
+	// Its threads are only started when something uses it.
+	bool use_multiple_threads;
+	ThreadWorkPool work_pool;
+	_FORCE_INLINE_ ThreadWorkPool *_get_work_pool() { return use_multiple_threads ? &work_pool : nullptr; }
 	RBSet<const SpaceSW *> active_spaces;
 
 	mutable RID_Owner<ShapeSW> shape_owner;
@@ -104,6 +113,12 @@ public:
 	virtual Vector<Vector3> space_get_contacts(RID p_space) const;
 	virtual int space_get_contact_count(RID p_space) const;
 
+	virtual PoolVector<uint8_t> space_get_snapshot(RID p_space) const;
+	virtual Error space_set_snapshot(RID p_space, const PoolVector<uint8_t> &p_snapshot);
+
+	// time spent in each phase of the last step of the space, in microseconds
+	uint64_t space_get_elapsed_time(RID p_space, SpaceSW::ElapsedTime p_time) const;
+
 	/* AREA API */
 
 	virtual RID area_create();
@@ -358,7 +373,9 @@ public:
 	virtual void set_active(bool p_active);
 	virtual void init();
 	virtual void step(real_t p_step);
+	virtual void sync();
 	virtual void flush_queries();
+	virtual void end_sync();
 	virtual void finish();
 
 	virtual void set_collision_iterations(int p_iterations);
@@ -0,0 +1,418 @@
+#ifndef PHYSICSSERVERWRAPMT_H
+#define PHYSICSSERVERWRAPMT_H
+
+/*************************************************************************/
+/*  physics_server_wrap_mt.h                                             */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "core/config/project_settings.h"
+#include "core/containers/command_queue_mt.h"
+#include "core/os/safe_refcount.h"
+#include "core/os/thread.h"
+#include "servers/physics_server.h"
+
+#ifdef DEBUG_SYNC
+#define SYNC_DEBUG print_line("sync on: " + String(__FUNCTION__));
+#else
+#define SYNC_DEBUG
+#endif
+
+class PhysicsServerWrapMT : public PhysicsServer {
+	mutable PhysicsServer *physics_server;
+
+	mutable CommandQueueMT command_queue;
+
+	static void _thread_callback(void *_instance);
+	void thread_loop();
+
+	Thread::ID server_thread;
+	Thread::ID main_thread;
+	SafeFlag exit;
+	Thread thread;
+	SafeFlag step_thread_up;
+	bool create_thread;
+
+	Semaphore step_sem;
+	void thread_step(real_t p_delta);
+
+	void thread_exit();
+
+	bool first_frame;
+
+	Mutex alloc_mutex;
+	int pool_max_size;
+
+public:
+#define ServerName PhysicsServer
+#define ServerNameWrapMT PhysicsServerWrapMT
+#define server_name physics_server
+#include "servers/server_wrap_mt_common.h"
+
+	//FUNC1RID(shape,ShapeType); todo fix
+	FUNC1R(RID, shape_create, ShapeType);
+	FUNC2(shape_set_data, RID, const Variant &);
+	FUNC2(shape_set_custom_solver_bias, RID, real_t);
+
+	FUNC2(shape_set_margin, RID, real_t);
+	FUNC1RC(real_t, shape_get_margin, RID);
+
+	FUNC1RC(ShapeType, shape_get_type, RID);
+	FUNC1RC(Variant, shape_get_data, RID);
+	FUNC1RC(real_t, shape_get_custom_solver_bias, RID);
+
+	/* SPACE API */
+
+	FUNCRID(space);
+	FUNC2(space_set_active, RID, bool);
+	FUNC1RC(bool, space_is_active, RID);
+
+	FUNC3(space_set_param, RID, SpaceParameter, real_t);
+	FUNC2RC(real_t, space_get_param, RID, SpaceParameter);
+
+	// this function only works on physics process, errors and returns null otherwise
+	PhysicsDirectSpaceState *space_get_direct_state(RID p_space) {
+		ERR_FAIL_COND_V(main_thread != Thread::get_caller_id(), nullptr);
+		return physics_server->space_get_direct_state(p_space);
+	}
+
+	FUNC2(space_set_debug_contacts, RID, int);
+	virtual Vector<Vector3> space_get_contacts(RID p_space) const {
+		ERR_FAIL_COND_V(main_thread != Thread::get_caller_id(), Vector<Vector3>());
+		return physics_server->space_get_contacts(p_space);
+	}
+
+	virtual int space_get_contact_count(RID p_space) const {
+		ERR_FAIL_COND_V(main_thread != Thread::get_caller_id(), 0);
+		return physics_server->space_get_contact_count(p_space);
+	}
+
+	FUNC1RC(PoolVector<uint8_t>, space_get_snapshot, RID);
+	FUNC2R(Error, space_set_snapshot, RID, const PoolVector<uint8_t> &);
+
+	/* AREA API */
+
+	//FUNC0RID(area);
+	FUNCRID(area);
+
+	FUNC2(area_set_space, RID, RID);
+	FUNC1RC(RID, area_get_space, RID);
+
+	FUNC2(area_set_space_override_mode, RID, AreaSpaceOverrideMode);
+	FUNC1RC(AreaSpaceOverrideMode, area_get_space_override_mode, RID);
+
+	FUNC4(area_add_shape, RID, RID, const Transform &, bool);
+	FUNC3(area_set_shape, RID, int, RID);
+	FUNC3(area_set_shape_transform, RID, int, const Transform &);
+	FUNC3(area_set_shape_disabled, RID, int, bool);
+
+	FUNC1RC(int, area_get_shape_count, RID);
+	FUNC2RC(RID, area_get_shape, RID, int);
+	FUNC2RC(Transform, area_get_shape_transform, RID, int);
+	FUNC2(area_remove_shape, RID, int);
+	FUNC1(area_clear_shapes, RID);
+
+	FUNC2(area_attach_object_instance_id, RID, ObjectID);
+	FUNC1RC(ObjectID, area_get_object_instance_id, RID);
+
+	FUNC3(area_set_param, RID, AreaParameter, const Variant &);
+	FUNC2(area_set_transform, RID, const Transform &);
+
+	FUNC2RC(Variant, area_get_param, RID, AreaParameter);
+	FUNC1RC(Transform, area_get_transform, RID);
+
+	FUNC2(area_set_collision_mask, RID, uint32_t);
+	FUNC2(area_set_collision_layer, RID, uint32_t);
+
+	FUNC2(area_set_monitorable, RID, bool);
+	FUNC2(area_set_ray_pickable, RID, bool);
+	FUNC1RC(bool, area_is_ray_pickable, RID);
+
+	FUNC3(area_set_monitor_callback, RID, Object *, const StringName &);
+	FUNC3(area_set_area_monitor_callback, RID, Object *, const StringName &);
+
+	/* BODY API */
+
+	//FUNC2RID(body,BodyMode,bool);
+	FUNC2R(RID, body_create, BodyMode, bool);
+
+	FUNC2(body_set_space, RID, RID);
+	FUNC1RC(RID, body_get_space, RID);
+
+	FUNC2(body_set_mode, RID, BodyMode);
+	FUNC1RC(BodyMode, body_get_mode, RID);
+
+	FUNC4(body_add_shape, RID, RID, const Transform &, bool);
+	FUNC3(body_set_shape, RID, int, RID);
+	FUNC3(body_set_shape_transform, RID, int, const Transform &);
+
+	FUNC1RC(int, body_get_shape_count, RID);
+	FUNC2RC(Transform, body_get_shape_transform, RID, int);
+	FUNC2RC(RID, body_get_shape, RID, int);
+
+	FUNC3(body_set_shape_disabled, RID, int, bool);
+
+	FUNC2(body_remove_shape, RID, int);
+	FUNC1(body_clear_shapes, RID);
+
+	FUNC2(body_attach_object_instance_id, RID, uint32_t);
+	FUNC1RC(uint32_t, body_get_object_instance_id, RID);
+
+	FUNC2(body_set_enable_continuous_collision_detection, RID, bool);
+	FUNC1RC(bool, body_is_continuous_collision_detection_enabled, RID);
+
+	FUNC2(body_set_collision_layer, RID, uint32_t);
+	FUNC1RC(uint32_t, body_get_collision_layer, RID);
+
+	FUNC2(body_set_collision_mask, RID, uint32_t);
+	FUNC1RC(uint32_t, body_get_collision_mask, RID);
+
+	FUNC2(body_set_user_flags, RID, uint32_t);
+	FUNC1RC(uint32_t, body_get_user_flags, RID);
+
+	FUNC3(body_set_param, RID, BodyParameter, float);
+	FUNC2RC(float, body_get_param, RID, BodyParameter);
+
+	FUNC2(body_set_kinematic_safe_margin, RID, real_t);
+	FUNC1RC(real_t, body_get_kinematic_safe_margin, RID);
+
+	FUNC3(body_set_state, RID, BodyState, const Variant &);
+	FUNC2RC(Variant, body_get_state, RID, BodyState);
+
+	FUNC2(body_set_applied_force, RID, const Vector3 &);
+	FUNC1RC(Vector3, body_get_applied_force, RID);
+
+	FUNC2(body_set_applied_torque, RID, const Vector3 &);
+	FUNC1RC(Vector3, body_get_applied_torque, RID);
+
+	FUNC2(body_add_central_force, RID, const Vector3 &);
+	FUNC3(body_add_force, RID, const Vector3 &, const Vector3 &);
+	FUNC2(body_add_torque, RID, const Vector3 &);
+	FUNC2(body_apply_central_impulse, RID, const Vector3 &);
+	FUNC3(body_apply_impulse, RID, const Vector3 &, const Vector3 &);
+	FUNC2(body_apply_torque_impulse, RID, const Vector3 &);
+	FUNC2(body_set_axis_velocity, RID, const Vector3 &);
+
+	FUNC3(body_set_axis_lock, RID, BodyAxis, bool);
+	FUNC2RC(bool, body_is_axis_locked, RID, BodyAxis);
+
+	FUNC2(body_add_collision_exception, RID, RID);
+	FUNC2(body_remove_collision_exception, RID, RID);
+	FUNC2S(body_get_collision_exceptions, RID, List<RID> *);
+
+	FUNC2(body_set_max_contacts_reported, RID, int);
+	FUNC1RC(int, body_get_max_contacts_reported, RID);
+
+	FUNC2(body_set_contacts_reported_depth_threshold, RID, float);
+	FUNC1RC(float, body_get_contacts_reported_depth_threshold, RID);
+
+	FUNC2(body_set_omit_force_integration, RID, bool);
+	FUNC1RC(bool, body_is_omitting_force_integration, RID);
+
+	FUNC4(body_set_force_integration_callback, RID, Object *, const StringName &, const Variant &);
+
+	FUNC2(body_set_ray_pickable, RID, bool);
+	FUNC1RC(bool, body_is_ray_pickable, RID);
+
+	FUNC7R(bool, body_test_motion, RID, const Transform &, const Vector3 &, bool, MotionResult *, bool, const RBSet<RID> &);
+	FUNC7R(int, body_test_ray_separation, RID, const Transform &, bool, Vector3 &, SeparationResult *, int, float);
+
+	// this function only works on physics process, errors and returns null otherwise
+	PhysicsDirectBodyState *body_get_direct_state(RID p_body) {
+		ERR_FAIL_COND_V(main_thread != Thread::get_caller_id(), nullptr);
+		return physics_server->body_get_direct_state(p_body);
+	}
+
+	/* SOFT BODY API */
+
+	FUNC1R(RID, soft_body_create, bool);
+
+	// the handler writes into the rendering server, so wait for it instead of queuing it
+	FUNC2S(soft_body_update_rendering_server, RID, class SoftBodyRenderingServerHandler *);
+
+	FUNC2(soft_body_set_space, RID, RID);
+	FUNC1RC(RID, soft_body_get_space, RID);
+
+	FUNC2S(soft_body_set_mesh, RID, const REF &);
+
+	FUNC2(soft_body_set_collision_layer, RID, uint32_t);
+	FUNC1RC(uint32_t, soft_body_get_collision_layer, RID);
+
+	FUNC2(soft_body_set_collision_mask, RID, uint32_t);
+	FUNC1RC(uint32_t, soft_body_get_collision_mask, RID);
+
+	FUNC2(soft_body_add_collision_exception, RID, RID);
+	FUNC2(soft_body_remove_collision_exception, RID, RID);
+	FUNC2S(soft_body_get_collision_exceptions, RID, List<RID> *);
+
+	FUNC3(soft_body_set_state, RID, BodyState, const Variant &);
+	FUNC2RC(Variant, soft_body_get_state, RID, BodyState);
+
+	FUNC2(soft_body_set_transform, RID, const Transform &);
+	FUNC2RC(Vector3, soft_body_get_vertex_position, RID, int);
+
+	FUNC2(soft_body_set_ray_pickable, RID, bool);
+	FUNC1RC(bool, soft_body_is_ray_pickable, RID);
+
+	FUNC2(soft_body_set_simulation_precision, RID, int);
+	FUNC1R(int, soft_body_get_simulation_precision, RID);
+
+	FUNC2(soft_body_set_total_mass, RID, real_t);
+	FUNC1R(real_t, soft_body_get_total_mass, RID);
+
+	FUNC2(soft_body_set_linear_stiffness, RID, real_t);
+	FUNC1R(real_t, soft_body_get_linear_stiffness, RID);
+
+	FUNC2(soft_body_set_areaAngular_stiffness, RID, real_t);
+	FUNC1R(real_t, soft_body_get_areaAngular_stiffness, RID);
+
+	FUNC2(soft_body_set_volume_stiffness, RID, real_t);
+	FUNC1R(real_t, soft_body_get_volume_stiffness, RID);
+
+	FUNC2(soft_body_set_pressure_coefficient, RID, real_t);
+	FUNC1R(real_t, soft_body_get_pressure_coefficient, RID);
+
+	FUNC2(soft_body_set_pose_matching_coefficient, RID, real_t);
+	FUNC1R(real_t, soft_body_get_pose_matching_coefficient, RID);
+
+	FUNC2(soft_body_set_damping_coefficient, RID, real_t);
+	FUNC1R(real_t, soft_body_get_damping_coefficient, RID);
+
+	FUNC2(soft_body_set_drag_coefficient, RID, real_t);
+	FUNC1R(real_t, soft_body_get_drag_coefficient, RID);
+
+	FUNC3(soft_body_move_point, RID, int, const Vector3 &);
+	FUNC2R(Vector3, soft_body_get_point_global_position, RID, int);
+	FUNC2RC(Vector3, soft_body_get_point_offset, RID, int);
+
+	FUNC1(soft_body_remove_all_pinned_points, RID);
+	FUNC3(soft_body_pin_point, RID, int, bool);
+	FUNC2R(bool, soft_body_is_point_pinned, RID, int);
+
+	/* JOINT API */
+
+	FUNC1RC(JointType, joint_get_type, RID);
+
+	FUNC2(joint_set_solver_priority, RID, int);
+	FUNC1RC(int, joint_get_solver_priority, RID);
+
+	FUNC2(joint_disable_collisions_between_bodies, RID, const bool);
+	FUNC1RC(bool, joint_is_disabled_collisions_between_bodies, RID);
+
+	//TODO need to convert this to FUNCRID, but it's a hassle..
+
+	FUNC4R(RID, joint_create_pin, RID, const Vector3 &, RID, const Vector3 &);
+
+	FUNC3(pin_joint_set_param, RID, PinJointParam, float);
+	FUNC2RC(float, pin_joint_get_param, RID, PinJointParam);
+
+	FUNC2(pin_joint_set_local_a, RID, const Vector3 &);
+	FUNC1RC(Vector3, pin_joint_get_local_a, RID);
+
+	FUNC2(pin_joint_set_local_b, RID, const Vector3 &);
+	FUNC1RC(Vector3, pin_joint_get_local_b, RID);
+
+	FUNC4R(RID, joint_create_hinge, RID, const Transform &, RID, const Transform &);
+	FUNC6R(RID, joint_create_hinge_simple, RID, const Vector3 &, const Vector3 &, RID, const Vector3 &, const Vector3 &);
+
+	FUNC3(hinge_joint_set_param, RID, HingeJointParam, float);
+	FUNC2RC(float, hinge_joint_get_param, RID, HingeJointParam);
+
+	FUNC3(hinge_joint_set_flag, RID, HingeJointFlag, bool);
+	FUNC2RC(bool, hinge_joint_get_flag, RID, HingeJointFlag);
+
+	FUNC4R(RID, joint_create_slider, RID, const Transform &, RID, const Transform &);
+
+	FUNC3(slider_joint_set_param, RID, SliderJointParam, float);
+	FUNC2RC(float, slider_joint_get_param, RID, SliderJointParam);
+
+	FUNC4R(RID, joint_create_cone_twist, RID, const Transform &, RID, const Transform &);
+
+	FUNC3(cone_twist_joint_set_param, RID, ConeTwistJointParam, float);
+	FUNC2RC(float, cone_twist_joint_get_param, RID, ConeTwistJointParam);
+
+	FUNC4R(RID, joint_create_generic_6dof, RID, const Transform &, RID, const Transform &);
+
+	FUNC4(generic_6dof_joint_set_param, RID, Vector3::Axis, G6DOFJointAxisParam, float);
+	FUNC3R(float, generic_6dof_joint_get_param, RID, Vector3::Axis, G6DOFJointAxisParam);
+
+	FUNC4(generic_6dof_joint_set_flag, RID, Vector3::Axis, G6DOFJointAxisFlag, bool);
+	FUNC3R(bool, generic_6dof_joint_get_flag, RID, Vector3::Axis, G6DOFJointAxisFlag);
+
+	/* MISC */
+
+	FUNC1(free, RID);
+	FUNC1(set_active, bool);
+	FUNC1(set_collision_iterations, int);
+
+	virtual void init();
+	virtual void step(float p_step);
+	virtual void sync();
+	virtual void end_sync();
+	virtual void flush_queries();
+	virtual void finish();
+
+	virtual bool is_flushing_queries() const {
+		return physics_server->is_flushing_queries();
+	}
+
+	int get_process_info(ProcessInfo p_info) {
+		return physics_server->get_process_info(p_info);
+	}
+
+	PhysicsServerWrapMT(PhysicsServer *p_contained, bool p_create_thread);
+	~PhysicsServerWrapMT();
+
+	template <class T>
+	static PhysicsServer *init_server() {
+#ifdef NO_THREADS
+		return memnew(T); // Always single unsafe when no threads are available.
+#else
+		int tm = GLOBAL_DEF("physics/3d/thread_model", 1);
+		if (tm == 0) { // single unsafe
+			return memnew(T);
+		} else if (tm == 1) { // single safe
+			return memnew(PhysicsServerWrapMT(memnew(T), false));
+		} else { // multi threaded
+			return memnew(PhysicsServerWrapMT(memnew(T), true));
+		}
+#endif
+	}
+
+#undef ServerNameWrapMT
+#undef ServerName
+#undef server_name
+};
+
+#ifdef DEBUG_SYNC
+#undef DEBUG_SYNC
+#endif
+#undef SYNC_DEBUG
+
+#endif // PHYSICSSERVERWRAPMT_H
@@ -54,6 +54,25 @@ _FORCE_INLINE_ static bool _can_collide_with(CollisionObjectSW *p_object, uint32
 	return true;
 }
 
+_FORCE_INLINE_ static bool _intersect_ray_shape(const CollisionObjectSW *p_object, int p_shape, const Vector3 &p_begin, const Vector3 &p_end, Vector3 &r_point, Vector3 &r_normal) {
+	Transform inv_xform = p_object->get_shape_inv_transform(p_shape) * p_object->get_inv_transform();
+
+	Vector3 local_from = inv_xform.xform(p_begin);
+	Vector3 local_to = inv_xform.xform(p_end);
+
+	Vector3 shape_point, shape_normal;
+
+	if (!p_object->get_shape(p_shape)->intersect_segment(local_from, local_to, shape_point, shape_normal)) {
+		return false;
+	}
+
+	Transform xform = p_object->get_transform() * p_object->get_shape_transform(p_shape);
+	r_point = xform.xform(shape_point);
+	r_normal = inv_xform.basis.xform_inv(shape_normal).normalized();
+
+	return true;
+}
+
 int PhysicsDirectSpaceStateSW::intersect_point(const Vector3 &p_point, ShapeResult *r_results, int p_result_max, const RBSet<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
 	ERR_FAIL_COND_V(space->locked, false);
 	int amount = space->broadphase->cull_point(p_point, space->intersection_query_results, SpaceSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
@@ -134,27 +153,17 @@ bool PhysicsDirectSpaceStateSW::intersect_ray(const Vector3 &p_from, const Vecto
 		}
 
 		const CollisionObjectSW *col_obj = space->intersection_query_results[i];
-
 		int shape_idx = space->intersection_query_subindex_results[i];
-		Transform inv_xform = col_obj->get_shape_inv_transform(shape_idx) * col_obj->get_inv_transform();
-
-		Vector3 local_from = inv_xform.xform(begin);
-		Vector3 local_to = inv_xform.xform(end);
-
-		const ShapeSW *shape = col_obj->get_shape(shape_idx);
 
 		Vector3 shape_point, shape_normal;
 
-		if (shape->intersect_segment(local_from, local_to, shape_point, shape_normal)) {
-			Transform xform = col_obj->get_transform() * col_obj->get_shape_transform(shape_idx);
-			shape_point = xform.xform(shape_point);
-
+		if (_intersect_ray_shape(col_obj, shape_idx, begin, end, shape_point, shape_normal)) {
 			real_t ld = normal.dot(shape_point);
 
 			if (ld < min_d) {
 				min_d = ld;
 				res_point = shape_point;
-				res_normal = inv_xform.basis.xform_inv(shape_normal).normalized();
+				res_normal = shape_normal;
 				res_shape = shape_idx;
 				res_obj = col_obj;
 				collided = true;
@@ -185,7 +194,7 @@ int PhysicsDirectSpaceStateSW::intersect_shape(const RID &p_shape, const Transfo
 		return 0;
 	}
 
-	ShapeSW *shape = static_cast<PhysicsServerSW *>(PhysicsServer::get_singleton())->shape_owner.get(p_shape);
+	ShapeSW *shape = PhysicsServerSW::singleton->shape_owner.get(p_shape);
 	ERR_FAIL_COND_V(!shape, 0);
 
 	AABB aabb = p_xform.xform(shape->get_aabb());
@@ -236,7 +245,7 @@ int PhysicsDirectSpaceStateSW::intersect_shape(const RID &p_shape, const Transfo
 }
 
 bool PhysicsDirectSpaceStateSW::cast_motion(const RID &p_shape, const Transform &p_xform, const Vector3 &p_motion, real_t p_margin, real_t &p_closest_safe, real_t &p_closest_unsafe, const RBSet<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas, ShapeRestInfo *r_info) {
-	ShapeSW *shape = static_cast<PhysicsServerSW *>(PhysicsServer::get_singleton())->shape_owner.get(p_shape);
+	ShapeSW *shape = PhysicsServerSW::singleton->shape_owner.get(p_shape);
 	ERR_FAIL_COND_V(!shape, false);
 
 	AABB aabb = p_xform.xform(shape->get_aabb());
@@ -359,7 +368,7 @@ bool PhysicsDirectSpaceStateSW::collide_shape(RID p_shape, const Transform &p_sh
 		return false;
 	}
 
-	ShapeSW *shape = static_cast<PhysicsServerSW *>(PhysicsServer::get_singleton())->shape_owner.get(p_shape);
+	ShapeSW *shape = PhysicsServerSW::singleton->shape_owner.get(p_shape);
 	ERR_FAIL_COND_V(!shape, 0);
 
 	AABB aabb = p_shape_xform.xform(shape->get_aabb());
@@ -433,7 +442,7 @@ static void _rest_cbk_result(const Vector3 &p_point_A, const Vector3 &p_point_B,
 	rd->best_local_shape = rd->local_shape;
 }
 bool PhysicsDirectSpaceStateSW::rest_info(RID p_shape, const Transform &p_shape_xform, real_t p_margin, ShapeRestInfo *r_info, const RBSet<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
-	ShapeSW *shape = static_cast<PhysicsServerSW *>(PhysicsServer::get_singleton())->shape_owner.get(p_shape);
+	ShapeSW *shape = PhysicsServerSW::singleton->shape_owner.get(p_shape);
 	ERR_FAIL_COND_V(!shape, 0);
 
 	real_t margin = MAX(p_margin, TEST_MOTION_MARGIN_MIN_VALUE);
@@ -532,8 +541,319 @@ Vector3 PhysicsDirectSpaceStateSW::get_closest_point_to_object_volume(RID p_obje
 	}
 }
 
+// Interleaves the lower 10 bits of p_v with two zero bits between each of them.
+static uint32_t _morton_spread(uint32_t p_v) {
+	p_v &= 0x3FF;
+	p_v = (p_v | (p_v << 16)) & 0x30000FF;
+	p_v = (p_v | (p_v << 8)) & 0x300F00F;
+	p_v = (p_v | (p_v << 4)) & 0x30C30C3;
+	p_v = (p_v | (p_v << 2)) & 0x9249249;
+	return p_v;
+}
+
+// Cell of p_value on the 10 bit grid of _morton_spread(). The positions are relative to the
+// bounds of the batch, but rounding can still put them slightly outside of [0, 1023].
+static _FORCE_INLINE_ uint32_t _morton_cell(real_t p_value) {
+	if (!(p_value > 0)) {
+		// Also catches NaN.
+		return 0;
+	}
+
+	int32_t cell = (int32_t)Math::floor(MIN(p_value, (real_t)1023));
+	return (uint32_t)cell;
+}
+
+void PhysicsDirectSpaceStateSW::_set_batch_exclude(const Vector<RID> &p_exclude) {
+	batch_exclude.clear();
+	for (int i = 0; i < p_exclude.size(); i++) {
+		batch_exclude.push_back(p_exclude[i]);
+	}
+	batch_exclude.sort();
+}
+
+_FORCE_INLINE_ static bool _is_excluded(const LocalVector<RID> &p_exclude, const RID &p_rid) {
+	int low = 0;
+	int high = (int)p_exclude.size() - 1;
+
+	while (low <= high) {
+		int middle = (low + high) / 2;
+		if (p_exclude[middle] == p_rid) {
+			return true;
+		} else if (p_exclude[middle] < p_rid) {
+			low = middle + 1;
+		} else {
+			high = middle - 1;
+		}
+	}
+
+	return false;
+}
+
+void PhysicsDirectSpaceStateSW::_sort_batch() {
+	uint32_t count = batch_positions.size();
+
+	batch_order.resize(count);
+	if (count == 0) {
+		return;
+	}
+
+	AABB bounds(batch_positions[0], Vector3());
+	for (uint32_t i = 1; i < count; i++) {
+		bounds.expand_to(batch_positions[i]);
+	}
+
+	Vector3 scale;
+	for (int i = 0; i < 3; i++) {
+		scale[i] = bounds.size[i] > CMP_EPSILON ? 1023.0 / bounds.size[i] : 0.0;
+	}
+
+	// Order the queries along a Morton curve, the index is kept in the low bits.
+	for (uint32_t i = 0; i < count; i++) {
+		Vector3 cell = (batch_positions[i] - bounds.position) * scale;
+		uint32_t code = _morton_spread(_morton_cell(cell.x)) | (_morton_spread(_morton_cell(cell.y)) << 1) | (_morton_spread(_morton_cell(cell.z)) << 2);
+		batch_order[i] = ((uint64_t)code << 32) | i;
+	}
+
+	batch_order.sort();
+}
+
+void PhysicsDirectSpaceStateSW::_gather_candidates(uint32_t p_query, int p_amount, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	QueryRange &range = batch_ranges[p_query];
+	range.from = batch_candidates.size();
+
+	for (int i = 0; i < p_amount; i++) {
+		const CollisionObjectSW *col_obj = space->intersection_query_results[i];
+
+		if (!_can_collide_with(space->intersection_query_results[i], p_collision_mask, p_collide_with_bodies, p_collide_with_areas)) {
+			continue;
+		}
+
+		if (batch_exclude.size() && _is_excluded(batch_exclude, col_obj->get_self())) {
+			continue;
+		}
+
+		QueryCandidate candidate;
+		candidate.object = col_obj;
+		candidate.shape = space->intersection_query_subindex_results[i];
+		batch_candidates.push_back(candidate);
+	}
+
+	range.count = batch_candidates.size() - range.from;
+}
+
+template <class U>
+void PhysicsDirectSpaceStateSW::_run_work(uint32_t p_count, void (PhysicsDirectSpaceStateSW::*p_method)(uint32_t, U), U p_userdata) {
+#ifndef NO_THREADS
+	// The pool is busy when the query comes from a callback made during the step.
+	if (work_pool && !work_pool->is_working() && p_count > 1) {
+		if (work_pool->get_thread_count() == 0) {
+			work_pool->init();
+		}
+		work_pool->do_work(p_count, this, p_method, p_userdata);
+		return;
+	}
+#endif
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		(this->*p_method)(i, p_userdata);
+	}
+}
+
+void PhysicsDirectSpaceStateSW::_ray_batch_work(uint32_t p_batch, RayBatch *p_rays) {
+	uint32_t from = p_batch * QUERY_BATCH_SIZE;
+	uint32_t to = MIN(from + QUERY_BATCH_SIZE, (uint32_t)p_rays->count);
+
+	for (uint32_t i = from; i < to; i++) {
+		const Vector3 &begin = p_rays->from[i];
+		const Vector3 &end = p_rays->to[i];
+		Vector3 normal = (end - begin).normalized();
+
+		RayHit &hit = batch_ray_hits[i];
+		hit.object = nullptr;
+
+		real_t min_d = 1e10;
+
+		const QueryRange &range = batch_ranges[i];
+		for (uint32_t j = range.from; j < range.from + range.count; j++) {
+			const QueryCandidate &candidate = batch_candidates[j];
+
+			Vector3 shape_point, shape_normal;
+
+			if (_intersect_ray_shape(candidate.object, candidate.shape, begin, end, shape_point, shape_normal)) {
+				real_t ld = normal.dot(shape_point);
+
+				if (ld < min_d) {
+					min_d = ld;
+					hit.object = candidate.object;
+					hit.shape = candidate.shape;
+					hit.position = shape_point;
+					hit.normal = shape_normal;
+				}
+			}
+		}
+	}
+}
+
+void PhysicsDirectSpaceStateSW::_shape_batch_work(uint32_t p_batch, ShapeBatch *p_shapes) {
+	uint32_t from = p_batch * QUERY_BATCH_SIZE;
+	uint32_t to = MIN(from + QUERY_BATCH_SIZE, (uint32_t)p_shapes->count);
+
+	for (uint32_t i = from; i < to; i++) {
+		QueryCandidate *results = &batch_shape_hits[i * p_shapes->result_max];
+		int cc = 0;
+
+		const QueryRange &range = batch_ranges[i];
+		for (uint32_t j = range.from; j < range.from + range.count && cc < p_shapes->result_max; j++) {
+			const QueryCandidate &candidate = batch_candidates[j];
+			const CollisionObjectSW *col_obj = candidate.object;
+
+			if (!CollisionSolverSW::solve_static(p_shapes->shape, p_shapes->xforms[i], col_obj->get_shape(candidate.shape), col_obj->get_transform() * col_obj->get_shape_transform(candidate.shape), nullptr, nullptr, nullptr, p_shapes->margin, 0)) {
+				continue;
+			}
+
+			results[cc++] = candidate;
+		}
+
+		p_shapes->result_counts[i] = cc;
+	}
+}
+
+int PhysicsDirectSpaceStateSW::intersect_rays(const Vector3 *p_from, const Vector3 *p_to, int p_ray_count, RayResult *r_results, bool *r_hits, const Vector<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	ERR_FAIL_COND_V(space->locked, 0);
+
+	if (p_ray_count <= 0) {
+		return 0;
+	}
+
+	_set_batch_exclude(p_exclude);
+
+	batch_positions.resize(p_ray_count);
+	for (int i = 0; i < p_ray_count; i++) {
+		batch_positions[i] = (p_from[i] + p_to[i]) * 0.5;
+	}
+	_sort_batch();
+
+	batch_ranges.resize(p_ray_count);
+	batch_candidates.clear();
+
+	for (int i = 0; i < p_ray_count; i++) {
+		uint32_t ray = batch_order[i] & 0xFFFFFFFF;
+		int amount = space->broadphase->cull_segment(p_from[ray], p_to[ray], space->intersection_query_results, SpaceSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
+		_gather_candidates(ray, amount, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+	}
+
+	batch_ray_hits.resize(p_ray_count);
+
+	RayBatch rays;
+	rays.from = p_from;
+	rays.to = p_to;
+	rays.count = p_ray_count;
+
+	_run_work((p_ray_count + QUERY_BATCH_SIZE - 1) / QUERY_BATCH_SIZE, &PhysicsDirectSpaceStateSW::_ray_batch_work, &rays);
+
+	int hit_count = 0;
+
+	for (int i = 0; i < p_ray_count; i++) {
+		const RayHit &hit = batch_ray_hits[i];
+
+		r_hits[i] = hit.object != nullptr;
+		if (!hit.object) {
+			continue;
+		}
+
+		RayResult &r_result = r_results[i];
+		r_result.collider_id = hit.object->get_instance_id();
+		if (r_result.collider_id != 0) {
+			r_result.collider = ObjectDB::get_instance(r_result.collider_id);
+		} else {
+			r_result.collider = nullptr;
+		}
+		r_result.normal = hit.normal;
+		r_result.position = hit.position;
+		r_result.rid = hit.object->get_self();
+		r_result.shape = hit.shape;
+
+		hit_count++;
+	}
+
+	return hit_count;
+}
+
+int PhysicsDirectSpaceStateSW::intersect_shapes(const RID &p_shape, const Transform *p_xforms, int p_query_count, real_t p_margin, ShapeResult *r_results, int p_result_max, int *r_result_counts, const Vector<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	ERR_FAIL_COND_V(space->locked, 0);
+
+	if (p_query_count <= 0) {
+		return 0;
+	}
+
+	if (p_result_max <= 0) {
+		for (int i = 0; i < p_query_count; i++) {
+			r_result_counts[i] = 0;
+		}
+		return 0;
+	}
+
+	ShapeSW *shape = PhysicsServerSW::singleton->shape_owner.get(p_shape);
+	ERR_FAIL_COND_V(!shape, 0);
+
+	_set_batch_exclude(p_exclude);
+
+	batch_positions.resize(p_query_count);
+	for (int i = 0; i < p_query_count; i++) {
+		batch_positions[i] = p_xforms[i].origin;
+	}
+	_sort_batch();
+
+	batch_ranges.resize(p_query_count);
+	batch_candidates.clear();
+
+	AABB shape_aabb = shape->get_aabb();
+
+	for (int i = 0; i < p_query_count; i++) {
+		uint32_t query = batch_order[i] & 0xFFFFFFFF;
+		AABB aabb = p_xforms[query].xform(shape_aabb);
+		int amount = space->broadphase->cull_aabb(aabb, space->intersection_query_results, SpaceSW::INTERSECTION_QUERY_MAX, space->intersection_query_subindex_results);
+		_gather_candidates(query, amount, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+	}
+
+	batch_shape_hits.resize(p_query_count * p_result_max);
+
+	ShapeBatch shapes;
+	shapes.shape = shape;
+	shapes.xforms = p_xforms;
+	shapes.margin = p_margin;
+	shapes.result_max = p_result_max;
+	shapes.result_counts = r_result_counts;
+	shapes.count = p_query_count;
+
+	_run_work((p_query_count + QUERY_BATCH_SIZE - 1) / QUERY_BATCH_SIZE, &PhysicsDirectSpaceStateSW::_shape_batch_work, &shapes);
+
+	int result_count = 0;
+
+	for (int i = 0; i < p_query_count; i++) {
+		for (int j = 0; j < r_result_counts[i]; j++) {
+			const QueryCandidate &hit = batch_shape_hits[i * p_result_max + j];
+
+			ShapeResult &r_result = r_results[i * p_result_max + j];
+			r_result.collider_id = hit.object->get_instance_id();
+			if (r_result.collider_id != 0) {
+				r_result.collider = ObjectDB::get_instance(r_result.collider_id);
+			} else {
+				r_result.collider = nullptr;
+			}
+			r_result.rid = hit.object->get_self();
+			r_result.shape = hit.shape;
+		}
+
+		result_count += r_result_counts[i];
+	}
+
+	return result_count;
+}
+
 PhysicsDirectSpaceStateSW::PhysicsDirectSpaceStateSW() {
 	space = nullptr;
+	work_pool = nullptr;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1169,6 +1489,11 @@ void SpaceSW::remove_object(CollisionObjectSW *p_object) {
 	objects.erase(p_object);
 }
 
+void SpaceSW::body_pair_add_to_list(SelfList<BodyPairSW> *p_pair) {
+	// removed by the pair's destructor
+	body_pair_list.add(p_pair);
+}
+
 const RBSet<CollisionObjectSW *> &SpaceSW::get_objects() const {
 	return objects;
 }
@@ -1225,6 +1550,223 @@ void SpaceSW::update() {
 	broadphase->update();
 }
 
+// Snapshots store the state of the non static bodies and the contact caches
+// of the body pairs, in native layout, as they are only meant to be restored
+// by the same build. Bodies and pairs are sorted by RID id, so the same state
+// always gives the same bytes.
+
+#define SPACE_SNAPSHOT_MAGIC 0x50534E33 // "PSN3"
+#define SPACE_SNAPSHOT_VERSION 2
+
+struct SpaceSnapshotHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t real_size;
+	uint32_t body_count;
+	uint32_t pair_count;
+};
+
+struct SpaceSnapshotBody {
+	uint32_t id;
+	BodySW::SnapshotState state;
+
+	bool operator<(const SpaceSnapshotBody &p_other) const { return id < p_other.id; }
+};
+
+struct SpaceSnapshotPairKey {
+	uint32_t id_A;
+	int32_t shape_A;
+	uint32_t id_B;
+	int32_t shape_B;
+
+	bool operator==(const SpaceSnapshotPairKey &p_other) const {
+		return id_A == p_other.id_A && shape_A == p_other.shape_A && id_B == p_other.id_B && shape_B == p_other.shape_B;
+	}
+
+	bool operator<(const SpaceSnapshotPairKey &p_other) const {
+		if (id_A != p_other.id_A) {
+			return id_A < p_other.id_A;
+		}
+		if (shape_A != p_other.shape_A) {
+			return shape_A < p_other.shape_A;
+		}
+		if (id_B != p_other.id_B) {
+			return id_B < p_other.id_B;
+		}
+		return shape_B < p_other.shape_B;
+	}
+
+	// The broadphase may report a pair in either order, so the key always
+	// puts the lower (id, shape) first. Returns true if that swapped A and B.
+	bool set(const BodyPairSW *p_pair) {
+		id_A = p_pair->get_body_a()->get_self().get_id();
+		shape_A = p_pair->get_shape_a();
+		id_B = p_pair->get_body_b()->get_self().get_id();
+		shape_B = p_pair->get_shape_b();
+
+		if (id_B < id_A || (id_B == id_A && shape_B < shape_A)) {
+			SWAP(id_A, id_B);
+			SWAP(shape_A, shape_B);
+			return true;
+		}
+		return false;
+	}
+};
+
+struct SpaceSnapshotPair {
+	SpaceSnapshotPairKey key;
+	BodyPairSW::SnapshotState state;
+
+	bool operator<(const SpaceSnapshotPair &p_other) const { return key < p_other.key; }
+};
+
+PoolVector<uint8_t> SpaceSW::get_snapshot() const {
+	LocalVector<SpaceSnapshotBody> bodies;
+	LocalVector<SpaceSnapshotPair> pairs;
+
+	for (const RBSet<CollisionObjectSW *>::Element *E = objects.front(); E; E = E->next()) {
+		if (E->get()->get_type() != CollisionObjectSW::TYPE_BODY) {
+			continue;
+		}
+
+		const BodySW *body = static_cast<const BodySW *>(E->get());
+		if (body->get_mode() == PhysicsServer::BODY_MODE_STATIC) {
+			continue;
+		}
+
+		SpaceSnapshotBody snapshot_body;
+		memset((void *)&snapshot_body, 0, sizeof(SpaceSnapshotBody)); // padding too, for identical bytes
+		snapshot_body.id = body->get_self().get_id();
+		body->get_snapshot_state(snapshot_body.state);
+		bodies.push_back(snapshot_body);
+	}
+
+	for (const SelfList<BodyPairSW> *E = body_pair_list.first(); E; E = E->next()) {
+		SpaceSnapshotPair snapshot_pair;
+		memset((void *)&snapshot_pair, 0, sizeof(SpaceSnapshotPair));
+		bool swapped = snapshot_pair.key.set(E->self());
+		E->self()->get_snapshot_state(snapshot_pair.state);
+		if (swapped) {
+			BodyPairSW::swap_snapshot_state(snapshot_pair.state); // stored in key order
+		}
+		pairs.push_back(snapshot_pair);
+	}
+
+	bodies.sort();
+	pairs.sort();
+
+	SpaceSnapshotHeader header;
+	header.magic = SPACE_SNAPSHOT_MAGIC;
+	header.version = SPACE_SNAPSHOT_VERSION;
+	header.real_size = sizeof(real_t);
+	header.body_count = bodies.size();
+	header.pair_count = pairs.size();
+
+	uint32_t bodies_size = bodies.size() * sizeof(SpaceSnapshotBody);
+	uint32_t pairs_size = pairs.size() * sizeof(SpaceSnapshotPair);
+
+	PoolVector<uint8_t> snapshot;
+	snapshot.resize(sizeof(SpaceSnapshotHeader) + bodies_size + pairs_size);
+
+	PoolVector<uint8_t>::Write w = snapshot.write();
+	uint8_t *ptr = w.ptr();
+	memcpy(ptr, &header, sizeof(SpaceSnapshotHeader));
+	ptr += sizeof(SpaceSnapshotHeader);
+	if (bodies_size) {
+		memcpy(ptr, bodies.ptr(), bodies_size);
+		ptr += bodies_size;
+	}
+	if (pairs_size) {
+		memcpy(ptr, pairs.ptr(), pairs_size);
+	}
+
+	return snapshot;
+}
+
+Error SpaceSW::set_snapshot(const PoolVector<uint8_t> &p_snapshot) {
+	ERR_FAIL_COND_V_MSG(locked, ERR_LOCKED, "Can't restore a snapshot while the space is being stepped.");
+	ERR_FAIL_COND_V(p_snapshot.size() < (int)sizeof(SpaceSnapshotHeader), ERR_INVALID_DATA);
+
+	PoolVector<uint8_t>::Read r = p_snapshot.read();
+	const uint8_t *ptr = r.ptr();
+
+	SpaceSnapshotHeader header;
+	memcpy(&header, ptr, sizeof(SpaceSnapshotHeader));
+	ptr += sizeof(SpaceSnapshotHeader);
+
+	ERR_FAIL_COND_V_MSG(header.magic != SPACE_SNAPSHOT_MAGIC || header.version != SPACE_SNAPSHOT_VERSION, ERR_INVALID_DATA, "Invalid physics space snapshot.");
+	ERR_FAIL_COND_V_MSG(header.real_size != sizeof(real_t), ERR_INVALID_DATA, "Physics space snapshot was made by a build with a different real_t size.");
+	ERR_FAIL_COND_V(p_snapshot.size() != (int)(sizeof(SpaceSnapshotHeader) + header.body_count * sizeof(SpaceSnapshotBody) + header.pair_count * sizeof(SpaceSnapshotPair)), ERR_INVALID_DATA);
+
+	HashMap<uint32_t, BodySW *> bodies;
+	for (const RBSet<CollisionObjectSW *>::Element *E = objects.front(); E; E = E->next()) {
+		if (E->get()->get_type() == CollisionObjectSW::TYPE_BODY) {
+			bodies.set(E->get()->get_self().get_id(), static_cast<BodySW *>(E->get()));
+		}
+	}
+
+	// bodies created after the snapshot keep their state, removed ones are skipped
+	for (uint32_t i = 0; i < header.body_count; i++) {
+		SpaceSnapshotBody snapshot_body;
+		memcpy(&snapshot_body, ptr, sizeof(SpaceSnapshotBody));
+		ptr += sizeof(SpaceSnapshotBody);
+
+		BodySW **body = bodies.getptr(snapshot_body.id);
+		if (!body || (*body)->get_mode() == PhysicsServer::BODY_MODE_STATIC) {
+			continue;
+		}
+		(*body)->set_snapshot_state(snapshot_body.state);
+	}
+
+	// Create and remove the pairs for the restored transforms right away,
+	// so their contacts can be restored before the next step.
+	broadphase->update();
+
+	LocalVector<SpaceSnapshotPair> pairs;
+	pairs.resize(header.pair_count);
+	if (header.pair_count) {
+		memcpy(pairs.ptr(), ptr, header.pair_count * sizeof(SpaceSnapshotPair));
+	}
+
+	struct CurrentPair {
+		SpaceSnapshotPairKey key;
+		BodyPairSW *pair;
+		bool swapped;
+
+		bool operator<(const CurrentPair &p_other) const { return key < p_other.key; }
+	};
+
+	LocalVector<CurrentPair> current_pairs;
+	for (SelfList<BodyPairSW> *E = body_pair_list.first(); E; E = E->next()) {
+		CurrentPair current;
+		current.swapped = current.key.set(E->self());
+		current.pair = E->self();
+		current_pairs.push_back(current);
+	}
+	current_pairs.sort();
+
+	// both lists are sorted by key, pairs which did not exist in the snapshot start without contacts
+	uint32_t snapshot_index = 0;
+	for (uint32_t i = 0; i < current_pairs.size(); i++) {
+		const CurrentPair &current = current_pairs[i];
+
+		while (snapshot_index < pairs.size() && pairs[snapshot_index].key < current.key) {
+			snapshot_index++;
+		}
+
+		if (snapshot_index < pairs.size() && pairs[snapshot_index].key == current.key) {
+			if (current.swapped) {
+				BodyPairSW::swap_snapshot_state(pairs[snapshot_index].state);
+			}
+			current.pair->set_snapshot_state(pairs[snapshot_index].state);
+		} else {
+			current.pair->clear_contacts();
+		}
+	}
+
+	return OK;
+}
+
 void SpaceSW::set_param(PhysicsServer::SpaceParameter p_param, real_t p_value) {
 	switch (p_param) {
 		case PhysicsServer::SPACE_PARAM_CONTACT_RECYCLE_RADIUS:
@@ -1323,6 +1865,11 @@ SpaceSW::SpaceSW() {
 	}
 }
 
+void SpaceSW::set_work_pool(ThreadWorkPool *p_work_pool) {
+	broadphase->set_work_pool(p_work_pool);
+	direct_access->set_work_pool(p_work_pool);
+}
+
 SpaceSW::~SpaceSW() {
 	memdelete(broadphase);
 	memdelete(direct_access);
@@ -40,14 +40,79 @@
 #include "collision_object_sw.h"
 #include "core/config/project_settings.h"
 #include "core/containers/hash_map.h"
+#include "core/containers/local_vector.h"
+#include "core/os/spin_lock.h"
+#include "core/os/thread_work_pool.h"
 #include "core/typedefs.h"
 
 class PhysicsDirectSpaceStateSW : public PhysicsDirectSpaceState {
 	GDCLASS(PhysicsDirectSpaceStateSW, PhysicsDirectSpaceState);
 
+	enum {
+		// Batched queries are tested in groups of this size when using threads.
+		QUERY_BATCH_SIZE = 32,
+	};
+
+	struct QueryCandidate {
+		const CollisionObjectSW *object;
+		int shape;
+	};
+
+	struct QueryRange {
+		uint32_t from;
+		uint32_t count;
+	};
+
+	struct RayHit {
+		const CollisionObjectSW *object;
+		int shape;
+		Vector3 position;
+		Vector3 normal;
+	};
+
+	struct RayBatch {
+		const Vector3 *from;
+		const Vector3 *to;
+		int count;
+	};
+
+	struct ShapeBatch {
+		const ShapeSW *shape;
+		const Transform *xforms;
+		real_t margin;
+		int result_max;
+		int *result_counts;
+		int count;
+	};
+
+	// The broadphase is culled serially for all the queries of a batch (in spatial order,
+	// so consecutive queries walk the same part of the tree), then the shapes are tested
+	// in parallel, on the server's pool (null when it doesn't use threads).
+	ThreadWorkPool *work_pool;
+
+	LocalVector<RID> batch_exclude;
+	LocalVector<Vector3> batch_positions;
+	LocalVector<uint64_t> batch_order;
+	LocalVector<QueryRange> batch_ranges;
+	LocalVector<QueryCandidate> batch_candidates;
+	LocalVector<RayHit> batch_ray_hits;
+	LocalVector<QueryCandidate> batch_shape_hits;
+
+	void _set_batch_exclude(const Vector<RID> &p_exclude);
+	void _sort_batch();
+	void _gather_candidates(uint32_t p_query, int p_amount, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas);
+
+	void _ray_batch_work(uint32_t p_batch, RayBatch *p_rays);
+	void _shape_batch_work(uint32_t p_batch, ShapeBatch *p_shapes);
+
+	template <class U>
+	void _run_work(uint32_t p_count, void (PhysicsDirectSpaceStateSW::*p_method)(uint32_t, U), U p_userdata);
+
 public:
 	SpaceSW *space;
 
+	void set_work_pool(ThreadWorkPool *p_work_pool) { work_pool = p_work_pool; }
+
 	virtual int intersect_point(const Vector3 &p_point, ShapeResult *r_results, int p_result_max, const RBSet<RID> &p_exclude = RBSet<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
 	virtual bool intersect_ray(const Vector3 &p_from, const Vector3 &p_to, RayResult &r_result, const RBSet<RID> &p_exclude = RBSet<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false, bool p_pick_ray = false);
 	virtual int intersect_shape(const RID &p_shape, const Transform &p_xform, real_t p_margin, ShapeResult *r_results, int p_result_max, const RBSet<RID> &p_exclude = RBSet<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
@@ -56,6 +121,9 @@ public:
 	virtual bool rest_info(RID p_shape, const Transform &p_shape_xform, real_t p_margin, ShapeRestInfo *r_info, const RBSet<RID> &p_exclude = RBSet<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
 	virtual Vector3 get_closest_point_to_object_volume(RID p_object, const Vector3 p_point) const;
 
+	virtual int intersect_rays(const Vector3 *p_from, const Vector3 *p_to, int p_ray_count, RayResult *r_results, bool *r_hits, const Vector<RID> &p_exclude = Vector<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
+	virtual int intersect_shapes(const RID &p_shape, const Transform *p_xforms, int p_query_count, real_t p_margin, ShapeResult *r_results, int p_result_max, int *r_result_counts, const Vector<RID> &p_exclude = Vector<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
+
 	PhysicsDirectSpaceStateSW();
 };
 
@@ -83,6 +151,7 @@ private:
 	SelfList<BodySW>::List state_query_list;
 	SelfList<AreaSW>::List monitor_query_list;
 	SelfList<AreaSW>::List area_moved_list;
+	SelfList<BodyPairSW>::List body_pair_list;
 
 	static void *_broadphase_pair(CollisionObjectSW *p_object_A, int p_subindex_A, CollisionObjectSW *p_object_B, int p_subindex_B, void *p_pair_data, void *p_self);
 	static void _broadphase_unpair(CollisionObjectSW *p_object_A, int p_subindex_A, CollisionObjectSW *p_object_B, int p_subindex_B, void *p_pair_data, void *p_self);
@@ -121,6 +190,10 @@ private:
 	Vector<Vector3> contact_debug;
 	int contact_debug_count;
 
+	// Guards what islands stepped in parallel can share: non-dynamic bodies,
+	// areas and the debug contacts.
+	SpinLock shared_state_lock;
+
 	friend class PhysicsDirectSpaceStateSW;
 
 	int _cull_aabb_for_body(BodySW *p_body, const AABB &p_aabb);
@@ -132,6 +205,8 @@ public:
 	_FORCE_INLINE_ void set_step(const real_t &p_step) { step = p_step; }
 	_FORCE_INLINE_ real_t get_step() const { return step; }
 
+	_FORCE_INLINE_ SpinLock &get_shared_state_lock() { return shared_state_lock; }
+
 	void set_default_area(AreaSW *p_area) { area = p_area; }
 	AreaSW *get_default_area() const { return area; }
 
@@ -150,6 +225,8 @@ public:
 	void area_remove_from_moved_list(SelfList<AreaSW> *p_area);
 	const SelfList<AreaSW>::List &get_moved_area_list() const;
 
+	void body_pair_add_to_list(SelfList<BodyPairSW> *p_pair);
+
 	BroadPhaseSW *get_broadphase();
 
 	void add_object(CollisionObjectSW *p_object);
@@ -169,6 +246,9 @@ public:
 	void setup();
 	void call_queries();
 
+	PoolVector<uint8_t> get_snapshot() const;
+	Error set_snapshot(const PoolVector<uint8_t> &p_snapshot);
+
 	bool is_locked() const;
 	void lock();
 	void unlock();
@@ -185,13 +265,17 @@ public:
 	int get_collision_pairs() const { return collision_pairs; }
 
 	PhysicsDirectSpaceStateSW *get_direct_state();
+	// The server's pool, null when it doesn't use threads.
+	void set_work_pool(ThreadWorkPool *p_work_pool);
 
 	void set_debug_contacts(int p_amount) { contact_debug.resize(p_amount); }
 	_FORCE_INLINE_ bool is_debugging_contacts() const { return !contact_debug.empty(); }
 	_FORCE_INLINE_ void add_debug_contact(const Vector3 &p_contact) {
+		shared_state_lock.lock();
 		if (contact_debug_count < contact_debug.size()) {
 			contact_debug.write[contact_debug_count++] = p_contact;
 		}
+		shared_state_lock.unlock();
 	}
 	_FORCE_INLINE_ Vector<Vector3> get_debug_contacts() { return contact_debug; }
 	_FORCE_INLINE_ int get_debug_contact_count() { return contact_debug_count; }
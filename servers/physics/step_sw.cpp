@@ -140,6 +140,81 @@ void StepSW::_check_suspend(BodySW *p_island, real_t p_delta) {
 	}
 }
 
+void StepSW::_gather_active_bodies(const SelfList<BodySW>::List *p_body_list) {
+	active_bodies.clear();
+
+	const SelfList<BodySW> *b = p_body_list->first();
+	while (b) {
+		active_bodies.push_back(b->self());
+		b = b->next();
+	}
+}
+
+template <class U>
+void StepSW::_run_work(uint32_t p_count, void (StepSW::*p_method)(uint32_t, U), U p_userdata) {
+#ifndef NO_THREADS
+	if (work_pool && p_count > 1) {
+		if (work_pool->get_thread_count() == 0) {
+			work_pool->init();
+		}
+		work_pool->do_work(p_count, this, p_method, p_userdata);
+		return;
+	}
+#endif
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		(this->*p_method)(i, p_userdata);
+	}
+}
+
+void StepSW::_integrate_forces_batch(uint32_t p_batch, BodySW **p_bodies) {
+	uint32_t from = p_batch * BODY_BATCH_SIZE;
+	uint32_t to = MIN(from + BODY_BATCH_SIZE, active_bodies.size());
+
+	for (uint32_t i = from; i < to; i++) {
+		p_bodies[i]->integrate_forces(_delta, &body_states, i);
+	}
+
+	body_states.integrate_forces(p_batch, _delta);
+
+	for (uint32_t i = from; i < to; i++) {
+		p_bodies[i]->apply_integrated_forces(_delta, &body_states, i);
+	}
+}
+
+void StepSW::_integrate_velocities_batch(uint32_t p_batch, BodySW **p_bodies) {
+	uint32_t from = p_batch * BODY_BATCH_SIZE;
+	uint32_t to = MIN(from + BODY_BATCH_SIZE, active_bodies.size());
+
+	for (uint32_t i = from; i < to; i++) {
+		p_bodies[i]->integrate_velocities(_delta, &body_states, i);
+	}
+
+	body_states.integrate_velocities(p_batch, _delta);
+
+	for (uint32_t i = from; i < to; i++) {
+		p_bodies[i]->apply_integrated_velocities(&body_states, i);
+	}
+}
+
+void StepSW::_generate_contacts_batch(uint32_t p_batch, ConstraintSW **p_constraints) {
+	uint32_t from = p_batch * CONSTRAINT_BATCH_SIZE;
+	uint32_t to = MIN(from + CONSTRAINT_BATCH_SIZE, constraints.size());
+
+	for (uint32_t i = from; i < to; i++) {
+		p_constraints[i]->generate_contacts(_delta);
+	}
+}
+
+void StepSW::_setup_island_work(uint32_t p_index, ConstraintSW **p_islands) {
+	_setup_island(p_islands[p_index], _delta);
+}
+
+void StepSW::_solve_island_work(uint32_t p_index, ConstraintSW **p_islands) {
+	//iterating each island separatedly improves cache efficiency
+	_solve_island(p_islands[p_index], _iterations, _delta);
+}
+
 void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 	p_space->lock(); // can't access space during this
 	p_space->set_step(p_delta);
@@ -147,18 +222,23 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 
 	const SelfList<BodySW>::List *body_list = &p_space->get_active_body_list();
 
+	_delta = p_delta;
+	_iterations = p_iterations;
+
 	/* INTEGRATE FORCES */
 
 	uint64_t profile_begtime = OS::get_singleton()->get_ticks_usec();
 	uint64_t profile_endtime = 0;
 
-	int active_count = 0;
+	_gather_active_bodies(body_list);
 
-	const SelfList<BodySW> *b = body_list->first();
-	while (b) {
-		b->self()->integrate_forces(p_delta);
-		b = b->next();
-		active_count++;
+	int active_count = active_bodies.size();
+
+	body_states.resize(active_bodies.size());
+	_run_work((active_bodies.size() + BODY_BATCH_SIZE - 1) / BODY_BATCH_SIZE, &StepSW::_integrate_forces_batch, active_bodies.ptr());
+
+	for (uint32_t i = 0; i < active_bodies.size(); i++) {
+		active_bodies[i]->finish_integrate_forces();
 	}
 
 	p_space->set_active_objects(active_count);
@@ -176,7 +256,7 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 
 	BodySW *island_list = nullptr;
 	ConstraintSW *constraint_island_list = nullptr;
-	b = body_list->first();
+	const SelfList<BodySW> *b = body_list->first();
 
 	int island_count = 0;
 
@@ -226,14 +306,32 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* SETUP CONSTRAINT ISLANDS */
 
+	constraint_islands.clear();
+
 	{
 		ConstraintSW *ci = constraint_island_list;
 		while (ci) {
-			_setup_island(ci, p_delta);
+			constraint_islands.push_back(ci);
 			ci = ci->get_island_list_next();
 		}
 	}
 
+	// Run the narrow phase of all the constraints first, so it is spread evenly
+	// across the threads even when most of them end up in the same island.
+	constraints.clear();
+
+	for (uint32_t i = 0; i < constraint_islands.size(); i++) {
+		ConstraintSW *ci = constraint_islands[i];
+		while (ci) {
+			constraints.push_back(ci);
+			ci = ci->get_island_next();
+		}
+	}
+
+	_run_work((constraints.size() + CONSTRAINT_BATCH_SIZE - 1) / CONSTRAINT_BATCH_SIZE, &StepSW::_generate_contacts_batch, constraints.ptr());
+
+	_run_work(constraint_islands.size(), &StepSW::_setup_island_work, constraint_islands.ptr());
+
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
 		p_space->set_elapsed_time(SpaceSW::ELAPSED_TIME_SETUP_CONSTRAINTS, profile_endtime - profile_begtime);
@@ -242,14 +340,7 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* SOLVE CONSTRAINT ISLANDS */
 
-	{
-		ConstraintSW *ci = constraint_island_list;
-		while (ci) {
-			//iterating each island separatedly improves cache efficiency
-			_solve_island(ci, p_iterations, p_delta);
-			ci = ci->get_island_list_next();
-		}
-	}
+	_run_work(constraint_islands.size(), &StepSW::_solve_island_work, constraint_islands.ptr());
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
@@ -259,11 +350,15 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* INTEGRATE VELOCITIES */
 
-	b = body_list->first();
-	while (b) {
-		const SelfList<BodySW> *n = b->next();
-		b->self()->integrate_velocities(p_delta);
-		b = n;
+	// Pairs created by the broadphase update can wake bodies up, gather the list again.
+	_gather_active_bodies(body_list);
+
+	body_states.resize(active_bodies.size());
+	_run_work((active_bodies.size() + BODY_BATCH_SIZE - 1) / BODY_BATCH_SIZE, &StepSW::_integrate_velocities_batch, active_bodies.ptr());
+
+	for (uint32_t i = 0; i < active_bodies.size(); i++) {
+		// Can remove the body from the active list, which is why the bodies were gathered.
+		active_bodies[i]->finish_integrate_velocities();
 	}
 
 	/* SLEEP / WAKE UP ISLANDS */
@@ -288,4 +383,7 @@ void StepSW::step(SpaceSW *p_space, real_t p_delta, int p_iterations) {
 
 StepSW::StepSW() {
 	_step = 1;
+	_delta = 0;
+	_iterations = 0;
+	work_pool = nullptr;
 }
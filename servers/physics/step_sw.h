@@ -34,16 +34,54 @@
 
 #include "space_sw.h"
 
+#include "body_state_storage_sw.h"
+#include "core/containers/local_vector.h"
+#include "core/os/thread_work_pool.h"
+
 class StepSW {
+	enum {
+		// Bodies are integrated in batches of this size when using threads,
+		// one block of the body state storage each.
+		BODY_BATCH_SIZE = BodyStateStorageSW::BATCH_SIZE,
+		// Same for the narrow phase of the constraints.
+		CONSTRAINT_BATCH_SIZE = 16,
+	};
+
 	uint64_t _step;
 
+	// Islands are independent, so their setup and solve (and the integration
+	// of the active bodies) is spread across a work pool. The islands can still
+	// share static and kinematic bodies, see SpaceSW::get_shared_state_lock().
+	// The pool belongs to the server, null when it doesn't use threads.
+	ThreadWorkPool *work_pool;
+
+	real_t _delta;
+	int _iterations;
+	LocalVector<BodySW *> active_bodies;
+	// Indexed like active_bodies.
+	BodyStateStorageSW body_states;
+	LocalVector<ConstraintSW *> constraint_islands;
+	LocalVector<ConstraintSW *> constraints;
+
+	void _gather_active_bodies(const SelfList<BodySW>::List *p_body_list);
 	void _populate_island(BodySW *p_body, BodySW **p_island, ConstraintSW **p_constraint_island);
 	void _setup_island(ConstraintSW *p_island, real_t p_delta);
 	void _solve_island(ConstraintSW *p_island, int p_iterations, real_t p_delta);
 	void _check_suspend(BodySW *p_island, real_t p_delta);
 
+	void _integrate_forces_batch(uint32_t p_batch, BodySW **p_bodies);
+	void _integrate_velocities_batch(uint32_t p_batch, BodySW **p_bodies);
+	void _generate_contacts_batch(uint32_t p_batch, ConstraintSW **p_constraints);
+	void _setup_island_work(uint32_t p_index, ConstraintSW **p_islands);
+	void _solve_island_work(uint32_t p_index, ConstraintSW **p_islands);
+
+	template <class U>
+	void _run_work(uint32_t p_count, void (StepSW::*p_method)(uint32_t, U), U p_userdata);
+
 public:
 	void step(SpaceSW *p_space, real_t p_delta, int p_iterations);
+	void set_work_pool(ThreadWorkPool *p_work_pool) { work_pool = p_work_pool; }
+
 	StepSW();
 };
 
@@ -31,6 +31,7 @@
 
 #include "area_pair_2d_sw.h"
 #include "collision_solver_2d_sw.h"
+#include "space_2d_sw.h"
 
 bool AreaPair2DSW::setup(real_t p_step) {
 	bool result = false;
@@ -39,6 +40,10 @@ bool AreaPair2DSW::setup(real_t p_step) {
 	}
 
 	if (result != colliding) {
+		// Areas and bodies outside of the island can be shared with islands set up in parallel.
+		SpinLock &shared_state_lock = area->get_space()->get_shared_state_lock();
+		shared_state_lock.lock();
+
 		if (result) {
 			if (area->get_space_override_mode() != Physics2DServer::AREA_SPACE_OVERRIDE_DISABLED) {
 				body->add_area(area);
@@ -57,6 +62,8 @@ bool AreaPair2DSW::setup(real_t p_step) {
 		}
 
 		colliding = result;
+
+		shared_state_lock.unlock();
 	}
 
 	return false; //never do any post solving
@@ -100,6 +107,9 @@ bool Area2Pair2DSW::setup(real_t p_step) {
 	}
 
 	if (result != colliding) {
+		SpinLock &shared_state_lock = area_a->get_space()->get_shared_state_lock();
+		shared_state_lock.lock();
+
 		if (result) {
 			if (area_b->has_area_monitor_callback() && area_a_monitorable) {
 				area_b->add_area_to_query(area_a, shape_a, shape_b);
@@ -120,6 +130,8 @@ bool Area2Pair2DSW::setup(real_t p_step) {
 		}
 
 		colliding = result;
+
+		shared_state_lock.unlock();
 	}
 
 	return false; //never do any post solving
@@ -102,6 +102,28 @@ void Body2DSW::update_inertias() {
 	//_update_shapes();
 }
 
+void Body2DSW::get_snapshot_state(SnapshotState &r_state) const {
+	r_state.transform = get_transform();
+	r_state.linear_velocity = linear_velocity;
+	r_state.angular_velocity = angular_velocity;
+	r_state.still_time = still_time;
+	r_state.active = active;
+}
+
+void Body2DSW::set_snapshot_state(const SnapshotState &p_state) {
+	_set_transform(p_state.transform);
+	_set_inv_transform(p_state.transform.affine_inverse());
+	new_transform = p_state.transform;
+
+	linear_velocity = p_state.linear_velocity;
+	angular_velocity = p_state.angular_velocity;
+	biased_linear_velocity = Vector2();
+	biased_angular_velocity = 0;
+	still_time = p_state.still_time;
+
+	set_active(p_state.active);
+}
+
 void Body2DSW::set_active(bool p_active) {
 	if (active == p_active) {
 		return;
@@ -525,7 +547,8 @@ void Body2DSW::integrate_forces(real_t p_step) {
 	biased_linear_velocity = Vector2();
 
 	if (do_motion) { //shapes temporarily extend for raycast
-		_update_shapes_with_motion(motion);
+		pending_shape_motion = motion;
+		pending_shape_motion_update = true;
 	}
 
 	// damp_area=NULL; // clear the area, so it is set in the next frame
@@ -533,21 +556,21 @@ void Body2DSW::integrate_forces(real_t p_step) {
 	contact_count = 0;
 }
 
+void Body2DSW::finish_integrate_forces() {
+	if (pending_shape_motion_update) {
+		_update_shapes_with_motion(pending_shape_motion);
+		pending_shape_motion_update = false;
+	}
+}
+
 void Body2DSW::integrate_velocities(real_t p_step) {
 	if (mode == Physics2DServer::BODY_MODE_STATIC) {
 		return;
 	}
 
-	if (fi_callback) {
-		get_space()->body_add_to_state_query_list(&direct_state_query_list);
-	}
-
 	if (mode == Physics2DServer::BODY_MODE_KINEMATIC) {
 		_set_transform(new_transform, false);
 		_set_inv_transform(new_transform.affine_inverse());
-		if (contacts.size() == 0 && linear_velocity == Vector2() && angular_velocity == 0) {
-			set_active(false); //stopped moving, deactivate
-		}
 		return;
 	}
 
@@ -557,7 +580,7 @@ void Body2DSW::integrate_velocities(real_t p_step) {
 	real_t angle = get_transform().get_rotation() + total_angular_velocity * p_step;
 	Vector2 pos = get_transform().get_origin() + total_linear_velocity * p_step;
 
-	_set_transform(Transform2D(angle, pos), continuous_cd_mode == Physics2DServer::CCD_MODE_DISABLED);
+	_set_transform(Transform2D(angle, pos), false);
 	_set_inv_transform(get_transform().inverse());
 
 	if (continuous_cd_mode != Physics2DServer::CCD_MODE_DISABLED) {
@@ -567,6 +590,27 @@ void Body2DSW::integrate_velocities(real_t p_step) {
 	//_update_inertia_tensor();
 }
 
+void Body2DSW::finish_integrate_velocities() {
+	if (mode == Physics2DServer::BODY_MODE_STATIC) {
+		return;
+	}
+
+	if (fi_callback) {
+		get_space()->body_add_to_state_query_list(&direct_state_query_list);
+	}
+
+	if (mode == Physics2DServer::BODY_MODE_KINEMATIC) {
+		if (contacts.size() == 0 && linear_velocity == Vector2() && angular_velocity == 0) {
+			set_active(false); //stopped moving, deactivate
+		}
+		return;
+	}
+
+	if (continuous_cd_mode == Physics2DServer::CCD_MODE_DISABLED) {
+		_update_shapes();
+	}
+}
+
 void Body2DSW::wakeup_neighbours() {
 	for (RBMap<Constraint2DSW *, int>::Element *E = constraint_map.front(); E; E = E->next()) {
 		const Constraint2DSW *c = E->key();
@@ -672,6 +716,7 @@ Body2DSW::Body2DSW() :
 	contact_count = 0;
 	gravity_scale = 1.0;
 	first_integration = false;
+	pending_shape_motion_update = false;
 
 	still_time = 0;
 	continuous_cd_mode = Physics2DServer::CCD_MODE_DISABLED;
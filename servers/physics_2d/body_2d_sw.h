@@ -84,6 +84,10 @@ class Body2DSW : public CollisionObject2DSW {
 	bool can_sleep;
 	bool first_time_kinematic;
 	bool first_integration;
+
+	// Broadphase work left over by integrate_forces(), see finish_integrate_forces().
+	Vector2 pending_shape_motion;
+	bool pending_shape_motion_update;
 	void _update_inertia();
 	virtual void _shapes_changed();
 	Transform2D new_transform;
@@ -208,20 +212,35 @@ public:
 	_FORCE_INLINE_ void set_biased_angular_velocity(real_t p_velocity) { biased_angular_velocity = p_velocity; }
 	_FORCE_INLINE_ real_t get_biased_angular_velocity() const { return biased_angular_velocity; }
 
+	// Static and kinematic bodies have no inverse mass, impulses can't change
+	// them. Returning early also keeps islands solved in parallel from writing to
+	// the non-dynamic bodies they share.
 	_FORCE_INLINE_ void apply_central_impulse(const Vector2 &p_impulse) {
+		if (mode <= Physics2DServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		linear_velocity += p_impulse * _inv_mass;
 	}
 
 	_FORCE_INLINE_ void apply_impulse(const Vector2 &p_offset, const Vector2 &p_impulse) {
+		if (mode <= Physics2DServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		linear_velocity += p_impulse * _inv_mass;
 		angular_velocity += _inv_inertia * p_offset.cross(p_impulse);
 	}
 
 	_FORCE_INLINE_ void apply_torque_impulse(real_t p_torque) {
+		if (mode <= Physics2DServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		angular_velocity += _inv_inertia * p_torque;
 	}
 
 	_FORCE_INLINE_ void apply_bias_impulse(const Vector2 &p_pos, const Vector2 &p_j) {
+		if (mode <= Physics2DServer::BODY_MODE_KINEMATIC) {
+			return;
+		}
 		biased_linear_velocity += p_j * _inv_mass;
 		biased_angular_velocity += _inv_inertia * p_pos.cross(p_j);
 	}
@@ -229,6 +248,18 @@ public:
 	void set_active(bool p_active);
 	_FORCE_INLINE_ bool is_active() const { return active; }
 
+	// State saved and restored by space snapshots, see Space2DSW::get_snapshot().
+	struct SnapshotState {
+		Transform2D transform;
+		Vector2 linear_velocity;
+		real_t angular_velocity;
+		real_t still_time;
+		bool active;
+	};
+
+	void get_snapshot_state(SnapshotState &r_state) const;
+	void set_snapshot_state(const SnapshotState &p_state);
+
 	_FORCE_INLINE_ void wakeup() {
 		if ((!get_space()) || mode == Physics2DServer::BODY_MODE_STATIC || mode == Physics2DServer::BODY_MODE_KINEMATIC) {
 			return;
@@ -279,8 +310,13 @@ public:
 	_FORCE_INLINE_ real_t get_linear_damp() const { return linear_damp; }
 	_FORCE_INLINE_ real_t get_angular_damp() const { return angular_damp; }
 
+	// The integration passes only touch the body itself, so the active bodies
+	// can be integrated in parallel. Updating the broadphase and the space lists
+	// is left to the matching finish_*() call, made from the stepping thread.
 	void integrate_forces(real_t p_step);
+	void finish_integrate_forces();
 	void integrate_velocities(real_t p_step);
+	void finish_integrate_velocities();
 
 	_FORCE_INLINE_ Vector2 get_velocity_in_local_point(const Vector2 &rel_pos) const {
 		return linear_velocity + Vector2(-angular_velocity * rel_pos.y, angular_velocity * rel_pos.x);
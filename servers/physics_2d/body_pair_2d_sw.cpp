@@ -219,29 +219,32 @@ real_t combine_friction(Body2DSW *A, Body2DSW *B) {
 	return ABS(MIN(A->get_friction(), B->get_friction()));
 }
 
-bool BodyPair2DSW::setup(real_t p_step) {
+void BodyPair2DSW::generate_contacts(real_t p_step) {
 	//cannot collide
 	if (!A->test_collision_mask(B) || A->has_exception(B->get_self()) || B->has_exception(A->get_self())) {
 		collided = false;
-		return false;
+		check_collision = false;
+		return;
 	}
 
-	bool report_contacts_only = false;
+	report_contacts_only = false;
 	if ((A->get_mode() <= Physics2DServer::BODY_MODE_KINEMATIC) && (B->get_mode() <= Physics2DServer::BODY_MODE_KINEMATIC)) {
 		if ((A->get_max_contacts_reported() > 0) || (B->get_max_contacts_reported() > 0)) {
 			report_contacts_only = true;
 		} else {
 			collided = false;
-			return false;
+			check_collision = false;
+			return;
 		}
 	}
 
+	check_collision = true;
+
 	//use local A coordinates to avoid numerical issues on collision detection
 	offset_B = B->get_transform().get_origin() - A->get_transform().get_origin();
 
 	_validate_contacts();
 
-	Vector2 offset_A = A->get_transform().get_origin();
 	Transform2D xform_Au = A->get_transform().untranslated();
 	Transform2D xform_A = xform_Au * A->get_shape_transform(shape_A);
 
@@ -249,9 +252,6 @@ bool BodyPair2DSW::setup(real_t p_step) {
 	xform_Bu.columns[2] -= A->get_transform().get_origin();
 	Transform2D xform_B = xform_Bu * B->get_shape_transform(shape_B);
 
-	Shape2DSW *shape_A_ptr = A->get_shape(shape_A);
-	Shape2DSW *shape_B_ptr = B->get_shape(shape_B);
-
 	Vector2 motion_A, motion_B;
 
 	if (A->get_continuous_collision_detection_mode() == Physics2DServer::CCD_MODE_CAST_SHAPE) {
@@ -261,11 +261,30 @@ bool BodyPair2DSW::setup(real_t p_step) {
 		motion_B = B->get_motion();
 	}
 
-	bool prev_collided = collided;
+	prev_collided = collided;
+
+	collided = CollisionSolver2DSW::solve(A->get_shape(shape_A), xform_A, motion_A, B->get_shape(shape_B), xform_B, motion_B, _add_contact, this, &sep_axis);
+}
+
+bool BodyPair2DSW::setup(real_t p_step) {
+	if (!check_collision) {
+		return false;
+	}
+
+	Vector2 offset_A = A->get_transform().get_origin();
+	Transform2D xform_Au = A->get_transform().untranslated();
+	Transform2D xform_A = xform_Au * A->get_shape_transform(shape_A);
+
+	Transform2D xform_Bu = B->get_transform();
+	xform_Bu.columns[2] -= A->get_transform().get_origin();
+	Transform2D xform_B = xform_Bu * B->get_shape_transform(shape_B);
+
+	Shape2DSW *shape_A_ptr = A->get_shape(shape_A);
+	Shape2DSW *shape_B_ptr = B->get_shape(shape_B);
 
-	collided = CollisionSolver2DSW::solve(shape_A_ptr, xform_A, motion_A, shape_B_ptr, xform_B, motion_B, _add_contact, this, &sep_axis);
 	if (!collided) {
 		//test ccd (currently just a raycast)
+		//done here rather than in generate_contacts(), as it changes the velocity of the body
 
 		if (A->get_continuous_collision_detection_mode() == Physics2DServer::CCD_MODE_CAST_RAY && A->get_mode() > Physics2DServer::BODY_MODE_KINEMATIC) {
 			if (_test_ccd(p_step, A, shape_A, xform_A, B, shape_B, xform_B)) {
@@ -352,6 +371,9 @@ bool BodyPair2DSW::setup(real_t p_step) {
 
 	bool do_process = false;
 
+	// Static and kinematic bodies can be part of several islands being set up in parallel.
+	bool lock_contact_report = (A->can_report_contacts() && A->get_mode() <= Physics2DServer::BODY_MODE_KINEMATIC) || (B->can_report_contacts() && B->get_mode() <= Physics2DServer::BODY_MODE_KINEMATIC);
+
 	for (int i = 0; i < contact_count; i++) {
 		Contact &c = contacts[i];
 		c.active = false;
@@ -375,6 +397,10 @@ bool BodyPair2DSW::setup(real_t p_step) {
 		c.rA = global_A;
 		c.rB = global_B - offset_B;
 
+		if (lock_contact_report) {
+			space->get_shared_state_lock().lock();
+		}
+
 		if (A->can_report_contacts()) {
 			Vector2 crB(-B->get_angular_velocity() * c.rB.y, B->get_angular_velocity() * c.rB.x);
 			A->add_contact(global_A + offset_A, -c.normal, depth, shape_A, global_B + offset_A, shape_B, B->get_instance_id(), B->get_self(), crB + B->get_linear_velocity());
@@ -385,6 +411,10 @@ bool BodyPair2DSW::setup(real_t p_step) {
 			B->add_contact(global_B + offset_A, c.normal, depth, shape_B, global_A + offset_A, shape_A, A->get_instance_id(), A->get_self(), crA + A->get_linear_velocity());
 		}
 
+		if (lock_contact_report) {
+			space->get_shared_state_lock().unlock();
+		}
+
 		if (report_contacts_only) {
 			collided = false;
 			continue;
@@ -490,8 +520,56 @@ void BodyPair2DSW::solve(real_t p_step) {
 	}
 }
 
+void BodyPair2DSW::get_snapshot_state(SnapshotState &r_state) const {
+	r_state.offset_B = offset_B;
+	r_state.sep_axis = sep_axis;
+	for (int i = 0; i < contact_count; i++) {
+		r_state.contacts[i] = contacts[i];
+	}
+	r_state.contact_count = contact_count;
+	r_state.collided = collided;
+	r_state.prev_collided = prev_collided;
+	r_state.oneway_disabled = oneway_disabled;
+}
+
+void BodyPair2DSW::set_snapshot_state(const SnapshotState &p_state) {
+	ERR_FAIL_INDEX(p_state.contact_count, MAX_CONTACTS + 1);
+
+	offset_B = p_state.offset_B;
+	sep_axis = p_state.sep_axis;
+	for (int i = 0; i < p_state.contact_count; i++) {
+		contacts[i] = p_state.contacts[i];
+	}
+	contact_count = p_state.contact_count;
+	collided = p_state.collided;
+	prev_collided = p_state.prev_collided;
+	oneway_disabled = p_state.oneway_disabled;
+}
+
+// Turns a state saved with the bodies in one order into the state of the same
+// pair with A and B exchanged. The impulse applied to each body must stay the
+// same, so with the normal flipped only the parts that don't follow it change.
+void BodyPair2DSW::swap_snapshot_state(SnapshotState &r_state) {
+	r_state.offset_B = -r_state.offset_B;
+	r_state.sep_axis = -r_state.sep_axis;
+	for (int i = 0; i < r_state.contact_count; i++) {
+		Contact &c = r_state.contacts[i];
+		SWAP(c.local_A, c.local_B);
+		SWAP(c.rA, c.rB);
+		c.normal = -c.normal;
+		// acc_tangent_impulse is along normal.tangent(), which flips with the normal.
+	}
+}
+
+void BodyPair2DSW::clear_contacts() {
+	contact_count = 0;
+	collided = false;
+	prev_collided = false;
+}
+
 BodyPair2DSW::BodyPair2DSW(Body2DSW *p_A, int p_shape_A, Body2DSW *p_B, int p_shape_B) :
-		Constraint2DSW(_arr, 2) {
+		Constraint2DSW(_arr, 2),
+		space_list(this) {
 	A = p_A;
 	B = p_B;
 	shape_A = p_shape_A;
@@ -501,7 +579,11 @@ BodyPair2DSW::BodyPair2DSW(Body2DSW *p_A, int p_shape_A, Body2DSW *p_B, int p_sh
 	B->add_constraint(this, 1);
 	contact_count = 0;
 	collided = false;
+	prev_collided = false;
+	check_collision = false;
+	report_contacts_only = false;
 	oneway_disabled = false;
+	space->body_pair_add_to_list(&space_list);
 }
 
 BodyPair2DSW::~BodyPair2DSW() {
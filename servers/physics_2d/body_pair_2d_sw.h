@@ -52,6 +52,7 @@ class BodyPair2DSW : public Constraint2DSW {
 	int shape_B;
 
 	Space2DSW *space;
+	SelfList<BodyPair2DSW> space_list;
 
 	struct Contact {
 		Vector2 position;
@@ -76,6 +77,9 @@ class BodyPair2DSW : public Constraint2DSW {
 	Contact contacts[MAX_CONTACTS];
 	int contact_count;
 	bool collided;
+	bool prev_collided;
+	bool check_collision;
+	bool report_contacts_only;
 	bool oneway_disabled;
 	int cc;
 
@@ -85,6 +89,28 @@ class BodyPair2DSW : public Constraint2DSW {
 	_FORCE_INLINE_ void _contact_added_callback(const Vector2 &p_point_A, const Vector2 &p_point_B);
 
 public:
+	// Contact cache saved and restored by space snapshots, see Space2DSW::get_snapshot().
+	struct SnapshotState {
+		Vector2 offset_B;
+		Vector2 sep_axis;
+		Contact contacts[MAX_CONTACTS];
+		int contact_count;
+		bool collided;
+		bool prev_collided;
+		bool oneway_disabled;
+	};
+
+	_FORCE_INLINE_ Body2DSW *get_body_a() const { return A; }
+	_FORCE_INLINE_ Body2DSW *get_body_b() const { return B; }
+	_FORCE_INLINE_ int get_shape_a() const { return shape_A; }
+	_FORCE_INLINE_ int get_shape_b() const { return shape_B; }
+
+	void get_snapshot_state(SnapshotState &r_state) const;
+	void set_snapshot_state(const SnapshotState &p_state);
+	static void swap_snapshot_state(SnapshotState &r_state);
+	void clear_contacts();
+
+	void generate_contacts(real_t p_step);
 	bool setup(real_t p_step);
 	void solve(real_t p_step);
 
@@ -122,6 +122,10 @@ void BroadPhase2DBVH::update() {
 	bvh.update();
 }
 
+void BroadPhase2DBVH::set_work_pool(ThreadWorkPool *p_work_pool) {
+	bvh.params_set_pairing_work_pool(p_work_pool);
+}
+
 BroadPhase2DSW *BroadPhase2DBVH::_create() {
 	return memnew(BroadPhase2DBVH);
 }
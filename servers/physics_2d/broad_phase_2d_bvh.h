@@ -96,6 +96,8 @@ public:
 
 	virtual void update();
 
+	virtual void set_work_pool(ThreadWorkPool *p_work_pool);
+
 	static BroadPhase2DSW *_create();
 	BroadPhase2DBVH();
 };
@@ -0,0 +1,579 @@
+/*************************************************************************/
+/*  broad_phase_2d_hierarchical_grid.cpp                                 */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "broad_phase_2d_hierarchical_grid.h"
+#include "collision_object_2d_sw.h"
+#include "core/config/project_settings.h"
+
+int BroadPhase2DHierarchicalGrid::_get_level(const Rect2 &p_aabb) const {
+	// an element no larger than a cell covers at most 2x2 cells
+	real_t extent = MAX(p_aabb.size.x, p_aabb.size.y);
+	int level = 0;
+	while (level < MAX_LEVELS - 1 && levels[level].cell_size < extent) {
+		level++;
+	}
+	return level;
+}
+
+void BroadPhase2DHierarchicalGrid::_get_cells(int p_level, const Rect2 &p_aabb, Point2i &r_from, Point2i &r_to) const {
+	real_t cell_size = levels[p_level].cell_size;
+	r_from = (p_aabb.position / cell_size).floor();
+	r_to = ((p_aabb.position + p_aabb.size) / cell_size).floor();
+}
+
+void BroadPhase2DHierarchicalGrid::_enter_grid(ID p_id, Element *p_elem) {
+	if (p_elem->aabb == Rect2()) {
+		p_elem->level = -1;
+		return;
+	}
+
+	p_elem->level = _get_level(p_elem->aabb);
+	_get_cells(p_elem->level, p_elem->aabb, p_elem->from, p_elem->to);
+
+	Level &level = levels[p_elem->level];
+	for (int i = p_elem->from.x; i <= p_elem->to.x; i++) {
+		for (int j = p_elem->from.y; j <= p_elem->to.y; j++) {
+			level.cells[_cell_key(i, j)].push_back(p_id);
+		}
+	}
+
+	level.element_count++;
+	used_levels = MAX(used_levels, p_elem->level + 1);
+}
+
+void BroadPhase2DHierarchicalGrid::_exit_grid(ID p_id, Element *p_elem) {
+	if (p_elem->level < 0) {
+		return;
+	}
+
+	Level &level = levels[p_elem->level];
+	for (int i = p_elem->from.x; i <= p_elem->to.x; i++) {
+		for (int j = p_elem->from.y; j <= p_elem->to.y; j++) {
+			uint64_t key = _cell_key(i, j);
+			Cell *cell = level.cells.getptr(key);
+			ERR_CONTINUE(!cell); //should exist!!
+
+			int64_t index = cell->find(p_id);
+			ERR_CONTINUE(index < 0);
+			cell->remove_unordered(index);
+
+			if (cell->empty()) {
+				level.cells.erase(key);
+			}
+		}
+	}
+
+	level.element_count--;
+	p_elem->level = -1;
+
+	while (used_levels > 0 && levels[used_levels - 1].element_count == 0) {
+		used_levels--;
+	}
+}
+
+void BroadPhase2DHierarchicalGrid::_mark_moved(ID p_id, Element *p_elem) {
+	if (!p_elem->moved) {
+		p_elem->moved = true;
+		moved_elements.push_back(p_id);
+	}
+}
+
+void BroadPhase2DHierarchicalGrid::_pair(ID p_id, Element *p_elem, ID p_with, Element *p_with_elem) {
+	void *ud = nullptr;
+	if (pair_callback) {
+		// always in ID order, so unpairing gets the same order back
+		if (p_id < p_with) {
+			ud = pair_callback(p_elem->owner, p_elem->subindex, p_with_elem->owner, p_with_elem->subindex, nullptr, pair_userdata);
+		} else {
+			ud = pair_callback(p_with_elem->owner, p_with_elem->subindex, p_elem->owner, p_elem->subindex, nullptr, pair_userdata);
+		}
+	}
+
+	PairRef ref;
+	ref.ud = ud;
+	ref.other = p_with;
+	p_elem->paired.push_back(ref);
+	ref.other = p_id;
+	p_with_elem->paired.push_back(ref);
+}
+
+void BroadPhase2DHierarchicalGrid::_unpair(ID p_id, Element *p_elem, int p_pair_index) {
+	PairRef ref = p_elem->paired[p_pair_index];
+	Element *with_elem = _get_element(ref.other);
+	ERR_FAIL_COND(!with_elem);
+
+	if (unpair_callback) {
+		if (p_id < ref.other) {
+			unpair_callback(p_elem->owner, p_elem->subindex, with_elem->owner, with_elem->subindex, ref.ud, unpair_userdata);
+		} else {
+			unpair_callback(with_elem->owner, with_elem->subindex, p_elem->owner, p_elem->subindex, ref.ud, unpair_userdata);
+		}
+	}
+
+	p_elem->paired.remove_unordered(p_pair_index);
+
+	for (uint32_t i = 0; i < with_elem->paired.size(); i++) {
+		if (with_elem->paired[i].other == p_id) {
+			with_elem->paired.remove_unordered(i);
+			break;
+		}
+	}
+}
+
+bool BroadPhase2DHierarchicalGrid::_can_pair(const Element *p_elem, const Element *p_with) const {
+	if (p_elem->owner == p_with->owner) {
+		return false;
+	}
+	if (p_elem->_static && p_with->_static) {
+		return false;
+	}
+	if (p_elem->level < 0 || p_with->level < 0) {
+		return false;
+	}
+	return p_elem->aabb.intersects(p_with->aabb) && p_elem->owner->test_collision_mask(p_with->owner);
+}
+
+template <class F>
+void BroadPhase2DHierarchicalGrid::_cull_cells(int p_level, const Point2i &p_from, const Point2i &p_to, F &p_func) {
+	const Level &level = levels[p_level];
+	if (level.element_count == 0) {
+		return;
+	}
+
+	int64_t cell_count = int64_t(p_to.x - p_from.x + 1) * int64_t(p_to.y - p_from.y + 1);
+
+	if (cell_count > level.cells.size()) {
+		// fewer cells in use than in the range, as when a large element looks for small ones
+		for (const HashMap<uint64_t, Cell>::Element *E = level.cells.front(); E; E = E->next) {
+			int32_t x = (int32_t)(E->key() >> 32);
+			int32_t y = (int32_t)(E->key() & 0xFFFFFFFF);
+			if (x < p_from.x || x > p_to.x || y < p_from.y || y > p_to.y) {
+				continue;
+			}
+
+			const Cell &cell = E->value();
+			for (uint32_t k = 0; k < cell.size(); k++) {
+				p_func(cell[k], elements[cell[k] - 1]);
+			}
+		}
+		return;
+	}
+
+	for (int i = p_from.x; i <= p_to.x; i++) {
+		for (int j = p_from.y; j <= p_to.y; j++) {
+			const Cell *cell = level.cells.getptr(_cell_key(i, j));
+			if (!cell) {
+				continue;
+			}
+
+			for (uint32_t k = 0; k < cell->size(); k++) {
+				p_func((*cell)[k], elements[(*cell)[k] - 1]);
+			}
+		}
+	}
+}
+
+template <class F>
+void BroadPhase2DHierarchicalGrid::_cull_segment_cells(int p_level, const Vector2 &p_from, const Vector2 &p_to, F &p_func) {
+	const Level &level = levels[p_level];
+	if (level.element_count == 0) {
+		return;
+	}
+
+	real_t cell_size = level.cell_size;
+	Point2i pos = (p_from / cell_size).floor();
+	Point2i end = (p_to / cell_size).floor();
+
+	if (ABS(end.x - pos.x) + ABS(end.y - pos.y) + 1 > (int64_t)level.cells.size()) {
+		// the segment crosses more cells than are in use, the callback tests the segment anyway
+		for (const HashMap<uint64_t, Cell>::Element *E = level.cells.front(); E; E = E->next) {
+			const Cell &cell = E->value();
+			for (uint32_t k = 0; k < cell.size(); k++) {
+				p_func(cell[k], elements[cell[k] - 1]);
+			}
+		}
+		return;
+	}
+
+	// Walk the cells crossed by the segment. t_max is the position along the
+	// segment (0 to 1) of the next cell border on each axis, t_delta the
+	// distance between borders.
+	Vector2 dir = p_to - p_from;
+	Point2i step(SGN(dir.x), SGN(dir.y));
+	Vector2 t_max(Math_INF, Math_INF);
+	Vector2 t_delta(Math_INF, Math_INF);
+
+	if (dir.x != 0) {
+		t_delta.x = cell_size / Math::abs(dir.x);
+		t_max.x = ((step.x > 0 ? pos.x + 1 : pos.x) * cell_size - p_from.x) / dir.x;
+	}
+	if (dir.y != 0) {
+		t_delta.y = cell_size / Math::abs(dir.y);
+		t_max.y = ((step.y > 0 ? pos.y + 1 : pos.y) * cell_size - p_from.y) / dir.y;
+	}
+
+	while (true) {
+		const Cell *cell = level.cells.getptr(_cell_key(pos.x, pos.y));
+		if (cell) {
+			for (uint32_t k = 0; k < cell->size(); k++) {
+				p_func((*cell)[k], elements[(*cell)[k] - 1]);
+			}
+		}
+
+		if (MIN(t_max.x, t_max.y) > 1) {
+			break;
+		}
+
+		if (t_max.x < t_max.y) {
+			t_max.x += t_delta.x;
+			pos.x += step.x;
+		} else {
+			t_max.y += t_delta.y;
+			pos.y += step.y;
+		}
+	}
+}
+
+void BroadPhase2DHierarchicalGrid::_update_pairs(ID p_id, Element *p_elem) {
+	// drop the pairs which no longer overlap, or were made static or filtered out
+	for (int i = (int)p_elem->paired.size() - 1; i >= 0; i--) {
+		Element *with_elem = _get_element(p_elem->paired[i].other);
+		if (!with_elem || !_can_pair(p_elem, with_elem)) {
+			_unpair(p_id, p_elem, i);
+		}
+	}
+
+	if (p_elem->level < 0) {
+		return;
+	}
+
+	pass++;
+	p_elem->pass = pass;
+	for (uint32_t i = 0; i < p_elem->paired.size(); i++) {
+		elements[p_elem->paired[i].other - 1]->pass = pass;
+	}
+
+	struct PairFinder {
+		BroadPhase2DHierarchicalGrid *grid;
+		ID id;
+		Element *elem;
+		uint64_t pass;
+
+		_FORCE_INLINE_ void operator()(ID p_with, Element *p_with_elem) {
+			if (p_with_elem->pass == pass) {
+				return;
+			}
+			p_with_elem->pass = pass;
+
+			if (grid->_can_pair(elem, p_with_elem)) {
+				grid->_pair(id, elem, p_with, p_with_elem);
+			}
+		}
+	};
+
+	PairFinder finder;
+	finder.grid = this;
+	finder.id = p_id;
+	finder.elem = p_elem;
+	finder.pass = pass;
+
+	for (int i = 0; i < used_levels; i++) {
+		Point2i from;
+		Point2i to;
+		_get_cells(i, p_elem->aabb, from, to);
+		_cull_cells(i, from, to, finder);
+	}
+}
+
+BroadPhase2DHierarchicalGrid::ID BroadPhase2DHierarchicalGrid::create(CollisionObject2DSW *p_object, int p_subindex, const Rect2 &p_aabb, bool p_static) {
+	Element *e = memnew(Element);
+	e->owner = p_object;
+	e->subindex = p_subindex;
+	e->_static = p_static;
+	e->moved = false;
+	e->aabb = p_aabb;
+	e->level = -1;
+	e->pass = 0;
+
+	ID id;
+	if (free_ids.size()) {
+		id = free_ids[free_ids.size() - 1];
+		free_ids.resize(free_ids.size() - 1);
+		elements[id - 1] = e;
+	} else {
+		elements.push_back(e);
+		id = elements.size();
+	}
+
+	if (e->aabb != Rect2()) {
+		_enter_grid(id, e);
+		_mark_moved(id, e);
+	}
+
+	return id;
+}
+
+void BroadPhase2DHierarchicalGrid::move(ID p_id, const Rect2 &p_aabb) {
+	Element *e = _get_element(p_id);
+	ERR_FAIL_COND(!e);
+
+	if (p_aabb != e->aabb) {
+		bool same_cells = false;
+		if (e->level >= 0 && p_aabb != Rect2()) {
+			int level = _get_level(p_aabb);
+			if (level == e->level) {
+				Point2i from;
+				Point2i to;
+				_get_cells(level, p_aabb, from, to);
+				same_cells = from == e->from && to == e->to;
+			}
+		}
+
+		if (same_cells) {
+			e->aabb = p_aabb;
+		} else {
+			_exit_grid(p_id, e);
+			e->aabb = p_aabb;
+			_enter_grid(p_id, e);
+		}
+	}
+
+	// also done for the same aabb, as that is how layer changes are notified
+	_mark_moved(p_id, e);
+}
+
+void BroadPhase2DHierarchicalGrid::recheck_pairs(ID p_id) {
+	Element *e = _get_element(p_id);
+	ERR_FAIL_COND(!e);
+
+	_mark_moved(p_id, e);
+}
+
+void BroadPhase2DHierarchicalGrid::set_static(ID p_id, bool p_static) {
+	Element *e = _get_element(p_id);
+	ERR_FAIL_COND(!e);
+
+	if (e->_static == p_static) {
+		return;
+	}
+
+	e->_static = p_static;
+	_mark_moved(p_id, e);
+}
+
+void BroadPhase2DHierarchicalGrid::remove(ID p_id) {
+	Element *e = _get_element(p_id);
+	ERR_FAIL_COND(!e);
+
+	while (e->paired.size()) {
+		_unpair(p_id, e, e->paired.size() - 1);
+	}
+
+	_exit_grid(p_id, e);
+
+	// left in moved_elements, which skips freed elements
+	memdelete(e);
+	elements[p_id - 1] = nullptr;
+	free_ids.push_back(p_id);
+}
+
+CollisionObject2DSW *BroadPhase2DHierarchicalGrid::get_object(ID p_id) const {
+	const Element *e = _get_element(p_id);
+	ERR_FAIL_COND_V(!e, nullptr);
+	return e->owner;
+}
+
+bool BroadPhase2DHierarchicalGrid::is_static(ID p_id) const {
+	const Element *e = _get_element(p_id);
+	ERR_FAIL_COND_V(!e, false);
+	return e->_static;
+}
+
+int BroadPhase2DHierarchicalGrid::get_subindex(ID p_id) const {
+	const Element *e = _get_element(p_id);
+	ERR_FAIL_COND_V(!e, -1);
+	return e->subindex;
+}
+
+int BroadPhase2DHierarchicalGrid::cull_segment(const Vector2 &p_from, const Vector2 &p_to, CollisionObject2DSW **p_results, int p_max_results, int *p_result_indices) {
+	if (p_from == p_to) {
+		return 0;
+	}
+
+	pass++;
+
+	struct SegmentCuller {
+		Vector2 from;
+		Vector2 to;
+		uint64_t pass;
+		CollisionObject2DSW **results;
+		int *result_indices;
+		int max_results;
+		int count;
+
+		_FORCE_INLINE_ void operator()(ID p_id, Element *p_elem) {
+			if (count >= max_results || p_elem->pass == pass) {
+				return;
+			}
+			p_elem->pass = pass;
+
+			if (!p_elem->aabb.intersects_segment(from, to)) {
+				return;
+			}
+
+			results[count] = p_elem->owner;
+			if (result_indices) {
+				result_indices[count] = p_elem->subindex;
+			}
+			count++;
+		}
+	};
+
+	SegmentCuller culler;
+	culler.from = p_from;
+	culler.to = p_to;
+	culler.pass = pass;
+	culler.results = p_results;
+	culler.result_indices = p_result_indices;
+	culler.max_results = p_max_results;
+	culler.count = 0;
+
+	for (int i = 0; i < used_levels && culler.count < p_max_results; i++) {
+		_cull_segment_cells(i, p_from, p_to, culler);
+	}
+
+	return culler.count;
+}
+
+int BroadPhase2DHierarchicalGrid::cull_aabb(const Rect2 &p_aabb, CollisionObject2DSW **p_results, int p_max_results, int *p_result_indices) {
+	pass++;
+
+	struct AABBCuller {
+		Rect2 aabb;
+		uint64_t pass;
+		CollisionObject2DSW **results;
+		int *result_indices;
+		int max_results;
+		int count;
+
+		_FORCE_INLINE_ void operator()(ID p_id, Element *p_elem) {
+			if (count >= max_results || p_elem->pass == pass) {
+				return;
+			}
+			p_elem->pass = pass;
+
+			if (!aabb.intersects(p_elem->aabb)) {
+				return;
+			}
+
+			results[count] = p_elem->owner;
+			if (result_indices) {
+				result_indices[count] = p_elem->subindex;
+			}
+			count++;
+		}
+	};
+
+	AABBCuller culler;
+	culler.aabb = p_aabb;
+	culler.pass = pass;
+	culler.results = p_results;
+	culler.result_indices = p_result_indices;
+	culler.max_results = p_max_results;
+	culler.count = 0;
+
+	for (int i = 0; i < used_levels && culler.count < p_max_results; i++) {
+		Point2i from;
+		Point2i to;
+		_get_cells(i, p_aabb, from, to);
+		_cull_cells(i, from, to, culler);
+	}
+
+	return culler.count;
+}
+
+void BroadPhase2DHierarchicalGrid::set_pair_callback(PairCallback p_pair_callback, void *p_userdata) {
+	pair_callback = p_pair_callback;
+	pair_userdata = p_userdata;
+}
+
+void BroadPhase2DHierarchicalGrid::set_unpair_callback(UnpairCallback p_unpair_callback, void *p_userdata) {
+	unpair_callback = p_unpair_callback;
+	unpair_userdata = p_userdata;
+}
+
+void BroadPhase2DHierarchicalGrid::update() {
+	for (uint32_t i = 0; i < moved_elements.size(); i++) {
+		ID id = moved_elements[i];
+		Element *e = _get_element(id);
+		if (!e || !e->moved) {
+			continue; // removed, or its ID was reused and it is further in the list
+		}
+
+		e->moved = false;
+		_update_pairs(id, e);
+	}
+
+	moved_elements.clear();
+}
+
+BroadPhase2DSW *BroadPhase2DHierarchicalGrid::_create() {
+	return memnew(BroadPhase2DHierarchicalGrid);
+}
+
+BroadPhase2DHierarchicalGrid::BroadPhase2DHierarchicalGrid() {
+	real_t cell_size = GLOBAL_GET("physics/2d/cell_size");
+	if (cell_size <= 0) {
+		cell_size = 128;
+	}
+
+	for (int i = 0; i < MAX_LEVELS; i++) {
+		levels[i].cell_size = cell_size;
+		levels[i].element_count = 0;
+		cell_size *= 2;
+	}
+
+	used_levels = 0;
+	pass = 1;
+
+	pair_callback = nullptr;
+	pair_userdata = nullptr;
+	unpair_callback = nullptr;
+	unpair_userdata = nullptr;
+}
+
+BroadPhase2DHierarchicalGrid::~BroadPhase2DHierarchicalGrid() {
+	for (uint32_t i = 0; i < elements.size(); i++) {
+		if (elements[i]) {
+			memdelete(elements[i]);
+		}
+	}
+}
@@ -0,0 +1,142 @@
+#ifndef BROAD_PHASE_2D_HIERARCHICAL_GRID_H
+#define BROAD_PHASE_2D_HIERARCHICAL_GRID_H
+
+/*************************************************************************/
+/*  broad_phase_2d_hierarchical_grid.h                                   */
+/*************************************************************************/
+/*                         This file is part of:                         */
+/*                          PANDEMONIUM ENGINE                           */
+/*             https://github.com/Relintai/pandemonium_engine            */
+/*************************************************************************/
+/* Copyright (c) 2022-present Péter Magyar.                              */
+/* Copyright (c) 2014-2022 Godot Engine contributors (cf. AUTHORS.md).   */
+/* Copyright (c) 2007-2022 Juan Linietsky, Ariel Manzur.                 */
+/*                                                                       */
+/* Permission is hereby granted, free of charge, to any person obtaining */
+/* a copy of this software and associated documentation files (the       */
+/* "Software"), to deal in the Software without restriction, including   */
+/* without limitation the rights to use, copy, modify, merge, publish,   */
+/* distribute, sublicense, and/or sell copies of the Software, and to    */
+/* permit persons to whom the Software is furnished to do so, subject to */
+/* the following conditions:                                             */
+/*                                                                       */
+/* The above copyright notice and this permission notice shall be        */
+/* included in all copies or substantial portions of the Software.       */
+/*                                                                       */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,       */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF    */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.*/
+/* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY  */
+/* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,  */
+/* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE     */
+/* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.                */
+/*************************************************************************/
+
+#include "broad_phase_2d_sw.h"
+#include "core/containers/hash_map.h"
+#include "core/containers/local_vector.h"
+
+// Hash grid with one level per power of two of the base cell size. Each
+// element is stored in the level where it covers at most 2x2 cells, so tiny
+// and huge objects can share a space without either flooding the cells or
+// being tested against everything.
+//
+// Pairs are only searched for the elements moved since the last update(),
+// so sleeping bodies and static colliders cost nothing until they move, and
+// two static elements are never paired.
+class BroadPhase2DHierarchicalGrid : public BroadPhase2DSW {
+	enum {
+		MAX_LEVELS = 24
+	};
+
+	struct PairRef {
+		ID other;
+		void *ud;
+	};
+
+	struct Element {
+		CollisionObject2DSW *owner;
+		int subindex;
+		bool _static;
+		bool moved; // in moved_elements
+		Rect2 aabb;
+		int level; // -1 when not in the grid
+		Point2i from; // cells covered at level
+		Point2i to;
+		uint64_t pass;
+		LocalVector<PairRef> paired;
+	};
+
+	typedef LocalVector<ID> Cell;
+
+	struct Level {
+		real_t cell_size;
+		uint32_t element_count;
+		HashMap<uint64_t, Cell> cells;
+	};
+
+	// indexed by ID - 1, freed slots are null
+	LocalVector<Element *> elements;
+	LocalVector<ID> free_ids;
+	LocalVector<ID> moved_elements;
+
+	Level levels[MAX_LEVELS];
+	int used_levels; // levels above this one are empty
+
+	uint64_t pass;
+
+	PairCallback pair_callback;
+	void *pair_userdata;
+	UnpairCallback unpair_callback;
+	void *unpair_userdata;
+
+	static _FORCE_INLINE_ uint64_t _cell_key(int32_t p_x, int32_t p_y) {
+		return ((uint64_t)(uint32_t)p_x << 32) | (uint32_t)p_y;
+	}
+
+	_FORCE_INLINE_ Element *_get_element(ID p_id) const {
+		return (p_id == 0 || p_id > elements.size()) ? nullptr : elements[p_id - 1];
+	}
+
+	int _get_level(const Rect2 &p_aabb) const;
+	void _get_cells(int p_level, const Rect2 &p_aabb, Point2i &r_from, Point2i &r_to) const;
+	void _enter_grid(ID p_id, Element *p_elem);
+	void _exit_grid(ID p_id, Element *p_elem);
+	void _mark_moved(ID p_id, Element *p_elem);
+
+	void _pair(ID p_id, Element *p_elem, ID p_with, Element *p_with_elem);
+	void _unpair(ID p_id, Element *p_elem, int p_pair_index);
+	bool _can_pair(const Element *p_elem, const Element *p_with) const;
+	void _update_pairs(ID p_id, Element *p_elem);
+
+	template <class F>
+	void _cull_cells(int p_level, const Point2i &p_from, const Point2i &p_to, F &p_func);
+	template <class F>
+	void _cull_segment_cells(int p_level, const Vector2 &p_from, const Vector2 &p_to, F &p_func);
+
+public:
+	virtual ID create(CollisionObject2DSW *p_object, int p_subindex = 0, const Rect2 &p_aabb = Rect2(), bool p_static = false);
+	virtual void move(ID p_id, const Rect2 &p_aabb);
+	virtual void recheck_pairs(ID p_id);
+	virtual void set_static(ID p_id, bool p_static);
+	virtual void remove(ID p_id);
+
+	virtual CollisionObject2DSW *get_object(ID p_id) const;
+	virtual bool is_static(ID p_id) const;
+	virtual int get_subindex(ID p_id) const;
+
+	virtual int cull_segment(const Vector2 &p_from, const Vector2 &p_to, CollisionObject2DSW **p_results, int p_max_results, int *p_result_indices = nullptr);
+	virtual int cull_aabb(const Rect2 &p_aabb, CollisionObject2DSW **p_results, int p_max_results, int *p_result_indices = nullptr);
+
+	virtual void set_pair_callback(PairCallback p_pair_callback, void *p_userdata);
+	virtual void set_unpair_callback(UnpairCallback p_unpair_callback, void *p_userdata);
+
+	virtual void update();
+
+	static BroadPhase2DSW *_create();
+
+	BroadPhase2DHierarchicalGrid();
+	~BroadPhase2DHierarchicalGrid();
+};
+
+#endif // BROAD_PHASE_2D_HIERARCHICAL_GRID_H
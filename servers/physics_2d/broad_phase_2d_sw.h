@@ -36,6 +36,7 @@
 #include "core/math/rect2.h"
 
 class CollisionObject2DSW;
+class ThreadWorkPool;
 
 class BroadPhase2DSW {
 public:
@@ -67,6 +68,9 @@ public:
 
 	virtual void update() = 0;
 
+	// Pool the broadphase can spread its work on, null when the server doesn't use threads.
+	virtual void set_work_pool(ThreadWorkPool *p_work_pool) {}
+
 	virtual ~BroadPhase2DSW();
 };
 
@@ -33,6 +33,7 @@
 #include "broad_phase_2d_basic.h"
 #include "broad_phase_2d_bvh.h"
 #include "broad_phase_2d_hash_grid.h"
+#include "broad_phase_2d_hierarchical_grid.h"
 #include "collision_solver_2d_sw.h"
 #include "core/config/project_settings.h"
 #include "core/object/script_language.h"
@@ -213,6 +214,7 @@ RID Physics2DServerSW::space_create() {
 	Space2DSW *space = memnew(Space2DSW);
 	RID id = space_owner.make_rid(space);
 	space->set_self(id);
+	space->set_work_pool(_get_work_pool());
 	RID area_id = RID_PRIME(area_create());
 	Area2DSW *area = area_owner.get(area_id);
 	ERR_FAIL_COND_V(!area, RID());
@@ -271,6 +273,25 @@ int Physics2DServerSW::space_get_contact_count(RID p_space) const {
 	return space->get_debug_contact_count();
 }
 
+PoolVector<uint8_t> Physics2DServerSW::space_get_snapshot(RID p_space) const {
+	const Space2DSW *space = space_owner.get(p_space);
+	ERR_FAIL_COND_V(!space, PoolVector<uint8_t>());
+	return space->get_snapshot();
+}
+
+Error Physics2DServerSW::space_set_snapshot(RID p_space, const PoolVector<uint8_t> &p_snapshot) {
+	Space2DSW *space = space_owner.get(p_space);
+	ERR_FAIL_COND_V(!space, ERR_INVALID_PARAMETER);
+	return space->set_snapshot(p_snapshot);
+}
+
+uint64_t Physics2DServerSW::space_get_elapsed_time(RID p_space, Space2DSW::ElapsedTime p_time) const {
+	const Space2DSW *space = space_owner.get(p_space);
+	ERR_FAIL_COND_V(!space, 0);
+	ERR_FAIL_INDEX_V(p_time, Space2DSW::ELAPSED_TIME_MAX, 0);
+	return space->get_elapsed_time(p_time);
+}
+
 Physics2DDirectSpaceState *Physics2DServerSW::space_get_direct_state(RID p_space) {
 	Space2DSW *space = space_owner.get(p_space);
 	ERR_FAIL_COND_V(!space, nullptr);
@@ -1210,6 +1231,7 @@ void Physics2DServerSW::init() {
 	doing_sync = false;
 	iterations = 8; // 8?
 	stepper = memnew(Step2DSW);
+	stepper->set_work_pool(_get_work_pool());
 };
 
 void Physics2DServerSW::step(real_t p_step) {
@@ -1289,6 +1311,7 @@ void Physics2DServerSW::end_sync() {
 
 void Physics2DServerSW::finish() {
 	memdelete(stepper);
+	work_pool.finish();
 };
 
 void Physics2DServerSW::_update_shapes() {
@@ -1320,16 +1343,22 @@ Physics2DServerSW::Physics2DServerSW() {
 	singletonsw = this;
 
 	GLOBAL_DEF("physics/2d/use_bvh", true);
+	GLOBAL_DEF("physics/2d/use_hierarchical_grid", false);
 	GLOBAL_DEF("physics/2d/bp_hash_table_size", 4096);
 	GLOBAL_DEF("physics/2d/cell_size", 128);
 	GLOBAL_DEF("physics/2d/large_object_surface_threshold_in_cells", 512);
 	GLOBAL_DEF("physics/2d/bvh_collision_margin", 1.0);
 	ProjectSettings::get_singleton()->set_custom_property_info("physics/2d/bvh_collision_margin", PropertyInfo(Variant::REAL, "physics/2d/bvh_collision_margin", PROPERTY_HINT_RANGE, "0.0,20.0,0.1"));
+	GLOBAL_DEF("physics/2d/use_multiple_threads", false);
 
 	bool use_bvh = GLOBAL_GET("physics/2d/use_bvh");
 
+	bool use_hierarchical_grid = GLOBAL_GET("physics/2d/use_hierarchical_grid");
+
 	if (use_bvh) {
 		BroadPhase2DSW::create_func = BroadPhase2DBVH::_create;
+	} else if (use_hierarchical_grid) {
+		BroadPhase2DSW::create_func = BroadPhase2DHierarchicalGrid::_create;
 	} else {
 		BroadPhase2DSW::create_func = BroadPhase2DHashGrid::_create;
 	}
@@ -1343,6 +1372,7 @@ Physics2DServerSW::Physics2DServerSW() {
 #else
 	using_threads = int(GLOBAL_GET("physics/2d/thread_model")) == 2;
 #endif
+	use_multiple_threads = GLOBAL_GET("physics/2d/use_multiple_threads");
 	flushing_queries = false;
 };
 
@@ -56,6 +56,12 @@ class Physics2DServerSW : public Physics2DServer {
 	bool flushing_queries;
 
 	Step2DSW *stepper;
+
+	// Shared by the stepper and every space, so the server never runs more than one set of threads.
+	// Its threads are only started when something uses it.
+	bool use_multiple_threads;
+	ThreadWorkPool work_pool;
+	_FORCE_INLINE_ ThreadWorkPool *_get_work_pool() { return use_multiple_threads ? &work_pool : nullptr; }
 	RBSet<const Space2DSW *> active_spaces;
 
 	mutable RID_Owner<Shape2DSW> shape_owner;
@@ -64,8 +70,6 @@ class Physics2DServerSW : public Physics2DServer {
 	mutable RID_Owner<Body2DSW> body_owner;
 	mutable RID_Owner<Joint2DSW> joint_owner;
 
-	static Physics2DServerSW *singletonsw;
-
 	//void _clear_query(Query2DSW *p_query);
 	friend class CollisionObject2DSW;
 	SelfList<CollisionObject2DSW>::List pending_shape_update_list;
@@ -74,6 +78,8 @@ class Physics2DServerSW : public Physics2DServer {
 	RID _shape_create(ShapeType p_shape);
 
 public:
+	static Physics2DServerSW *singletonsw;
+
 	struct CollCbkData {
 		Vector2 valid_dir;
 		real_t valid_depth;
@@ -117,6 +123,12 @@ public:
 	virtual Vector<Vector2> space_get_contacts(RID p_space) const;
 	virtual int space_get_contact_count(RID p_space) const;
 
+	virtual PoolVector<uint8_t> space_get_snapshot(RID p_space) const;
+	virtual Error space_set_snapshot(RID p_space, const PoolVector<uint8_t> &p_snapshot);
+
+	// time spent in each phase of the last step of the space, in microseconds
+	uint64_t space_get_elapsed_time(RID p_space, Space2DSW::ElapsedTime p_time) const;
+
 	// this function only works on physics process, errors and returns null otherwise
 	virtual Physics2DDirectSpaceState *space_get_direct_state(RID p_space);
 
@@ -124,6 +124,9 @@ public:
 		return physics_2d_server->space_get_contact_count(p_space);
 	}
 
+	FUNC1RC(PoolVector<uint8_t>, space_get_snapshot, RID);
+	FUNC2R(Error, space_set_snapshot, RID, const PoolVector<uint8_t> &);
+
 	/* AREA API */
 
 	//FUNC0RID(area);
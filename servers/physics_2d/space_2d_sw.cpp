@@ -32,6 +32,7 @@
 #include "space_2d_sw.h"
 
 #include "collision_solver_2d_sw.h"
+#include "core/containers/local_vector.h"
 #include "core/containers/pair.h"
 #include "core/os/os.h"
 #include "physics_2d_server_sw.h"
@@ -1287,6 +1288,11 @@ void Space2DSW::remove_object(CollisionObject2DSW *p_object) {
 	objects.erase(p_object);
 }
 
+void Space2DSW::body_pair_add_to_list(SelfList<BodyPair2DSW> *p_pair) {
+	// removed by the pair's destructor
+	body_pair_list.add(p_pair);
+}
+
 const RBSet<CollisionObject2DSW *> &Space2DSW::get_objects() const {
 	return objects;
 }
@@ -1344,6 +1350,223 @@ void Space2DSW::update() {
 	broadphase->update();
 }
 
+// Snapshots store the state of the non static bodies and the contact caches
+// of the body pairs, in native layout, as they are only meant to be restored
+// by the same build. Bodies and pairs are sorted by RID id, so the same state
+// always gives the same bytes.
+
+#define SPACE_SNAPSHOT_MAGIC 0x50534E32 // "PSN2"
+#define SPACE_SNAPSHOT_VERSION 2
+
+struct SpaceSnapshotHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t real_size;
+	uint32_t body_count;
+	uint32_t pair_count;
+};
+
+struct SpaceSnapshotBody {
+	uint32_t id;
+	Body2DSW::SnapshotState state;
+
+	bool operator<(const SpaceSnapshotBody &p_other) const { return id < p_other.id; }
+};
+
+struct SpaceSnapshotPairKey {
+	uint32_t id_A;
+	int32_t shape_A;
+	uint32_t id_B;
+	int32_t shape_B;
+
+	bool operator==(const SpaceSnapshotPairKey &p_other) const {
+		return id_A == p_other.id_A && shape_A == p_other.shape_A && id_B == p_other.id_B && shape_B == p_other.shape_B;
+	}
+
+	bool operator<(const SpaceSnapshotPairKey &p_other) const {
+		if (id_A != p_other.id_A) {
+			return id_A < p_other.id_A;
+		}
+		if (shape_A != p_other.shape_A) {
+			return shape_A < p_other.shape_A;
+		}
+		if (id_B != p_other.id_B) {
+			return id_B < p_other.id_B;
+		}
+		return shape_B < p_other.shape_B;
+	}
+
+	// The broadphase may report a pair in either order, so the key always
+	// puts the lower (id, shape) first. Returns true if that swapped A and B.
+	bool set(const BodyPair2DSW *p_pair) {
+		id_A = p_pair->get_body_a()->get_self().get_id();
+		shape_A = p_pair->get_shape_a();
+		id_B = p_pair->get_body_b()->get_self().get_id();
+		shape_B = p_pair->get_shape_b();
+
+		if (id_B < id_A || (id_B == id_A && shape_B < shape_A)) {
+			SWAP(id_A, id_B);
+			SWAP(shape_A, shape_B);
+			return true;
+		}
+		return false;
+	}
+};
+
+struct SpaceSnapshotPair {
+	SpaceSnapshotPairKey key;
+	BodyPair2DSW::SnapshotState state;
+
+	bool operator<(const SpaceSnapshotPair &p_other) const { return key < p_other.key; }
+};
+
+PoolVector<uint8_t> Space2DSW::get_snapshot() const {
+	LocalVector<SpaceSnapshotBody> bodies;
+	LocalVector<SpaceSnapshotPair> pairs;
+
+	for (const RBSet<CollisionObject2DSW *>::Element *E = objects.front(); E; E = E->next()) {
+		if (E->get()->get_type() != CollisionObject2DSW::TYPE_BODY) {
+			continue;
+		}
+
+		const Body2DSW *body = static_cast<const Body2DSW *>(E->get());
+		if (body->get_mode() == Physics2DServer::BODY_MODE_STATIC) {
+			continue;
+		}
+
+		SpaceSnapshotBody snapshot_body;
+		memset((void *)&snapshot_body, 0, sizeof(SpaceSnapshotBody)); // padding too, for identical bytes
+		snapshot_body.id = body->get_self().get_id();
+		body->get_snapshot_state(snapshot_body.state);
+		bodies.push_back(snapshot_body);
+	}
+
+	for (const SelfList<BodyPair2DSW> *E = body_pair_list.first(); E; E = E->next()) {
+		SpaceSnapshotPair snapshot_pair;
+		memset((void *)&snapshot_pair, 0, sizeof(SpaceSnapshotPair));
+		bool swapped = snapshot_pair.key.set(E->self());
+		E->self()->get_snapshot_state(snapshot_pair.state);
+		if (swapped) {
+			BodyPair2DSW::swap_snapshot_state(snapshot_pair.state); // stored in key order
+		}
+		pairs.push_back(snapshot_pair);
+	}
+
+	bodies.sort();
+	pairs.sort();
+
+	SpaceSnapshotHeader header;
+	header.magic = SPACE_SNAPSHOT_MAGIC;
+	header.version = SPACE_SNAPSHOT_VERSION;
+	header.real_size = sizeof(real_t);
+	header.body_count = bodies.size();
+	header.pair_count = pairs.size();
+
+	uint32_t bodies_size = bodies.size() * sizeof(SpaceSnapshotBody);
+	uint32_t pairs_size = pairs.size() * sizeof(SpaceSnapshotPair);
+
+	PoolVector<uint8_t> snapshot;
+	snapshot.resize(sizeof(SpaceSnapshotHeader) + bodies_size + pairs_size);
+
+	PoolVector<uint8_t>::Write w = snapshot.write();
+	uint8_t *ptr = w.ptr();
+	memcpy(ptr, &header, sizeof(SpaceSnapshotHeader));
+	ptr += sizeof(SpaceSnapshotHeader);
+	if (bodies_size) {
+		memcpy(ptr, bodies.ptr(), bodies_size);
+		ptr += bodies_size;
+	}
+	if (pairs_size) {
+		memcpy(ptr, pairs.ptr(), pairs_size);
+	}
+
+	return snapshot;
+}
+
+Error Space2DSW::set_snapshot(const PoolVector<uint8_t> &p_snapshot) {
+	ERR_FAIL_COND_V_MSG(locked, ERR_LOCKED, "Can't restore a snapshot while the space is being stepped.");
+	ERR_FAIL_COND_V(p_snapshot.size() < (int)sizeof(SpaceSnapshotHeader), ERR_INVALID_DATA);
+
+	PoolVector<uint8_t>::Read r = p_snapshot.read();
+	const uint8_t *ptr = r.ptr();
+
+	SpaceSnapshotHeader header;
+	memcpy(&header, ptr, sizeof(SpaceSnapshotHeader));
+	ptr += sizeof(SpaceSnapshotHeader);
+
+	ERR_FAIL_COND_V_MSG(header.magic != SPACE_SNAPSHOT_MAGIC || header.version != SPACE_SNAPSHOT_VERSION, ERR_INVALID_DATA, "Invalid physics space snapshot.");
+	ERR_FAIL_COND_V_MSG(header.real_size != sizeof(real_t), ERR_INVALID_DATA, "Physics space snapshot was made by a build with a different real_t size.");
+	ERR_FAIL_COND_V(p_snapshot.size() != (int)(sizeof(SpaceSnapshotHeader) + header.body_count * sizeof(SpaceSnapshotBody) + header.pair_count * sizeof(SpaceSnapshotPair)), ERR_INVALID_DATA);
+
+	HashMap<uint32_t, Body2DSW *> bodies;
+	for (const RBSet<CollisionObject2DSW *>::Element *E = objects.front(); E; E = E->next()) {
+		if (E->get()->get_type() == CollisionObject2DSW::TYPE_BODY) {
+			bodies.set(E->get()->get_self().get_id(), static_cast<Body2DSW *>(E->get()));
+		}
+	}
+
+	// bodies created after the snapshot keep their state, removed ones are skipped
+	for (uint32_t i = 0; i < header.body_count; i++) {
+		SpaceSnapshotBody snapshot_body;
+		memcpy(&snapshot_body, ptr, sizeof(SpaceSnapshotBody));
+		ptr += sizeof(SpaceSnapshotBody);
+
+		Body2DSW **body = bodies.getptr(snapshot_body.id);
+		if (!body || (*body)->get_mode() == Physics2DServer::BODY_MODE_STATIC) {
+			continue;
+		}
+		(*body)->set_snapshot_state(snapshot_body.state);
+	}
+
+	// Create and remove the pairs for the restored transforms right away,
+	// so their contacts can be restored before the next step.
+	broadphase->update();
+
+	LocalVector<SpaceSnapshotPair> pairs;
+	pairs.resize(header.pair_count);
+	if (header.pair_count) {
+		memcpy(pairs.ptr(), ptr, header.pair_count * sizeof(SpaceSnapshotPair));
+	}
+
+	struct CurrentPair {
+		SpaceSnapshotPairKey key;
+		BodyPair2DSW *pair;
+		bool swapped;
+
+		bool operator<(const CurrentPair &p_other) const { return key < p_other.key; }
+	};
+
+	LocalVector<CurrentPair> current_pairs;
+	for (SelfList<BodyPair2DSW> *E = body_pair_list.first(); E; E = E->next()) {
+		CurrentPair current;
+		current.swapped = current.key.set(E->self());
+		current.pair = E->self();
+		current_pairs.push_back(current);
+	}
+	current_pairs.sort();
+
+	// both lists are sorted by key, pairs which did not exist in the snapshot start without contacts
+	uint32_t snapshot_index = 0;
+	for (uint32_t i = 0; i < current_pairs.size(); i++) {
+		const CurrentPair &current = current_pairs[i];
+
+		while (snapshot_index < pairs.size() && pairs[snapshot_index].key < current.key) {
+			snapshot_index++;
+		}
+
+		if (snapshot_index < pairs.size() && pairs[snapshot_index].key == current.key) {
+			if (current.swapped) {
+				BodyPair2DSW::swap_snapshot_state(pairs[snapshot_index].state);
+			}
+			current.pair->set_snapshot_state(pairs[snapshot_index].state);
+		} else {
+			current.pair->clear_contacts();
+		}
+	}
+
+	return OK;
+}
+
 void Space2DSW::set_param(Physics2DServer::SpaceParameter p_param, real_t p_value) {
 	switch (p_param) {
 		case Physics2DServer::SPACE_PARAM_CONTACT_RECYCLE_RADIUS:
@@ -1437,6 +1660,10 @@ Space2DSW::Space2DSW() {
 	}
 }
 
+void Space2DSW::set_work_pool(ThreadWorkPool *p_work_pool) {
+	broadphase->set_work_pool(p_work_pool);
+}
+
 Space2DSW::~Space2DSW() {
 	memdelete(broadphase);
 	memdelete(direct_access);
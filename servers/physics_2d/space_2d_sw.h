@@ -40,6 +40,7 @@
 #include "collision_object_2d_sw.h"
 #include "core/config/project_settings.h"
 #include "core/containers/hash_map.h"
+#include "core/os/spin_lock.h"
 #include "core/typedefs.h"
 
 class Physics2DDirectSpaceStateSW : public Physics2DDirectSpaceState {
@@ -91,6 +92,7 @@ private:
 	SelfList<Body2DSW>::List state_query_list;
 	SelfList<Area2DSW>::List monitor_query_list;
 	SelfList<Area2DSW>::List area_moved_list;
+	SelfList<BodyPair2DSW>::List body_pair_list;
 
 	static void *_broadphase_pair(CollisionObject2DSW *p_object_A, int p_subindex_A, CollisionObject2DSW *p_object_B, int p_subindex_B, void *p_pair_data, void *p_self);
 	static void _broadphase_unpair(CollisionObject2DSW *p_object_A, int p_subindex_A, CollisionObject2DSW *p_object_B, int p_subindex_B, void *p_pair_data, void *p_self);
@@ -128,6 +130,10 @@ private:
 	Vector<Vector2> contact_debug;
 	int contact_debug_count;
 
+	// Guards what islands stepped in parallel can share: non-dynamic bodies,
+	// areas and the debug contacts.
+	SpinLock shared_state_lock;
+
 	friend class Physics2DDirectSpaceStateSW;
 
 public:
@@ -137,6 +143,8 @@ public:
 	_FORCE_INLINE_ void set_step(const real_t &p_step) { step = p_step; }
 	_FORCE_INLINE_ real_t get_step() const { return step; }
 
+	_FORCE_INLINE_ SpinLock &get_shared_state_lock() { return shared_state_lock; }
+
 	void set_default_area(Area2DSW *p_area) { area = p_area; }
 	Area2DSW *get_default_area() const { return area; }
 
@@ -149,6 +157,8 @@ public:
 	void area_remove_from_moved_list(SelfList<Area2DSW> *p_area);
 	const SelfList<Area2DSW>::List &get_moved_area_list() const;
 
+	void body_pair_add_to_list(SelfList<BodyPair2DSW> *p_pair);
+
 	void body_add_to_state_query_list(SelfList<Body2DSW> *p_body);
 	void body_remove_from_state_query_list(SelfList<Body2DSW> *p_body);
 
@@ -173,6 +183,9 @@ public:
 	void setup();
 	void call_queries();
 
+	PoolVector<uint8_t> get_snapshot() const;
+	Error set_snapshot(const PoolVector<uint8_t> &p_snapshot);
+
 	bool is_locked() const;
 	void lock();
 	void unlock();
@@ -194,14 +207,18 @@ public:
 	void set_debug_contacts(int p_amount) { contact_debug.resize(p_amount); }
 	_FORCE_INLINE_ bool is_debugging_contacts() const { return !contact_debug.empty(); }
 	_FORCE_INLINE_ void add_debug_contact(const Vector2 &p_contact) {
+		shared_state_lock.lock();
 		if (contact_debug_count < contact_debug.size()) {
 			contact_debug.write[contact_debug_count++] = p_contact;
 		}
+		shared_state_lock.unlock();
 	}
 	_FORCE_INLINE_ Vector<Vector2> get_debug_contacts() { return contact_debug; }
 	_FORCE_INLINE_ int get_debug_contact_count() { return contact_debug_count; }
 
 	Physics2DDirectSpaceStateSW *get_direct_state();
+	// The server's pool, null when it doesn't use threads.
+	void set_work_pool(ThreadWorkPool *p_work_pool);
 
 	void set_elapsed_time(ElapsedTime p_time, uint64_t p_msec) { elapsed_time[p_time] = p_msec; }
 	uint64_t get_elapsed_time(ElapsedTime p_time) const { return elapsed_time[p_time]; }
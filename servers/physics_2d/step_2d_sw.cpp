@@ -129,6 +129,64 @@ void Step2DSW::_check_suspend(Body2DSW *p_island, real_t p_delta) {
 	}
 }
 
+template <class U>
+void Step2DSW::_run_work(uint32_t p_count, void (Step2DSW::*p_method)(uint32_t, U), U p_userdata) {
+#ifndef NO_THREADS
+	if (work_pool && p_count > 1) {
+		if (work_pool->get_thread_count() == 0) {
+			work_pool->init();
+		}
+		work_pool->do_work(p_count, this, p_method, p_userdata);
+		return;
+	}
+#endif
+
+	for (uint32_t i = 0; i < p_count; i++) {
+		(this->*p_method)(i, p_userdata);
+	}
+}
+
+void Step2DSW::_integrate_forces_batch(uint32_t p_batch, Body2DSW **p_bodies) {
+	uint32_t from = p_batch * BODY_BATCH_SIZE;
+	uint32_t to = MIN(from + BODY_BATCH_SIZE, active_bodies.size());
+
+	for (uint32_t i = from; i < to; i++) {
+		p_bodies[i]->integrate_forces(_delta);
+	}
+}
+
+void Step2DSW::_integrate_velocities_batch(uint32_t p_batch, Body2DSW **p_bodies) {
+	uint32_t from = p_batch * BODY_BATCH_SIZE;
+	uint32_t to = MIN(from + BODY_BATCH_SIZE, active_bodies.size());
+
+	for (uint32_t i = from; i < to; i++) {
+		p_bodies[i]->integrate_velocities(_delta);
+	}
+}
+
+void Step2DSW::_generate_contacts_batch(uint32_t p_batch, Constraint2DSW **p_constraints) {
+	uint32_t from = p_batch * CONSTRAINT_BATCH_SIZE;
+	uint32_t to = MIN(from + CONSTRAINT_BATCH_SIZE, constraints.size());
+
+	for (uint32_t i = from; i < to; i++) {
+		p_constraints[i]->generate_contacts(_delta);
+	}
+}
+
+void Step2DSW::_setup_island_work(uint32_t p_index, Constraint2DSW **p_islands) {
+	if (_setup_island(p_islands[p_index], _delta)) {
+		//removed the root from the island graph because it is not to be processed
+		p_islands[p_index] = p_islands[p_index]->get_island_next();
+	}
+}
+
+void Step2DSW::_solve_island_work(uint32_t p_index, Constraint2DSW **p_islands) {
+	if (p_islands[p_index]) {
+		//iterating each island separatedly improves cache efficiency
+		_solve_island(p_islands[p_index], _iterations, _delta);
+	}
+}
+
 void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 	p_space->lock(); // can't access space during this
 	p_space->set_step(p_delta);
@@ -136,18 +194,28 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 	const SelfList<Body2DSW>::List *body_list = &p_space->get_active_body_list();
 
+	_delta = p_delta;
+	_iterations = p_iterations;
+
 	/* INTEGRATE FORCES */
 
 	uint64_t profile_begtime = OS::get_singleton()->get_ticks_usec();
 	uint64_t profile_endtime = 0;
 
-	int active_count = 0;
+	active_bodies.clear();
 
 	const SelfList<Body2DSW> *b = body_list->first();
 	while (b) {
-		b->self()->integrate_forces(p_delta);
+		active_bodies.push_back(b->self());
 		b = b->next();
-		active_count++;
+	}
+
+	int active_count = active_bodies.size();
+
+	_run_work((active_bodies.size() + BODY_BATCH_SIZE - 1) / BODY_BATCH_SIZE, &Step2DSW::_integrate_forces_batch, active_bodies.ptr());
+
+	for (uint32_t i = 0; i < active_bodies.size(); i++) {
+		active_bodies[i]->finish_integrate_forces();
 	}
 
 	p_space->set_active_objects(active_count);
@@ -215,41 +283,32 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* SETUP CONSTRAINT ISLANDS */
 
+	constraint_islands.clear();
+
 	{
 		Constraint2DSW *ci = constraint_island_list;
-		Constraint2DSW *prev_ci = nullptr;
 		while (ci) {
-			if (_setup_island(ci, p_delta)) {
-				//removed the root from the island graph because it is not to be processed
-
-				Constraint2DSW *next = ci->get_island_next();
-
-				if (next) {
-					//root from list being deleted no longer exists, replace by next
-					next->set_island_list_next(ci->get_island_list_next());
-					if (prev_ci) {
-						prev_ci->set_island_list_next(next);
-					} else {
-						constraint_island_list = next;
-					}
-					prev_ci = next;
-				} else {
-					//list is empty, just skip
-					if (prev_ci) {
-						prev_ci->set_island_list_next(ci->get_island_list_next());
-
-					} else {
-						constraint_island_list = ci->get_island_list_next();
-					}
-				}
-			} else {
-				prev_ci = ci;
-			}
-
+			constraint_islands.push_back(ci);
 			ci = ci->get_island_list_next();
 		}
 	}
 
+	// Run the narrow phase of all the constraints first, so it is spread evenly
+	// across the threads even when most of them end up in the same island.
+	constraints.clear();
+
+	for (uint32_t i = 0; i < constraint_islands.size(); i++) {
+		Constraint2DSW *ci = constraint_islands[i];
+		while (ci) {
+			constraints.push_back(ci);
+			ci = ci->get_island_next();
+		}
+	}
+
+	_run_work((constraints.size() + CONSTRAINT_BATCH_SIZE - 1) / CONSTRAINT_BATCH_SIZE, &Step2DSW::_generate_contacts_batch, constraints.ptr());
+
+	_run_work(constraint_islands.size(), &Step2DSW::_setup_island_work, constraint_islands.ptr());
+
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
 		p_space->set_elapsed_time(Space2DSW::ELAPSED_TIME_SETUP_CONSTRAINTS, profile_endtime - profile_begtime);
@@ -258,14 +317,7 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* SOLVE CONSTRAINT ISLANDS */
 
-	{
-		Constraint2DSW *ci = constraint_island_list;
-		while (ci) {
-			//iterating each island separatedly improves cache efficiency
-			_solve_island(ci, p_iterations, p_delta);
-			ci = ci->get_island_list_next();
-		}
-	}
+	_run_work(constraint_islands.size(), &Step2DSW::_solve_island_work, constraint_islands.ptr());
 
 	{ //profile
 		profile_endtime = OS::get_singleton()->get_ticks_usec();
@@ -275,11 +327,20 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 	/* INTEGRATE VELOCITIES */
 
+	// Pairs created by the broadphase update can wake bodies up, gather the list again.
+	active_bodies.clear();
+
 	b = body_list->first();
 	while (b) {
-		const SelfList<Body2DSW> *n = b->next();
-		b->self()->integrate_velocities(p_delta);
-		b = n; // in case it shuts itself down
+		active_bodies.push_back(b->self());
+		b = b->next();
+	}
+
+	_run_work((active_bodies.size() + BODY_BATCH_SIZE - 1) / BODY_BATCH_SIZE, &Step2DSW::_integrate_velocities_batch, active_bodies.ptr());
+
+	for (uint32_t i = 0; i < active_bodies.size(); i++) {
+		// Can remove the body from the active list, which is why the bodies were gathered.
+		active_bodies[i]->finish_integrate_velocities();
 	}
 
 	/* SLEEP / WAKE UP ISLANDS */
@@ -304,4 +365,7 @@ void Step2DSW::step(Space2DSW *p_space, real_t p_delta, int p_iterations) {
 
 Step2DSW::Step2DSW() {
 	_step = 1;
+	_delta = 0;
+	_iterations = 0;
+	work_pool = nullptr;
 }
@@ -34,16 +34,49 @@
 
 #include "space_2d_sw.h"
 
+#include "core/containers/local_vector.h"
+#include "core/os/thread_work_pool.h"
+
 class Step2DSW {
+	enum {
+		// Bodies are integrated in batches of this size when using threads.
+		BODY_BATCH_SIZE = 64,
+		// Same for the narrow phase of the constraints.
+		CONSTRAINT_BATCH_SIZE = 16,
+	};
+
 	uint64_t _step;
 
+	// Islands are independent, so their setup and solve (and the integration
+	// of the active bodies) is spread across a work pool. The islands can still
+	// share static and kinematic bodies, see Space2DSW::get_shared_state_lock().
+	// The pool belongs to the server, null when it doesn't use threads.
+	ThreadWorkPool *work_pool;
+
+	real_t _delta;
+	int _iterations;
+	LocalVector<Body2DSW *> active_bodies;
+	LocalVector<Constraint2DSW *> constraint_islands;
+	LocalVector<Constraint2DSW *> constraints;
+
 	void _populate_island(Body2DSW *p_body, Body2DSW **p_island, Constraint2DSW **p_constraint_island);
 	bool _setup_island(Constraint2DSW *p_island, real_t p_delta);
 	void _solve_island(Constraint2DSW *p_island, int p_iterations, real_t p_delta);
 	void _check_suspend(Body2DSW *p_island, real_t p_delta);
 
+	void _integrate_forces_batch(uint32_t p_batch, Body2DSW **p_bodies);
+	void _integrate_velocities_batch(uint32_t p_batch, Body2DSW **p_bodies);
+	void _generate_contacts_batch(uint32_t p_batch, Constraint2DSW **p_constraints);
+	void _setup_island_work(uint32_t p_index, Constraint2DSW **p_islands);
+	void _solve_island_work(uint32_t p_index, Constraint2DSW **p_islands);
+
+	template <class U>
+	void _run_work(uint32_t p_count, void (Step2DSW::*p_method)(uint32_t, U), U p_userdata);
+
 public:
 	void step(Space2DSW *p_space, real_t p_delta, int p_iterations);
+	void set_work_pool(ThreadWorkPool *p_work_pool) { work_pool = p_work_pool; }
+
 	Step2DSW();
 };
 
@@ -522,6 +522,8 @@ void Physics2DServer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("space_set_param", "space", "param", "value"), &Physics2DServer::space_set_param);
 	ClassDB::bind_method(D_METHOD("space_get_param", "space", "param"), &Physics2DServer::space_get_param);
 	ClassDB::bind_method(D_METHOD("space_get_direct_state", "space"), &Physics2DServer::space_get_direct_state);
+	ClassDB::bind_method(D_METHOD("space_get_snapshot", "space"), &Physics2DServer::space_get_snapshot);
+	ClassDB::bind_method(D_METHOD("space_set_snapshot", "space", "snapshot"), &Physics2DServer::space_set_snapshot);
 
 	ClassDB::bind_method(D_METHOD("area_create"), &Physics2DServer::area_create);
 	ClassDB::bind_method(D_METHOD("area_set_space", "area", "space"), &Physics2DServer::area_set_space);
@@ -274,6 +274,10 @@ public:
 	virtual Vector<Vector2> space_get_contacts(RID p_space) const = 0;
 	virtual int space_get_contact_count(RID p_space) const = 0;
 
+	// state of the bodies and their contacts, for rolling back and resimulating
+	virtual PoolVector<uint8_t> space_get_snapshot(RID p_space) const = 0;
+	virtual Error space_set_snapshot(RID p_space, const PoolVector<uint8_t> &p_snapshot) = 0;
+
 	//missing space parameters
 
 	/* AREA API */
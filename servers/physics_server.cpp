@@ -32,6 +32,7 @@
 #include "physics_server.h"
 
 #include "core/config/project_settings.h"
+#include "core/containers/local_vector.h"
 #include "core/object/method_bind_ext.gen.inc"
 #include "core/string/print_string.h"
 
@@ -374,6 +375,149 @@ Dictionary PhysicsDirectSpaceState::_get_rest_info(const Ref<PhysicsShapeQueryPa
 	return r;
 }
 
+Dictionary PhysicsDirectSpaceState::_intersect_rays(const PoolVector3Array &p_from, const PoolVector3Array &p_to, const Vector<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	ERR_FAIL_COND_V(p_from.size() != p_to.size(), Dictionary());
+
+	int ray_count = p_from.size();
+
+	LocalVector<RayResult> results;
+	results.resize(ray_count);
+	LocalVector<bool> hits;
+	hits.resize(ray_count);
+
+	PoolVector3Array::Read from_r = p_from.read();
+	PoolVector3Array::Read to_r = p_to.read();
+
+	intersect_rays(from_r.ptr(), to_r.ptr(), ray_count, results.ptr(), hits.ptr(), p_exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+
+	PoolVector3Array positions;
+	positions.resize(ray_count);
+	PoolVector3Array normals;
+	normals.resize(ray_count);
+	PoolIntArray shapes;
+	shapes.resize(ray_count);
+	Array collider_ids;
+	collider_ids.resize(ray_count);
+	Array colliders;
+	colliders.resize(ray_count);
+	Array rids;
+	rids.resize(ray_count);
+
+	{
+		PoolVector3Array::Write positions_w = positions.write();
+		PoolVector3Array::Write normals_w = normals.write();
+		PoolIntArray::Write shapes_w = shapes.write();
+
+		for (int i = 0; i < ray_count; i++) {
+			if (!hits[i]) {
+				// A shape index of -1 marks the rays that did not hit anything.
+				shapes_w[i] = -1;
+				continue;
+			}
+
+			const RayResult &res = results[i];
+			positions_w[i] = res.position;
+			normals_w[i] = res.normal;
+			shapes_w[i] = res.shape;
+			collider_ids[i] = res.collider_id;
+			colliders[i] = res.collider;
+			rids[i] = res.rid;
+		}
+	}
+
+	Dictionary d;
+	d["position"] = positions;
+	d["normal"] = normals;
+	d["shape"] = shapes;
+	d["collider_id"] = collider_ids;
+	d["collider"] = colliders;
+	d["rid"] = rids;
+
+	return d;
+}
+
+Array PhysicsDirectSpaceState::_intersect_shapes(const Ref<PhysicsShapeQueryParameters> &p_shape_query, const PoolVector3Array &p_positions, int p_max_results) {
+	ERR_FAIL_COND_V(!p_shape_query.is_valid(), Array());
+	ERR_FAIL_COND_V(p_max_results <= 0, Array());
+
+	int query_count = p_positions.size();
+
+	Vector<Transform> xforms;
+	xforms.resize(query_count);
+
+	{
+		PoolVector3Array::Read positions_r = p_positions.read();
+		Transform *xforms_w = xforms.ptrw();
+
+		for (int i = 0; i < query_count; i++) {
+			xforms_w[i] = Transform(p_shape_query->transform.basis, positions_r[i]);
+		}
+	}
+
+	Vector<ShapeResult> sr;
+	sr.resize(query_count * p_max_results);
+	Vector<int> counts;
+	counts.resize(query_count);
+
+	Vector<RID> exclude;
+	for (RBSet<RID>::Element *E = p_shape_query->exclude.front(); E; E = E->next()) {
+		exclude.push_back(E->get());
+	}
+
+	intersect_shapes(p_shape_query->shape, xforms.ptr(), query_count, p_shape_query->margin, sr.ptrw(), p_max_results, counts.ptrw(), exclude, p_shape_query->collision_mask, p_shape_query->collide_with_bodies, p_shape_query->collide_with_areas);
+
+	Array ret;
+	ret.resize(query_count);
+	for (int i = 0; i < query_count; i++) {
+		Array query_ret;
+		query_ret.resize(counts[i]);
+		for (int j = 0; j < counts[i]; j++) {
+			const ShapeResult &res = sr[i * p_max_results + j];
+			Dictionary d;
+			d["rid"] = res.rid;
+			d["collider_id"] = res.collider_id;
+			d["collider"] = res.collider;
+			d["shape"] = res.shape;
+			query_ret[j] = d;
+		}
+		ret[i] = query_ret;
+	}
+
+	return ret;
+}
+
+int PhysicsDirectSpaceState::intersect_rays(const Vector3 *p_from, const Vector3 *p_to, int p_ray_count, RayResult *r_results, bool *r_hits, const Vector<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	RBSet<RID> exclude;
+	for (int i = 0; i < p_exclude.size(); i++) {
+		exclude.insert(p_exclude[i]);
+	}
+
+	int hit_count = 0;
+	for (int i = 0; i < p_ray_count; i++) {
+		r_hits[i] = intersect_ray(p_from[i], p_to[i], r_results[i], exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+		if (r_hits[i]) {
+			hit_count++;
+		}
+	}
+
+	return hit_count;
+}
+
+int PhysicsDirectSpaceState::intersect_shapes(const RID &p_shape, const Transform *p_xforms, int p_query_count, float p_margin, ShapeResult *r_results, int p_result_max, int *r_result_counts, const Vector<RID> &p_exclude, uint32_t p_collision_mask, bool p_collide_with_bodies, bool p_collide_with_areas) {
+	RBSet<RID> exclude;
+	for (int i = 0; i < p_exclude.size(); i++) {
+		exclude.insert(p_exclude[i]);
+	}
+
+	int result_count = 0;
+	for (int i = 0; i < p_query_count; i++) {
+		r_result_counts[i] = intersect_shape(p_shape, p_xforms[i], p_margin, &r_results[i * p_result_max], p_result_max, exclude, p_collision_mask, p_collide_with_bodies, p_collide_with_areas);
+		result_count += r_result_counts[i];
+	}
+
+	return result_count;
+}
+
 PhysicsDirectSpaceState::PhysicsDirectSpaceState() {
 }
 
@@ -384,6 +528,8 @@ void PhysicsDirectSpaceState::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("cast_motion", "shape", "motion"), &PhysicsDirectSpaceState::_cast_motion);
 	ClassDB::bind_method(D_METHOD("collide_shape", "shape", "max_results"), &PhysicsDirectSpaceState::_collide_shape, DEFVAL(32));
 	ClassDB::bind_method(D_METHOD("get_rest_info", "shape"), &PhysicsDirectSpaceState::_get_rest_info);
+	ClassDB::bind_method(D_METHOD("intersect_rays", "from", "to", "exclude", "collision_mask", "collide_with_bodies", "collide_with_areas"), &PhysicsDirectSpaceState::_intersect_rays, DEFVAL(Array()), DEFVAL(0x7FFFFFFF), DEFVAL(true), DEFVAL(false));
+	ClassDB::bind_method(D_METHOD("intersect_shapes", "shape", "positions", "max_results"), &PhysicsDirectSpaceState::_intersect_shapes, DEFVAL(32));
 }
 
 ///////////////////////////////
@@ -493,6 +639,8 @@ void PhysicsServer::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("space_set_param", "space", "param", "value"), &PhysicsServer::space_set_param);
 	ClassDB::bind_method(D_METHOD("space_get_param", "space", "param"), &PhysicsServer::space_get_param);
 	ClassDB::bind_method(D_METHOD("space_get_direct_state", "space"), &PhysicsServer::space_get_direct_state);
+	ClassDB::bind_method(D_METHOD("space_get_snapshot", "space"), &PhysicsServer::space_get_snapshot);
+	ClassDB::bind_method(D_METHOD("space_set_snapshot", "space", "snapshot"), &PhysicsServer::space_set_snapshot);
 
 	ClassDB::bind_method(D_METHOD("area_create"), &PhysicsServer::area_create);
 	ClassDB::bind_method(D_METHOD("area_set_space", "area", "space"), &PhysicsServer::area_set_space);
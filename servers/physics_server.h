@@ -149,6 +149,8 @@ private:
 	Array _cast_motion(const Ref<PhysicsShapeQueryParameters> &p_shape_query, const Vector3 &p_motion);
 	Array _collide_shape(const Ref<PhysicsShapeQueryParameters> &p_shape_query, int p_max_results = 32);
 	Dictionary _get_rest_info(const Ref<PhysicsShapeQueryParameters> &p_shape_query);
+	Dictionary _intersect_rays(const PoolVector3Array &p_from, const PoolVector3Array &p_to, const Vector<RID> &p_exclude = Vector<RID>(), uint32_t p_collision_mask = 0, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
+	Array _intersect_shapes(const Ref<PhysicsShapeQueryParameters> &p_shape_query, const PoolVector3Array &p_positions, int p_max_results = 32);
 
 protected:
 	static void _bind_methods();
@@ -193,6 +195,15 @@ public:
 
 	virtual Vector3 get_closest_point_to_object_volume(RID p_object, const Vector3 p_point) const = 0;
 
+	// Batched intersect_ray(), ray i goes from p_from[i] to p_to[i]. r_hits[i] is set to whether
+	// r_results[i] holds a hit. Returns the amount of rays that hit something.
+	virtual int intersect_rays(const Vector3 *p_from, const Vector3 *p_to, int p_ray_count, RayResult *r_results, bool *r_hits, const Vector<RID> &p_exclude = Vector<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
+
+	// Batched intersect_shape(), the shape is tested at every transform in p_xforms. The results of
+	// query i start at r_results[i * p_result_max], and their amount is stored in r_result_counts[i].
+	// Returns the total amount of results.
+	virtual int intersect_shapes(const RID &p_shape, const Transform *p_xforms, int p_query_count, float p_margin, ShapeResult *r_results, int p_result_max, int *r_result_counts, const Vector<RID> &p_exclude = Vector<RID>(), uint32_t p_collision_mask = 0xFFFFFFFF, bool p_collide_with_bodies = true, bool p_collide_with_areas = false);
+
 	PhysicsDirectSpaceState();
 };
 
@@ -264,6 +275,10 @@ public:
 	virtual Vector<Vector3> space_get_contacts(RID p_space) const = 0;
 	virtual int space_get_contact_count(RID p_space) const = 0;
 
+	// state of the bodies and their contacts, for rolling back and resimulating
+	virtual PoolVector<uint8_t> space_get_snapshot(RID p_space) const = 0;
+	virtual Error space_set_snapshot(RID p_space, const PoolVector<uint8_t> &p_snapshot) = 0;
+
 	//missing space parameters
 
 	/* AREA API */
@@ -727,7 +742,9 @@ public:
 	virtual void set_active(bool p_active) = 0;
 	virtual void init() = 0;
 	virtual void step(float p_step) = 0;
+	virtual void sync() = 0;
 	virtual void flush_queries() = 0;
+	virtual void end_sync() = 0;
 	virtual void finish() = 0;
 
 	virtual bool is_flushing_queries() const = 0;